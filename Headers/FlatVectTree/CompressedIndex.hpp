@@ -0,0 +1,349 @@
+#ifndef COMPRESSED_INDEX_HPP
+#define COMPRESSED_INDEX_HPP
+
+#include <stdint.h>
+#include <cstring>
+#include <type_traits>
+
+#include "../MexMem.hpp"
+#include "../GenericMexIO.hpp"
+#include "../ParallelHelpers.hpp"
+
+// The block decoding is vectorized using AVX2 or SSE2 when the compiler
+// targets them (/arch:AVX2 or -mavx2 for AVX2, SSE2 being implied on x64).
+// Define MEXMEM_NO_SIMD to force the scalar implementation.
+#ifndef MEXMEM_NO_SIMD
+#  if defined(__AVX2__)
+#    define MEXMEM_COMPRESSED_INDEX_AVX2
+#  elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define MEXMEM_COMPRESSED_INDEX_SSE2
+#  endif
+#endif
+
+#if defined(MEXMEM_COMPRESSED_INDEX_AVX2)
+#  include <immintrin.h>
+#elif defined(MEXMEM_COMPRESSED_INDEX_SSE2)
+#  include <emmintrin.h>
+#endif
+
+// CompressedIndex is a compressed, read-only representation of a vector of
+// indices, intended for the levels of FlatVectTree::PartitionIndex (see
+// FlatVectTree::compressIndex). The vector is split into blocks of
+// BLOCK_SIZE indices. Each block stores its minimum (the base) and the
+// offsets of its indices from the base, bit-packed using the smallest width
+// (0 to 32 bits) that fits the largest offset. As the partition indices are
+// non-decreasing, the offsets in a block are bounded by the number of
+// elements partitioned by the block, so that a level with tiny leaves needs
+// only a few bits per index.
+//
+// The packed offsets of a block are interleaved over 4 lanes (offset j being
+// in lane j % 4) i.e. 32-bit word k of lane l is the word 4*k + l of the
+// block. This allows a block to be decoded 4 (SSE2) or 8 (AVX2) indices at a
+// time while any single index can be decoded in O(1). Blocks whose offsets
+// do not fit in 32 bits (only possible for uint64_t indices) store the
+// offsets unpacked as pairs of words (width 64). In either case, a block of
+// width W occupies 4*W words.
+template <typename IndexT = uint32_t, class Al = mxAllocator>
+class CompressedIndex {
+
+	static_assert(std::is_same<IndexT, uint32_t>::value || std::is_same<IndexT, uint64_t>::value,
+	              "CompressedIndex requires uint32_t or uint64_t indices");
+
+	MexVector<IndexT, Al>   BlockBases;
+	MexVector<uint8_t, Al>  BlockWidths;
+	MexVector<uint64_t, Al> BlockOffsets;   // Word offset of each block (NBlocks + 1)
+	MexVector<uint32_t, Al> PackedOffsets;  // Padded by 4 words (see decodeBlock)
+	size_t NIndices;
+
+	static inline uint8_t getBitWidth(uint64_t MaxOffset);
+	static inline void packBlock(const IndexT* BlockIndices, size_t NBlockIndices, IndexT Base, uint8_t Width, uint32_t* BlockWords);
+
+public:
+	static const size_t BLOCK_SIZE = 128;
+
+	// Constructors
+	inline CompressedIndex() : BlockBases(), BlockWidths(), BlockOffsets(), PackedOffsets(), NIndices(0) {}
+	template <class AlIn>
+	inline explicit CompressedIndex(const MexVector<IndexT, AlIn> &IndexIn) : CompressedIndex() {
+		compress(IndexIn);
+	}
+
+	// Conversion Functions
+	template <class AlIn>
+	inline void compress(const MexVector<IndexT, AlIn> &IndexIn);
+	template <class AlOut>
+	inline void decompress(MexVector<IndexT, AlOut> &IndexOut) const;
+
+	// Access Functions (unchecked and checked)
+	inline IndexT operator[] (size_t Index) const;
+	inline IndexT at(size_t Index) const {
+		if (Index >= NIndices)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT,
+			               "The index requested (%llu) exceeds the size of the CompressedIndex (%llu)\n",
+			               (unsigned long long)Index, (unsigned long long)NIndices);
+		return (*this)[Index];
+	}
+
+	// Decodes the BLOCK_SIZE indices of the given block into BlockOut. The
+	// entries beyond the end of the last block are equal to its base.
+	inline void decodeBlock(size_t BlockIndex, IndexT* BlockOut) const;
+
+	// Property Access Functions
+	inline size_t size() const       { return NIndices; }
+	inline size_t nBlocks() const    { return BlockBases.size(); }
+	inline bool   isempty() const    { return NIndices == 0; }
+	inline size_t memoryBytes() const {
+		return BlockBases.size()*sizeof(IndexT) + BlockWidths.size()*sizeof(uint8_t)
+		     + BlockOffsets.size()*sizeof(uint64_t) + PackedOffsets.size()*sizeof(uint32_t);
+	}
+};
+
+/////////////////////////////////////////////////
+// PRIVATE HELPER FUNCTIONS  ////////////////////
+/////////////////////////////////////////////////
+
+template <typename IndexT, class Al>
+inline uint8_t CompressedIndex<IndexT, Al>::getBitWidth(uint64_t MaxOffset) {
+	uint8_t Width = 0;
+	while (MaxOffset > 0) {
+		MaxOffset >>= 1;
+		++Width;
+	}
+	return (Width > 32) ? 64 : Width;
+}
+
+template <typename IndexT, class Al>
+inline void CompressedIndex<IndexT, Al>::packBlock(const IndexT* BlockIndices, size_t NBlockIndices, IndexT Base, uint8_t Width, uint32_t* BlockWords) {
+
+	// The words of the block must have been zeroed. The entries beyond
+	// NBlockIndices are packed as zero offsets.
+
+	if (Width == 64) {
+		for (size_t j = 0; j < NBlockIndices; ++j) {
+			uint64_t Offset = BlockIndices[j] - Base;
+			BlockWords[2*j]     = uint32_t(Offset);
+			BlockWords[2*j + 1] = uint32_t(Offset >> 32);
+		}
+		return;
+	}
+
+	for (size_t j = 0; j < NBlockIndices; ++j) {
+		uint32_t Offset = uint32_t(BlockIndices[j] - Base);
+		size_t   Lane   = j & 3;
+		size_t   BitPos = (j >> 2)*Width;
+		size_t   Word   = BitPos >> 5;
+		uint32_t Shift  = BitPos & 31;
+
+		BlockWords[4*Word + Lane] |= Offset << Shift;
+		if (Shift + Width > 32)
+			BlockWords[4*(Word + 1) + Lane] |= Offset >> (32 - Shift);
+	}
+}
+
+/////////////////////////////////////////////////
+// CONVERSION FUNCTIONS      ////////////////////
+/////////////////////////////////////////////////
+
+template <typename IndexT, class Al>
+template <class AlIn>
+inline void CompressedIndex<IndexT, Al>::compress(const MexVector<IndexT, AlIn> &IndexIn) {
+
+	// The widths of the blocks are computed in parallel, their word offsets
+	// by a prefix sum, and the blocks are then packed in parallel.
+
+	NIndices = IndexIn.size();
+	int64_t NBlocks = (NIndices + BLOCK_SIZE - 1)/BLOCK_SIZE;
+	const IndexT* Indices = IndexIn.begin();
+
+	BlockBases.resize(NBlocks);
+	BlockWidths.resize(NBlocks);
+	BlockOffsets.resize(NBlocks + 1);
+	BlockOffsets[0] = 0;
+
+	#pragma omp parallel for if(int64_t(NIndices) >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = b*BLOCK_SIZE;
+		size_t BlockEnd = (BlockBeg + BLOCK_SIZE < NIndices) ? BlockBeg + BLOCK_SIZE : NIndices;
+		IndexT MinIndex = Indices[BlockBeg], MaxIndex = Indices[BlockBeg];
+		for (size_t i = BlockBeg + 1; i < BlockEnd; ++i) {
+			MinIndex = (Indices[i] < MinIndex) ? Indices[i] : MinIndex;
+			MaxIndex = (Indices[i] > MaxIndex) ? Indices[i] : MaxIndex;
+		}
+		BlockBases[b] = MinIndex;
+		BlockWidths[b] = getBitWidth(MaxIndex - MinIndex);
+		BlockOffsets[b + 1] = 4*uint64_t(BlockWidths[b]);
+	}
+	uint64_t NWords = InclusivePrefixSum(BlockOffsets.begin() + 1, NBlocks);
+
+	PackedOffsets.resize(NWords + 4);
+	if (PackedOffsets.size() > 0)
+		memset(PackedOffsets.begin(), 0, PackedOffsets.size()*sizeof(uint32_t));
+
+	#pragma omp parallel for if(int64_t(NIndices) >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = b*BLOCK_SIZE;
+		size_t NBlockIndices = (BlockBeg + BLOCK_SIZE < NIndices) ? BLOCK_SIZE : NIndices - BlockBeg;
+		packBlock(Indices + BlockBeg, NBlockIndices, BlockBases[b], BlockWidths[b], PackedOffsets.begin() + BlockOffsets[b]);
+	}
+}
+
+template <typename IndexT, class Al>
+template <class AlOut>
+inline void CompressedIndex<IndexT, Al>::decompress(MexVector<IndexT, AlOut> &IndexOut) const {
+
+	IndexOut.resize(NIndices);
+	int64_t NBlocks = this->nBlocks();
+	IndexT* IndicesOut = IndexOut.begin();
+
+	#pragma omp parallel for if(int64_t(NIndices) >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = b*BLOCK_SIZE;
+		if (BlockBeg + BLOCK_SIZE <= NIndices) {
+			decodeBlock(b, IndicesOut + BlockBeg);
+		}
+		else {
+			IndexT BlockBuffer[BLOCK_SIZE];
+			decodeBlock(b, BlockBuffer);
+			for (size_t i = BlockBeg; i < NIndices; ++i)
+				IndicesOut[i] = BlockBuffer[i - BlockBeg];
+		}
+	}
+}
+
+/////////////////////////////////////////////////
+// ACCESS FUNCTIONS          ////////////////////
+/////////////////////////////////////////////////
+
+template <typename IndexT, class Al>
+inline IndexT CompressedIndex<IndexT, Al>::operator[] (size_t Index) const {
+
+	size_t   Block = Index / BLOCK_SIZE;
+	size_t   j     = Index % BLOCK_SIZE;
+	uint8_t  Width = BlockWidths[Block];
+	IndexT   Base  = BlockBases[Block];
+	const uint32_t* BlockWords = PackedOffsets.begin() + BlockOffsets[Block];
+
+	if (Width == 0)
+		return Base;
+	if (Width == 64)
+		return Base + IndexT(BlockWords[2*j] | (uint64_t(BlockWords[2*j + 1]) << 32));
+
+	size_t   Lane   = j & 3;
+	size_t   BitPos = (j >> 2)*Width;
+	size_t   Word   = BitPos >> 5;
+	uint32_t Shift  = BitPos & 31;
+
+	uint64_t Offset = BlockWords[4*Word + Lane] >> Shift;
+	if (Shift + Width > 32)
+		Offset |= uint64_t(BlockWords[4*(Word + 1) + Lane]) << (32 - Shift);
+
+	return Base + IndexT(Offset & ((uint64_t(1) << Width) - 1));
+}
+
+#if defined(MEXMEM_COMPRESSED_INDEX_AVX2)
+
+inline void storeDecodedRows(__m256i Offsets, uint32_t Base, uint32_t* Out) {
+	_mm256_storeu_si256((__m256i*)Out, _mm256_add_epi32(Offsets, _mm256_set1_epi32(Base)));
+}
+inline void storeDecodedRows(__m256i Offsets, uint64_t Base, uint64_t* Out) {
+	__m256i BaseVect = _mm256_set1_epi64x(Base);
+	_mm256_storeu_si256((__m256i*)Out    , _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(Offsets)), BaseVect));
+	_mm256_storeu_si256((__m256i*)(Out + 4), _mm256_add_epi64(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(Offsets, 1)), BaseVect));
+}
+
+#elif defined(MEXMEM_COMPRESSED_INDEX_SSE2)
+
+inline void storeDecodedRow(__m128i Offsets, uint32_t Base, uint32_t* Out) {
+	_mm_storeu_si128((__m128i*)Out, _mm_add_epi32(Offsets, _mm_set1_epi32(Base)));
+}
+inline void storeDecodedRow(__m128i Offsets, uint64_t Base, uint64_t* Out) {
+	__m128i BaseVect = _mm_set1_epi64x(Base);
+	__m128i Zero = _mm_setzero_si128();
+	_mm_storeu_si128((__m128i*)Out    , _mm_add_epi64(_mm_unpacklo_epi32(Offsets, Zero), BaseVect));
+	_mm_storeu_si128((__m128i*)(Out + 2), _mm_add_epi64(_mm_unpackhi_epi32(Offsets, Zero), BaseVect));
+}
+
+#endif
+
+template <typename IndexT, class Al>
+inline void CompressedIndex<IndexT, Al>::decodeBlock(size_t BlockIndex, IndexT* BlockOut) const {
+
+	// Each row of 4 lanes (i.e. 4 consecutive indices) starts at the same bit
+	// position in each lane, so that a row is decoded by shifting and masking
+	// the 4 words containing it (and the next 4 words if the row straddles a
+	// word boundary). The next 4 words are always read by the AVX2 version,
+	// this being in bounds due to the padding of PackedOffsets.
+
+	uint8_t Width = BlockWidths[BlockIndex];
+	IndexT  Base  = BlockBases[BlockIndex];
+	const uint32_t* BlockWords = PackedOffsets.begin() + BlockOffsets[BlockIndex];
+
+	if (Width == 0) {
+		for (size_t j = 0; j < BLOCK_SIZE; ++j)
+			BlockOut[j] = Base;
+		return;
+	}
+	if (Width == 64) {
+		for (size_t j = 0; j < BLOCK_SIZE; ++j)
+			BlockOut[j] = Base + IndexT(BlockWords[2*j] | (uint64_t(BlockWords[2*j + 1]) << 32));
+		return;
+	}
+
+	uint32_t Mask = (Width == 32) ? ~uint32_t(0) : (uint32_t(1) << Width) - 1;
+
+#if defined(MEXMEM_COMPRESSED_INDEX_AVX2)
+
+	__m256i MaskVect = _mm256_set1_epi32(Mask);
+	for (size_t Row = 0; Row < BLOCK_SIZE/4; Row += 2) {
+		size_t   BitPos0 = Row*Width, BitPos1 = (Row + 1)*Width;
+		size_t   Word0 = BitPos0 >> 5, Word1 = BitPos1 >> 5;
+		uint32_t Shift0 = BitPos0 & 31, Shift1 = BitPos1 & 31;
+		// A left shift of 32 zeroes the lanes that do not straddle
+		uint32_t Spill0 = (Shift0 + Width > 32) ? 32 - Shift0 : 32;
+		uint32_t Spill1 = (Shift1 + Width > 32) ? 32 - Shift1 : 32;
+
+		__m256i Curr = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(BlockWords + 4*Word0))),
+			_mm_loadu_si128((const __m128i*)(BlockWords + 4*Word1)), 1);
+		__m256i Next = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(BlockWords + 4*(Word0 + 1)))),
+			_mm_loadu_si128((const __m128i*)(BlockWords + 4*(Word1 + 1))), 1);
+
+		__m256i Offsets = _mm256_or_si256(
+			_mm256_srlv_epi32(Curr, _mm256_setr_epi32(Shift0, Shift0, Shift0, Shift0, Shift1, Shift1, Shift1, Shift1)),
+			_mm256_sllv_epi32(Next, _mm256_setr_epi32(Spill0, Spill0, Spill0, Spill0, Spill1, Spill1, Spill1, Spill1)));
+		storeDecodedRows(_mm256_and_si256(Offsets, MaskVect), Base, BlockOut + 4*Row);
+	}
+
+#elif defined(MEXMEM_COMPRESSED_INDEX_SSE2)
+
+	__m128i MaskVect = _mm_set1_epi32(Mask);
+	for (size_t Row = 0; Row < BLOCK_SIZE/4; ++Row) {
+		size_t   BitPos = Row*Width;
+		size_t   Word   = BitPos >> 5;
+		uint32_t Shift  = BitPos & 31;
+
+		__m128i Offsets = _mm_srl_epi32(_mm_loadu_si128((const __m128i*)(BlockWords + 4*Word)), _mm_cvtsi32_si128(Shift));
+		if (Shift + Width > 32)
+			Offsets = _mm_or_si128(Offsets, _mm_sll_epi32(_mm_loadu_si128((const __m128i*)(BlockWords + 4*(Word + 1))), _mm_cvtsi32_si128(32 - Shift)));
+		storeDecodedRow(_mm_and_si128(Offsets, MaskVect), Base, BlockOut + 4*Row);
+	}
+
+#else
+
+	for (size_t Row = 0; Row < BLOCK_SIZE/4; ++Row) {
+		size_t   BitPos = Row*Width;
+		size_t   Word   = BitPos >> 5;
+		uint32_t Shift  = BitPos & 31;
+		for (size_t Lane = 0; Lane < 4; ++Lane) {
+			uint64_t Offset = BlockWords[4*Word + Lane] >> Shift;
+			if (Shift + Width > 32)
+				Offset |= uint64_t(BlockWords[4*(Word + 1) + Lane]) << (32 - Shift);
+			BlockOut[4*Row + Lane] = Base + IndexT(Offset & Mask);
+		}
+	}
+
+#endif
+}
+
+#endif
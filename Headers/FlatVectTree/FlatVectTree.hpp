@@ -2,6 +2,7 @@
 #define FLAT_VECT_TREE_HPP
 
 #include <type_traits>
+#include <limits>
 #include <stdint.h>
 
 #include "VectTreeInfo.hpp"
@@ -11,22 +12,45 @@
 
 enum FV_ExCodes {
     FV_INVALID_APPEND = 0x01,
-	FV_INVALID_FETCH  = 0x02
+	FV_INVALID_FETCH  = 0x02,
+	FV_INVALID_FILTER = 0x04,
+	FV_INVALID_GROUP  = 0x08
 };
 
-template<typename T, class FVT_Al = mxAllocator, class B = typename std::enable_if< std::is_arithmetic<T>::value >::type>
+#include "FlatVectTreeView.hpp"
+#include "CompressedIndex.hpp"
+#include "IndexValidation.hpp"
+
+class MexSnapshotWriter;
+template<typename T, typename IndexT> class FlatVectTreeBuilder;
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT> class StaticFlatVectTree;
+
+// IndexT is the type of the partition indices. It defaults to uint32_t which
+// limits the number of elements in each level (and in Data) to 2^32 - 1. For
+// larger trees use uint64_t.
+template<
+	typename T,
+	class FVT_Al = mxAllocator,
+	typename IndexT = uint32_t,
+	class B = typename std::enable_if< std::is_arithmetic<T>::value && std::is_unsigned<IndexT>::value >::type>
 class FlatVectTree {
 
-	MexVector<MexVector<uint32_t, FVT_Al>, FVT_Al> PartitionIndex;
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> PartitionIndex;
 	MexVector<T, FVT_Al> Data;
 
+	// This is false only if the tree was assigned from trusted input without
+	// validation (see assign and validate). All other operations either
+	// validate their input or preserve the validity of the tree.
+	bool isStructValidated;
+
 	uint32_t getActualInsertDepth(uint32_t InsertDepth, uint32_t GivenDepth) const;
 	uint32_t getAppendInsertDepth(uint32_t GivenInsertDepth, uint32_t AppendTreeDepth) const;
+	inline void linkAppendedTree(uint32_t CurrDepth, uint32_t GivenDepth, uint32_t ActualInsertDepth);
 
 	template<class Al>
-	inline void getVectTreeFromInds(MexVector<T, Al> &VectTreeOut, uint32_t Level, uint32_t LevelIndex);
+	inline void getVectTreeFromInds(MexVector<T, Al> &VectTreeOut, uint32_t Level, IndexT LevelIndex);
 	template<typename SubElemT, class AlSub, class Al>
-	inline void getVectTreeFromInds(MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeOut, uint32_t Level, uint32_t LevelIndex);
+	inline void getVectTreeFromInds(MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeOut, uint32_t Level, IndexT LevelIndex);
 	
 	template<class Al>
 	inline void appendFast(const MexVector<T, Al> &VectIn);
@@ -38,15 +62,55 @@ class FlatVectTree {
 	template<typename SubElemT, class AlSub, class Al>
 	inline void appendFast(MexVector<MexVector<SubElemT, AlSub>, Al > &&VectTreeIn);
 
-	template<typename, class, class>
+	template<class AlLeaf, class Al>
+	static inline void buildLevels(const MexVector<const MexVector<MexVector<T, AlLeaf>, Al>*> &Parents, const IndexT* ParentOffsets, MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> &PartitionIndexOut, uint32_t Level, MexVector<T, FVT_Al> &DataOut);
+	template<typename SubElemT, class AlSub, class AlNode, class Al>
+	static inline void buildLevels(const MexVector<const MexVector<MexVector<MexVector<SubElemT, AlSub>, AlNode>, Al>*> &Parents, const IndexT* ParentOffsets, MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> &PartitionIndexOut, uint32_t Level, MexVector<T, FVT_Al> &DataOut);
+
+	static inline void checkBuildLevelSize(uint64_t LevelSize, uint32_t Level);
+
+	static inline void moveLeafData(MexVector<T, FVT_Al> &DataOut, MexVector<T, FVT_Al> &VectIn);
+	template<class Al>
+	static inline void moveLeafData(MexVector<T, FVT_Al> &DataOut, MexVector<T, Al> &VectIn);
+
+	template<class AlInds>
+	inline void checkLevelIndices(uint32_t Level, const MexVector<IndexT, AlInds> &Indices) const;
+	template<class AlOut, class AlInds>
+	inline void extractLevels(uint32_t Level, const MexVector<IndexT, AlInds> &Indices, MexVector<MexVector<IndexT, AlOut>, AlOut> &PartitionIndexOut, MexVector<T, AlOut> &DataOut) const;
+	template<class AlInds>
+	inline void filterSorted(uint32_t Level, const MexVector<IndexT, AlInds> &SortedIndices);
+
+	template<class Al>
+	static inline void addLevelSizes(const MexVector<T, Al> &VectIn, size_t* LevelSizes);
+	template<typename SubElemT, class AlSub, class Al>
+	static inline void addLevelSizes(const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeIn, size_t* LevelSizes);
+	inline uint32_t initBatchAppend(uint32_t InsertDepth, uint32_t GivenDepth);
+	inline void reserveBatchAppend(const MexVector<size_t> &ExtraLevelSizes);
+	inline bool takeOverTree(FlatVectTree<T, FVT_Al, IndexT> &VectTreeIn);
+	template<class Al>
+	inline bool takeOverTree(FlatVectTree<T, Al, IndexT> &VectTreeIn) { return false; }
+
+	inline size_t getShardWeight(uint32_t Level, IndexT LevelIndex) const;
+
+	template<class AlSub, class Al, class AlData>
+	inline void assignFast(const MexVector<MexVector<IndexT, AlSub>, Al> &PartitionIndexIn, const MexVector<T, AlData> & DataIn, bool ActualCopy = true, bool isValidated = true);
+
+	template<typename, class, typename, class>
 	friend class FlatVectTree;
+	template<typename, class>
+	friend struct FieldInfo;
+	friend class MexSnapshotWriter;
+	template<typename, typename>
+	friend class FlatVectTreeBuilder;
+	template<typename, uint32_t, class, typename>
+	friend class StaticFlatVectTree;
 
 public:
 	
 
 	// Constructors
-	inline FlatVectTree() : PartitionIndex(), Data() {}
-	inline FlatVectTree(int Depth) : PartitionIndex(Depth, MexVector<uint32_t>(1, uint32_t(0))), Data() {}
+	inline FlatVectTree() : PartitionIndex(), Data(), isStructValidated(true) {}
+	inline FlatVectTree(int Depth) : PartitionIndex(Depth, MexVector<IndexT, FVT_Al>(1, IndexT(0))), Data(), isStructValidated(true) {}
 
 	// Property Reassignment Functions
 	inline bool setDepth(uint32_t NewDepth);
@@ -55,25 +119,53 @@ public:
 
 	// Assignment Functions
 	template<class AlSub, class Al, class AlData>
-	inline void assign(const MexVector<MexVector<uint32_t, AlSub>, Al> &PartitionIndexIn, const MexVector<T, AlData> & DataIn, bool ActualCopy = true);
+	inline void assign(const MexVector<MexVector<IndexT, AlSub>, Al> &PartitionIndexIn, const MexVector<T, AlData> & DataIn, bool ActualCopy = true, bool isTrusted = false);
 	template<class FVT_Al2>
-	inline void assign(const FlatVectTree<T, FVT_Al2> &FlatVectTreeIn, bool ActualCopy = true);
+	inline void assign(const FlatVectTree<T, FVT_Al2, IndexT> &FlatVectTreeIn, bool ActualCopy = true);
+
+	// Bulk Construction Functions
+	template<class Al>
+	inline void build(const MexVector<T, Al> &VectIn);
+	template<typename SubElemT, class AlSub, class Al>
+	inline void build(const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeIn);
+
+	// Move-Bulk Construction Functions
+	template<class Al>
+	inline void build(MexVector<T, Al> &&VectIn);
+	template<typename SubElemT, class AlSub, class Al>
+	inline void build(MexVector<MexVector<SubElemT, AlSub>, Al> &&VectTreeIn);
+
+	// Group-By Construction Functions
+	template<typename KeyT, class AlKeys, class AlVals>
+	inline void group_by(const MexVector<KeyT, AlKeys> &Keys, const MexVector<T, AlVals> &Values, IndexT NGroups = IndexT(-1), bool SortGroups = false);
 
 	// Appending Functions
 	template<typename SubElemT, class Al>
 	inline void append(const MexVector<SubElemT, Al> &SubElemTree, uint32_t InsertDepth = uint32_t(-1));
 	template <class Al>
-	inline void append(const FlatVectTree<T, Al> &SubElemTree, uint32_t InsertDepth = uint32_t(-1));
+	inline void append(const FlatVectTree<T, Al, IndexT> &SubElemTree, uint32_t InsertDepth = uint32_t(-1));
 
 	// Move-Appending functions
 	template<typename SubElemT, class Al>
 	inline void append(MexVector<SubElemT, Al> &&SubElemTree, uint32_t InsertDepth = uint32_t(-1));
 
+	// Batch-Appending Functions
+	template<typename SubElemT, class AlSub, class Al>
+	inline void append_batch(const MexVector<MexVector<SubElemT, AlSub>, Al> &SubElemTrees, uint32_t InsertDepth = uint32_t(-1));
+	template<class AlSub, class Al>
+	inline void append_batch(const MexVector<FlatVectTree<T, AlSub, IndexT>, Al> &SubElemTrees, uint32_t InsertDepth = uint32_t(-1));
+
+	// Move-Batch-Appending Functions
+	template<typename SubElemT, class AlSub, class Al>
+	inline void append_batch(MexVector<MexVector<SubElemT, AlSub>, Al> &&SubElemTrees, uint32_t InsertDepth = uint32_t(-1));
+	template<class AlSub, class Al>
+	inline void append_batch(MexVector<FlatVectTree<T, AlSub, IndexT>, Al> &&SubElemTrees, uint32_t InsertDepth = uint32_t(-1));
+
 	// Push-Back Functions
 	template<typename SubElemT, class Al>
 	inline void push_back(const MexVector<SubElemT, Al> &MexVectIn);
 	template <class Al>
-	void push_back(FlatVectTree<T, Al> &VectTreeIn);
+	void push_back(FlatVectTree<T, Al, IndexT> &VectTreeIn);
 
 	// Move-Push-Back Functions
 	template<typename SubElemT, class Al>
@@ -81,18 +173,44 @@ public:
 
 	// Get Vector Tree
 	template<typename SubElemT, class Al, class AlInds>
-	inline void getVectTree(MexVector<SubElemT, Al> &VectTreeOut, const MexVector<uint32_t, AlInds> &Indices = MexVector<uint32_t>(0));
+	inline void getVectTree(MexVector<SubElemT, Al> &VectTreeOut, const MexVector<IndexT, AlInds> &Indices = MexVector<IndexT>(0));
 	template<typename SubElemT, class Al>
 	inline void getVectTree(MexVector<SubElemT, Al> &VectTreeOut, uint32_t NIndices = 0, ...);
 
+	// View Functions
+	inline FlatVectTreeView<T, FVT_Al, IndexT> view() const;
+	inline FlatVectTreeView<T, FVT_Al, IndexT> view(uint32_t Level, IndexT LevelBeg, IndexT LevelEnd) const;
+
+	// Sharding and Parallel Leaf Functions
+	template<class Al>
+	inline void shard(MexVector<FlatVectTreeView<T, FVT_Al, IndexT>, Al> &ShardsOut, uint32_t NShards, uint32_t Level = uint32_t(-1)) const;
+	template<typename Func>
+	inline void parallel_for_each_leaf(Func LeafFunc) const;
+	template<typename TOut, class AlOut, typename Func>
+	inline void parallel_map_leaves(FlatVectTree<TOut, AlOut, IndexT> &FlatVectTreeOut, Func LeafFunc) const;
+
+	// Filter and Extract Functions
+	template<class AlInds>
+	inline void filter(uint32_t Level, const MexVector<IndexT, AlInds> &Indices);
+	template<class AlMask>
+	inline void filter(uint32_t Level, const MexVector<bool, AlMask> &Mask);
+	template<class Al, class AlInds>
+	inline void extract(FlatVectTree<T, Al, IndexT> &FlatVectTreeOut, uint32_t Level, const MexVector<IndexT, AlInds> &Indices) const;
+
+	// Compressed Index Functions
+	template<class Al>
+	inline void compressIndex(MexVector<CompressedIndex<IndexT, Al>, Al> &CompressedIndexOut) const;
+	template<class AlSub, class Al, class AlData>
+	inline void assign(const MexVector<CompressedIndex<IndexT, AlSub>, Al> &CompressedIndexIn, const MexVector<T, AlData> &DataIn);
+
 	// Release-Memory Functions
-	inline void releaseMem(MexVector<MexVector<uint32_t, FVT_Al>, FVT_Al> &ReleasedPartInds, MexVector<T, FVT_Al> &ReleasedData);
+	inline void releaseMem(MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> &ReleasedPartInds, MexVector<T, FVT_Al> &ReleasedData);
 
     // Property Access Functions
     inline uint32_t depth() const                  {
         return PartitionIndex.size();
     }
-	inline uint32_t LevelSize(uint32_t LevelIndex) {
+	inline IndexT   LevelSize(uint32_t LevelIndex) {
 		return PartitionIndex[LevelIndex].size() - 1;
 	}
 	inline bool     isempty() const                {
@@ -101,38 +219,68 @@ public:
 	inline bool     istrulyempty() const           {
 		return (this->depth() == 0);
 	}
+	inline bool     isvalidated() const            {
+		return isStructValidated;
+	}
+
+	// Validates a tree assigned from trusted input (the result is cached)
+	inline bool validate();
+
 	// Static Functions
 	template<class AlSub, class Al, class AlData>
-	static inline bool isValidFVT(const MexVector<MexVector<uint32_t, AlSub>, Al>& PartitionInds, const MexVector<T, AlData>& Data);
+	static inline bool isValidFVT(const MexVector<MexVector<IndexT, AlSub>, Al>& PartitionInds, const MexVector<T, AlData>& Data);
 };
 
 template <typename T, class Enable = void>
 struct isFlatVectTree { static constexpr bool value = false; };
-template <typename T, class Al>
-struct isFlatVectTree<FlatVectTree<T, Al>, typename std::enable_if<std::is_arithmetic<T>::value>::type> { 
+template <typename T, class Al, typename IndexT>
+struct isFlatVectTree<FlatVectTree<T, Al, IndexT>, typename std::enable_if<std::is_arithmetic<T>::value>::type> { 
 	static constexpr bool value = true; 
 	typedef T type;
+	typedef IndexT indexType;
 };
 
 template <typename T>
 struct FieldInfo<T, typename std::enable_if<isFlatVectTree<T>::value>::type> {
 	static inline bool CheckType(const mxArray* InputmxArray);
-	static inline uint32_t getSize(const mxArray* InputmxArray);
-	static inline uint32_t getDepth(const mxArray* InputmxArray);
+	static inline size_t getSize(const mxArray* InputmxArray);
+	static inline size_t getDepth(const mxArray* InputmxArray);
+	static inline bool isFlatCellArrayStruct(const mxArray* InputmxArray);
+	static inline bool CheckPartitionIndexType(const mxArray* PartitionIndexmxArr);
+	static inline bool CheckTypeAndAssign(const mxArray* InputmxArray, T &FlatVectTreeIn, bool isTrusted = false);
 	static inline void moveIntoVectors(const mxArray* InputmxArray, 
-		MexVector<MexVector<uint32_t> >   &PartitionIndexIn, 
-		MexVector<typename isFlatVectTree<T>::type> &Data);
+		MexVector<MexVector<typename isFlatVectTree<T>::indexType> > &PartitionIndexIn, 
+		MexVector<typename isFlatVectTree<T>::type> &Data,
+		bool CheckFieldTypes = true);
+	static inline void assignCellArrayLevels(
+		const MexVector<MexVector<const mxArray*> > &LevelNodes,
+		mxClassID LeafClass,
+		uint32_t Depth,
+		T &FlatVectTreeOut);
 };
 
-template <typename T> inline mxArrayPtr assignmxArray(FlatVectTree<T> &FlatVectTreeOut);
-template <typename T, class Al> static void getInputfrommxArray(const mxArray *InputArray, FlatVectTree<T, Al> &FlatVectTreeIn);
+template <typename T, typename IndexT> inline mxArrayPtr assignmxArray(FlatVectTree<T, mxAllocator, IndexT> &FlatVectTreeOut);
+template <typename IndexT, typename T> inline mxArrayPtr assignmxFlatCellArray(MexVector<MexVector<IndexT> > &PartitionIndex, MexVector<T> &Data);
+template <typename IndexT = uint32_t, typename T, class AlSub, class Al> inline mxArrayPtr assignmxFlatCellArray(MexVector<MexVector<T, AlSub>, Al> &VectTreeOut);
+template <typename T, class Al, typename IndexT> static bool getCheckedInputfrommxArray(const mxArray *InputArray, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, bool isTrusted = false);
+template <typename T, class Al, typename IndexT> static void getInputfrommxArray(const mxArray *InputArray, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn);
+inline bool getCellArrayLevels(const mxArray *CellArrayIn, MexVector<MexVector<const mxArray*> > &LevelNodes, mxClassID &LeafClass);
+inline size_t getCellArrayMaxLevelSize(const MexVector<MexVector<const mxArray*> > &LevelNodes);
+template <typename SrcT, typename T, typename IndexT> inline void copyCellArrayLeaves(const MexVector<const mxArray*> &Leaves, const IndexT* LeafOffsets, T* DataOut);
+template <typename T, class Al, typename IndexT> static bool getCheckedInputfromCellArray(const mxArray *CellArrayIn, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, uint32_t RequiredDepth);
+template <typename T, class Al, typename IndexT> static void getInputfromCellArray(const mxArray *CellArrayIn, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, uint32_t RequiredDepth);
+template <typename T, class Al, typename IndexT> inline mxArrayPtr assignmxCellArray(const FlatVectTreeView<T, Al, IndexT> &VectTreeView);
+template <typename T, class Al, typename IndexT> inline mxArrayPtr assignmxCellArray(const FlatVectTree<T, Al, IndexT> &FlatVectTreeOut);
 template <
 	typename TSpec,
 	typename T,
 	typename B=typename std::enable_if<std::is_same<T,TSpec>::value>::type,
-	class Al>
-static int getInputfromStruct(const mxArray *InputStruct, const char* FieldName, FlatVectTree<T, Al> &FlatVectTreeIn, uint32_t RequiredDepth, MexMemInputOps InputOps = MexMemInputOps());
+	class Al,
+	typename IndexT>
+static int getInputfromStruct(const mxArray *InputStruct, const char* FieldName, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, uint32_t RequiredDepth, MexMemInputOps InputOps = MexMemInputOps());
 
 #include "FlatVectTree.inl"
 #include "FlatVectTreeIO.inl"
+#include "FlatVectTreeBuilder.hpp"
+#include "StaticFlatVectTree.hpp"
 #endif
@@ -1,4 +1,6 @@
 #include <utility>
+#include <cstring>
+#include <algorithm>
 #include "FlatVectTree.hpp"
 
 typedef uint32_t T;
@@ -8,8 +10,8 @@ typedef std::enable_if< std::is_arithmetic<T>::value >::type B;
 // PRIVATE HELPER FUNCTIONS  ////////////////////
 /////////////////////////////////////////////////
 
-template<typename T, class FVT_Al, class B>
-uint32_t FlatVectTree<T, FVT_Al, B>::getAppendInsertDepth(uint32_t GivenInsertDepth, uint32_t AppendTreeDepth) const {
+template<typename T, class FVT_Al, typename IndexT, class B>
+uint32_t FlatVectTree<T, FVT_Al, IndexT, B>::getAppendInsertDepth(uint32_t GivenInsertDepth, uint32_t AppendTreeDepth) const {
 	// This function does the following:
 	//
 	// 1. Validates GivenInsertDepth in the context of AppendTreeDepth and CurrDepth.
@@ -54,8 +56,8 @@ uint32_t FlatVectTree<T, FVT_Al, B>::getAppendInsertDepth(uint32_t GivenInsertDe
 	return GivenInsertDepth;
 };
 
-template<typename T, class FVT_Al, class B>
-uint32_t FlatVectTree<T, FVT_Al, B>::getActualInsertDepth(uint32_t InsertDepth, uint32_t GivenDepth) const {
+template<typename T, class FVT_Al, typename IndexT, class B>
+uint32_t FlatVectTree<T, FVT_Al, IndexT, B>::getActualInsertDepth(uint32_t InsertDepth, uint32_t GivenDepth) const {
 
 	uint32_t CurrDepth = this->depth();
 
@@ -85,23 +87,41 @@ uint32_t FlatVectTree<T, FVT_Al, B>::getActualInsertDepth(uint32_t InsertDepth,
 /////////////////////////////////////////////////
 // ASSIGNMENT FUNCTIONS      ////////////////////
 /////////////////////////////////////////////////
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class AlSub, class Al, class AlData>
-inline void FlatVectTree<T, FVT_Al, B>::assign(const MexVector<MexVector<uint32_t, AlSub>, Al> &PartitionIndexIn, const MexVector<T, AlData> & DataIn, bool ActualCopy)
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::assignFast(const MexVector<MexVector<IndexT, AlSub>, Al> &PartitionIndexIn, const MexVector<T, AlData> & DataIn, bool ActualCopy, bool isValidated)
 {
-	if (FlatVectTree<T>::isValidFVT(PartitionIndexIn, DataIn)) {
-		if (ActualCopy) {
-			PartitionIndex = PartitionIndexIn;
-			Data = DataIn;
-		}
-		else {
-			uint32_t TreeDepth = PartitionIndexIn.size();
-			PartitionIndex.resize(TreeDepth);
-			for (uint32_t i = 0; i < TreeDepth; ++i) {
-				PartitionIndex[i].assign(PartitionIndexIn[i].size(), PartitionIndexIn[i].begin(), false);
-			}
-			Data.assign(DataIn.size(), DataIn.begin(), false);
+	// This function performs the assignment without validating PartitionIndexIn
+	// and DataIn. It is to be used only when the validity has already been
+	// established (see assign and FieldInfo<FlatVectTree>::CheckTypeAndAssign)
+	// or when the input is trusted, in which case isValidated must be false
+
+	if (ActualCopy) {
+		PartitionIndex = PartitionIndexIn;
+		Data = DataIn;
+	}
+	else {
+		uint32_t TreeDepth = PartitionIndexIn.size();
+		PartitionIndex.resize(TreeDepth);
+		for (uint32_t i = 0; i < TreeDepth; ++i) {
+			PartitionIndex[i].assign(PartitionIndexIn[i].size(), PartitionIndexIn[i].begin(), false);
 		}
+		Data.assign(DataIn.size(), DataIn.begin(), false);
+	}
+	isStructValidated = isValidated;
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlSub, class Al, class AlData>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::assign(const MexVector<MexVector<IndexT, AlSub>, Al> &PartitionIndexIn, const MexVector<T, AlData> & DataIn, bool ActualCopy, bool isTrusted)
+{
+	// If isTrusted is true, the validation is deferred (see validate). This
+	// is intended for hot paths whose input was produced by this library.
+	if (isTrusted) {
+		assignFast(PartitionIndexIn, DataIn, ActualCopy, false);
+	}
+	else if (isValidFVT(PartitionIndexIn, DataIn)) {
+		assignFast(PartitionIndexIn, DataIn, ActualCopy);
 	}
 	else {
 		WriteException(
@@ -112,9 +132,9 @@ inline void FlatVectTree<T, FVT_Al, B>::assign(const MexVector<MexVector<uint32_
 
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class FVT_Al2>
-inline void FlatVectTree<T, FVT_Al, B>::assign(const FlatVectTree<T, FVT_Al2> &FlatVectTreeIn, bool ActualCopy)
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::assign(const FlatVectTree<T, FVT_Al2, IndexT> &FlatVectTreeIn, bool ActualCopy)
 {
 	if (ActualCopy) {
 		PartitionIndex = FlatVectTreeIn.PartitionIndex;
@@ -128,6 +148,381 @@ inline void FlatVectTree<T, FVT_Al, B>::assign(const FlatVectTree<T, FVT_Al2> &F
 		}
 		Data.assign(FlatVectTreeIn.Data.size(), FlatVectTreeIn.Data.begin(), false);
 	}
+	isStructValidated = FlatVectTreeIn.isStructValidated;
+}
+
+/////////////////////////////////////////////////
+// BULK CONSTRUCTION FUNCTIONS //////////////////
+/////////////////////////////////////////////////
+
+// Build Level Functions
+// =====================
+//
+// These functions flatten a nested MexVector into PartitionIndexOut and
+// DataOut one level at a time. The nodes of the given level are the elements
+// of the vectors pointed to by Parents (in order) i.e. the nodes of the
+// previous level, and ParentOffsets[k] is the position of the first element
+// of Parents[k] in the current level. Each level is built in three passes:
+//
+// 1. The sizes of all the nodes of the level are written to PartitionIndex
+//    (in parallel over the parents).
+// 2. The inclusive prefix sum of the sizes gives the offsets of the children
+//    of each node in the next level.
+// 3. For the lowest level, the leaf vectors are scattered into DataOut at the
+//    offsets computed above. For higher levels, the nodes become the parents
+//    of the next level.
+//
+// Each level (and DataOut) is thus allocated exactly once. The size of each
+// level is also summed in int64_t in pass 1, so that a level (or DataOut)
+// too large for IndexT is rejected before the prefix sum would wrap around.
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::checkBuildLevelSize(uint64_t LevelSize, uint32_t Level) {
+	if (LevelSize > uint64_t(std::numeric_limits<IndexT>::max()))
+		WriteException(
+			FV_ExCodes::FV_INVALID_APPEND,
+			"The size of level %d of the tree being built (%llu) exceeds the range of the index type",
+			Level, (unsigned long long)LevelSize
+		);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlLeaf, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::buildLevels(
+	const MexVector<const MexVector<MexVector<T, AlLeaf>, Al>*> &Parents,
+	const IndexT* ParentOffsets,
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> &PartitionIndexOut,
+	uint32_t Level,
+	MexVector<T, FVT_Al> &DataOut) {
+
+	/*
+	    Template specialization (recursion termination step) for buildLevels
+	    i.e. the nodes of this level are leaf vectors.
+	*/
+
+	MexVector<IndexT, FVT_Al> &CurrLevelIndex = PartitionIndexOut[Level];
+	int64_t NParents = Parents.size();
+	int64_t NNodes = ParentOffsets[NParents];
+
+	CurrLevelIndex.resize(NNodes + 1);
+	CurrLevelIndex[0] = 0;
+	int64_t NextLevelSize = 0;
+	#pragma omp parallel for schedule(dynamic, 16) reduction(+:NextLevelSize) if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t k = 0; k < NParents; ++k) {
+		const MexVector<MexVector<T, AlLeaf>, Al> &CurrParent = *Parents[k];
+		IndexT* CurrSizes = CurrLevelIndex.begin() + ParentOffsets[k] + 1;
+		size_t NChildren = CurrParent.size();
+		for (size_t j = 0; j < NChildren; ++j) {
+			CurrSizes[j] = IndexT(CurrParent[j].size());
+			NextLevelSize += CurrParent[j].size();
+		}
+	}
+	checkBuildLevelSize(NextLevelSize, Level + 1);
+	InclusivePrefixSum(CurrLevelIndex.begin() + 1, NNodes);
+
+	DataOut.resize(CurrLevelIndex.last());
+	#pragma omp parallel for schedule(dynamic, 16) if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t k = 0; k < NParents; ++k) {
+		const MexVector<MexVector<T, AlLeaf>, Al> &CurrParent = *Parents[k];
+		const IndexT* CurrOffsets = CurrLevelIndex.begin() + ParentOffsets[k];
+		size_t NChildren = CurrParent.size();
+		for (size_t j = 0; j < NChildren; ++j) {
+			// Leaves are typically small, an inlined loop outperforms memcpy
+			const T* LeafBeg = CurrParent[j].begin();
+			size_t LeafSize = CurrParent[j].size();
+			T* DataPtr = DataOut.begin() + CurrOffsets[j];
+			for (size_t i = 0; i < LeafSize; ++i)
+				DataPtr[i] = LeafBeg[i];
+		}
+	}
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename SubElemT, class AlSub, class AlNode, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::buildLevels(
+	const MexVector<const MexVector<MexVector<MexVector<SubElemT, AlSub>, AlNode>, Al>*> &Parents,
+	const IndexT* ParentOffsets,
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> &PartitionIndexOut,
+	uint32_t Level,
+	MexVector<T, FVT_Al> &DataOut) {
+
+	MexVector<IndexT, FVT_Al> &CurrLevelIndex = PartitionIndexOut[Level];
+	int64_t NParents = Parents.size();
+	int64_t NNodes = ParentOffsets[NParents];
+
+	CurrLevelIndex.resize(NNodes + 1);
+	CurrLevelIndex[0] = 0;
+	int64_t NextLevelSize = 0;
+	#pragma omp parallel for schedule(dynamic, 16) reduction(+:NextLevelSize) if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t k = 0; k < NParents; ++k) {
+		const MexVector<MexVector<MexVector<SubElemT, AlSub>, AlNode>, Al> &CurrParent = *Parents[k];
+		IndexT* CurrSizes = CurrLevelIndex.begin() + ParentOffsets[k] + 1;
+		size_t NChildren = CurrParent.size();
+		for (size_t j = 0; j < NChildren; ++j) {
+			CurrSizes[j] = IndexT(CurrParent[j].size());
+			NextLevelSize += CurrParent[j].size();
+		}
+	}
+	checkBuildLevelSize(NextLevelSize, Level + 1);
+	InclusivePrefixSum(CurrLevelIndex.begin() + 1, NNodes);
+
+	// The nodes of this level are the parents of the next level
+	MexVector<const MexVector<MexVector<SubElemT, AlSub>, AlNode>*> NextParents(NNodes);
+	#pragma omp parallel for schedule(dynamic, 16) if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t k = 0; k < NParents; ++k) {
+		const MexVector<MexVector<MexVector<SubElemT, AlSub>, AlNode>, Al> &CurrParent = *Parents[k];
+		const MexVector<MexVector<SubElemT, AlSub>, AlNode>** CurrNodePtrs = NextParents.begin() + ParentOffsets[k];
+		size_t NChildren = CurrParent.size();
+		for (size_t j = 0; j < NChildren; ++j) {
+			CurrNodePtrs[j] = &CurrParent[j];
+		}
+	}
+
+	buildLevels(NextParents, CurrLevelIndex.begin(), PartitionIndexOut, Level + 1, DataOut);
+}
+
+// Move Leaf Functions
+// ===================
+//
+// These move the given leaf vector into DataOut. The array is taken over if
+// the allocators match and VectIn owns its memory. Otherwise it is copied.
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::moveLeafData(MexVector<T, FVT_Al> &DataOut, MexVector<T, FVT_Al> &VectIn) {
+	if (!VectIn.ismemext())
+		DataOut.swap(VectIn);
+	else
+		DataOut = VectIn;
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::moveLeafData(MexVector<T, FVT_Al> &DataOut, MexVector<T, Al> &VectIn) {
+	DataOut = VectIn;
+}
+
+// Build Functions
+// ===============
+//
+// build replaces the contents of the FlatVectTree with the given nested
+// MexVector, the depth becoming that of the nested MexVector. Unlike append,
+// which grows Data and PartitionIndex one element at a time, build computes
+// the size of every level beforehand and fills the levels in parallel (see
+// buildLevels), allocating each array exactly once. The new arrays replace
+// the current ones only after they are completely built.
+
+// ## Copy Versions ##
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::build(const MexVector<T, Al> &VectIn) {
+
+	/*
+	    Template specialization for a tree of depth 0 (a single leaf vector)
+	*/
+
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex;
+	MexVector<T, FVT_Al> NewData(VectIn);
+
+	PartitionIndex.swap(NewPartitionIndex);
+	Data.swap(NewData);
+	isStructValidated = true;
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename SubElemT, class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::build(const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeIn) {
+
+	uint32_t GivenDepth = getTreeInfo<MexVector<MexVector<SubElemT, AlSub>, Al> >::depth;
+
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(GivenDepth);
+	MexVector<T, FVT_Al> NewData;
+
+	// VectTreeIn is the sole parent of the top level
+	checkBuildLevelSize(VectTreeIn.size(), 0);
+	MexVector<const MexVector<MexVector<SubElemT, AlSub>, Al>*> RootParent(1, &VectTreeIn);
+	IndexT RootOffsets[2] = { 0, IndexT(VectTreeIn.size()) };
+	buildLevels(RootParent, RootOffsets, NewPartitionIndex, 0, NewData);
+
+	PartitionIndex.swap(NewPartitionIndex);
+	Data.swap(NewData);
+	isStructValidated = true;
+}
+
+// ## Move Versions ##
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::build(MexVector<T, Al> &&VectIn) {
+
+	/*
+	    Template specialization for a tree of depth 0. Here, the array of
+	    VectIn is taken over by Data if possible (see moveLeafData)
+	*/
+
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex;
+	MexVector<T, FVT_Al> NewData;
+	moveLeafData(NewData, VectIn);
+
+	PartitionIndex.swap(NewPartitionIndex);
+	Data.swap(NewData);
+	isStructValidated = true;
+
+	// Deallocating VectIn
+	MexVector<T, Al> EmptyVect;
+	VectIn.swap(EmptyVect);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename SubElemT, class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::build(MexVector<MexVector<SubElemT, AlSub>, Al> &&VectTreeIn) {
+
+	// The leaf vectors are necessarily copied as Data is contiguous. The
+	// memory of VectTreeIn is released once the build is complete.
+	this->build(static_cast<const MexVector<MexVector<SubElemT, AlSub>, Al> &>(VectTreeIn));
+
+	// Deallocating VectTreeIn
+	MexVector<MexVector<SubElemT, AlSub>, Al> EmptyVectTree;
+	VectTreeIn.swap(EmptyVectTree);
+}
+
+// Group-By Function
+// =================
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename KeyT, class AlKeys, class AlVals>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::group_by(
+	const MexVector<KeyT, AlKeys> &Keys,
+	const MexVector<T, AlVals> &Values,
+	IndexT NGroups,
+	bool SortGroups)
+{
+	/*
+	   This function replaces the contents of the FlatVectTree with the tree of
+	   depth 1 whose leaf k contains the values Values[i] with Keys[i] == k, in
+	   the order in which they appear in Values (sorted if SortGroups is true).
+	   NGroups defaults to the maximum key + 1. This is a counting sort:
+
+	   1. Values are split into blocks (one per thread) and the number of
+	      occurrences of each key in each block is counted.
+	   2. The group offsets (PartitionIndex[0]) are the prefix sum of the
+	      counts, and each block writes into group k starting after the values
+	      of group k in the previous blocks.
+	   3. Each block scatters its values to these offsets, in order.
+
+	   Apart from the counts, only PartitionIndex[0] and Data are allocated.
+	   The counts take NBlocks*NGroups indices, so fewer blocks are used when
+	   there are many more groups than values. The result can be returned to
+	   MATLAB directly as a FlatCellArray (see assignmxArray).
+	*/
+
+	static_assert(std::is_integral<KeyT>::value, "The keys must be of an integral type");
+
+	size_t NValues = Values.size();
+	if (Keys.size() != NValues)
+		WriteException(
+			FV_ExCodes::FV_INVALID_GROUP,
+			"The number of keys (%llu) must be equal to the number of values (%llu)",
+			(unsigned long long)Keys.size(), (unsigned long long)NValues
+		);
+	if (NValues >= size_t(std::numeric_limits<IndexT>::max()))
+		WriteException(
+			FV_ExCodes::FV_INVALID_GROUP,
+			"The number of values (%llu) exceeds the range of the index type",
+			(unsigned long long)NValues
+		);
+
+	int NBlocks = (NValues >= MEXMEM_PARALLEL_THRESHOLD) ? getMaxThreads() : 1;
+
+	// Calculating the maximum key of each block. Negative keys become very
+	// large when cast to uint64_t and are rejected below.
+	MexVector<uint64_t> BlockMaxKeys(NBlocks, uint64_t(0));
+	#pragma omp parallel for schedule(static, 1) if(NBlocks > 1)
+	for (int b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = NValues*b/NBlocks, BlockEnd = NValues*(b + 1)/NBlocks;
+		uint64_t MaxKey = 0;
+		for (size_t i = BlockBeg; i < BlockEnd; ++i)
+			MaxKey = (uint64_t(Keys[i]) > MaxKey) ? uint64_t(Keys[i]) : MaxKey;
+		BlockMaxKeys[b] = MaxKey;
+	}
+	uint64_t MaxKey = *std::max_element(BlockMaxKeys.begin(), BlockMaxKeys.end());
+
+	if (NGroups == IndexT(-1)) {
+		if (NValues > 0 && MaxKey >= uint64_t(std::numeric_limits<IndexT>::max()))
+			WriteException(
+				FV_ExCodes::FV_INVALID_GROUP,
+				"The keys must be non-negative and less than %llu",
+				(unsigned long long)std::numeric_limits<IndexT>::max()
+			);
+		NGroups = (NValues > 0) ? IndexT(MaxKey + 1) : 0;
+	}
+	else if (NValues > 0 && MaxKey >= NGroups) {
+		WriteException(
+			FV_ExCodes::FV_INVALID_GROUP,
+			"The keys must be non-negative and less than the number of groups (%llu)",
+			(unsigned long long)NGroups
+		);
+	}
+
+	// Limiting the size of the counts to about twice the number of values
+	size_t MaxCountBlocks = (NGroups > 0) ? 2*NValues/NGroups : NBlocks;
+	int NCountBlocks = (MaxCountBlocks < size_t(NBlocks)) ? int(MaxCountBlocks) : NBlocks;
+	NCountBlocks = (NCountBlocks > 0) ? NCountBlocks : 1;
+
+	MexVector<IndexT> BlockCounts(size_t(NCountBlocks)*NGroups, IndexT(0));
+	MexVector<IndexT, FVT_Al> NewOffsets(size_t(NGroups) + 1);
+	MexVector<T, FVT_Al> NewData(NValues);
+
+	// Counting the keys in each block
+	#pragma omp parallel for schedule(static, 1) if(NCountBlocks > 1)
+	for (int b = 0; b < NCountBlocks; ++b) {
+		size_t BlockBeg = NValues*b/NCountBlocks, BlockEnd = NValues*(b + 1)/NCountBlocks;
+		IndexT* Counts = BlockCounts.begin() + size_t(NGroups)*b;
+		for (size_t i = BlockBeg; i < BlockEnd; ++i)
+			++Counts[Keys[i]];
+	}
+
+	// Calculating the offset of each block within each group and the size of
+	// each group, followed by the group offsets
+	int64_t NGroupsSigned = NGroups;
+	NewOffsets[0] = 0;
+	#pragma omp parallel for if(NGroupsSigned >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t k = 0; k < NGroupsSigned; ++k) {
+		IndexT RunningCount = 0;
+		for (int b = 0; b < NCountBlocks; ++b) {
+			IndexT &Count = BlockCounts[size_t(NGroups)*b + k];
+			IndexT BlockCount = Count;
+			Count = RunningCount;
+			RunningCount += BlockCount;
+		}
+		NewOffsets[k + 1] = RunningCount;
+	}
+	InclusivePrefixSum(NewOffsets.begin() + 1, NGroups);
+
+	// Scattering the values (stable within each block, and the blocks are
+	// placed in order)
+	#pragma omp parallel for schedule(static, 1) if(NCountBlocks > 1)
+	for (int b = 0; b < NCountBlocks; ++b) {
+		size_t BlockBeg = NValues*b/NCountBlocks, BlockEnd = NValues*(b + 1)/NCountBlocks;
+		IndexT* Cursors = BlockCounts.begin() + size_t(NGroups)*b;
+		for (size_t i = BlockBeg; i < BlockEnd; ++i) {
+			KeyT Key = Keys[i];
+			NewData[NewOffsets[Key] + Cursors[Key]++] = Values[i];
+		}
+	}
+
+	// Sorting within each group
+	if (SortGroups) {
+		#pragma omp parallel for schedule(dynamic, 256) if(NBlocks > 1)
+		for (int64_t k = 0; k < NGroupsSigned; ++k) {
+			std::sort(NewData.begin() + NewOffsets[k], NewData.begin() + NewOffsets[k + 1]);
+		}
+	}
+
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(1);
+	NewPartitionIndex[0].swap(NewOffsets);
+
+	PartitionIndex.swap(NewPartitionIndex);
+	Data.swap(NewData);
+	isStructValidated = true;
 }
 
 /////////////////////////////////////////////////
@@ -138,24 +533,24 @@ inline void FlatVectTree<T, FVT_Al, B>::assign(const FlatVectTree<T, FVT_Al2> &F
 // =====================
 
 // ## Copy Versions ##
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class Al>
-inline void FlatVectTree<T, FVT_Al, B>::appendFast(const MexVector<T, Al> &VectIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::appendFast(const MexVector<T, Al> &VectIn) {
 
 	/*
 	    Template specialization (recursion termination step) for appendFast
 	*/
 
-	uint32_t OldSize = this->Data.size();
-	uint32_t NElems = VectIn.size();
+	size_t OldSize = this->Data.size();
+	size_t NElems = VectIn.size();
 	this->Data.push_size(NElems);
 	this->Data.copyArray(OldSize, VectIn.begin(), NElems);
 
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class AlSub, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::appendFast(const MexVector<MexVector<SubElemT, AlSub>, Al > &VectTreeIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::appendFast(const MexVector<MexVector<SubElemT, AlSub>, Al > &VectTreeIn) {
 	/*
 	   AppendFast simply appends the given Tree to its required height without
 	   doing any for of validations, default calculations. it also does not edit 
@@ -169,31 +564,31 @@ inline void FlatVectTree<T, FVT_Al, B>::appendFast(const MexVector<MexVector<Sub
 	uint32_t NElems      = VectTreeIn.size();
 	
 	for (uint32_t i = 0; i < NElems; ++i) {
-		uint32_t NSubElems = VectTreeIn[i].size();
+		size_t NSubElems = VectTreeIn[i].size();
 		appendFast(VectTreeIn[i]);
 		PartitionIndex[InsertDepth].push_back(PartitionIndex[InsertDepth].last() + NSubElems);
 	}
 }
 
 // ## Move Versions ##
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class Al>
-inline void FlatVectTree<T, FVT_Al, B>::appendFast(MexVector<T, Al> &&VectIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::appendFast(MexVector<T, Al> &&VectIn) {
 	/*
 	   Template specialization (recursion termination step) for appendFast move version
 	*/
 
-	uint32_t OldSize = this->Data.size();
-	uint32_t NElems = VectIn.size();
+	size_t OldSize = this->Data.size();
+	size_t NElems = VectIn.size();
 	this->Data.push_size(NElems);
 	this->Data.copyArray(OldSize, VectIn.begin(), NElems);
 	VectIn.clear();
 	VectIn.trim();
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class AlSub, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::appendFast(MexVector<MexVector<SubElemT, AlSub>, Al > &&VectTreeIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::appendFast(MexVector<MexVector<SubElemT, AlSub>, Al > &&VectTreeIn) {
 	/*
 	AppendFast simply appends the given Tree to its required height without
 	doing any for of validations, default calculations. it also does not edit
@@ -207,7 +602,7 @@ inline void FlatVectTree<T, FVT_Al, B>::appendFast(MexVector<MexVector<SubElemT,
 	uint32_t NElems = VectTreeIn.size();
 
 	for (uint32_t i = 0; i < NElems; ++i) {
-		uint32_t NSubElems = VectTreeIn[i].size();
+		size_t NSubElems = VectTreeIn[i].size();
 		appendFast(VectTreeIn[i]);
 		PartitionIndex[InsertDepth].push_back(PartitionIndex[InsertDepth].last() + NSubElems);
 	}
@@ -217,11 +612,40 @@ inline void FlatVectTree<T, FVT_Al, B>::appendFast(MexVector<MexVector<SubElemT,
 	VectTreeIn.trim();
 }
 
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::linkAppendedTree(uint32_t CurrDepth, uint32_t GivenDepth, uint32_t ActualInsertDepth) {
+
+	// Completes an append once the levels of the appended tree (of depth
+	// GivenDepth) have been appended to the bottom levels of this FVT.
+
+	// If The vector is inserted on a Level higher than CurrDepth - GivenDepth
+	// then an additional entry needs to be made for all the levels from the
+	// CurrDepth - GivenDepth - 1 to the ActualInsertDepth.
+	if (ActualInsertDepth < CurrDepth - GivenDepth) {
+		if (GivenDepth == 0)
+			PartitionIndex[CurrDepth - 1].push_back(Data.size());
+		else
+			PartitionIndex[CurrDepth - GivenDepth - 1].push_back(PartitionIndex[CurrDepth - GivenDepth].size() - 1);
+
+		for (uint32_t i = CurrDepth - GivenDepth - 1; i --> ActualInsertDepth ;) {
+			PartitionIndex[i].push_back(PartitionIndex[i + 1].size() - 1); // Discounting BTE Element
+		}
+	}
+
+	// The Beyond-The_End element for the level above the insert
+	// level needs to be updated (assuming Such a level exists)
+	if (ActualInsertDepth > 0 && ActualInsertDepth != CurrDepth)
+		PartitionIndex[ActualInsertDepth - 1].last() = PartitionIndex[ActualInsertDepth].size() - 1;
+	else if (ActualInsertDepth > 0 && ActualInsertDepth == CurrDepth) {
+		PartitionIndex[ActualInsertDepth - 1].last() = Data.size();
+	}
+}
+
 // Actual Append Functions
 // =======================
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::append(const MexVector<SubElemT, Al> &VectTreeIn, uint32_t InsertDepth) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append(const MexVector<SubElemT, Al> &VectTreeIn, uint32_t InsertDepth) {
 	/* 
 	   This function appends the given MexVectIn at the specified InsertDepth
 	   
@@ -303,37 +727,18 @@ inline void FlatVectTree<T, FVT_Al, B>::append(const MexVector<SubElemT, Al> &Ve
 	// Initialize FVT if empty
 	if (this->istrulyempty()) {
 		this->setDepth(InsertDepth + GivenDepth);
+		CurrDepth = InsertDepth + GivenDepth;
 	}
 
 	// Perform Fast Append
 	appendFast(VectTreeIn);
 
-	// If The vector is inserted on a Level higher than CurrDepth - GivenDepth
-	// then an additional entry needs to be made for all the levels from the 
-	// CurrDepth - GivenDepth - 1 to the ActualInsertDepth.
-	if (ActualInsertDepth < CurrDepth - GivenDepth) {
-		if (GivenDepth == 0)
-			PartitionIndex[CurrDepth - 1].push_back(Data.size());
-		else
-			PartitionIndex[CurrDepth - GivenDepth - 1].push_back(PartitionIndex[CurrDepth - GivenDepth].size() - 1);
-		
-		for (uint32_t i = CurrDepth - GivenDepth - 1; i --> ActualInsertDepth ;) {
-			PartitionIndex[i].push_back(PartitionIndex[i + 1].size() - 1); // Discounting BTE Element
-		}
-	}
-	
-	// The Beyond-The_End element for the level above the insert 
-	// level needs to be updated (assuming Such a level exists)
-	if (ActualInsertDepth > 0 && ActualInsertDepth != CurrDepth)
-		PartitionIndex[ActualInsertDepth - 1].last() = PartitionIndex[ActualInsertDepth].size() - 1;
-	else if (ActualInsertDepth > 0 && ActualInsertDepth == CurrDepth) {
-		PartitionIndex[ActualInsertDepth - 1].last() = Data.size();
-	}
+	linkAppendedTree(CurrDepth, GivenDepth, ActualInsertDepth);
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::append(MexVector<SubElemT, Al> &&VectTreeIn, uint32_t InsertDepth) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append(MexVector<SubElemT, Al> &&VectTreeIn, uint32_t InsertDepth) {
 	/* 
 	   This function appends the given MexVectIn at the specified InsertDepth
 	   
@@ -415,37 +820,18 @@ inline void FlatVectTree<T, FVT_Al, B>::append(MexVector<SubElemT, Al> &&VectTre
 	// Initialize FVT if empty
 	if (this->istrulyempty()) {
 		this->setDepth(InsertDepth + GivenDepth);
+		CurrDepth = InsertDepth + GivenDepth;
 	}
 
 	// Perform Fast Append
 	appendFast(std::move(VectTreeIn));
 
-	// If The vector is inserted on a Level higher than CurrDepth - GivenDepth
-	// then an additional entry needs to be made for all the levels from the
-	// CurrDepth - GivenDepth - 1 to the ActualInsertDepth.
-	if (ActualInsertDepth < CurrDepth - GivenDepth) {
-		if (GivenDepth == 0)
-			PartitionIndex[CurrDepth - 1].push_back(Data.size());
-		else
-			PartitionIndex[CurrDepth - GivenDepth - 1].push_back(PartitionIndex[CurrDepth - GivenDepth].size() - 1);
-
-		for (uint32_t i = CurrDepth - GivenDepth - 1; i --> ActualInsertDepth ;) {
-			PartitionIndex[i].push_back(PartitionIndex[i + 1].size() - 1); // Discounting BTE Element
-		}
-	}
-
-	// The Beyond-The_End element for the level above the insert 
-	// level needs to be updated (assuming Such a level exists)
-	if (ActualInsertDepth > 0 && ActualInsertDepth != CurrDepth)
-		PartitionIndex[ActualInsertDepth - 1].last() = PartitionIndex[ActualInsertDepth].size() - 1;
-	else if (ActualInsertDepth > 0 && ActualInsertDepth == CurrDepth) {
-		PartitionIndex[ActualInsertDepth - 1].last() = Data.size();
-	}
+	linkAppendedTree(CurrDepth, GivenDepth, ActualInsertDepth);
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class Al>
-inline void FlatVectTree<T, FVT_Al, B>::append(const FlatVectTree<T, Al> &VectTreeIn, uint32_t InsertDepth) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append(const FlatVectTree<T, Al, IndexT> &VectTreeIn, uint32_t InsertDepth) {
 	/*
 	 * This function is used to append a FlatVectTree instead of a VectVect.
 	 * The semantics of this operation are identical to the other append functions
@@ -464,49 +850,268 @@ inline void FlatVectTree<T, FVT_Al, B>::append(const FlatVectTree<T, Al> &VectTr
 		CurrDepth = InsertDepth + GivenDepth;
 	}
 
-	// Perform Fast Append
+	// Perform Fast Append. Each level is grown once and the offsets of
+	// VectTreeIn are rebased onto the last element of the level
 	for(uint32_t i=0; i<GivenDepth; ++i) {
 		auto &CurrentFVTPartition = PartitionIndex[CurrDepth - GivenDepth + i];
 		auto &AppendFVTPartition = VectTreeIn.PartitionIndex[i];
-		auto CurrPartitionLastIndex = PartitionIndex[CurrDepth - GivenDepth + i].last();
+		IndexT CurrPartitionLastIndex = CurrentFVTPartition.last();
 		// Ignore the first element of AppendFVTPartition as hat corresponds to
 		// the BLE of CurrentFVTPartition
-		for(uint32_t j=1; j < AppendFVTPartition.size(); ++j) {
-			CurrentFVTPartition.push_back(CurrPartitionLastIndex + AppendFVTPartition[j]);
+		size_t OldSize = CurrentFVTPartition.size();
+		size_t NAppended = AppendFVTPartition.size() - 1;
+		CurrentFVTPartition.push_size(NAppended);
+		IndexT* DestIter = CurrentFVTPartition.begin() + OldSize;
+		const IndexT* SrcIter = AppendFVTPartition.begin() + 1;
+		for(size_t j=0; j < NAppended; ++j) {
+			DestIter[j] = CurrPartitionLastIndex + SrcIter[j];
 		}
 	}
-	Data.insert(Data.size(), VectTreeIn.Data);
+	size_t OldDataSize = Data.size();
+	Data.push_size(VectTreeIn.Data.size());
+	Data.copyArray(OldDataSize, VectTreeIn.Data.begin(), VectTreeIn.Data.size());
+	isStructValidated = isStructValidated && VectTreeIn.isStructValidated;
 
-	// If The vector is inserted on a Level higher than CurrDepth - GivenDepth
-	// then an additional entry needs to be made for all the levels from the
-	// CurrDepth - GivenDepth - 1 to the ActualInsertDepth.
-	if (ActualInsertDepth < CurrDepth - GivenDepth) {
-		if (GivenDepth == 0)
-			PartitionIndex[CurrDepth - 1].push_back(Data.size());
-		else
-			PartitionIndex[CurrDepth - GivenDepth - 1].push_back(PartitionIndex[CurrDepth - GivenDepth].size() - 1);
+	linkAppendedTree(CurrDepth, GivenDepth, ActualInsertDepth);
+}
 
-		for (uint32_t i = CurrDepth - GivenDepth - 1; i --> ActualInsertDepth ;) {
-			PartitionIndex[i].push_back(PartitionIndex[i + 1].size() - 1); // Discounting BTE Element
-		}
+// Batch Append Functions
+// ======================
+
+// ## Helper Functions ##
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::addLevelSizes(const MexVector<T, Al> &VectIn, size_t* LevelSizes) {
+	LevelSizes[0] += VectIn.size();
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename SubElemT, class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::addLevelSizes(const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeIn, size_t* LevelSizes) {
+
+	// Adds to LevelSizes[L] the number of elements in level L of VectTreeIn
+	// (the last entry being the number of elements of Data)
+
+	LevelSizes[0] += VectTreeIn.size();
+	for (auto &SubTree : VectTreeIn) {
+		addLevelSizes(SubTree, LevelSizes + 1);
 	}
+}
 
-	// The Beyond-The_End element for the level above the insert
-	// level needs to be updated (assuming Such a level exists)
-	if (ActualInsertDepth > 0 && ActualInsertDepth != CurrDepth)
-		PartitionIndex[ActualInsertDepth - 1].last() = PartitionIndex[ActualInsertDepth].size() - 1;
-	else if (ActualInsertDepth > 0 && ActualInsertDepth == CurrDepth) {
-		PartitionIndex[ActualInsertDepth - 1].last() = Data.size();
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline uint32_t FlatVectTree<T, FVT_Al, IndexT, B>::initBatchAppend(uint32_t InsertDepth, uint32_t GivenDepth) {
+
+	// Validates InsertDepth for the first tree of the batch and initializes
+	// the depth of the FVT if it is empty (as the first append would). The
+	// batch cannot grow trees wrapping external memory.
+
+	for (auto &Level : PartitionIndex) {
+		if (Level.ismemext())
+			throw ExOps::EXCEPTION_EXTMEM_MOD;
+	}
+	if (Data.ismemext())
+		throw ExOps::EXCEPTION_EXTMEM_MOD;
+
+	InsertDepth = getAppendInsertDepth(InsertDepth, GivenDepth);
+	if (this->istrulyempty()) {
+		this->setDepth(InsertDepth + GivenDepth);
+	}
+	return this->depth();
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::reserveBatchAppend(const MexVector<size_t> &ExtraLevelSizes) {
+
+	// ExtraLevelSizes[L] is (an upper bound of) the number of elements that
+	// will be appended to level L, ExtraLevelSizes[depth()] being that of Data
+
+	uint32_t CurrDepth = this->depth();
+	for (uint32_t i = 0; i < CurrDepth; ++i) {
+		PartitionIndex[i].reserve(PartitionIndex[i].size() + ExtraLevelSizes[i]);
+	}
+	Data.reserve(Data.size() + ExtraLevelSizes[CurrDepth]);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline bool FlatVectTree<T, FVT_Al, IndexT, B>::takeOverTree(FlatVectTree<T, FVT_Al, IndexT> &VectTreeIn) {
+
+	// Takes over the arrays of VectTreeIn if this is truly empty (in which
+	// case appending VectTreeIn at InsertDepth 0 results in a copy of it).
+	// External memory cannot be taken over.
+
+	if (!this->istrulyempty() || VectTreeIn.Data.ismemext())
+		return false;
+	for (auto &Level : VectTreeIn.PartitionIndex) {
+		if (Level.ismemext())
+			return false;
 	}
+
+	PartitionIndex.swap(VectTreeIn.PartitionIndex);
+	Data.swap(VectTreeIn.Data);
+	isStructValidated = VectTreeIn.isStructValidated;
+	return true;
+}
+
+// ## Copy Versions ##
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename SubElemT, class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append_batch(const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreesIn, uint32_t InsertDepth) {
+	/*
+	   This function appends each of the trees in VectTreesIn (in order) at
+	   InsertDepth. The result is identical to that of calling
+
+	     append(VectTreesIn[i], InsertDepth)
+
+	   for each i. However, the number of elements added to each level is
+	   counted beforehand, so that each level (and Data) is reallocated at
+	   most once for the entire batch.
+	*/
+
+	size_t NTrees = VectTreesIn.size();
+	if (NTrees == 0)
+		return;
+
+	uint32_t GivenDepth = getTreeInfo<MexVector<SubElemT, AlSub> >::depth;
+	uint32_t CurrDepth = initBatchAppend(InsertDepth, GivenDepth);
+
+	// Each append adds at most one element to each level above the top
+	// level of the appended tree
+	MexVector<size_t> ExtraLevelSizes(CurrDepth + 1, size_t(0));
+	for (size_t i = 0; i < CurrDepth - GivenDepth; ++i)
+		ExtraLevelSizes[i] = NTrees;
+	for (auto &VectTree : VectTreesIn)
+		addLevelSizes(VectTree, ExtraLevelSizes.begin() + CurrDepth - GivenDepth);
+	reserveBatchAppend(ExtraLevelSizes);
+
+	// The insert depth is resolved once for the batch. The actual insert
+	// depth is still found for each tree, as it depends on whether the
+	// previous tree left the last branch above InsertDepth empty (it costs
+	// O(InsertDepth) per tree).
+	InsertDepth = getAppendInsertDepth(InsertDepth, GivenDepth);
+	for (auto &VectTree : VectTreesIn) {
+		uint32_t ActualInsertDepth = getActualInsertDepth(InsertDepth, GivenDepth);
+		appendFast(VectTree);
+		linkAppendedTree(CurrDepth, GivenDepth, ActualInsertDepth);
+	}
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append_batch(const MexVector<FlatVectTree<T, AlSub, IndexT>, Al> &FlatVectTreesIn, uint32_t InsertDepth) {
+	/*
+	   The FlatVectTree version of the above. The trees may be of different
+	   depths (if InsertDepth is not specified, it is calculated for each tree
+	   as in append).
+	*/
+
+	size_t NTrees = FlatVectTreesIn.size();
+	if (NTrees == 0)
+		return;
+
+	uint32_t CurrDepth = initBatchAppend(InsertDepth, FlatVectTreesIn[0].depth());
+
+	MexVector<size_t> ExtraLevelSizes(CurrDepth + 1, size_t(0));
+	for (auto &VectTree : FlatVectTreesIn) {
+		uint32_t GivenDepth = VectTree.depth();
+		if (GivenDepth > CurrDepth)
+			break; // append will throw the appropriate exception
+		for (uint32_t i = 0; i < CurrDepth - GivenDepth; ++i)
+			ExtraLevelSizes[i] += 1;
+		for (uint32_t i = 0; i < GivenDepth; ++i)
+			ExtraLevelSizes[CurrDepth - GivenDepth + i] += VectTree.PartitionIndex[i].size() - 1;
+		ExtraLevelSizes[CurrDepth] += VectTree.Data.size();
+	}
+	reserveBatchAppend(ExtraLevelSizes);
+
+	// The trees may differ in depth, so the insert depth of each is found by
+	// append (which rebases each of its levels in a single pass)
+	for (auto &VectTree : FlatVectTreesIn)
+		append(VectTree, InsertDepth);
+}
+
+// ## Move Versions ##
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename SubElemT, class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append_batch(MexVector<MexVector<SubElemT, AlSub>, Al> &&VectTreesIn, uint32_t InsertDepth) {
+
+	// As Data is contiguous, the leaf vectors are necessarily copied. Each
+	// tree is deallocated as soon as it has been appended.
+
+	size_t NTrees = VectTreesIn.size();
+	if (NTrees == 0)
+		return;
+
+	uint32_t GivenDepth = getTreeInfo<MexVector<SubElemT, AlSub> >::depth;
+	uint32_t CurrDepth = initBatchAppend(InsertDepth, GivenDepth);
+
+	MexVector<size_t> ExtraLevelSizes(CurrDepth + 1, size_t(0));
+	for (size_t i = 0; i < CurrDepth - GivenDepth; ++i)
+		ExtraLevelSizes[i] = NTrees;
+	for (auto &VectTree : VectTreesIn)
+		addLevelSizes(VectTree, ExtraLevelSizes.begin() + CurrDepth - GivenDepth);
+	reserveBatchAppend(ExtraLevelSizes);
+
+	InsertDepth = getAppendInsertDepth(InsertDepth, GivenDepth);
+	for (auto &VectTree : VectTreesIn) {
+		uint32_t ActualInsertDepth = getActualInsertDepth(InsertDepth, GivenDepth);
+		appendFast(std::move(VectTree));
+		linkAppendedTree(CurrDepth, GivenDepth, ActualInsertDepth);
+	}
+
+	// Deallocating VectTreesIn
+	MexVector<MexVector<SubElemT, AlSub>, Al> EmptyVectTrees;
+	VectTreesIn.swap(EmptyVectTrees);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlSub, class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::append_batch(MexVector<FlatVectTree<T, AlSub, IndexT>, Al> &&FlatVectTreesIn, uint32_t InsertDepth) {
+
+	// If this FVT is truly empty and the first tree is inserted at the top
+	// level, the arrays of the first tree are taken over (if the allocators
+	// match) and the remaining trees are appended to them.
+
+	size_t NTrees = FlatVectTreesIn.size();
+	if (NTrees == 0)
+		return;
+
+	size_t NTakenOver = 0;
+	if ((InsertDepth == uint32_t(-1) || InsertDepth == 0) && takeOverTree(FlatVectTreesIn[0]))
+		NTakenOver = 1;
+
+	if (NTakenOver < NTrees) {
+		uint32_t CurrDepth = initBatchAppend(InsertDepth, FlatVectTreesIn[NTakenOver].depth());
+
+		MexVector<size_t> ExtraLevelSizes(CurrDepth + 1, size_t(0));
+		for (size_t j = NTakenOver; j < NTrees; ++j) {
+			auto &VectTree = FlatVectTreesIn[j];
+			uint32_t GivenDepth = VectTree.depth();
+			if (GivenDepth > CurrDepth)
+				break; // append will throw the appropriate exception
+			for (uint32_t i = 0; i < CurrDepth - GivenDepth; ++i)
+				ExtraLevelSizes[i] += 1;
+			for (uint32_t i = 0; i < GivenDepth; ++i)
+				ExtraLevelSizes[CurrDepth - GivenDepth + i] += VectTree.PartitionIndex[i].size() - 1;
+			ExtraLevelSizes[CurrDepth] += VectTree.Data.size();
+		}
+		reserveBatchAppend(ExtraLevelSizes);
+
+		for (size_t j = NTakenOver; j < NTrees; ++j)
+			append(FlatVectTreesIn[j], InsertDepth);
+	}
+
+	// Deallocating FlatVectTreesIn
+	MexVector<FlatVectTree<T, AlSub, IndexT>, Al> EmptyVectTrees;
+	FlatVectTreesIn.swap(EmptyVectTrees);
 }
 
 /////////////////////////////////////////////////
 // PUSH_BACK FUNCTIONS       ////////////////////
 /////////////////////////////////////////////////
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::push_back(const MexVector<SubElemT, Al> &VectTreeIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::push_back(const MexVector<SubElemT, Al> &VectTreeIn) {
 	/*
 	   push_back is like append except that the default calculated InsertDepth is one higher
 	   than append. The InsertDepth is not taken as argument as it is expected that the user
@@ -549,9 +1154,9 @@ inline void FlatVectTree<T, FVT_Al, B>::push_back(const MexVector<SubElemT, Al>
 	append(VectTreeIn, InsertDepth);
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::push_back(MexVector<SubElemT, Al> &&VectTreeIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::push_back(MexVector<SubElemT, Al> &&VectTreeIn) {
 	/* 
 	   This performs push_back and deallocates memory in VectTreeIn
 	*/
@@ -577,9 +1182,9 @@ inline void FlatVectTree<T, FVT_Al, B>::push_back(MexVector<SubElemT, Al> &&Vect
 	append(std::move(VectTreeIn), InsertDepth);
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class Al>
-inline void FlatVectTree<T, FVT_Al, B>::push_back(FlatVectTree<T, Al> &VectTreeIn) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::push_back(FlatVectTree<T, Al, IndexT> &VectTreeIn) {
 	/*
 	   This performs push_back and deallocates memory in VectTreeIn
 	*/
@@ -609,9 +1214,9 @@ inline void FlatVectTree<T, FVT_Al, B>::push_back(FlatVectTree<T, Al> &VectTreeI
 // GET VECTOR TREE FUNCTIONS ////////////////////
 /////////////////////////////////////////////////
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class Al>
-inline void FlatVectTree<T, FVT_Al, B>::getVectTreeFromInds(MexVector<T, Al> &VectTreeOut, uint32_t Level, uint32_t LevelIndex) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::getVectTreeFromInds(MexVector<T, Al> &VectTreeOut, uint32_t Level, IndexT LevelIndex) {
 
 	// Validate compatibility of depth
 	uint32_t OutDepth = 0;
@@ -628,20 +1233,20 @@ inline void FlatVectTree<T, FVT_Al, B>::getVectTreeFromInds(MexVector<T, Al> &Ve
 	if (LevelIndex >= PartitionIndex[Level].size() - 1) {
 		WriteException(
 			FV_ExCodes::FV_INVALID_FETCH,
-			"The index of cell array requested (%d) exceeds the (size of the Level  - 1 = %d)",
-			LevelIndex, PartitionIndex[Level].size() - 2
+			"The index of cell array requested (%llu) exceeds the (size of the Level  - 1 = %llu)",
+			(unsigned long long)LevelIndex, (unsigned long long)(PartitionIndex[Level].size() - 2)
 			);
 	}
 
 	// Returning Cell Array
-	uint32_t VectSize = PartitionIndex[Level][LevelIndex + 1] - PartitionIndex[Level][LevelIndex];
+	IndexT VectSize = PartitionIndex[Level][LevelIndex + 1] - PartitionIndex[Level][LevelIndex];
 	VectTreeOut.resize(VectSize);
 	VectTreeOut.copyArray(0, Data.begin() + PartitionIndex[Level][LevelIndex], VectSize);
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class AlSub, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::getVectTreeFromInds(MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeOut, uint32_t Level, uint32_t LevelIndex) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::getVectTreeFromInds(MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeOut, uint32_t Level, IndexT LevelIndex) {
 	
 	// Validate compatibility of depth
 	uint32_t OutDepth = getTreeInfo<decltype(VectTreeOut)>::depth;
@@ -658,24 +1263,24 @@ inline void FlatVectTree<T, FVT_Al, B>::getVectTreeFromInds(MexVector<MexVector<
 	if (LevelIndex >= PartitionIndex[Level].size() - 1) {
 		WriteException(
 			FV_ExCodes::FV_INVALID_FETCH,
-			"The index of cell array requested (%d) exceeds the (size of the Level  - 1 = %d)",
-			LevelIndex, PartitionIndex[Level].size() - 2
+			"The index of cell array requested (%llu) exceeds the (size of the Level  - 1 = %llu)",
+			(unsigned long long)LevelIndex, (unsigned long long)(PartitionIndex[Level].size() - 2)
 			);
 	}
 
-	uint32_t NElems = PartitionIndex[Level][LevelIndex + 1] - PartitionIndex[Level][LevelIndex];
+	IndexT NElems = PartitionIndex[Level][LevelIndex + 1] - PartitionIndex[Level][LevelIndex];
 	VectTreeOut.resize(NElems);
 
-	for (uint32_t i = 0; i < NElems; ++i) {
-		uint32_t CurrElemIndex = PartitionIndex[Level][LevelIndex] + i;
+	for (IndexT i = 0; i < NElems; ++i) {
+		IndexT CurrElemIndex = PartitionIndex[Level][LevelIndex] + i;
 		getVectTreeFromInds(VectTreeOut[i], Level + 1, CurrElemIndex);
 	}
 }
 
 // Get Vector Tree
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class Al, class AlInds>
-inline void FlatVectTree<T, FVT_Al, B>::getVectTree(MexVector<SubElemT, Al> &VectTreeOut, const MexVector<uint32_t, AlInds> &Indices) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::getVectTree(MexVector<SubElemT, Al> &VectTreeOut, const MexVector<IndexT, AlInds> &Indices) {
 
 	// Validate Indices.
 	if (Indices.size() > this->depth()) {
@@ -702,58 +1307,534 @@ inline void FlatVectTree<T, FVT_Al, B>::getVectTree(MexVector<SubElemT, Al> &Vec
 				);
 		}
 		else {
-			uint32_t NElems = PartitionIndex[0].size() - 1;
+			IndexT NElems = PartitionIndex[0].size() - 1;
 			VectTreeOut.resize(NElems);
-			for (uint32_t i = 0; i < NElems; ++i) {
+			for (IndexT i = 0; i < NElems; ++i) {
 				getVectTreeFromInds(VectTreeOut[i], 0, i);
 			}
 		}
 	}
 	// If Not, then Finding LevelIndex and Level and call getVectTreeFromInds
 	else {
-		uint32_t Level = 0;
-		uint32_t LevelIndex = 0;
-
-		for (uint32_t i = 0; i < IndicesSize; ++i, ++Level) {
-			uint32_t CurrentLevelSize = PartitionIndex[Level].size() - 1;
-			if (Indices[Level] < CurrentLevelSize) {
-				LevelIndex = PartitionIndex[Level][LevelIndex + Indices[Level]];
-			}
-			else
-				WriteException(
-					FV_ExCodes::FV_INVALID_FETCH,
-					"At Level %d, Indices[%d] = %d exceeds the size of the level (%d)",
-					Level, Level, Indices[Level], CurrentLevelSize
-					);
+		// Navigating to the required element using the views (which perform
+		// the bounds checking)
+		FlatVectTreeView<T, FVT_Al, IndexT> CurrView = this->view();
+		for (uint32_t i = 0; i < IndicesSize - 1; ++i) {
+			CurrView = CurrView.at(Indices[i]);
 		}
-		--Level; // Level becomes one more in the last increment of for loop
+		if (Indices.last() >= CurrView.size())
+			WriteException(
+				FV_ExCodes::FV_INVALID_FETCH,
+				"At Level %d, Indices[%d] = %llu exceeds the size of the cell (%llu)",
+				IndicesSize - 1, IndicesSize - 1, (unsigned long long)Indices.last(), (unsigned long long)CurrView.size()
+				);
 
-		getVectTreeFromInds(VectTreeOut, Level, LevelIndex);
+		getVectTreeFromInds(VectTreeOut, IndicesSize - 1, CurrView.levelBeg() + Indices.last());
 	}
 }
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<typename SubElemT, class Al>
-inline void FlatVectTree<T, FVT_Al, B>::getVectTree(MexVector<SubElemT, Al> &VectTreeOut, uint32_t NIndices, ...) {
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::getVectTree(MexVector<SubElemT, Al> &VectTreeOut, uint32_t NIndices, ...) {
 
-	// Converting Indices into vector
-	MexVector<uint32_t> Indices(NIndices);
+	// Converting Indices into vector. Note that the variadic arguments are
+	// read as IndexT and must therefore be passed as such (e.g. when IndexT
+	// is uint64_t, passing int literals is undefined behaviour)
+	MexVector<IndexT> Indices(NIndices);
 	std::va_list Args;
 	va_start(Args, NIndices);
 	for (uint32_t i = 0; i < NIndices; ++i) {
-		Indices[i] = va_arg(Args, uint32_t);
+		Indices[i] = va_arg(Args, IndexT);
 	}
 	va_end(Args);
 
 	getVectTree(VectTreeOut, Indices);
 }
 
+/////////////////////////////////////////////////
+// VIEW FUNCTIONS            ////////////////////
+/////////////////////////////////////////////////
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline FlatVectTreeView<T, FVT_Al, IndexT> FlatVectTree<T, FVT_Al, IndexT, B>::view() const
+{
+	// Returns the view of the entire tree (i.e. of the top level elements).
+	// For a FlatVectTree of depth 0, this is a leaf view of Data
+
+	uint32_t TreeDepth = this->depth();
+	IndexT TopLevelSize = (TreeDepth > 0) ? PartitionIndex[0].size() - 1 : Data.size();
+
+	return FlatVectTreeView<T, FVT_Al, IndexT>(PartitionIndex.begin(), Data.begin(), TreeDepth, 0, 0, TopLevelSize);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline FlatVectTreeView<T, FVT_Al, IndexT> FlatVectTree<T, FVT_Al, IndexT, B>::view(uint32_t Level, IndexT LevelBeg, IndexT LevelEnd) const
+{
+	// Returns the view of the elements [LevelBeg, LevelEnd) of the given Level
+	// (0 to depth(), see FILTER AND EXTRACT FUNCTIONS below for the convention).
+	// The range is validated.
+
+	uint32_t TreeDepth = this->depth();
+	if (Level > TreeDepth)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FETCH,
+			"The Level requested (%d) exceeds the depth of the FlatVectTree (%d)",
+			Level, TreeDepth
+		);
+
+	size_t LevelSize = (Level < TreeDepth) ? PartitionIndex[Level].size() - 1 : Data.size();
+	if (LevelBeg > LevelEnd || LevelEnd > LevelSize)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FETCH,
+			"The range requested [%llu, %llu) is invalid for Level %d of size %llu",
+			(unsigned long long)LevelBeg, (unsigned long long)LevelEnd, Level, (unsigned long long)LevelSize
+		);
+
+	return FlatVectTreeView<T, FVT_Al, IndexT>(PartitionIndex.begin(), Data.begin(), TreeDepth, Level, LevelBeg, LevelEnd);
+}
+
+/////////////////////////////////////////////////
+// SHARDING AND PARALLEL LEAF FUNCTIONS /////////
+/////////////////////////////////////////////////
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline size_t FlatVectTree<T, FVT_Al, IndexT, B>::getShardWeight(uint32_t Level, IndexT LevelIndex) const
+{
+	// Returns the weight of the elements [0, LevelIndex) of Level, which is
+	// the number of elements of Data they contain plus LevelIndex (each node
+	// counts as one element so that many empty leaves are also split). The
+	// weight is strictly increasing in LevelIndex.
+
+	size_t DataOffset = LevelIndex;
+	for (uint32_t i = Level; i < this->depth(); ++i)
+		DataOffset = PartitionIndex[i][DataOffset];
+
+	return DataOffset + LevelIndex;
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::shard(MexVector<FlatVectTreeView<T, FVT_Al, IndexT>, Al> &ShardsOut, uint32_t NShards, uint32_t Level) const
+{
+	/*
+	   This function splits the elements of Level (by default depth() - 1,
+	   the level of the leaf vectors) into at most NShards non-empty ranges of
+	   roughly equal weight (see getShardWeight), and assigns to ShardsOut the
+	   views of the subtrees in each range. The boundaries are found by binary
+	   search on the partition offsets, taking O(NShards * depth * log(size)).
+
+	   A shard cannot be lighter than its heaviest element, so sharding a
+	   higher level balances worse when the subtrees are skewed. The shards are
+	   views and remain valid as long as the tree is not modified.
+	*/
+
+	uint32_t TreeDepth = this->depth();
+	if (Level == uint32_t(-1))
+		Level = (TreeDepth > 0) ? TreeDepth - 1 : 0;
+	if (Level > TreeDepth)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FETCH,
+			"The Level requested (%d) exceeds the depth of the FlatVectTree (%d)",
+			Level, TreeDepth
+		);
+	if (NShards == 0)
+		NShards = 1;
+
+	IndexT LevelSize = (Level < TreeDepth) ? PartitionIndex[Level].size() - 1 : Data.size();
+	size_t TotalWeight = getShardWeight(Level, LevelSize);
+
+	ShardsOut.clear();
+	ShardsOut.reserve(NShards);
+
+	IndexT ShardBeg = 0;
+	for (uint32_t k = 1; k <= NShards && ShardBeg < LevelSize; ++k) {
+		// floor(TotalWeight*k/NShards) without overflow
+		size_t TargetWeight = (TotalWeight / NShards)*k + (TotalWeight % NShards)*k / NShards;
+		if (getShardWeight(Level, ShardBeg) >= TargetWeight)
+			continue;
+
+		// Finding the first element whose weight reaches TargetWeight
+		IndexT Lo = ShardBeg + 1, Hi = LevelSize;
+		while (Lo < Hi) {
+			IndexT Mid = Lo + (Hi - Lo) / 2;
+			if (getShardWeight(Level, Mid) < TargetWeight)
+				Lo = Mid + 1;
+			else
+				Hi = Mid;
+		}
+		ShardsOut.push_back(FlatVectTreeView<T, FVT_Al, IndexT>(PartitionIndex.begin(), Data.begin(), TreeDepth, Level, ShardBeg, Lo));
+		ShardBeg = Lo;
+	}
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename Func>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::parallel_for_each_leaf(Func LeafFunc) const
+{
+	/*
+	   This function calls LeafFunc(LeafIndex, Leaf) for every leaf vector of
+	   the tree, where LeafIndex is the index of the leaf in the level
+	   depth() - 1 and Leaf is its FlatVectTreeSpan. For a tree of depth 0,
+	   Data is the only leaf (with index 0).
+
+	   The leaves are split into MEXMEM_SHARDS_PER_THREAD shards per thread
+	   (see shard) that are scheduled dynamically, i.e. threads that finish
+	   early take over the remaining shards, so that skewed leaf sizes do not
+	   leave threads idle. The beginning of the next leaf is prefetched before
+	   processing each leaf.
+
+	   LeafFunc is called concurrently from several threads. It must be
+	   thread safe, must not throw and must not call the MATLAB API.
+	*/
+
+	uint32_t TreeDepth = this->depth();
+	if (TreeDepth == 0) {
+		LeafFunc(IndexT(0), FlatVectTreeSpan<T>(Data.begin(), Data.end()));
+		return;
+	}
+
+	const IndexT* LeafOffsets = PartitionIndex[TreeDepth - 1].begin();
+	const T* DataBeg = Data.begin();
+	size_t NLeaves = PartitionIndex[TreeDepth - 1].size() - 1;
+
+	int NThreads = (NLeaves + Data.size() >= MEXMEM_PARALLEL_THRESHOLD) ? getMaxThreads() : 1;
+	MexVector<FlatVectTreeView<T, FVT_Al, IndexT>, CAllocator> Shards;
+	shard(Shards, uint32_t(NThreads)*MEXMEM_SHARDS_PER_THREAD, TreeDepth - 1);
+	int64_t NShards = Shards.size();
+
+	#pragma omp parallel for schedule(dynamic, 1) if(NThreads > 1)
+	for (int64_t s = 0; s < NShards; ++s) {
+		IndexT LeafEnd = Shards[s].levelEnd();
+		for (IndexT i = Shards[s].levelBeg(); i < LeafEnd; ++i) {
+			MEXMEM_PREFETCH(DataBeg + LeafOffsets[i + 1]);
+			LeafFunc(i, FlatVectTreeSpan<T>(DataBeg + LeafOffsets[i], DataBeg + LeafOffsets[i + 1]));
+		}
+	}
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<typename TOut, class AlOut, typename Func>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::parallel_map_leaves(FlatVectTree<TOut, AlOut, IndexT> &FlatVectTreeOut, Func LeafFunc) const
+{
+	/*
+	   This function assigns to FlatVectTreeOut a tree with the same structure
+	   as this tree, whose leaves are computed by LeafFunc(Leaf, LeafOut) where
+	   Leaf is the FlatVectTreeSpan of a leaf of this tree and LeafOut points to
+	   the Leaf.size() elements of the corresponding output leaf. The leaves
+	   are processed in parallel as in parallel_for_each_leaf, with the same
+	   restrictions on LeafFunc. FlatVectTreeOut may be this tree.
+	*/
+
+	uint32_t TreeDepth = this->depth();
+	MexVector<MexVector<IndexT, AlOut>, AlOut> NewPartitionIndex(TreeDepth);
+	MexVector<TOut, AlOut> NewData(Data.size());
+
+	for (uint32_t i = 0; i < TreeDepth; ++i) {
+		NewPartitionIndex[i] = PartitionIndex[i];
+	}
+
+	const T* DataBeg = Data.begin();
+	TOut* NewDataBeg = NewData.begin();
+	parallel_for_each_leaf([&](IndexT LeafIndex, const FlatVectTreeSpan<T> &Leaf) {
+		LeafFunc(Leaf, NewDataBeg + (Leaf.begin() - DataBeg));
+	});
+
+	FlatVectTreeOut.PartitionIndex.swap(NewPartitionIndex);
+	FlatVectTreeOut.Data.swap(NewData);
+	FlatVectTreeOut.isStructValidated = isStructValidated;
+}
+
+/////////////////////////////////////////////////
+// FILTER AND EXTRACT FUNCTIONS /////////////////
+/////////////////////////////////////////////////
+
+// In the following functions, Level ranges from 0 to this->depth(). The
+// elements of the Level L < this->depth() are those partitioned by
+// PartitionIndex[L], and the elements of the Level this->depth() are the
+// elements of Data. The indices are 0-based.
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlInds>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::checkLevelIndices(uint32_t Level, const MexVector<IndexT, AlInds> &Indices) const
+{
+	uint32_t TreeDepth = this->depth();
+	if (Level > TreeDepth)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FILTER,
+			"The Level (%d) must not exceed the depth of the FlatVectTree (%d)",
+			Level, TreeDepth
+		);
+
+	size_t NLevelElems = (Level < TreeDepth) ? PartitionIndex[Level].size() - 1 : Data.size();
+	int64_t NIndices = Indices.size();
+	int isInvalid = 0;
+
+	#pragma omp parallel for reduction(|:isInvalid) if(NIndices >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t j = 0; j < NIndices; ++j) {
+		isInvalid |= (Indices[j] >= NLevelElems);
+	}
+	if (isInvalid)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FILTER,
+			"The indices must be less than the number of elements (%llu) at Level %d",
+			(unsigned long long)NLevelElems, Level
+		);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlOut, class AlInds>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::extractLevels(
+	uint32_t Level,
+	const MexVector<IndexT, AlInds> &Indices,
+	MexVector<MexVector<IndexT, AlOut>, AlOut> &PartitionIndexOut,
+	MexVector<T, AlOut> &DataOut) const
+{
+	// This function extracts the elements of Level indexed by Indices (in the
+	// given order), along with all their descendants. PartitionIndexOut[i]
+	// (which must be of size this->depth() - Level) and DataOut are assigned
+	// the corresponding levels of the extracted tree. For each level, the
+	// sizes of the selected elements are prefix summed to give the new
+	// partition index, and the indices of the selected elements of the next
+	// level, i.e. the children of the current selection, are filled in
+	// parallel at the offsets given by it. The indices are assumed valid.
+
+	uint32_t TreeDepth = this->depth();
+
+	MexVector<IndexT> CurrInds;
+	const IndexT* CurrIndsPtr = Indices.begin();
+	int64_t NCurrInds = Indices.size();
+
+	for (uint32_t l = Level; l < TreeDepth; ++l) {
+		MexVector<IndexT, AlOut> &NewLevelIndex = PartitionIndexOut[l - Level];
+		const IndexT* OldLevelIndex = PartitionIndex[l].begin();
+
+		NewLevelIndex.resize(NCurrInds + 1);
+		NewLevelIndex[0] = 0;
+		#pragma omp parallel for if(NCurrInds >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t j = 0; j < NCurrInds; ++j) {
+			NewLevelIndex[j + 1] = OldLevelIndex[CurrIndsPtr[j] + 1] - OldLevelIndex[CurrIndsPtr[j]];
+		}
+		InclusivePrefixSum(NewLevelIndex.begin() + 1, NCurrInds);
+
+		if (l + 1 < TreeDepth) {
+			// Calculating the indices of the selected elements of the next level
+			MexVector<IndexT> NextInds(NewLevelIndex.last());
+			#pragma omp parallel for schedule(dynamic, 1024) if(NCurrInds >= MEXMEM_PARALLEL_THRESHOLD)
+			for (int64_t j = 0; j < NCurrInds; ++j) {
+				IndexT ChildBeg = OldLevelIndex[CurrIndsPtr[j]];
+				IndexT NChildren = NewLevelIndex[j + 1] - NewLevelIndex[j];
+				IndexT* NextIndsPtr = NextInds.begin() + NewLevelIndex[j];
+				for (IndexT k = 0; k < NChildren; ++k)
+					NextIndsPtr[k] = ChildBeg + k;
+			}
+			CurrInds.swap(NextInds);
+			CurrIndsPtr = CurrInds.begin();
+			NCurrInds = CurrInds.size();
+		}
+		else {
+			// The children are contiguous ranges of Data
+			DataOut.resize(NewLevelIndex.last());
+			#pragma omp parallel for schedule(dynamic, 1024) if(NCurrInds >= MEXMEM_PARALLEL_THRESHOLD)
+			for (int64_t j = 0; j < NCurrInds; ++j) {
+				IndexT NChildren = NewLevelIndex[j + 1] - NewLevelIndex[j];
+				if (NChildren > 0)
+					std::memcpy(DataOut.begin() + NewLevelIndex[j], Data.begin() + OldLevelIndex[CurrIndsPtr[j]], NChildren*sizeof(T));
+			}
+		}
+	}
+
+	if (Level == TreeDepth) {
+		DataOut.resize(NCurrInds);
+		#pragma omp parallel for if(NCurrInds >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t j = 0; j < NCurrInds; ++j) {
+			DataOut[j] = Data[CurrIndsPtr[j]];
+		}
+	}
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlInds>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::filterSorted(uint32_t Level, const MexVector<IndexT, AlInds> &SortedIndices)
+{
+	// Performs the filtering given a sorted vector of unique, valid indices.
+	// The levels from Level onwards are rebuilt by extractLevels. The level
+	// above (if it exists) retains all its elements, each of which now
+	// contains only its selected children. Its new partition index is
+	// obtained by mapping each old index to the number of selected elements
+	// before it (an exclusive prefix sum over the selection mask).
+
+	uint32_t TreeDepth = this->depth();
+	size_t NLevelElems = (Level < TreeDepth) ? PartitionIndex[Level].size() - 1 : Data.size();
+
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(TreeDepth - Level);
+	MexVector<T, FVT_Al> NewData;
+	extractLevels(Level, SortedIndices, NewPartitionIndex, NewData);
+
+	if (Level > 0) {
+		int64_t NIndices = SortedIndices.size();
+		MexVector<IndexT> NewPositions(NLevelElems + 1, IndexT(0));
+		#pragma omp parallel for if(NIndices >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t j = 0; j < NIndices; ++j) {
+			NewPositions[SortedIndices[j] + 1] = 1;
+		}
+		InclusivePrefixSum(NewPositions.begin() + 1, NLevelElems);
+
+		const MexVector<IndexT, FVT_Al> &OldParentIndex = PartitionIndex[Level - 1];
+		int64_t NParentEntries = OldParentIndex.size();
+		MexVector<IndexT, FVT_Al> NewParentIndex(NParentEntries);
+		#pragma omp parallel for if(NParentEntries >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t p = 0; p < NParentEntries; ++p) {
+			NewParentIndex[p] = NewPositions[OldParentIndex[p]];
+		}
+		PartitionIndex[Level - 1].swap(NewParentIndex);
+	}
+
+	for (uint32_t l = Level; l < TreeDepth; ++l) {
+		PartitionIndex[l].swap(NewPartitionIndex[l - Level]);
+	}
+	Data.swap(NewData);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlInds>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::filter(uint32_t Level, const MexVector<IndexT, AlInds> &Indices)
+{
+	/*
+	   This function filters the Level to contain only the elements indexed by
+	   Indices (along with all their descendants). As in MATLAB's
+	   FlatCellArray.filter, repeated indices are ignored and the relative
+	   order of the retained elements is preserved. The elements of the level
+	   above Level are retained (possibly becoming empty).
+	*/
+
+	checkLevelIndices(Level, Indices);
+
+	MexVector<IndexT> SortedIndices(Indices);
+	std::sort(SortedIndices.begin(), SortedIndices.end());
+	SortedIndices.resize(std::unique(SortedIndices.begin(), SortedIndices.end()) - SortedIndices.begin());
+
+	filterSorted(Level, SortedIndices);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlMask>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::filter(uint32_t Level, const MexVector<bool, AlMask> &Mask)
+{
+	/*
+	   This function filters the Level to contain only the elements for which
+	   Mask is true. Mask must have one entry per element of Level.
+	*/
+
+	uint32_t TreeDepth = this->depth();
+	if (Level > TreeDepth)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FILTER,
+			"The Level (%d) must not exceed the depth of the FlatVectTree (%d)",
+			Level, TreeDepth
+		);
+
+	size_t NLevelElems = (Level < TreeDepth) ? PartitionIndex[Level].size() - 1 : Data.size();
+	if (Mask.size() != NLevelElems)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FILTER,
+			"The size of the mask (%llu) must be equal to the number of elements (%llu) at Level %d",
+			(unsigned long long)Mask.size(), (unsigned long long)NLevelElems, Level
+		);
+
+	// Calculating the indices of the true elements using a prefix sum
+	int64_t NMaskElems = NLevelElems;
+	MexVector<IndexT> MaskPositions(NLevelElems + 1);
+	MaskPositions[0] = 0;
+	#pragma omp parallel for if(NMaskElems >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t i = 0; i < NMaskElems; ++i) {
+		MaskPositions[i + 1] = Mask[i] ? 1 : 0;
+	}
+	InclusivePrefixSum(MaskPositions.begin() + 1, NLevelElems);
+
+	MexVector<IndexT> SortedIndices(MaskPositions.last());
+	#pragma omp parallel for if(NMaskElems >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t i = 0; i < NMaskElems; ++i) {
+		if (Mask[i])
+			SortedIndices[MaskPositions[i]] = i;
+	}
+
+	filterSorted(Level, SortedIndices);
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al, class AlInds>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::extract(FlatVectTree<T, Al, IndexT> &FlatVectTreeOut, uint32_t Level, const MexVector<IndexT, AlInds> &Indices) const
+{
+	/*
+	   This function assigns to FlatVectTreeOut the FlatVectTree of depth
+	   this->depth() - Level whose top level elements are the elements of
+	   Level indexed by Indices (in the given order, repetitions allowed).
+	   If Level == this->depth(), FlatVectTreeOut is of depth 0 and contains
+	   the indexed elements of Data. This is the equivalent of MATLAB's
+	   FlatCellArray.getSubFlatCellArr.
+	*/
+
+	checkLevelIndices(Level, Indices);
+
+	MexVector<MexVector<IndexT, Al>, Al> NewPartitionIndex(this->depth() - Level);
+	MexVector<T, Al> NewData;
+	extractLevels(Level, Indices, NewPartitionIndex, NewData);
+
+	FlatVectTreeOut.PartitionIndex.swap(NewPartitionIndex);
+	FlatVectTreeOut.Data.swap(NewData);
+	FlatVectTreeOut.isStructValidated = isStructValidated;
+}
+
+/////////////////////////////////////////////////
+// COMPRESSED INDEX FUNCTIONS ///////////////////
+/////////////////////////////////////////////////
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class Al>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::compressIndex(MexVector<CompressedIndex<IndexT, Al>, Al> &CompressedIndexOut) const
+{
+	// Compresses each level of PartitionIndex (see CompressedIndex). The
+	// FlatVectTree itself is left unmodified.
+
+	uint32_t TreeDepth = this->depth();
+	CompressedIndexOut.resize(TreeDepth);
+	for (uint32_t i = 0; i < TreeDepth; ++i) {
+		CompressedIndexOut[i].compress(PartitionIndex[i]);
+	}
+}
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+template<class AlSub, class Al, class AlData>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::assign(const MexVector<CompressedIndex<IndexT, AlSub>, Al> &CompressedIndexIn, const MexVector<T, AlData> &DataIn)
+{
+	// Decompresses the given levels and assigns them (along with a copy of
+	// DataIn) after validation.
+
+	uint32_t TreeDepth = CompressedIndexIn.size();
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(TreeDepth);
+	for (uint32_t i = 0; i < TreeDepth; ++i) {
+		CompressedIndexIn[i].decompress(NewPartitionIndex[i]);
+	}
+
+	if (!isValidFVT(NewPartitionIndex, DataIn)) {
+		WriteException(
+			FV_ExCodes::FV_INVALID_APPEND,
+			"The Given CompressedIndexIn, DataIn do not represent a valid FlatVectTree"
+			);
+	}
+
+	MexVector<T, FVT_Al> NewData(DataIn);
+	PartitionIndex.swap(NewPartitionIndex);
+	Data.swap(NewData);
+	isStructValidated = true;
+}
+
 /////////////////////////////////////////////////
 // PROPERTY ASSIGNMENT FUNCTIONS ////////////////
 /////////////////////////////////////////////////
 
-template<typename T, class FVT_Al, class B>
-inline bool FlatVectTree<T, FVT_Al, B>::setDepth(uint32_t NewDepth)
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline bool FlatVectTree<T, FVT_Al, IndexT, B>::setDepth(uint32_t NewDepth)
 {
 	/*
 	   This function sets the depth of the FlatTreeVect to NewDepth given 
@@ -786,12 +1867,12 @@ inline bool FlatVectTree<T, FVT_Al, B>::setDepth(uint32_t NewDepth)
 
 	uint32_t OldDepth = this->depth();
 	if (OldDepth == 0) {
-		PartitionIndex.resize(NewDepth, MexVector<uint32_t>(1, (uint32_t)0));
+		PartitionIndex.resize(NewDepth, MexVector<IndexT>(1, (IndexT)0));
 		// it is assumed that given that OldDepth == 0, Data is Empty
 		return true;
 	}
 	else if (OldDepth < NewDepth) {
-		MexVector<MexVector<uint32_t> > NewPartitionIndex(NewDepth, MexVector<uint32_t>(1, (uint32_t)0));
+		MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(NewDepth, MexVector<IndexT, FVT_Al>(1, (IndexT)0));
 
 		if (!this->isempty()) {
 			for (uint32_t i = 0; i < NewDepth - OldDepth - 1; ++i) {
@@ -827,7 +1908,7 @@ inline bool FlatVectTree<T, FVT_Al, B>::setDepth(uint32_t NewDepth)
 				}
 
 			if (isValid) {
-				MexVector<MexVector<uint32_t> > NewPartitionIndex(NewDepth);
+				MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(NewDepth);
 				for (uint32_t i = 0; i < NewDepth; ++i)
 					NewPartitionIndex[i].swap(PartitionIndex[i + OldDepth - NewDepth]);
 				PartitionIndex.swap(NewPartitionIndex);
@@ -843,8 +1924,8 @@ inline bool FlatVectTree<T, FVT_Al, B>::setDepth(uint32_t NewDepth)
 	}
 }
 
-template<typename T, class FVT_Al, class B>
-inline void FlatVectTree<T, FVT_Al, B>::clear()
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::clear()
 {
 	uint32_t CurrDepth = this->depth();
 	for (uint32_t i = 0; i < CurrDepth; ++i) {
@@ -852,10 +1933,11 @@ inline void FlatVectTree<T, FVT_Al, B>::clear()
 		PartitionIndex[i][0] = 0;
 	}
 	Data.clear();
+	isStructValidated = true;
 }
 
-template<typename T, class FVT_Al, class B>
-inline void FlatVectTree<T, FVT_Al, B>::empty()
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::empty()
 {
 	this->clear();
 	this->setDepth(0);
@@ -867,18 +1949,18 @@ inline void FlatVectTree<T, FVT_Al, B>::empty()
 // MEMORY RELEASE FUNCTIONS /////////////////////
 /////////////////////////////////////////////////
 
-template<typename T, class FVT_Al, class B>
-inline void FlatVectTree<T, FVT_Al, B>::releaseMem(MexVector<MexVector<uint32_t, FVT_Al>, FVT_Al> &ReleasedPartInds, MexVector<T, FVT_Al> &ReleasedData)
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline void FlatVectTree<T, FVT_Al, IndexT, B>::releaseMem(MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> &ReleasedPartInds, MexVector<T, FVT_Al> &ReleasedData)
 {
 	uint32_t TreeDepth = this->depth();
 
 	// Relinquishing PartitionIndex and Data arrays 
 	ReleasedPartInds.resize(TreeDepth);
 	for (uint32_t i = 0; i < TreeDepth; ++i) {
-		uint32_t NElemsinCurrLevel = PartitionIndex[i].size();
+		size_t NElemsinCurrLevel = PartitionIndex[i].size();
 		ReleasedPartInds[i].assign(NElemsinCurrLevel, PartitionIndex[i].releaseArray());
 	}
-	uint32_t NElemsData = Data.size();
+	size_t NElemsData = Data.size();
 	ReleasedData.assign(NElemsData, Data.releaseArray());
 
 	// Reinitializing PartitionInds and Data
@@ -886,68 +1968,53 @@ inline void FlatVectTree<T, FVT_Al, B>::releaseMem(MexVector<MexVector<uint32_t,
 		PartitionIndex[i].resize(1, 0);
 	}
 	// Data is already an empty (null) vector
+	isStructValidated = true;
+}
+
+/////////////////////////////////////////////////
+// VALIDATION FUNCTIONS     /////////////////////
+/////////////////////////////////////////////////
+
+template<typename T, class FVT_Al, typename IndexT, class B>
+inline bool FlatVectTree<T, FVT_Al, IndexT, B>::validate()
+{
+	if (!isStructValidated)
+		isStructValidated = isValidFVT(PartitionIndex, Data);
+	return isStructValidated;
 }
 
 /////////////////////////////////////////////////
 // STATIC FUNCTIONS         /////////////////////
 /////////////////////////////////////////////////
 
-template<typename T, class FVT_Al, class B>
+template<typename T, class FVT_Al, typename IndexT, class B>
 template<class AlSub, class Al, class AlData>
-inline bool FlatVectTree<T, FVT_Al, B>::isValidFVT(const MexVector<MexVector<uint32_t, AlSub>, Al>& PartitionInds, const MexVector<T, AlData>& Data)
+inline bool FlatVectTree<T, FVT_Al, IndexT, B>::isValidFVT(const MexVector<MexVector<IndexT, AlSub>, Al>& PartitionInds, const MexVector<T, AlData>& Data)
 {
-	bool isValid = true;
-	
 	size_t NLevels = PartitionInds.size();
 
-	if (PartitionInds.size() > 0) {
-
-		// Checking if sizes > 0
-		for (uint32_t i = 0; i < NLevels && isValid; ++i) {
-			size_t NElemsatCurrLevel = PartitionInds[i].size();
-			if (PartitionInds[i].size() == 0) {
-				isValid = false;
-				break;
-			}
-		}
-
-		// Checking sorted
-		if(isValid)
-		for (uint32_t i = 0; i < NLevels && isValid; ++i) {
-			size_t NElemsatCurrLevel = PartitionInds[i].size();
-			for (uint32_t j = 0; j < NElemsatCurrLevel - 1; ++j) {
-				if (PartitionInds[i][j] > PartitionInds[i][j + 1]) {
-					isValid = false;
-					break;
-				}
-			}
-		}
+	if (NLevels == 0)
+		return (Data.size() == 0);
 
-		// Chacking validity of first elements (must be 0)
-		if (isValid)
-		for (uint32_t i = 0; i < NLevels && isValid; ++i) {
-			if (PartitionInds[i][0] != 0) {
-				isValid = false;
-				break;
-			}
-		}
+	// Checking if sizes > 0
+	for (uint32_t i = 0; i < NLevels; ++i) {
+		if (PartitionInds[i].size() == 0)
+			return false;
+	}
 
-		// Checking validity of BTE Elems
-		if (isValid)
-		for (uint32_t i = 0; i < NLevels - 1 && isValid; ++i) {
-			if (PartitionInds[i].last() != PartitionInds[i + 1].size() - 1) {
-				isValid = false;
-				break;
-			}
-		}
-		if (isValid)
-		if (PartitionInds.last().last() != Data.size())
-			isValid = false;
+	// Checking validity of first elements (must be 0) and BTE Elems (the last
+	// element of each level must be the number of elements in the next level)
+	for (uint32_t i = 0; i < NLevels; ++i) {
+		size_t NextLevelSize = (i + 1 < NLevels) ? PartitionInds[i + 1].size() - 1 : Data.size();
+		if (PartitionInds[i][0] != 0 || PartitionInds[i].last() != NextLevelSize)
+			return false;
 	}
-	else {
-		if (Data.size() > 0)
-			isValid = false;
+
+	// Checking sorted (vectorized and parallelized within each level)
+	for (uint32_t i = 0; i < NLevels; ++i) {
+		if (!isNonDecreasing(PartitionInds[i].begin(), PartitionInds[i].size()))
+			return false;
 	}
 
-	return isValid;
+	return true;
 }
@@ -0,0 +1,297 @@
+#ifndef FLAT_VECT_TREE_BUILDER_HPP
+#define FLAT_VECT_TREE_BUILDER_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include "../MexMem.hpp"
+#include "../GenericMexIO.hpp"
+#include "../ParallelHelpers.hpp"
+#include "FlatVectTree.hpp"
+
+// FlatVectTreeBuilder records the top level elements of a FlatVectTree of a
+// fixed depth (>= 1) into private buffers, so that each thread can build its
+// part of a tree independently. The buffers are std::vectors rather than
+// MexVectors because growing a MexVector updates the (global) MemCounter and
+// may call mxRealloc, neither of which is thread safe. The parts are then
+// combined into a single FlatVectTree by merge, e.g.
+//
+//   std::vector<FlatVectTreeBuilder<float> > Builders(getMaxThreads(), FlatVectTreeBuilder<float>(1));
+//   #pragma omp parallel
+//   {
+//       std::vector<float> Leaf;
+//       #pragma omp for schedule(dynamic)
+//       for (int64_t i = 0; i < NTasks; ++i) {
+//           computeTask(i, Leaf);
+//           Builders[omp_get_thread_num()].push_back(Leaf.data(), Leaf.size(), i);
+//       }
+//   }
+//   FlatVectTreeBuilder<float>::merge(Builders, FlatVectTreeOut, true);
+//
+// For the same reason, the tasks must not create or grow MexVectors inside
+// the parallel region (computeTask fills a thread private std::vector
+// above). The MexVector form of push_back only reads its argument, so it
+// may be given sub-trees built before the parallel region.
+//
+// Each element may be tagged with a task index. If merge is asked to keep
+// the task order, the elements are ordered by task index (elements of the
+// same task keep the order of the builders and of their insertion), which
+// makes the result independent of the scheduling of the tasks.
+template<typename T, typename IndexT = uint32_t>
+class FlatVectTreeBuilder {
+
+	// A run of consecutive top level elements with the same task index
+	struct TaskRun {
+		uint64_t TaskIndex;
+		size_t TopLevelBeg;
+	};
+
+	// A range of top level elements of a builder to be gathered by merge
+	struct MergePiece {
+		const FlatVectTreeBuilder* Builder;
+		size_t TopLevelBeg, TopLevelEnd;
+		uint64_t TaskIndex;
+	};
+
+	std::vector<std::vector<IndexT> > PartitionIndex;
+	std::vector<T> Data;
+	std::vector<TaskRun> TaskRuns;
+
+	template<class Al>
+	static inline uint32_t getNestDepth(const MexVector<T, Al>*) { return 0; }
+	template<typename SubElemT, class AlSub, class Al>
+	static inline uint32_t getNestDepth(const MexVector<MexVector<SubElemT, AlSub>, Al>*) {
+		return getNestDepth((const MexVector<SubElemT, AlSub>*)nullptr) + 1;
+	}
+
+	template<class Al>
+	inline void recordNode(const MexVector<T, Al> &LeafIn, uint32_t Level);
+	template<typename SubElemT, class AlSub, class Al>
+	inline void recordNode(const MexVector<MexVector<SubElemT, AlSub>, Al> &NodeIn, uint32_t Level);
+	inline void recordTask(uint64_t TaskIndex);
+
+public:
+
+	// Constructors
+	inline explicit FlatVectTreeBuilder(uint32_t Depth);
+
+	// Recording Functions. SubTreeIn must be of depth depth() - 1 (i.e. a
+	// single leaf vector for a builder of depth 1). The second form records a
+	// leaf from an array and requires depth() == 1.
+	template<typename SubElemT, class Al>
+	inline void push_back(const MexVector<SubElemT, Al> &SubTreeIn, uint64_t TaskIndex = 0);
+	inline void push_back(const T* LeafIn, size_t LeafSize, uint64_t TaskIndex = 0);
+
+	inline void clear();
+
+	// Property Access Functions
+	inline uint32_t depth() const {
+		return PartitionIndex.size();
+	}
+	inline size_t size() const {
+		return PartitionIndex[0].size() - 1;
+	}
+
+	// Merging Function
+	template<class Al>
+	static inline void merge(const std::vector<FlatVectTreeBuilder> &Builders, FlatVectTree<T, Al, IndexT> &FlatVectTreeOut, bool KeepTaskOrder = false);
+};
+
+template<typename T, typename IndexT>
+inline FlatVectTreeBuilder<T, IndexT>::FlatVectTreeBuilder(uint32_t Depth) :
+	PartitionIndex(Depth, std::vector<IndexT>(1, IndexT(0))), Data(), TaskRuns()
+{
+	if (Depth == 0)
+		WriteException(
+			FV_ExCodes::FV_INVALID_APPEND,
+			"The depth of a FlatVectTreeBuilder must be at least 1"
+		);
+}
+
+template<typename T, typename IndexT>
+inline void FlatVectTreeBuilder<T, IndexT>::recordTask(uint64_t TaskIndex)
+{
+	if (TaskRuns.empty() || TaskRuns.back().TaskIndex != TaskIndex) {
+		TaskRun NewRun = { TaskIndex, this->size() };
+		TaskRuns.push_back(NewRun);
+	}
+}
+
+template<typename T, typename IndexT>
+template<class Al>
+inline void FlatVectTreeBuilder<T, IndexT>::recordNode(const MexVector<T, Al> &LeafIn, uint32_t Level)
+{
+	Data.insert(Data.end(), LeafIn.begin(), LeafIn.end());
+	PartitionIndex[Level].push_back(IndexT(Data.size()));
+}
+
+template<typename T, typename IndexT>
+template<typename SubElemT, class AlSub, class Al>
+inline void FlatVectTreeBuilder<T, IndexT>::recordNode(const MexVector<MexVector<SubElemT, AlSub>, Al> &NodeIn, uint32_t Level)
+{
+	for (auto &ChildNode : NodeIn)
+		recordNode(ChildNode, Level + 1);
+	PartitionIndex[Level].push_back(IndexT(PartitionIndex[Level + 1].size() - 1));
+}
+
+template<typename T, typename IndexT>
+template<typename SubElemT, class Al>
+inline void FlatVectTreeBuilder<T, IndexT>::push_back(const MexVector<SubElemT, Al> &SubTreeIn, uint64_t TaskIndex)
+{
+	uint32_t GivenDepth = getNestDepth(&SubTreeIn);
+	if (GivenDepth + 1 != this->depth())
+		WriteException(
+			FV_ExCodes::FV_INVALID_APPEND,
+			"The depth of the sub-tree (%d) must be one less than the depth of the builder (%d)",
+			GivenDepth, this->depth()
+		);
+
+	recordTask(TaskIndex);
+	recordNode(SubTreeIn, 0);
+}
+
+template<typename T, typename IndexT>
+inline void FlatVectTreeBuilder<T, IndexT>::push_back(const T* LeafIn, size_t LeafSize, uint64_t TaskIndex)
+{
+	if (this->depth() != 1)
+		WriteException(
+			FV_ExCodes::FV_INVALID_APPEND,
+			"A leaf can only be pushed into a builder of depth 1 (depth = %d)",
+			this->depth()
+		);
+
+	recordTask(TaskIndex);
+	Data.insert(Data.end(), LeafIn, LeafIn + LeafSize);
+	PartitionIndex[0].push_back(IndexT(Data.size()));
+}
+
+template<typename T, typename IndexT>
+inline void FlatVectTreeBuilder<T, IndexT>::clear()
+{
+	for (auto &Level : PartitionIndex)
+		Level.resize(1);
+	Data.clear();
+	TaskRuns.clear();
+}
+
+template<typename T, typename IndexT>
+template<class Al>
+inline void FlatVectTreeBuilder<T, IndexT>::merge(const std::vector<FlatVectTreeBuilder> &Builders, FlatVectTree<T, Al, IndexT> &FlatVectTreeOut, bool KeepTaskOrder)
+{
+	/*
+	   This function replaces the contents of FlatVectTreeOut with the
+	   concatenation of the elements recorded in Builders, either in the order
+	   of the builders or (if KeepTaskOrder) in the order of the task indices.
+
+	   The elements are gathered as pieces, each piece being a range of top
+	   level elements of a builder (the whole builder, or a run of elements of
+	   the same task). A range of elements of one level corresponds to a range
+	   of each level below it, so the output offsets of every piece in every
+	   level are obtained by a prefix sum over the pieces. The pieces are then
+	   copied in parallel, rebasing the partition indices by these offsets.
+	*/
+
+	size_t NBuilders = Builders.size();
+	if (NBuilders == 0)
+		WriteException(
+			FV_ExCodes::FV_INVALID_APPEND,
+			"At least one FlatVectTreeBuilder must be given to merge"
+		);
+
+	uint32_t TreeDepth = Builders[0].depth();
+	for (size_t b = 1; b < NBuilders; ++b) {
+		if (Builders[b].depth() != TreeDepth)
+			WriteException(
+				FV_ExCodes::FV_INVALID_APPEND,
+				"All the builders must have the same depth (builder %llu has depth %d instead of %d)",
+				(unsigned long long)b, Builders[b].depth(), TreeDepth
+			);
+	}
+
+	// Collecting the pieces
+	std::vector<MergePiece> Pieces;
+	for (size_t b = 0; b < NBuilders; ++b) {
+		const FlatVectTreeBuilder &Builder = Builders[b];
+		if (!KeepTaskOrder) {
+			MergePiece NewPiece = { &Builder, 0, Builder.size(), 0 };
+			Pieces.push_back(NewPiece);
+			continue;
+		}
+		size_t NRuns = Builder.TaskRuns.size();
+		for (size_t r = 0; r < NRuns; ++r) {
+			size_t RunEnd = (r + 1 < NRuns) ? Builder.TaskRuns[r + 1].TopLevelBeg : Builder.size();
+			MergePiece NewPiece = { &Builder, Builder.TaskRuns[r].TopLevelBeg, RunEnd, Builder.TaskRuns[r].TaskIndex };
+			Pieces.push_back(NewPiece);
+		}
+	}
+	if (KeepTaskOrder)
+		std::stable_sort(Pieces.begin(), Pieces.end(),
+			[](const MergePiece &A, const MergePiece &B) { return A.TaskIndex < B.TaskIndex; });
+
+	// Calculating the range of each piece in each level (the level TreeDepth
+	// being Data) and its offset in the output
+	size_t NPieces = Pieces.size();
+	size_t NLevels = size_t(TreeDepth) + 1;
+	std::vector<size_t> PieceBegs(NPieces*NLevels), PieceOffsets((NPieces + 1)*NLevels, 0);
+
+	for (size_t p = 0; p < NPieces; ++p) {
+		size_t LevelBeg = Pieces[p].TopLevelBeg, LevelEnd = Pieces[p].TopLevelEnd;
+		for (uint32_t l = 0; l < NLevels; ++l) {
+			PieceBegs[p*NLevels + l] = LevelBeg;
+			PieceOffsets[(p + 1)*NLevels + l] = PieceOffsets[p*NLevels + l] + (LevelEnd - LevelBeg);
+			if (l < TreeDepth) {
+				const std::vector<IndexT> &Level = Pieces[p].Builder->PartitionIndex[l];
+				LevelBeg = Level[LevelBeg];
+				LevelEnd = Level[LevelEnd];
+			}
+		}
+	}
+
+	const size_t* LevelSizes = &PieceOffsets[NPieces*NLevels];
+	for (uint32_t l = 0; l < NLevels; ++l) {
+		if (LevelSizes[l] >= size_t(std::numeric_limits<IndexT>::max()))
+			WriteException(
+				FV_ExCodes::FV_INVALID_APPEND,
+				"The size of level %d of the merged tree (%llu) exceeds the range of the index type",
+				l, (unsigned long long)LevelSizes[l]
+			);
+	}
+
+	// Allocating the output (outside the parallel region)
+	MexVector<MexVector<IndexT, Al>, Al> NewPartitionIndex(TreeDepth);
+	for (uint32_t l = 0; l < TreeDepth; ++l) {
+		NewPartitionIndex[l].resize(LevelSizes[l] + 1);
+		NewPartitionIndex[l][0] = 0;
+	}
+	MexVector<T, Al> NewData(LevelSizes[TreeDepth]);
+
+	// Gathering the pieces
+	int64_t NPiecesSigned = NPieces;
+	#pragma omp parallel for schedule(dynamic, 1) if(LevelSizes[TreeDepth] + LevelSizes[0] >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t p = 0; p < NPiecesSigned; ++p) {
+		const FlatVectTreeBuilder &Builder = *Pieces[p].Builder;
+		const size_t* Begs = &PieceBegs[p*NLevels];
+		const size_t* Offsets = &PieceOffsets[p*NLevels];
+		const size_t* Ends = &PieceOffsets[(p + 1)*NLevels];
+
+		for (uint32_t l = 0; l < TreeDepth; ++l) {
+			const IndexT* LevelIn = Builder.PartitionIndex[l].data();
+			IndexT* LevelOut = NewPartitionIndex[l].begin() + Offsets[l] + 1;
+			IndexT Rebase = IndexT(Offsets[l + 1]) - LevelIn[Begs[l]];
+			size_t NElems = Ends[l] - Offsets[l];
+			for (size_t i = 0; i < NElems; ++i)
+				LevelOut[i] = LevelIn[Begs[l] + i + 1] + Rebase;
+		}
+		std::copy(
+			Builder.Data.begin() + Begs[TreeDepth],
+			Builder.Data.begin() + Begs[TreeDepth] + (Ends[TreeDepth] - Offsets[TreeDepth]),
+			NewData.begin() + Offsets[TreeDepth]);
+	}
+
+	FlatVectTreeOut.PartitionIndex.swap(NewPartitionIndex);
+	FlatVectTreeOut.Data.swap(NewData);
+	FlatVectTreeOut.isStructValidated = true;
+}
+
+#endif
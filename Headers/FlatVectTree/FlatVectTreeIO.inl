@@ -4,35 +4,87 @@
 #define VECT_TREE_FIELD_INFO_(T) FieldInfo< T, typename std::enable_if<isFlatVectTree< T >::value>::type>::
 
 template <typename T>
-inline bool VECT_TREE_FIELD_INFO_(T) CheckType(const mxArray* InputmxArray) {
-	bool isValid = true;
-	if (InputmxArray != nullptr && !mxIsEmpty(InputmxArray) && mxIsStruct(InputmxArray)) {
-		// Check if ClassName Field matches 'FlatCellArray'
+inline bool VECT_TREE_FIELD_INFO_(T) isFlatCellArrayStruct(const mxArray* InputmxArray) {
+	
+	// This function only checks if InputmxArray is a struct whose ClassName
+	// field is 'FlatCellArray'. The PartitionIndex and Data fields are not
+	// inspected.
+
+	bool isValid = false;
+	if (mxIsStruct(InputmxArray)) {
 		const mxArray* ClassNamemxArr = getValidStructField<char16_t>(InputmxArray, "ClassName");
 		if (ClassNamemxArr != nullptr) {
 			char* ClassNameStr = mxArrayToString(ClassNamemxArr);
-			if (!std::strcmp(ClassNameStr, "FlatCellArray")) {
-				// Extract elements from PartitionIndex and Data and confirm if 
-				// they represent a valid FlatVectTree / FlatCellArray
-				typedef typename isFlatVectTree<T>::type TypeofData;
-				
-				MexVector<MexVector<uint32_t> > PartitionIndex;
-				MexVector<TypeofData> Data;
-
-				moveIntoVectors(InputmxArray, PartitionIndex, Data);
-
-				// Validate FlatVectTree
-				isValid = FlatVectTree<TypeofData>::isValidFVT(PartitionIndex, Data);
-			}
-			else
-				isValid = false;
+			isValid = !std::strcmp(ClassNameStr, "FlatCellArray");
 			mxFree(ClassNameStr);
 		}
+	}
+	return isValid;
+}
+
+template <typename T>
+inline bool VECT_TREE_FIELD_INFO_(T) CheckPartitionIndexType(const mxArray* PartitionIndexmxArr) {
+
+	// The PartitionIndex must be a cell array of vectors all of which are of
+	// the same class. This class must either be that corresponding to the
+	// IndexT of the FlatVectTree, or uint32 if IndexT is wider (in which case
+	// the indices are widened by moveIntoVectors)
+
+	typedef typename isFlatVectTree<T>::indexType IndexT;
+
+	if (PartitionIndexmxArr == nullptr || mxIsEmpty(PartitionIndexmxArr))
+		return true;
+	if (!mxIsCell(PartitionIndexmxArr))
+		return false;
+
+	const mxArray* const* LevelsmxArr = reinterpret_cast<const mxArray* const*>(mxGetData(PartitionIndexmxArr));
+	size_t TreeDepth = mxGetNumberOfElements(PartitionIndexmxArr);
+	mxClassID LevelClassID = mxUNKNOWN_CLASS;
+
+	for (size_t i = 0; i < TreeDepth; ++i) {
+		if (LevelsmxArr[i] == nullptr || mxIsEmpty(LevelsmxArr[i]))
+			continue;
+
+		mxClassID CurrClassID = mxGetClassID(LevelsmxArr[i]);
+		if (LevelClassID == mxUNKNOWN_CLASS)
+			LevelClassID = CurrClassID;
+
+		bool isValidLevel;
+		if (CurrClassID != LevelClassID)
+			isValidLevel = false;
+		else if (CurrClassID == GetMexType<IndexT>::typeVal)
+			isValidLevel = FieldInfo<MexVector<IndexT> >::CheckType(LevelsmxArr[i]);
+		else
+			isValidLevel = sizeof(IndexT) > sizeof(uint32_t) && FieldInfo<MexVector<uint32_t> >::CheckType(LevelsmxArr[i]);
+
+		if (!isValidLevel)
+			return false;
+	}
+	return true;
+}
+
+template <typename T>
+inline bool VECT_TREE_FIELD_INFO_(T) CheckType(const mxArray* InputmxArray) {
+	bool isValid = true;
+	if (InputmxArray != nullptr && !mxIsEmpty(InputmxArray)) {
+		// Check if ClassName Field matches 'FlatCellArray'
+		if (isFlatCellArrayStruct(InputmxArray)) {
+			// Extract elements from PartitionIndex and Data and confirm if 
+			// they represent a valid FlatVectTree / FlatCellArray
+			typedef typename isFlatVectTree<T>::type TypeofData;
+			typedef typename isFlatVectTree<T>::indexType IndexT;
+			
+			MexVector<MexVector<IndexT> > PartitionIndex;
+			MexVector<TypeofData> Data;
+
+			moveIntoVectors(InputmxArray, PartitionIndex, Data);
+
+			// Validate FlatVectTree
+			isValid = T::isValidFVT(PartitionIndex, Data);
+		}
 		else
 			isValid = false;
 	}
-	else if (InputmxArray != nullptr && !mxIsEmpty(InputmxArray))
-		isValid = false;
 	else
 		isValid = true;
 
@@ -40,7 +92,48 @@ inline bool VECT_TREE_FIELD_INFO_(T) CheckType(const mxArray* InputmxArray) {
 }
 
 template <typename T>
-inline uint32_t VECT_TREE_FIELD_INFO_(T) getSize(const mxArray* InputmxArray) {
+inline bool VECT_TREE_FIELD_INFO_(T) CheckTypeAndAssign(const mxArray* InputmxArray, T &FlatVectTreeIn, bool isTrusted) {
+
+	// This function performs the work of CheckType and getInputfrommxArray in a
+	// single pass i.e. the fields are extracted and the FlatVectTree is
+	// validated exactly once before being copied into FlatVectTreeIn. It
+	// returns false (leaving FlatVectTreeIn unmodified) if InputmxArray is not
+	// a valid FlatCellArray. An empty InputmxArray is valid and clears
+	// FlatVectTreeIn (keeping its depth).
+	//
+	// If isTrusted is true, the types of the fields are still checked but the
+	// partition indices are not traversed and FlatVectTreeIn is marked as not
+	// validated (see FlatVectTree::validate).
+
+	typedef typename isFlatVectTree<T>::type TypeofData;
+	typedef typename isFlatVectTree<T>::indexType IndexT;
+
+	if (InputmxArray == nullptr || mxIsEmpty(InputmxArray)) {
+		FlatVectTreeIn.clear();
+		return true;
+	}
+	if (!isFlatCellArrayStruct(InputmxArray))
+		return false;
+
+	// Validate the types of the fields (this does not traverse the data)
+	if (!CheckPartitionIndexType(mxGetField(InputmxArray, 0, "PartitionIndex"))
+	    || !FieldInfo<TypeofData>::CheckType(mxGetField(InputmxArray, 0, "Data")))
+		return false;
+
+	MexVector<MexVector<IndexT> > PartitionIndex;
+	MexVector<TypeofData> Data;
+
+	moveIntoVectors(InputmxArray, PartitionIndex, Data, false);
+
+	if (!isTrusted && !T::isValidFVT(PartitionIndex, Data))
+		return false;
+
+	FlatVectTreeIn.assignFast(PartitionIndex, Data, true, !isTrusted);
+	return true;
+}
+
+template <typename T>
+inline size_t VECT_TREE_FIELD_INFO_(T) getSize(const mxArray* InputmxArray) {
 	
 	// This function performs no validation of the data except for preventing 
 	// read of nullptr
@@ -54,8 +147,8 @@ inline uint32_t VECT_TREE_FIELD_INFO_(T) getSize(const mxArray* InputmxArray) {
 		if (PartitionIndexmxArr != nullptr && !mxIsEmpty(PartitionIndexmxArr)) {
 			mxArrayPtr PartitionIndexTopLevel = mxGetCell(PartitionIndexmxArr, 0);
 			if (PartitionIndexTopLevel != nullptr) {
-				uint32_t temp = mxGetNumberOfElements(PartitionIndexTopLevel);
-				NumElems = (temp > 0) ? temp - 1 : 0;
+				size_t TopLevelNElems = mxGetNumberOfElements(PartitionIndexTopLevel);
+				NumElems = (TopLevelNElems > 0) ? TopLevelNElems - 1 : 0;
 			}
 		}
 	}
@@ -63,7 +156,7 @@ inline uint32_t VECT_TREE_FIELD_INFO_(T) getSize(const mxArray* InputmxArray) {
 }
 
 template<typename T>
-inline uint32_t VECT_TREE_FIELD_INFO_(T) getDepth(const mxArray* InputmxArray)
+inline size_t VECT_TREE_FIELD_INFO_(T) getDepth(const mxArray* InputmxArray)
 {
 	// This function performs no validation of the data except for preventing 
 	// read of nullptr
@@ -84,22 +177,33 @@ inline uint32_t VECT_TREE_FIELD_INFO_(T) getDepth(const mxArray* InputmxArray)
 template<typename T>
 inline void VECT_TREE_FIELD_INFO_(T) moveIntoVectors(
 	const mxArray* InputmxArray, 
-	MexVector<MexVector<uint32_t> >& PartitionIndexIn, 
-	MexVector<typename isFlatVectTree<T>::type>& DataIn)
+	MexVector<MexVector<typename isFlatVectTree<T>::indexType> >& PartitionIndexIn, 
+	MexVector<typename isFlatVectTree<T>::type>& DataIn,
+	bool CheckFieldTypes)
 {
 	// This function moves the data in InputmxArray (interpreted as a FlatCellArray)
 	// into the given PartitionIndexIn and DataIn. If the PartitionIndex and Data
 	// fields are of invalid type then it raises an exception. If they are empty, then
 	// he corresponding vector is empty. The function makes no attempt to verify
-	// the correctness of the data.
+	// the correctness of the data. If CheckFieldTypes is false, the types of the
+	// fields are assumed to have been validated by the caller.
+	//
+	// The levels of PartitionIndex are moved (wrapped without copy) if their
+	// class matches IndexT. uint32 levels given for a wider IndexT are copied
+	// into PartitionIndexIn with widening.
 
 	// Getting and type validating the fields "PartitionIndexIn" and "Data"
 	typedef typename isFlatVectTree<T>::type TypeofData;
-	const mxArray* PartitionIndexmxArr = getValidStructField<MexVector<MexVector<uint32_t> > >(InputmxArray, "PartitionIndex");
-	const mxArray* DatamxArr = getValidStructField<TypeofData>(InputmxArray, "Data");
+	typedef typename isFlatVectTree<T>::indexType IndexT;
+	const mxArray* PartitionIndexmxArr = getValidStructField(InputmxArray, "PartitionIndex", MexMemInputOps(), false);
+	const mxArray* DatamxArr = getValidStructField<TypeofData>(InputmxArray, "Data", MexMemInputOps(), CheckFieldTypes);
+
+	if (CheckFieldTypes && !CheckPartitionIndexType(PartitionIndexmxArr)) {
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The Field '%s' does not match the type required.\n", "PartitionIndex");
+	}
 
 	// Calculating TreeDepth
-	uint32_t TreeDepth = 0;
+	size_t TreeDepth = 0;
 	if (PartitionIndexmxArr)
 		TreeDepth = mxGetNumberOfElements(PartitionIndexmxArr);
 	
@@ -109,12 +213,20 @@ inline void VECT_TREE_FIELD_INFO_(T) moveIntoVectors(
 
 	// Filling PartitionIndexIn
 	if (TreeDepth > 0) {
-		PartitionIndexIn.resize(TreeDepth, MexVector<uint32_t>());
+		PartitionIndexIn.resize(TreeDepth, MexVector<IndexT>());
 		mxArrayPtr * PartitionIndexLevelsmxArr = (mxArrayPtr *)mxGetData(PartitionIndexmxArr);
-		for (int i = 0; i < TreeDepth; ++i) {
-			int LevelNElems = FieldInfo<MexVector<uint32_t> >::getSize(PartitionIndexLevelsmxArr[i]);
-			if (LevelNElems > 0) {
-				PartitionIndexIn[i].assign(LevelNElems, (uint32_t *)mxGetData(PartitionIndexLevelsmxArr[i]), false);
+		for (size_t i = 0; i < TreeDepth; ++i) {
+			size_t LevelNElems = FieldInfo<MexVector<IndexT> >::getSize(PartitionIndexLevelsmxArr[i]);
+			if (LevelNElems > 0 && mxGetClassID(PartitionIndexLevelsmxArr[i]) == GetMexType<IndexT>::typeVal) {
+				PartitionIndexIn[i].assign(LevelNElems, (IndexT *)mxGetData(PartitionIndexLevelsmxArr[i]), false);
+			}
+			else if (LevelNElems > 0) {
+				// Widening uint32 indices
+				uint32_t* LevelIndices = (uint32_t *)mxGetData(PartitionIndexLevelsmxArr[i]);
+				PartitionIndexIn[i].resize(LevelNElems);
+				for (size_t j = 0; j < LevelNElems; ++j) {
+					PartitionIndexIn[i][j] = LevelIndices[j];
+				}
 			}
 		}
 	}
@@ -124,7 +236,88 @@ inline void VECT_TREE_FIELD_INFO_(T) moveIntoVectors(
 		DataIn.assign(mxGetNumberOfElements(DatamxArr), (TypeofData *)mxGetData(DatamxArr), false);
 }
 
-template<typename T> inline mxArrayPtr assignmxArray(FlatVectTree<T> &FlatVectTreeOut) {
+template<typename T>
+inline void VECT_TREE_FIELD_INFO_(T) assignCellArrayLevels(
+	const MexVector<MexVector<const mxArray*> > &LevelNodes,
+	mxClassID LeafClass,
+	uint32_t Depth,
+	T &FlatVectTreeOut)
+{
+	// This function builds FlatVectTreeOut (of depth Depth) from the levels of
+	// a cell array as returned by getCellArrayLevels. The leaves (of class
+	// LeafClass) are converted to the type of Data. Depth must be at least
+	// LevelNodes.size() and may exceed it only if there are no leaves, in which
+	// case the remaining levels are empty. No further validation is performed
+	// (in particular, the sizes of the levels must fit in IndexT, see
+	// getCellArrayMaxLevelSize).
+	//
+	// The partition indices of each level are computed as the (parallel)
+	// prefix sum of the number of elements of its nodes and the leaves are
+	// copied in parallel.
+
+	typedef typename isFlatVectTree<T>::indexType IndexT;
+
+	uint32_t NLevels = LevelNodes.size();
+
+	decltype(FlatVectTreeOut.PartitionIndex) PartitionIndexOut(Depth);
+	decltype(FlatVectTreeOut.Data) DataOut;
+
+	for (uint32_t Level = 0; Level < Depth; ++Level) {
+		if (Level >= NLevels) {
+			PartitionIndexOut[Level].resize(1, IndexT(0));
+			continue;
+		}
+
+		const mxArray* const * Nodes = LevelNodes[Level].begin();
+		int64_t NNodes = LevelNodes[Level].size();
+
+		PartitionIndexOut[Level].resize(NNodes + 1);
+		IndexT* LevelOffsets = PartitionIndexOut[Level].begin();
+		LevelOffsets[0] = 0;
+
+		#pragma omp parallel for if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t i = 0; i < NNodes; ++i) {
+			LevelOffsets[i + 1] = (Nodes[i] != nullptr) ? mxGetNumberOfElements(Nodes[i]) : 0;
+		}
+		InclusivePrefixSum(LevelOffsets + 1, NNodes);
+	}
+
+	// Copying the leaves into Data
+	if (LeafClass != mxUNKNOWN_CLASS && Depth > 0) {
+		const MexVector<const mxArray*> &Leaves = LevelNodes[NLevels - 1];
+		const IndexT* LeafOffsets = PartitionIndexOut[NLevels - 1].begin();
+		DataOut.resize(PartitionIndexOut[NLevels - 1].last());
+
+		switch (LeafClass) {
+			case mxDOUBLE_CLASS  : copyCellArrayLeaves<double  >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxSINGLE_CLASS  : copyCellArrayLeaves<float   >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxINT8_CLASS    : copyCellArrayLeaves<int8_t  >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxUINT8_CLASS   : copyCellArrayLeaves<uint8_t >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxINT16_CLASS   : copyCellArrayLeaves<int16_t >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxUINT16_CLASS  : copyCellArrayLeaves<uint16_t>(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxINT32_CLASS   : copyCellArrayLeaves<int32_t >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxUINT32_CLASS  : copyCellArrayLeaves<uint32_t>(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxINT64_CLASS   : copyCellArrayLeaves<int64_t >(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxUINT64_CLASS  : copyCellArrayLeaves<uint64_t>(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxLOGICAL_CLASS : copyCellArrayLeaves<mxLogical>(Leaves, LeafOffsets, DataOut.begin()); break;
+			case mxCHAR_CLASS    : copyCellArrayLeaves<mxChar  >(Leaves, LeafOffsets, DataOut.begin()); break;
+			default:
+				WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The leaves of the cell array are of unsupported class '%s'.\n", mxGetClassName(Leaves[0]));
+		}
+	}
+
+	FlatVectTreeOut.PartitionIndex.swap(PartitionIndexOut);
+	FlatVectTreeOut.Data.swap(DataOut);
+	FlatVectTreeOut.isStructValidated = true;
+}
+
+template<typename IndexT, typename T> inline mxArrayPtr assignmxFlatCellArray(
+	MexVector<MexVector<IndexT> > &PartitionIndex,
+	MexVector<T> &Data) {
+
+	// Creates the struct representing a FlatCellArray from the given
+	// PartitionIndex and Data. The memory of both vectors is moved into the
+	// returned mxArray. No validation is performed.
 
 	const char* FieldNames[] = {
 		"ClassName",
@@ -135,11 +328,6 @@ template<typename T> inline mxArrayPtr assignmxArray(FlatVectTree<T> &FlatVectTr
 	mwSize ArraySize[] = { 1, 1 };
 
 	mxArrayPtr ReturnPtr = mxCreateStructArray(2, ArraySize, 3, FieldNames);
-	
-	// Releasing Memory of FlatVectTreeOut
-	MexVector<MexVector<uint32_t> > PartitionIndex;
-	MexVector<T> Data;
-	FlatVectTreeOut.releaseMem(PartitionIndex, Data);
 
 	mxSetField(ReturnPtr, 0, "ClassName"     , mxCreateString("FlatCellArray"));
 	mxSetField(ReturnPtr, 0, "PartitionIndex", assignmxArray(PartitionIndex));
@@ -148,36 +336,264 @@ template<typename T> inline mxArrayPtr assignmxArray(FlatVectTree<T> &FlatVectTr
 	return ReturnPtr;
 }
 
-template <typename T, class Al> static void getInputfrommxArray(const mxArray* InputArray, FlatVectTree<T, Al> &FlatVectTreeIn) {
-
-	// Note: in this function, it is assumed that InputArray is a Valid FlatVectTreeIn
-	// with non-zero depth.
+template<typename T, typename IndexT> inline mxArrayPtr assignmxArray(FlatVectTree<T, mxAllocator, IndexT> &FlatVectTreeOut) {
 
-	// Declared with mxAllocator as they are to be used to move the 
-	// input mex arrays
-	MexVector<MexVector<uint32_t> > PartitionIndex;
+	// Releasing Memory of FlatVectTreeOut
+	MexVector<MexVector<IndexT> > PartitionIndex;
 	MexVector<T> Data;
+	FlatVectTreeOut.releaseMem(PartitionIndex, Data);
 
-	FieldInfo<FlatVectTree<T, Al> >::moveIntoVectors(InputArray, PartitionIndex, Data);
-	FlatVectTreeIn.assign(PartitionIndex, Data);
+	return assignmxFlatCellArray(PartitionIndex, Data);
 }
 
-template <typename TSpec, typename T, typename B, class Al> static int getInputfromStruct(
+template <typename IndexT, typename T, class AlSub, class Al> inline mxArrayPtr assignmxFlatCellArray(MexVector<MexVector<T, AlSub>, Al> &VectTreeOut) {
+
+	// This function returns the given nested MexVector as a FlatCellArray
+	// struct (the same as that returned by assignmxArray(FlatVectTree&))
+	// instead of a cell array. Only 3 + depth mxArrays are created
+	// irrespective of the number of leaves. As with the other assignmxArray
+	// functions, the memory of VectTreeOut is released. The type of the
+	// partition indices is given by IndexT (uint32_t by default).
+
+	typedef typename getTreeInfo<MexVector<MexVector<T, AlSub>, Al> >::type TypeofData;
+
+	// The nested vector is flattened by the (parallel) bulk construction of
+	// FlatVectTree, which also releases the memory of VectTreeOut
+	FlatVectTree<TypeofData, mxAllocator, IndexT> FlatVectTreeOut;
+	FlatVectTreeOut.build(std::move(VectTreeOut));
+
+	return assignmxArray(FlatVectTreeOut);
+}
+
+template <typename T, class Al, typename IndexT> static bool getCheckedInputfrommxArray(const mxArray* InputArray, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, bool isTrusted) {
+	return FieldInfo<FlatVectTree<T, Al, IndexT> >::CheckTypeAndAssign(InputArray, FlatVectTreeIn, isTrusted);
+}
+
+template <typename T, class Al, typename IndexT> static void getInputfrommxArray(const mxArray* InputArray, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn) {
+	if (!getCheckedInputfrommxArray(InputArray, FlatVectTreeIn)) {
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a valid FlatCellArray of the required type.\n");
+	}
+}
+
+inline bool getCellArrayLevels(const mxArray* CellArrayIn, MexVector<MexVector<const mxArray*> > &LevelNodes, mxClassID &LeafClass) {
+
+	// This function traverses the cell array CellArrayIn level by level and
+	// stores in LevelNodes[L] the mxArrays of the elements at level L (the
+	// elements of CellArrayIn being at level 0). The traversal stops at the
+	// first level that contains no cell arrays. This is the level of the leaf
+	// vectors, and the number of levels is the depth of the cell array.
+	// LeafClass is the class of the leaves. If there are no leaves, the type is
+	// undecided and LeafClass is mxUNKNOWN_CLASS.
+	//
+	// It returns false if CellArrayIn is not a cell array, if any level
+	// contains both cell arrays and non-cell arrays (i.e. the depth is not
+	// uniform) or if the leaves are not all of the same class. Uninitialized
+	// elements (nullptr) are treated as empty double arrays as in MATLAB.
+
+	LevelNodes.resize(0);
+	LeafClass = mxUNKNOWN_CLASS;
+
+	if (CellArrayIn == nullptr || !mxIsCell(CellArrayIn))
+		return false;
+
+	MexVector<const mxArray*> CurrNodes(mxGetNumberOfElements(CellArrayIn));
+	if (CurrNodes.size() > 0)
+		memcpy(CurrNodes.begin(), mxGetData(CellArrayIn), CurrNodes.size()*sizeof(const mxArray*));
+
+	while (true) {
+		int64_t NNodes = CurrNodes.size();
+		int64_t NCells = 0;
+
+		#pragma omp parallel for reduction(+:NCells) if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t i = 0; i < NNodes; ++i) {
+			NCells += (CurrNodes[i] != nullptr && mxIsCell(CurrNodes[i]));
+		}
+
+		LevelNodes.push_back(MexVector<const mxArray*>());
+		LevelNodes.last().swap(CurrNodes);
+
+		if (NCells == 0)
+			break;
+		else if (NCells != NNodes)
+			return false;
+
+		// Gathering the elements of all the cell arrays in the current level
+		const mxArray* const * Nodes = LevelNodes.last().begin();
+		MexVector<size_t> ChildOffsets(NNodes + 1);
+		ChildOffsets[0] = 0;
+
+		#pragma omp parallel for if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t i = 0; i < NNodes; ++i) {
+			ChildOffsets[i + 1] = mxGetNumberOfElements(Nodes[i]);
+		}
+		size_t NChildren = InclusivePrefixSum(ChildOffsets.begin() + 1, NNodes);
+
+		CurrNodes.resize(NChildren);
+		#pragma omp parallel for schedule(dynamic, 256) if(NNodes >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t i = 0; i < NNodes; ++i) {
+			size_t NCurrChildren = ChildOffsets[i + 1] - ChildOffsets[i];
+			if (NCurrChildren > 0)
+				memcpy(CurrNodes.begin() + ChildOffsets[i], mxGetData(Nodes[i]), NCurrChildren*sizeof(const mxArray*));
+		}
+	}
+
+	// Validating the class of the leaves
+	const mxArray* const * Leaves = LevelNodes.last().begin();
+	int64_t NLeaves = LevelNodes.last().size();
+
+	if (NLeaves > 0) {
+		LeafClass = (Leaves[0] != nullptr) ? mxGetClassID(Leaves[0]) : mxDOUBLE_CLASS;
+		int64_t NMismatches = 0;
+
+		#pragma omp parallel for reduction(+:NMismatches) if(NLeaves >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t i = 0; i < NLeaves; ++i) {
+			mxClassID CurrClass = (Leaves[i] != nullptr) ? mxGetClassID(Leaves[i]) : mxDOUBLE_CLASS;
+			NMismatches += (CurrClass != LeafClass);
+		}
+		if (NMismatches > 0)
+			return false;
+	}
+	return true;
+}
+
+inline size_t getCellArrayMaxLevelSize(const MexVector<MexVector<const mxArray*> > &LevelNodes) {
+
+	// Returns the maximum number of elements in any level of the cell array
+	// whose levels are given by LevelNodes (see getCellArrayLevels), including
+	// the level of the elements of the leaves. This is used to decide the
+	// type of the partition indices.
+
+	size_t MaxLevelSize = 0;
+	for (size_t i = 0; i < LevelNodes.size(); ++i) {
+		MaxLevelSize = (LevelNodes[i].size() > MaxLevelSize) ? LevelNodes[i].size() : MaxLevelSize;
+	}
+
+	if (LevelNodes.size() > 0) {
+		const mxArray* const * Leaves = LevelNodes.last().begin();
+		int64_t NLeaves = LevelNodes.last().size();
+		size_t NLeafElems = 0;
+
+		#pragma omp parallel for reduction(+:NLeafElems) if(NLeaves >= MEXMEM_PARALLEL_THRESHOLD)
+		for (int64_t i = 0; i < NLeaves; ++i) {
+			NLeafElems += (Leaves[i] != nullptr) ? mxGetNumberOfElements(Leaves[i]) : 0;
+		}
+		MaxLevelSize = (NLeafElems > MaxLevelSize) ? NLeafElems : MaxLevelSize;
+	}
+	return MaxLevelSize;
+}
+
+template <typename SrcT, typename T, typename IndexT>
+inline void copyCellArrayLeaves(const MexVector<const mxArray*> &Leaves, const IndexT* LeafOffsets, T* DataOut) {
+
+	// Copies the leaves (whose data is of type SrcT) into DataOut at the given
+	// offsets. The conversion is performed by static_cast (i.e. unlike MATLAB,
+	// floating point values are truncated when converted to integers)
+
+	int64_t NLeaves = Leaves.size();
+
+	#pragma omp parallel for schedule(dynamic, 256) if(NLeaves >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t i = 0; i < NLeaves; ++i) {
+		size_t LeafSize = LeafOffsets[i + 1] - LeafOffsets[i];
+		if (LeafSize == 0)
+			continue;
+		const SrcT* LeafData = (const SrcT*)mxGetData(Leaves[i]);
+		T* LeafOut = DataOut + LeafOffsets[i];
+		for (size_t j = 0; j < LeafSize; ++j) {
+			LeafOut[j] = static_cast<T>(LeafData[j]);
+		}
+	}
+}
+
+template <typename T, class Al, typename IndexT> static bool getCheckedInputfromCellArray(const mxArray* CellArrayIn, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, uint32_t RequiredDepth) {
+
+	// This function flattens the cell array CellArrayIn (of runtime depth)
+	// into FlatVectTreeIn without creating the intermediate nested vector. It
+	// returns false (leaving FlatVectTreeIn unmodified) if CellArrayIn is not a
+	// valid cell array of depth RequiredDepth with leaves of type T. A cell
+	// array with no leaves (i.e. of undecided type) of a lower depth is valid,
+	// the remaining levels being empty.
+
+	MexVector<MexVector<const mxArray*> > LevelNodes;
+	mxClassID LeafClass;
+
+	if (!getCellArrayLevels(CellArrayIn, LevelNodes, LeafClass))
+		return false;
+
+	uint32_t CellArrayDepth = LevelNodes.size();
+	if ((LeafClass != mxUNKNOWN_CLASS && (LeafClass != GetMexType<T>::typeVal || CellArrayDepth != RequiredDepth))
+		|| CellArrayDepth > RequiredDepth
+		|| getCellArrayMaxLevelSize(LevelNodes) > std::numeric_limits<IndexT>::max())
+		return false;
+
+	FieldInfo<FlatVectTree<T, Al, IndexT> >::assignCellArrayLevels(LevelNodes, LeafClass, RequiredDepth, FlatVectTreeIn);
+	return true;
+}
+
+template <typename T, class Al, typename IndexT> static void getInputfromCellArray(const mxArray* CellArrayIn, FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, uint32_t RequiredDepth) {
+	if (!getCheckedInputfromCellArray(CellArrayIn, FlatVectTreeIn, RequiredDepth)) {
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a valid cell array of the required type and depth (%d).\n", RequiredDepth);
+	}
+}
+
+template <typename T, class Al, typename IndexT> inline mxArrayPtr assignmxCellArray(const FlatVectTreeView<T, Al, IndexT> &VectTreeView) {
+
+	// This function returns the elements of the given view as a (nested)
+	// column cell array. A leaf view is returned as a column vector. Unlike
+	// the assignmxArray functions, the data is copied and the FlatVectTree is
+	// left unmodified. As the MATLAB API is not thread safe, this is serial.
+
+	if (VectTreeView.isLeaf()) {
+		mxArrayPtr ReturnPtr = mxCreateNumericMatrix(VectTreeView.size(), 1, GetMexType<T>::typeVal, mxREAL);
+		if (!VectTreeView.isempty())
+			memcpy(mxGetData(ReturnPtr), VectTreeView.span().begin(), VectTreeView.size()*sizeof(T));
+		return ReturnPtr;
+	}
+
+	mxArrayPtr ReturnPtr = mxCreateCellMatrix(VectTreeView.size(), 1);
+	size_t i = 0;
+	for (auto Child : VectTreeView) {
+		mxSetCell(ReturnPtr, i++, assignmxCellArray(Child));
+	}
+	return ReturnPtr;
+}
+
+template <typename T, class Al, typename IndexT> inline mxArrayPtr assignmxCellArray(const FlatVectTree<T, Al, IndexT> &FlatVectTreeOut) {
+	return assignmxCellArray(FlatVectTreeOut.view());
+}
+
+template <typename TSpec, typename T, typename B, class Al, typename IndexT> static int getInputfromStruct(
 	const mxArray* InputStruct, const char* FieldName, 
-	FlatVectTree<T, Al> &FlatVectTreeIn, uint32_t RequiredDepth,
+	FlatVectTree<T, Al, IndexT> &FlatVectTreeIn, uint32_t RequiredDepth,
 	MexMemInputOps InputOps) {
 
-	const mxArray* StructFieldPtr = getValidStructField<FlatVectTree<T,Al> >(InputStruct, FieldName, InputOps);
+	// The validation of the FlatCellArray is skipped in getValidStructField
+	// as it is performed while assigning by getCheckedInputfrommxArray
+	const mxArray* StructFieldPtr = getValidStructField<FlatVectTree<T, Al, IndexT> >(InputStruct, FieldName, InputOps, false);
 	if (StructFieldPtr != nullptr) {
-		uint32_t GivenTreeDepth = FieldInfo<FlatVectTree<T, Al> >::getDepth(StructFieldPtr);
+		if (!mxIsEmpty(StructFieldPtr) && !FieldInfo<FlatVectTree<T, Al, IndexT> >::isFlatCellArrayStruct(StructFieldPtr)) {
+			if (!InputOps.QUIET)
+				WriteOutput("The Field '%s' does not match the type required.\n", FieldName);
+			if (!InputOps.NO_EXCEPT)
+				throw ExOps::EXCEPTION_INVALID_INPUT;
+			return 1;
+		}
+		size_t GivenTreeDepth = FieldInfo<FlatVectTree<T, Al, IndexT> >::getDepth(StructFieldPtr);
 		if (GivenTreeDepth > 0 && GivenTreeDepth != RequiredDepth) {
 			if (!InputOps.QUIET)
-				WriteOutput("The depth of the given FlatVectTree (%d), does not match the depth required (%d)\n", GivenTreeDepth, RequiredDepth);
+				WriteOutput("The depth of the given FlatVectTree (%llu), does not match the depth required (%d)\n", (unsigned long long)GivenTreeDepth, RequiredDepth);
 			if (!InputOps.NO_EXCEPT)
 				throw ExOps::EXCEPTION_INVALID_INPUT;
+			return 1;
+		}
+		else if (GivenTreeDepth > 0) {
+			if (!getCheckedInputfrommxArray(StructFieldPtr, FlatVectTreeIn, InputOps.IS_TRUSTED)) {
+				if (!InputOps.QUIET)
+					WriteOutput("The Field '%s' does not match the type required.\n", FieldName);
+				if (!InputOps.NO_EXCEPT)
+					throw ExOps::EXCEPTION_INVALID_INPUT;
+				return 1;
+			}
 		}
-		else if (GivenTreeDepth > 0)
-			getInputfrommxArray(StructFieldPtr, FlatVectTreeIn);
 		else
 			return 1;
 		return 0;
@@ -185,4 +601,4 @@ template <typename TSpec, typename T, typename B, class Al> static int getInputf
 	else {
 		return 1;
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,164 @@
+#ifndef FLAT_VECT_TREE_VIEW_HPP
+#define FLAT_VECT_TREE_VIEW_HPP
+
+#include <stdint.h>
+
+#include "../MexMem.hpp"
+#include "../GenericMexIO.hpp"
+
+// FlatVectTreeSpan is a non-owning view of a contiguous range of the Data of
+// a FlatVectTree i.e. of a single leaf vector.
+template<typename T>
+class FlatVectTreeSpan {
+
+	const T* Array_Beg;
+	const T* Array_Last;
+
+public:
+	typedef const T* iterator;
+
+	inline FlatVectTreeSpan() : Array_Beg(nullptr), Array_Last(nullptr) {}
+	inline FlatVectTreeSpan(const T* Beg, const T* Last) : Array_Beg(Beg), Array_Last(Last) {}
+
+	inline const T& operator[] (size_t Index) const {
+		return Array_Beg[Index];
+	}
+	inline const T& at(size_t Index) const {
+		if (Index >= this->size())
+			WriteException(
+				FV_ExCodes::FV_INVALID_FETCH,
+				"The index requested (%llu) exceeds the size of the leaf vector (%llu)",
+				(unsigned long long)Index, (unsigned long long)this->size()
+			);
+		return Array_Beg[Index];
+	}
+	inline iterator begin() const {
+		return Array_Beg;
+	}
+	inline iterator end() const {
+		return Array_Last;
+	}
+	inline size_t size() const {
+		return Array_Last - Array_Beg;
+	}
+	inline bool isempty() const {
+		return Array_Last == Array_Beg;
+	}
+};
+
+// FlatVectTreeView is a non-owning view of a contiguous range of elements
+// [Beg, End) in the level Level of a FlatVectTree. The view of a single node
+// of the tree is the range of its children. If Level == Depth, the elements
+// are those of Data, and the view represents a leaf vector (see span()).
+//
+// Accessing a child (operator[], at) and iterating over the children
+// (begin(), end()) are O(1) per step and do not allocate. Views remain valid
+// as long as the FlatVectTree is not modified.
+template<typename T, class Al = mxAllocator, typename IndexT = uint32_t>
+class FlatVectTreeView {
+
+	const MexVector<IndexT, Al>* Levels;
+	const T* Data;
+	uint32_t Depth;
+	uint32_t Level;
+	IndexT Beg;
+	IndexT End;
+
+public:
+
+	// Cursor over the children of a view. It holds copies of the relevant
+	// members so that it remains valid even if the view it was obtained from
+	// goes out of scope.
+	class iterator {
+		const MexVector<IndexT, Al>* Levels;
+		const T* Data;
+		uint32_t Depth;
+		uint32_t Level;
+		IndexT Pos;
+	public:
+		inline iterator(const MexVector<IndexT, Al>* Levels_, const T* Data_, uint32_t Depth_, uint32_t Level_, IndexT Pos_) :
+			Levels(Levels_), Data(Data_), Depth(Depth_), Level(Level_), Pos(Pos_) {}
+		inline FlatVectTreeView operator*() const {
+			return FlatVectTreeView(Levels, Data, Depth, Level, Pos, Pos + 1).getChild(Pos);
+		}
+		inline iterator& operator++() {
+			++Pos;
+			return *this;
+		}
+		inline iterator operator++(int) {
+			iterator Temp = *this;
+			++Pos;
+			return Temp;
+		}
+		inline bool operator==(const iterator &Other) const {
+			return Pos == Other.Pos;
+		}
+		inline bool operator!=(const iterator &Other) const {
+			return Pos != Other.Pos;
+		}
+	};
+
+	inline FlatVectTreeView() : Levels(nullptr), Data(nullptr), Depth(0), Level(0), Beg(0), End(0) {}
+	inline FlatVectTreeView(const MexVector<IndexT, Al>* Levels_, const T* Data_, uint32_t Depth_, uint32_t Level_, IndexT Beg_, IndexT End_) :
+		Levels(Levels_), Data(Data_), Depth(Depth_), Level(Level_), Beg(Beg_), End(End_) {}
+
+	// Property Access Functions
+	inline size_t   size() const     { return End - Beg; }
+	inline bool     isempty() const  { return End == Beg; }
+	inline bool     isLeaf() const   { return Level == Depth; }
+	inline uint32_t depth() const    { return Depth - Level; }  // depth of the sub-tree
+	inline uint32_t level() const    { return Level; }
+	inline IndexT   levelBeg() const { return Beg; }
+	inline IndexT   levelEnd() const { return End; }
+
+	// Child Access Functions (unchecked and checked). The view must not be a
+	// leaf
+	inline FlatVectTreeView operator[] (size_t Index) const {
+		return getChild(Beg + Index);
+	}
+	inline FlatVectTreeView at(size_t Index) const {
+		if (this->isLeaf())
+			WriteException(
+				FV_ExCodes::FV_INVALID_FETCH,
+				"Attempted to access a child of a leaf vector"
+			);
+		if (Index >= this->size())
+			WriteException(
+				FV_ExCodes::FV_INVALID_FETCH,
+				"The index requested (%llu) exceeds the number of children (%llu) at Level %d",
+				(unsigned long long)Index, (unsigned long long)this->size(), Level
+			);
+		return getChild(Beg + Index);
+	}
+
+	// Iteration over children (for non-leaf views)
+	inline iterator begin() const {
+		return iterator(Levels, Data, Depth, Level, Beg);
+	}
+	inline iterator end() const {
+		return iterator(Levels, Data, Depth, Level, End);
+	}
+
+	// Leaf Access Functions (unchecked and checked)
+	inline FlatVectTreeSpan<T> span() const {
+		return FlatVectTreeSpan<T>(Data + Beg, Data + End);
+	}
+	inline FlatVectTreeSpan<T> checkedSpan() const {
+		if (!this->isLeaf())
+			WriteException(
+				FV_ExCodes::FV_INVALID_FETCH,
+				"The view at Level %d is not a leaf vector (Depth = %d)",
+				Level, Depth
+			);
+		return span();
+	}
+
+	// This returns the view of the element at the given (absolute) index of
+	// the current level.
+	inline FlatVectTreeView getChild(IndexT LevelIndex) const {
+		const IndexT* CurrLevel = Levels[Level].begin();
+		return FlatVectTreeView(Levels, Data, Depth, Level + 1, CurrLevel[LevelIndex], CurrLevel[LevelIndex + 1]);
+	}
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef INDEX_VALIDATION_HPP
+#define INDEX_VALIDATION_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <algorithm>
+
+#include "../ParallelHelpers.hpp"
+
+// The monotonicity check of the levels of FlatVectTree::PartitionIndex is
+// vectorized using AVX2 or SSE2 when the compiler targets them (/arch:AVX2 or
+// -mavx2 for AVX2, SSE2 being implied on x64). Define MEXMEM_NO_SIMD to force
+// the scalar implementation.
+#ifndef MEXMEM_NO_SIMD
+#  if defined(__AVX2__)
+#    define MEXMEM_INDEX_VALIDATION_AVX2
+#  elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define MEXMEM_INDEX_VALIDATION_SSE2
+#  endif
+#endif
+
+#if defined(MEXMEM_INDEX_VALIDATION_AVX2)
+#  include <immintrin.h>
+#elif defined(MEXMEM_INDEX_VALIDATION_SSE2)
+#  include <emmintrin.h>
+#endif
+
+// Number of pairs checked between two tests for early exit
+#define MEXMEM_INDEX_VALIDATION_CHUNK 4096
+
+// The following functions return true if Array[i] <= Array[i + 1] for all i
+// in [0, NPairs) i.e. they read Array[0 .. NPairs]. As there is no unsigned
+// comparison in SSE2 / AVX2, the sign bits are flipped before a signed
+// comparison.
+
+template <typename IndexT>
+inline bool isNonDecreasingPairs(const IndexT* Array, size_t NPairs) {
+	bool isValid = true;
+	for (size_t i = 0; i < NPairs; ++i)
+		isValid &= (Array[i] <= Array[i + 1]);
+	return isValid;
+}
+
+inline bool isNonDecreasingPairs(const uint32_t* Array, size_t NPairs) {
+
+	size_t i = 0;
+
+#if defined(MEXMEM_INDEX_VALIDATION_AVX2)
+
+	const __m256i SignBit = _mm256_set1_epi32(int32_t(0x80000000));
+	__m256i Violations = _mm256_setzero_si256();
+	for (; i + 8 <= NPairs; i += 8) {
+		__m256i Curr = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(Array + i)), SignBit);
+		__m256i Next = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(Array + i + 1)), SignBit);
+		Violations = _mm256_or_si256(Violations, _mm256_cmpgt_epi32(Curr, Next));
+	}
+	if (!_mm256_testz_si256(Violations, Violations))
+		return false;
+
+#elif defined(MEXMEM_INDEX_VALIDATION_SSE2)
+
+	const __m128i SignBit = _mm_set1_epi32(int32_t(0x80000000));
+	__m128i Violations = _mm_setzero_si128();
+	for (; i + 4 <= NPairs; i += 4) {
+		__m128i Curr = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(Array + i)), SignBit);
+		__m128i Next = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(Array + i + 1)), SignBit);
+		Violations = _mm_or_si128(Violations, _mm_cmpgt_epi32(Curr, Next));
+	}
+	if (_mm_movemask_epi8(Violations))
+		return false;
+
+#endif
+
+	return isNonDecreasingPairs<uint32_t>(Array + i, NPairs - i);
+}
+
+inline bool isNonDecreasingPairs(const uint64_t* Array, size_t NPairs) {
+
+	size_t i = 0;
+
+	// SSE2 has no 64-bit comparison, so only AVX2 is vectorized
+#if defined(MEXMEM_INDEX_VALIDATION_AVX2)
+
+	const __m256i SignBit = _mm256_set1_epi64x(int64_t(0x8000000000000000ull));
+	__m256i Violations = _mm256_setzero_si256();
+	for (; i + 4 <= NPairs; i += 4) {
+		__m256i Curr = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(Array + i)), SignBit);
+		__m256i Next = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(Array + i + 1)), SignBit);
+		Violations = _mm256_or_si256(Violations, _mm256_cmpgt_epi64(Curr, Next));
+	}
+	if (!_mm256_testz_si256(Violations, Violations))
+		return false;
+
+#endif
+
+	return isNonDecreasingPairs<uint64_t>(Array + i, NPairs - i);
+}
+
+// Returns true if Array[0 .. N) is sorted in non-decreasing order. Large
+// arrays are split into one block per thread. Each block is checked in chunks
+// so that all threads stop soon after a violation is found.
+template <typename IndexT>
+inline bool isNonDecreasing(const IndexT* Array, size_t N) {
+
+	if (N < 2)
+		return true;
+
+	size_t NPairs = N - 1;
+	int NBlocks = (NPairs >= MEXMEM_PARALLEL_THRESHOLD) ? getMaxThreads() : 1;
+	std::atomic<bool> isValid(true);
+
+	#pragma omp parallel for schedule(static, 1) if(NBlocks > 1)
+	for (int b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = NPairs*b/NBlocks, BlockEnd = NPairs*(b + 1)/NBlocks;
+		for (size_t ChunkBeg = BlockBeg; ChunkBeg < BlockEnd && isValid.load(std::memory_order_relaxed); ChunkBeg += MEXMEM_INDEX_VALIDATION_CHUNK) {
+			size_t ChunkEnd = std::min<size_t>(ChunkBeg + MEXMEM_INDEX_VALIDATION_CHUNK, BlockEnd);
+			if (!isNonDecreasingPairs(Array + ChunkBeg, ChunkEnd - ChunkBeg))
+				isValid.store(false, std::memory_order_relaxed);
+		}
+	}
+	return isValid.load();
+}
+
+#endif
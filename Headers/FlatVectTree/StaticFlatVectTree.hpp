@@ -0,0 +1,311 @@
+#ifndef STATIC_FLAT_VECT_TREE_HPP
+#define STATIC_FLAT_VECT_TREE_HPP
+
+#include <array>
+#include <type_traits>
+#include <utility>
+#include <stdint.h>
+
+#include "../MexMem.hpp"
+#include "../GenericMexIO.hpp"
+#include "FlatVectTree.hpp"
+
+// StaticFlatVectTree is a FlatVectTree whose depth is a template parameter.
+// The levels of the partition index are stored in a std::array, and the
+// indexing functions (leaf and operator()) take exactly one index per level,
+// the traversal being unrolled at compile time. There are no runtime depth
+// checks and, as with MexVector::operator[], no bounds checks.
+//
+// It is not meant to be modified element-wise. It is constructed from (and
+// converted back to) a FlatVectTree of the same depth, which is O(depth)
+// when moving, and is read from / written to MATLAB through the functions of
+// FlatVectTreeIO.inl (see the IO FUNCTIONS below).
+template<
+	typename T,
+	uint32_t Depth,
+	class FVT_Al = mxAllocator,
+	typename IndexT = uint32_t>
+class StaticFlatVectTree {
+
+	static_assert(Depth >= 1, "The depth of a StaticFlatVectTree must be at least 1");
+	static_assert(std::is_arithmetic<T>::value && std::is_unsigned<IndexT>::value,
+		"StaticFlatVectTree requires an arithmetic data type and an unsigned index type");
+
+	std::array<MexVector<IndexT, FVT_Al>, Depth> PartitionIndex;
+	MexVector<T, FVT_Al> Data;
+
+	// See FlatVectTree::isStructValidated
+	bool isStructValidated;
+
+	// getPosition<L>(Pos, i_1, ..., i_K) returns the position in level L + K
+	// of the child i_K of ... of the child i_1 of the element Pos of level L
+	template<uint32_t Level>
+	inline size_t getPosition(size_t Position) const {
+		return Position;
+	}
+	template<uint32_t Level, typename... IndexTypes>
+	inline size_t getPosition(size_t Position, size_t ChildIndex, IndexTypes... ChildIndices) const {
+		return getPosition<Level + 1>(PartitionIndex[Level][Position] + ChildIndex, ChildIndices...);
+	}
+
+	inline void resetLevels();
+
+public:
+
+	typedef FlatVectTree<T, FVT_Al, IndexT> DynamicType;
+
+	// Constructors
+	inline StaticFlatVectTree() : PartitionIndex(), Data(), isStructValidated(true) {
+		resetLevels();
+	}
+	template<class Al>
+	inline explicit StaticFlatVectTree(const FlatVectTree<T, Al, IndexT> &FlatVectTreeIn) : StaticFlatVectTree() {
+		assign(FlatVectTreeIn);
+	}
+	inline explicit StaticFlatVectTree(FlatVectTree<T, FVT_Al, IndexT> &&FlatVectTreeIn) : StaticFlatVectTree() {
+		assign(std::move(FlatVectTreeIn));
+	}
+
+	// Conversion Functions
+	template<class Al>
+	inline void assign(const FlatVectTree<T, Al, IndexT> &FlatVectTreeIn);
+	inline void assign(FlatVectTree<T, FVT_Al, IndexT> &&FlatVectTreeIn);
+	template<class Al>
+	inline void getFlatVectTree(FlatVectTree<T, Al, IndexT> &FlatVectTreeOut) const;
+	inline void releaseMem(FlatVectTree<T, FVT_Al, IndexT> &FlatVectTreeOut);
+
+	// Indexing Functions. leaf takes Depth indices and returns the leaf
+	// vector, operator() takes Depth + 1 indices and returns the element.
+	template<typename... IndexTypes>
+	inline FlatVectTreeSpan<T> leaf(size_t TopLevelIndex, IndexTypes... ChildIndices) const {
+		static_assert(sizeof...(IndexTypes) + 1 == Depth, "leaf requires exactly Depth indices");
+		size_t LeafPosition = getPosition<0>(TopLevelIndex, ChildIndices...);
+		const MexVector<IndexT, FVT_Al> &LeafLevel = PartitionIndex[Depth - 1];
+		return FlatVectTreeSpan<T>(Data.begin() + LeafLevel[LeafPosition], Data.begin() + LeafLevel[LeafPosition + 1]);
+	}
+	template<typename... IndexTypes>
+	inline const T& operator() (size_t TopLevelIndex, IndexTypes... ChildIndices) const {
+		static_assert(sizeof...(IndexTypes) == Depth, "operator() requires exactly Depth + 1 indices");
+		return Data[getPosition<0>(TopLevelIndex, ChildIndices...)];
+	}
+
+	// View Functions
+	inline FlatVectTreeView<T, FVT_Al, IndexT> view() const {
+		return FlatVectTreeView<T, FVT_Al, IndexT>(PartitionIndex.data(), Data.begin(), Depth, 0, 0, LevelSize(0));
+	}
+
+	// Property Access Functions
+	static constexpr uint32_t depth() {
+		return Depth;
+	}
+	inline IndexT LevelSize(uint32_t LevelIndex) const {
+		return PartitionIndex[LevelIndex].size() - 1;
+	}
+	inline bool isempty() const {
+		return PartitionIndex[0].size() == 1;
+	}
+	inline bool isvalidated() const {
+		return isStructValidated;
+	}
+
+	// Validates a tree converted from a non-validated FlatVectTree
+	inline bool validate();
+};
+
+template <typename T, class Enable = void>
+struct isStaticFlatVectTree { static constexpr bool value = false; };
+template <typename T, uint32_t Depth, class Al, typename IndexT>
+struct isStaticFlatVectTree<StaticFlatVectTree<T, Depth, Al, IndexT> > {
+	static constexpr bool value = true;
+	static constexpr uint32_t depth = Depth;
+	typedef T type;
+	typedef IndexT indexType;
+};
+
+/////////////////////////////////////////////////
+// CONVERSION FUNCTIONS     /////////////////////
+/////////////////////////////////////////////////
+
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT>
+inline void StaticFlatVectTree<T, Depth, FVT_Al, IndexT>::resetLevels()
+{
+	for (uint32_t i = 0; i < Depth; ++i) {
+		MexVector<IndexT, FVT_Al> EmptyLevel(1, IndexT(0));
+		PartitionIndex[i].swap(EmptyLevel);
+	}
+	MexVector<T, FVT_Al> EmptyData;
+	Data.swap(EmptyData);
+	isStructValidated = true;
+}
+
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT>
+template<class Al>
+inline void StaticFlatVectTree<T, Depth, FVT_Al, IndexT>::assign(const FlatVectTree<T, Al, IndexT> &FlatVectTreeIn)
+{
+	// Copies FlatVectTreeIn, which must be of depth Depth. A truly empty
+	// FlatVectTree (of depth 0) gives an empty tree.
+
+	if (FlatVectTreeIn.istrulyempty()) {
+		resetLevels();
+		return;
+	}
+	if (FlatVectTreeIn.depth() != Depth)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FETCH,
+			"The depth of the FlatVectTree (%d) does not match the depth of the StaticFlatVectTree (%d)",
+			FlatVectTreeIn.depth(), Depth
+		);
+
+	for (uint32_t i = 0; i < Depth; ++i) {
+		MexVector<IndexT, FVT_Al> NewLevel(FlatVectTreeIn.PartitionIndex[i]);
+		PartitionIndex[i].swap(NewLevel);
+	}
+	MexVector<T, FVT_Al> NewData(FlatVectTreeIn.Data);
+	Data.swap(NewData);
+	isStructValidated = FlatVectTreeIn.isStructValidated;
+}
+
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT>
+inline void StaticFlatVectTree<T, Depth, FVT_Al, IndexT>::assign(FlatVectTree<T, FVT_Al, IndexT> &&FlatVectTreeIn)
+{
+	// Takes over the arrays of FlatVectTreeIn, which is left empty (with its
+	// depth unchanged). Arrays wrapping external memory (see
+	// FlatVectTree::assign) cannot be taken over and are copied instead.
+
+	bool isAnyMemExt = FlatVectTreeIn.Data.ismemext();
+	for (uint32_t i = 0; i < FlatVectTreeIn.depth(); ++i)
+		isAnyMemExt |= FlatVectTreeIn.PartitionIndex[i].ismemext();
+
+	if (isAnyMemExt || FlatVectTreeIn.istrulyempty()) {
+		assign(static_cast<const FlatVectTree<T, FVT_Al, IndexT> &>(FlatVectTreeIn));
+		return;
+	}
+	if (FlatVectTreeIn.depth() != Depth)
+		WriteException(
+			FV_ExCodes::FV_INVALID_FETCH,
+			"The depth of the FlatVectTree (%d) does not match the depth of the StaticFlatVectTree (%d)",
+			FlatVectTreeIn.depth(), Depth
+		);
+
+	resetLevels();
+	for (uint32_t i = 0; i < Depth; ++i)
+		PartitionIndex[i].swap(FlatVectTreeIn.PartitionIndex[i]);
+	Data.swap(FlatVectTreeIn.Data);
+	isStructValidated = FlatVectTreeIn.isStructValidated;
+	FlatVectTreeIn.isStructValidated = true;
+}
+
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT>
+template<class Al>
+inline void StaticFlatVectTree<T, Depth, FVT_Al, IndexT>::getFlatVectTree(FlatVectTree<T, Al, IndexT> &FlatVectTreeOut) const
+{
+	MexVector<MexVector<IndexT, Al>, Al> NewPartitionIndex(Depth);
+	for (uint32_t i = 0; i < Depth; ++i)
+		NewPartitionIndex[i] = PartitionIndex[i];
+	MexVector<T, Al> NewData(Data);
+
+	FlatVectTreeOut.PartitionIndex.swap(NewPartitionIndex);
+	FlatVectTreeOut.Data.swap(NewData);
+	FlatVectTreeOut.isStructValidated = isStructValidated;
+}
+
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT>
+inline void StaticFlatVectTree<T, Depth, FVT_Al, IndexT>::releaseMem(FlatVectTree<T, FVT_Al, IndexT> &FlatVectTreeOut)
+{
+	// Moves the arrays of this tree into FlatVectTreeOut (O(Depth)) and
+	// leaves this tree empty.
+
+	MexVector<MexVector<IndexT, FVT_Al>, FVT_Al> NewPartitionIndex(Depth);
+	for (uint32_t i = 0; i < Depth; ++i)
+		NewPartitionIndex[i].swap(PartitionIndex[i]);
+	MexVector<T, FVT_Al> NewData;
+	NewData.swap(Data);
+
+	FlatVectTreeOut.PartitionIndex.swap(NewPartitionIndex);
+	FlatVectTreeOut.Data.swap(NewData);
+	FlatVectTreeOut.isStructValidated = isStructValidated;
+
+	resetLevels();
+}
+
+template<typename T, uint32_t Depth, class FVT_Al, typename IndexT>
+inline bool StaticFlatVectTree<T, Depth, FVT_Al, IndexT>::validate()
+{
+	// The levels are wrapped (not copied) to reuse FlatVectTree::isValidFVT
+	if (!isStructValidated) {
+		MexVector<MexVector<IndexT, FVT_Al>, CAllocator> Levels(Depth);
+		for (uint32_t i = 0; i < Depth; ++i)
+			Levels[i].assign(PartitionIndex[i].size(), PartitionIndex[i].begin(), false);
+		isStructValidated = FlatVectTree<T, FVT_Al, IndexT>::isValidFVT(Levels, Data);
+	}
+	return isStructValidated;
+}
+
+/////////////////////////////////////////////////
+// IO FUNCTIONS             /////////////////////
+/////////////////////////////////////////////////
+
+// These read the input as a FlatVectTree (using the functions of
+// FlatVectTreeIO.inl) and move it into the StaticFlatVectTree, and the
+// other way around for the output. The depth required is Depth.
+
+template <typename T, uint32_t Depth, class Al, typename IndexT>
+static bool getCheckedInputfrommxArray(const mxArray *InputArray, StaticFlatVectTree<T, Depth, Al, IndexT> &FlatVectTreeIn, bool isTrusted = false) {
+
+	FlatVectTree<T, Al, IndexT> DynamicTree;
+	if (!getCheckedInputfrommxArray(InputArray, DynamicTree, isTrusted))
+		return false;
+	// An empty mxArray gives a truly empty DynamicTree, which empties
+	// FlatVectTreeIn
+	if (!DynamicTree.istrulyempty() && DynamicTree.depth() != Depth)
+		return false;
+
+	FlatVectTreeIn.assign(std::move(DynamicTree));
+	return true;
+}
+
+template <typename T, uint32_t Depth, class Al, typename IndexT>
+static void getInputfrommxArray(const mxArray *InputArray, StaticFlatVectTree<T, Depth, Al, IndexT> &FlatVectTreeIn) {
+	if (!getCheckedInputfrommxArray(InputArray, FlatVectTreeIn)) {
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a valid FlatCellArray of the required type and depth (%d).\n", Depth);
+	}
+}
+
+template <typename T, uint32_t Depth, class Al, typename IndexT>
+static void getInputfromCellArray(const mxArray *CellArrayIn, StaticFlatVectTree<T, Depth, Al, IndexT> &FlatVectTreeIn) {
+
+	FlatVectTree<T, Al, IndexT> DynamicTree;
+	getInputfromCellArray(CellArrayIn, DynamicTree, Depth);
+	FlatVectTreeIn.assign(std::move(DynamicTree));
+}
+
+template <
+	typename TSpec,
+	typename T,
+	typename B = typename std::enable_if<std::is_same<T, TSpec>::value>::type,
+	uint32_t Depth,
+	class Al,
+	typename IndexT>
+static int getInputfromStruct(const mxArray *InputStruct, const char* FieldName, StaticFlatVectTree<T, Depth, Al, IndexT> &FlatVectTreeIn, MexMemInputOps InputOps = MexMemInputOps()) {
+
+	FlatVectTree<T, Al, IndexT> DynamicTree;
+	int ReturnVal = getInputfromStruct<TSpec>(InputStruct, FieldName, DynamicTree, Depth, InputOps);
+	if (ReturnVal == 0)
+		FlatVectTreeIn.assign(std::move(DynamicTree));
+	return ReturnVal;
+}
+
+template <typename T, uint32_t Depth, typename IndexT>
+inline mxArrayPtr assignmxArray(StaticFlatVectTree<T, Depth, mxAllocator, IndexT> &FlatVectTreeOut) {
+
+	FlatVectTree<T, mxAllocator, IndexT> DynamicTree;
+	FlatVectTreeOut.releaseMem(DynamicTree);
+	return assignmxArray(DynamicTree);
+}
+
+template <typename T, uint32_t Depth, class Al, typename IndexT>
+inline mxArrayPtr assignmxCellArray(const StaticFlatVectTree<T, Depth, Al, IndexT> &FlatVectTreeOut) {
+	return assignmxCellArray(FlatVectTreeOut.view());
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include <functional>
 #include <cstdio>
 #include <string.h>
+#include <cstring>
 
 #include "MexMem.hpp"
 #include "LambdaToFunction.hpp"
@@ -138,7 +139,7 @@ template<typename TypeDest, typename T> inline mxArrayPtr assignmxArray(T &Scala
 	return ReturnPointer;
 }
 
-template<typename T, class Al, class B=typename std::enable_if<std::is_same<Al, mxAllocator>::value>::type>
+template<typename T, class Al, class B=typename std::enable_if<std::is_base_of<mxAllocator, Al>::value>::type>
 inline mxArrayPtr assignmxArray(MexMatrix<T, Al> &MatrixOut){
 
 	mxClassID ClassID = GetMexType<T>::typeVal;
@@ -154,7 +155,7 @@ inline mxArrayPtr assignmxArray(MexMatrix<T, Al> &MatrixOut){
 	return ReturnPointer;
 }
 
-template<typename T, class Al, class B=typename std::enable_if<std::is_same<Al, mxAllocator>::value>::type>
+template<typename T, class Al, class B=typename std::enable_if<std::is_base_of<mxAllocator, Al>::value>::type>
 inline mxArrayPtr assignmxArray(MexVector<T, Al> &VectorOut){
 
 	mxClassID ClassID = GetMexType<T>::typeVal;
@@ -195,6 +196,7 @@ struct MexMemInputOps{
 	bool IS_NONEMPTY;
 	bool NO_EXCEPT;
 	bool QUIET;
+	bool IS_TRUSTED;
 	int  REQUIRED_SIZE;
 
 	MexMemInputOps(){
@@ -202,6 +204,7 @@ struct MexMemInputOps{
 		IS_NONEMPTY = false;
 		NO_EXCEPT = false;
 		QUIET = false;
+		IS_TRUSTED = false;
 		REQUIRED_SIZE = -1;
 	}
 
@@ -210,12 +213,14 @@ struct MexMemInputOps{
 		bool IS_NONEMPTY_ = false,
 		int  REQUIRED_SIZE_ = -1,
 		bool NO_EXCEPT_ = false,
-		bool QUIET_ = false
+		bool QUIET_ = false,
+		bool IS_TRUSTED_ = false
 		){
 		IS_REQUIRED = IS_REQUIRED_;
 		IS_NONEMPTY = IS_NONEMPTY_;
 		NO_EXCEPT = NO_EXCEPT_;
 		QUIET = QUIET_;
+		IS_TRUSTED = IS_TRUSTED_;
 		REQUIRED_SIZE = REQUIRED_SIZE_;
 	}
 };
@@ -240,6 +245,9 @@ inline MexMemInputOps getInputOps_v(int nOptions, va_list Options) {
 		else if (!STRCMPI_FUNC("NO_EXCEPT", CurrOption)) {
 			InputOps.NO_EXCEPT = true;
 		}
+		else if (!STRCMPI_FUNC("IS_TRUSTED", CurrOption)) {
+			InputOps.IS_TRUSTED = true;
+		}
 		else if (!STRCMPI_FUNC("REQUIRED_SIZE", CurrOption)) {
 			InputOps.REQUIRED_SIZE = va_arg(Options, int);
 		}
@@ -259,7 +267,12 @@ inline MexMemInputOps getInputOps(int nOptions = 0, ...) {
 }
 
 template <typename FieldCppType = void>
-static const mxArray* getValidStructField(const mxArray* InputStruct, const char * FieldName, const MexMemInputOps & InputOps = MexMemInputOps()){
+static const mxArray* getValidStructField(const mxArray* InputStruct, const char * FieldName, const MexMemInputOps & InputOps = MexMemInputOps(),
+                                          bool CheckFieldType = true){
+
+	// If CheckFieldType is false, the (possibly recursive) type check of the
+	// field is skipped. This is used by the input functions that validate the
+	// type in the same pass in which they copy the data.
 	
 	// Processing Struct Name Heirarchy
 	std::vector<std::string> NameHeirarchyVect;
@@ -289,7 +302,7 @@ static const mxArray* getValidStructField(const mxArray* InputStruct, const char
 	InputStructField = mxGetField(InputStructField, 0, NameHeirarchyVect.back().data());
 
 	// Validate Type of Field
-	if (!FieldInfo<FieldCppType>::CheckType(InputStructField)) {
+	if (CheckFieldType && !FieldInfo<FieldCppType>::CheckType(InputStructField)) {
 		if (!InputOps.QUIET)
 			WriteOutput("The Field '%s' does not match the type required.\n", FieldName);
 		if (!InputOps.NO_EXCEPT)
@@ -701,17 +714,110 @@ inline int getInputfromStruct(
 ///////////////////////// VECTVECT INPUT /////////////////////////
 //////////////////////////////////////////////////////////////////
 
+// -------- Checked Input (From mxArray) -------- //
+
+// The getCheckedInputfrommxArray functions validate the type of the input
+// while copying it, so that the cell array is traversed exactly once. They
+// return false as soon as an invalid element is encountered, in which case the
+// contents of VectorIn are unspecified. A null or empty InputArray is valid and
+// leaves VectorIn untouched.
+
+template <typename T, class Al>
+inline typename std::enable_if<std::is_arithmetic<T>::value, bool>::type getCheckedInputfrommxArray(
+	const mxArray* InputArray,
+	MexVector<T, Al> &VectorIn) {
+
+	if (!FieldInfo<MexVector<T> >::CheckType(InputArray))
+		return false;
+
+	size_t NumElems = FieldInfo<MexVector<T> >::getSize(InputArray);
+	VectorIn.resize(NumElems);
+	if (NumElems > 0)
+		std::memcpy(VectorIn.begin(), mxGetData(InputArray), NumElems*sizeof(T));
+	return true;
+}
+
+template <typename T, class AlSub, class Al>
+inline bool getCheckedInputfrommxArraySubVects(
+	const mxArray* const* SubArrays, size_t NumElems,
+	MexVector<MexVector<T, AlSub>, Al> &VectorIn, std::false_type) {
+
+	// Cell array of cell arrays. Recurse into each element
+	for (size_t i = 0; i < NumElems; ++i) {
+		if (SubArrays[i] == nullptr || mxIsEmpty(SubArrays[i]))
+			VectorIn[i].resize(0);
+		else if (!getCheckedInputfrommxArray(SubArrays[i], VectorIn[i]))
+			return false;
+	}
+	return true;
+}
+
+template <typename T, class AlSub, class Al>
+inline bool getCheckedInputfrommxArraySubVects(
+	const mxArray* const* SubArrays, size_t NumElems,
+	MexVector<MexVector<T, AlSub>, Al> &VectorIn, std::true_type) {
+
+	// Cell array of vectors (the leaf level).
+	if (NumElems < MEXMEM_PARALLEL_THRESHOLD) {
+		for (size_t i = 0; i < NumElems; ++i) {
+			if (!getCheckedInputfrommxArray(SubArrays[i], VectorIn[i]))
+				return false;
+		}
+		return true;
+	}
+
+	// For large cell arrays, the type check and size collection is done in
+	// parallel in a single pass over the headers, followed by the (serial)
+	// allocation of the subvectors and a parallel copy of the data.
+	MexVector<size_t> SubVectSizes(NumElems);
+	std::atomic<bool> isValidShared(true);
+	int64_t NumElemsSigned = NumElems;
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int64_t i = 0; i < NumElemsSigned; ++i) {
+		if (isValidShared.load(std::memory_order_relaxed)) {
+			if (FieldInfo<MexVector<T> >::CheckType(SubArrays[i]))
+				SubVectSizes[i] = FieldInfo<MexVector<T> >::getSize(SubArrays[i]);
+			else
+				isValidShared.store(false, std::memory_order_relaxed);
+		}
+	}
+	if (!isValidShared.load())
+		return false;
+
+	for (size_t i = 0; i < NumElems; ++i) {
+		VectorIn[i].resize(SubVectSizes[i]);
+	}
+
+	#pragma omp parallel for schedule(dynamic, 1024)
+	for (int64_t i = 0; i < NumElemsSigned; ++i) {
+		if (SubVectSizes[i] > 0)
+			std::memcpy(VectorIn[i].begin(), mxGetData(SubArrays[i]), SubVectSizes[i]*sizeof(T));
+	}
+	return true;
+}
+
+template <typename T, class AlSub, class Al>
+inline bool getCheckedInputfrommxArray(const mxArray* InputArray, MexVector<MexVector<T, AlSub>, Al> &VectorIn) {
+
+	if (InputArray == nullptr || mxIsEmpty(InputArray))
+		return true;
+	if (!mxIsCell(InputArray))
+		return false;
+
+	size_t NumElems = mxGetNumberOfElements(InputArray);
+	const mxArray* const* SubArrays = reinterpret_cast<const mxArray* const*>(mxGetData(InputArray));
+	VectorIn.resize(NumElems); // Reuses the existing subvectors (and their memory)
+
+	return getCheckedInputfrommxArraySubVects(SubArrays, NumElems, VectorIn, std::is_arithmetic<T>());
+}
+
 // -------- From mxArray -------- //
 
 template <typename T, class AlSub, class Al>
 inline void getInputfrommxArray(const mxArray* InputArray, MexVector<MexVector<T, AlSub>, Al> &VectorIn){
-	if (InputArray != nullptr && !mxIsEmpty(InputArray) && mxGetClassID(InputArray) == mxCELL_CLASS){
-		size_t NumElems = mxGetNumberOfElements(InputArray);
-		mxArrayPtr* tempArrayPtr = reinterpret_cast<mxArrayPtr*>(mxGetData(InputArray));
-		VectorIn = MexVector<MexVector<T> >(NumElems, MexVector<T>(0));
-		for (int i = 0; i < NumElems; ++i){
-			getInputfrommxArray<T>(tempArrayPtr[i], VectorIn[i]);
-		}
+	if (!getCheckedInputfrommxArray(InputArray, VectorIn)) {
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a valid cell array of the required type.\n");
 	}
 }
 
@@ -723,10 +829,17 @@ inline int getInputfromStruct(
 	MexVector<MexVector<T, AlSub>, Al> &VectorIn, 
 	MexMemInputOps InputOps = MexMemInputOps()) {
 
-	// Processing Data
-	const mxArray * StructFieldPtr = getValidStructField<MexVector<MexVector<T> > >(InputStruct, FieldName, InputOps);
+	// Processing Data. The type check is skipped in getValidStructField as it
+	// is performed while copying by getCheckedInputfrommxArray
+	const mxArray * StructFieldPtr = getValidStructField<MexVector<MexVector<T> > >(InputStruct, FieldName, InputOps, false);
 	if (StructFieldPtr != nullptr) {
-		getInputfrommxArray<T>(StructFieldPtr, VectorIn);
+		if (!getCheckedInputfrommxArray(StructFieldPtr, VectorIn)) {
+			if (!InputOps.QUIET)
+				WriteOutput("The Field '%s' does not match the type required.\n", FieldName);
+			if (!InputOps.NO_EXCEPT)
+				throw ExOps::EXCEPTION_INVALID_INPUT;
+			return 1;
+		}
 		return 0;
 	}
 	else {
@@ -0,0 +1,230 @@
+#ifndef MEX_ALLOC_PROFILER_HPP
+#define MEX_ALLOC_PROFILER_HPP
+
+// Call-site allocation profiler for MexVector and MexMatrix.
+//
+// When MEXMEM_PROFILE_ALLOCATIONS is defined, every MexVector / MexMatrix
+// records the source location at which it was constructed (using
+// __builtin_FILE / __builtin_LINE as default arguments of its constructors,
+// or an explicitly passed MexAllocSite), and each allocation, reallocation,
+// trim and release of its memory is aggregated per site. This tells apart
+// the container that reallocates 40 times in a hot loop from the ones that
+// merely hold a lot of memory (which is all that MemCounter shows).
+//
+// The statistics per site are
+//
+//   Allocations   - number of fresh blocks allocated
+//   Reallocations - number of times an existing block was grown
+//   Trims         - number of times a block was shrunk by trim()
+//   BytesCopied   - bytes copied by reallocations / trims that moved the
+//                   block (growing in place copies nothing)
+//   PeakCapacity  - largest capacity (in bytes) of any block of the site
+//   FinalCapacity - sum of the capacities (in bytes) of the blocks of the
+//                   site when they were freed or released to MATLAB
+//
+// Note that a container constructed as a member of another class (e.g. the
+// MexVectors in FlatVectTree) is attributed to the constructor of that
+// class unless a MexAllocSite is passed explicitly. Likewise, the elements
+// of a MexVector<MexVector<...> > that are default constructed by MexVector
+// itself (e.g. on resize) are attributed to MexMem.hpp.
+//
+// The profile is reset and printed by a MexAllocProfileScope placed in
+// mexFunction (or main), and may also be returned to MATLAB as a struct
+// array using MexAllocProfiler::getmxStruct(). Without
+// MEXMEM_PROFILE_ALLOCATIONS, the containers are unchanged and
+// MexAllocProfileScope does nothing. The profiler requires __builtin_FILE
+// (gcc >= 4.8, clang >= 9, Visual Studio >= 2019 16.6).
+
+#ifdef MEXMEM_PROFILE_ALLOCATIONS
+
+#include <matrix.h>
+#ifdef MEX_LIB
+#  include <mex.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct MexAllocSite {
+	const char* File;
+	int Line;
+	inline MexAllocSite(const char* File_ = "<unknown>", int Line_ = 0) : File(File_), Line(Line_) {}
+};
+
+// Parameter lists of the constructors of MexVector and MexMatrix
+#define MEXMEM_ALLOC_SITE_PARAM      MexAllocSite AllocSite_ = MexAllocSite(__builtin_FILE(), __builtin_LINE())
+#define MEXMEM_ALLOC_SITE_NEXT_PARAM , MEXMEM_ALLOC_SITE_PARAM
+#define MEXMEM_PROFILE_ALLOC(...)    __VA_ARGS__
+
+struct MexAllocSiteStats {
+	std::string File;
+	int         Line;
+	size_t      Allocations;
+	size_t      Reallocations;
+	size_t      Trims;
+	size_t      BytesCopied;
+	size_t      PeakCapacity;
+	size_t      FinalCapacity;
+};
+
+class MexAllocProfiler {
+
+	typedef std::map<std::pair<const char*, int>, MexAllocSiteStats> SiteTableType;
+
+	// Function-local statics so that containers constructed during static
+	// initialization can be profiled
+	static inline SiteTableType& getSiteTable() {
+		static SiteTableType SiteTable;
+		return SiteTable;
+	}
+	static inline std::mutex& getTableMutex() {
+		static std::mutex TableMutex;
+		return TableMutex;
+	}
+	static inline MexAllocSiteStats& getSiteStats(const MexAllocSite &Site) {
+		MexAllocSiteStats &Stats = getSiteTable()[std::make_pair(Site.File, Site.Line)];
+		if (Stats.File.empty()) {
+			Stats = MexAllocSiteStats();
+			Stats.File = Site.File;
+			Stats.Line = Site.Line;
+		}
+		return Stats;
+	}
+
+public:
+
+	// Events (called by MexVector and MexMatrix). A reserve with OldBytes = 0
+	// is an allocation and otherwise a reallocation.
+	static inline void onReserve(const MexAllocSite &Site, size_t OldBytes, size_t NewBytes, size_t BytesCopied) {
+		std::lock_guard<std::mutex> Lock(getTableMutex());
+		MexAllocSiteStats &Stats = getSiteStats(Site);
+		if (OldBytes == 0)
+			Stats.Allocations++;
+		else
+			Stats.Reallocations++;
+		Stats.BytesCopied += BytesCopied;
+		Stats.PeakCapacity = std::max(Stats.PeakCapacity, NewBytes);
+	}
+	static inline void onTrim(const MexAllocSite &Site, size_t OldBytes, size_t NewBytes, size_t BytesCopied) {
+		if (OldBytes == NewBytes)
+			return;
+		std::lock_guard<std::mutex> Lock(getTableMutex());
+		MexAllocSiteStats &Stats = getSiteStats(Site);
+		Stats.Trims++;
+		Stats.BytesCopied += BytesCopied;
+	}
+	static inline void onRelease(const MexAllocSite &Site, size_t CapacityBytes) {
+		std::lock_guard<std::mutex> Lock(getTableMutex());
+		getSiteStats(Site).FinalCapacity += CapacityBytes;
+	}
+
+	static inline void reset() {
+		std::lock_guard<std::mutex> Lock(getTableMutex());
+		getSiteTable().clear();
+	}
+
+	// Returns the statistics of each site (merging the entries of the same
+	// file and line from different translation units), sorted by the number
+	// of reallocations and then by the number of bytes copied
+	static inline void getReport(std::vector<MexAllocSiteStats> &Report) {
+		std::lock_guard<std::mutex> Lock(getTableMutex());
+		Report.clear();
+		for (auto &Entry : getSiteTable()) {
+			const MexAllocSiteStats &Stats = Entry.second;
+			auto Existing = std::find_if(Report.begin(), Report.end(), [&](const MexAllocSiteStats &S) {
+				return S.Line == Stats.Line && S.File == Stats.File;
+			});
+			if (Existing == Report.end()) {
+				Report.push_back(Stats);
+			}
+			else {
+				Existing->Allocations   += Stats.Allocations;
+				Existing->Reallocations += Stats.Reallocations;
+				Existing->Trims         += Stats.Trims;
+				Existing->BytesCopied   += Stats.BytesCopied;
+				Existing->PeakCapacity   = std::max(Existing->PeakCapacity, Stats.PeakCapacity);
+				Existing->FinalCapacity += Stats.FinalCapacity;
+			}
+		}
+		std::sort(Report.begin(), Report.end(), [](const MexAllocSiteStats &A, const MexAllocSiteStats &B) {
+			return (A.Reallocations != B.Reallocations) ? A.Reallocations > B.Reallocations : A.BytesCopied > B.BytesCopied;
+		});
+	}
+
+	static inline void printReport() {
+		std::vector<MexAllocSiteStats> Report;
+		getReport(Report);
+
+		char Line[256];
+		auto Print = [&]() {
+#ifdef MEX_LIB
+			mexPrintf("%s", Line);
+#else
+			std::printf("%s", Line);
+#endif
+		};
+
+		std::snprintf(Line, sizeof(Line), "%-48s %8s %8s %8s %14s %14s %14s\n",
+			"Site", "Allocs", "Reallocs", "Trims", "BytesCopied", "PeakCapacity", "FinalCapacity");
+		Print();
+		for (const MexAllocSiteStats &Stats : Report) {
+			// Long paths are truncated from the left
+			std::string Site = Stats.File + ":" + std::to_string(Stats.Line);
+			if (Site.size() > 48)
+				Site = "..." + Site.substr(Site.size() - 45);
+			std::snprintf(Line, sizeof(Line), "%-48s %8zu %8zu %8zu %14zu %14zu %14zu\n",
+				Site.c_str(), Stats.Allocations, Stats.Reallocations, Stats.Trims,
+				Stats.BytesCopied, Stats.PeakCapacity, Stats.FinalCapacity);
+			Print();
+		}
+	}
+
+	// Returns the report as a struct array (one element per site) with the
+	// fields File, Line and the statistics listed above (as doubles)
+	static inline mxArray* getmxStruct() {
+		std::vector<MexAllocSiteStats> Report;
+		getReport(Report);
+
+		const char* FieldNames[] = { "File", "Line", "Allocations", "Reallocations", "Trims",
+		                             "BytesCopied", "PeakCapacity", "FinalCapacity" };
+		mxArray* ReturnPtr = mxCreateStructMatrix(Report.size(), 1, 8, FieldNames);
+		for (size_t i = 0; i < Report.size(); ++i) {
+			const MexAllocSiteStats &Stats = Report[i];
+			mxSetField(ReturnPtr, i, "File"         , mxCreateString(Stats.File.c_str()));
+			mxSetField(ReturnPtr, i, "Line"         , mxCreateDoubleScalar(Stats.Line));
+			mxSetField(ReturnPtr, i, "Allocations"  , mxCreateDoubleScalar(double(Stats.Allocations)));
+			mxSetField(ReturnPtr, i, "Reallocations", mxCreateDoubleScalar(double(Stats.Reallocations)));
+			mxSetField(ReturnPtr, i, "Trims"        , mxCreateDoubleScalar(double(Stats.Trims)));
+			mxSetField(ReturnPtr, i, "BytesCopied"  , mxCreateDoubleScalar(double(Stats.BytesCopied)));
+			mxSetField(ReturnPtr, i, "PeakCapacity" , mxCreateDoubleScalar(double(Stats.PeakCapacity)));
+			mxSetField(ReturnPtr, i, "FinalCapacity", mxCreateDoubleScalar(double(Stats.FinalCapacity)));
+		}
+		return ReturnPtr;
+	}
+};
+
+// Resets the profile on construction and prints it on destruction
+struct MexAllocProfileScope {
+	inline MexAllocProfileScope()  { MexAllocProfiler::reset(); }
+	inline ~MexAllocProfileScope() { MexAllocProfiler::printReport(); }
+};
+
+#else
+
+#define MEXMEM_ALLOC_SITE_PARAM
+#define MEXMEM_ALLOC_SITE_NEXT_PARAM
+#define MEXMEM_PROFILE_ALLOC(...)
+
+struct MexAllocProfileScope {
+	inline MexAllocProfileScope() {}
+};
+
+#endif
+
+#endif
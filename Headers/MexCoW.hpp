@@ -0,0 +1,338 @@
+#ifndef MEX_COW_HPP
+#define MEX_COW_HPP
+
+#include <matrix.h>
+#include <cstring>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+#include "MexTypeTraits.hpp"
+
+// Copy-on-write wrapping of MATLAB inputs.
+//
+// A MexCoWVector starts as a zero-copy view of the data of an mxArray (which
+// must never be modified as MATLAB may share it with other variables). The
+// elements are read with operator[] and written with mut(), which copies the
+// chunk containing the element before returning a reference to it. Arrays
+// smaller than MEXMEM_COW_CHUNK_THRESHOLD bytes are copied whole on the
+// first write, larger ones per chunk of (at most) MEXMEM_COW_CHUNK_SIZE
+// bytes, so that a kernel that modifies a small fraction of a large input
+// copies only that fraction.
+//
+// The copied chunks are stored at their offsets in a buffer of the size of
+// the whole array, which is allocated (but not touched) on the first write.
+// materialize() copies the remaining chunks into this buffer and moves it
+// into a MexVector, which can then be resized or returned using
+// assignmxArray. MexCoWMatrix does the same for MexMatrix, and cell arrays
+// are wrapped as MexVector<MexCoWVector<T> > (see getCoWInputfrommxArray).
+//
+// The wrapped mxArray must outlive the container. Resizing operations are
+// not supported on the view itself; materialize it first.
+
+#ifndef MEXMEM_COW_CHUNK_THRESHOLD
+#  define MEXMEM_COW_CHUNK_THRESHOLD (1 << 20)
+#endif
+#ifndef MEXMEM_COW_CHUNK_SIZE
+#  define MEXMEM_COW_CHUNK_SIZE (1 << 16)
+#endif
+
+template <typename T, class Al = mxAllocator>
+class MexCoWVector {
+
+	static_assert(std::is_trivially_copyable<T>::value, "MexCoWVector requires trivially copyable elements");
+
+	const T* Source;                    // the wrapped (read-only) data
+	size_t Size;
+	uint32_t ChunkShift;                // log2 of the number of elements per chunk
+	MexVector<const T*> ChunkBegs;      // beginning of each chunk (in Source or Copied)
+	MexVector<T, Al> Copied;            // holds the copied chunks at their offsets
+
+	template <typename T2, class Al2>
+	friend class MexCoWMatrix;
+
+	inline size_t getChunkLength(size_t ChunkIndex) const {
+		size_t ChunkBeg = ChunkIndex << ChunkShift;
+		size_t ChunkEnd = ChunkBeg + (size_t(1) << ChunkShift);
+		return ((ChunkEnd < Size) ? ChunkEnd : Size) - ChunkBeg;
+	}
+	inline bool isChunkCopied(size_t ChunkIndex) const {
+		return ChunkBegs[ChunkIndex] != Source + (ChunkIndex << ChunkShift);
+	}
+	inline void copyChunk(size_t ChunkIndex) {
+		if (Copied.istrulyempty())
+			Copied.resize(Size);	// Elements are trivial, the memory is not touched
+		size_t ChunkBeg = ChunkIndex << ChunkShift;
+		std::memcpy(Copied.begin() + ChunkBeg, Source + ChunkBeg, getChunkLength(ChunkIndex)*sizeof(T));
+		ChunkBegs[ChunkIndex] = Copied.begin() + ChunkBeg;
+	}
+	template <class Al2>
+	inline void copyFrom(const MexCoWVector<T, Al2> &M) {
+		// Shares the source of M and copies the chunks copied by M
+		assign(M.Size, M.Source);
+		for (size_t i = 0; i < ChunkBegs.size(); ++i) {
+			if (M.isChunkCopied(i)) {
+				copyChunk(i);
+				std::memcpy(Copied.begin() + (i << ChunkShift), M.ChunkBegs[i], getChunkLength(i)*sizeof(T));
+			}
+		}
+	}
+
+public:
+
+	inline MexCoWVector() : Source(nullptr), Size(0), ChunkShift(0), ChunkBegs(), Copied() {}
+	inline MexCoWVector(size_t Size_, const T* Source_) : MexCoWVector() {
+		assign(Size_, Source_);
+	}
+	inline MexCoWVector(const MexCoWVector &M) : MexCoWVector() {
+		copyFrom(M);
+	}
+	inline MexCoWVector(MexCoWVector &&M) :
+		Source(M.Source), Size(M.Size), ChunkShift(M.ChunkShift),
+		ChunkBegs(std::move(M.ChunkBegs)), Copied(std::move(M.Copied)) {
+		M.assign(0, nullptr);
+	}
+
+	inline MexCoWVector & operator = (const MexCoWVector &M) {
+		if (this != &M)
+			copyFrom(M);
+		return *this;
+	}
+	inline MexCoWVector & operator = (MexCoWVector &&M) {
+		if (this != &M) {
+			Source = M.Source;
+			Size = M.Size;
+			ChunkShift = M.ChunkShift;
+			ChunkBegs = std::move(M.ChunkBegs);
+			Copied = std::move(M.Copied);
+			M.assign(0, nullptr);
+		}
+		return *this;
+	}
+
+	// Wraps the Size elements at Source (discarding any copied chunks)
+	inline MexCoWVector & assign(size_t Size_, const T* Source_) {
+		Source = Size_ ? Source_ : nullptr;
+		Size = Size_;
+		Copied = MexVector<T, Al>();
+		ChunkBegs = MexVector<const T*>();	// may have been moved from
+
+		// Whole array as a single chunk below the threshold, otherwise the
+		// largest power of 2 elements that fit in MEXMEM_COW_CHUNK_SIZE bytes
+		ChunkShift = 0;
+		if (Size*sizeof(T) < MEXMEM_COW_CHUNK_THRESHOLD) {
+			while ((size_t(1) << ChunkShift) < Size)
+				ChunkShift++;
+		}
+		else {
+			while ((size_t(2) << ChunkShift)*sizeof(T) <= MEXMEM_COW_CHUNK_SIZE)
+				ChunkShift++;
+		}
+
+		size_t NChunks = Size ? ((Size - 1) >> ChunkShift) + 1 : 0;
+		ChunkBegs.resize(NChunks);
+		for (size_t i = 0; i < NChunks; ++i)
+			ChunkBegs[i] = Source + (i << ChunkShift);
+		return *this;
+	}
+
+	inline const T& operator[] (size_t Index) const {
+		return ChunkBegs[Index >> ChunkShift][Index & ((size_t(1) << ChunkShift) - 1)];
+	}
+	// Returns a writable reference to the element, copying its chunk first
+	// if it is still shared with the mxArray
+	inline T& mut(size_t Index) {
+		size_t ChunkIndex = Index >> ChunkShift;
+		if (!isChunkCopied(ChunkIndex))
+			copyChunk(ChunkIndex);
+		return Copied[Index];
+	}
+
+	// Copies the chunks that have not yet been copied and moves the data
+	// into VectorOut. The MexCoWVector is empty after this.
+	inline void materialize(MexVector<T, Al> &VectorOut) {
+		for (size_t i = 0; i < ChunkBegs.size(); ++i) {
+			if (!isChunkCopied(i))
+				copyChunk(i);
+		}
+		VectorOut = std::move(Copied);
+		assign(0, nullptr);
+	}
+	// Copies the current contents into VectorOut (leaving the view as is)
+	template <class Al2>
+	inline void getVector(MexVector<T, Al2> &VectorOut) const {
+		VectorOut.resize(Size);
+		for (size_t i = 0; i < ChunkBegs.size(); ++i)
+			std::memcpy(VectorOut.begin() + (i << ChunkShift), ChunkBegs[i], getChunkLength(i)*sizeof(T));
+	}
+
+	inline size_t size() const {
+		return Size;
+	}
+	inline bool isempty() const {
+		return Size == 0;
+	}
+	inline size_t nchunks() const {
+		return ChunkBegs.size();
+	}
+	inline size_t ncopiedchunks() const {
+		size_t NCopied = 0;
+		for (size_t i = 0; i < ChunkBegs.size(); ++i)
+			NCopied += isChunkCopied(i);
+		return NCopied;
+	}
+};
+
+// MexMatrix counterpart of MexCoWVector (with the row major indexing of
+// MexMatrix, i.e. a row of the MexCoWMatrix is a column of the mxArray)
+template <typename T, class Al = mxAllocator>
+class MexCoWMatrix {
+	size_t NRows, NCols;
+	MexCoWVector<T, Al> Data;
+
+public:
+
+	inline MexCoWMatrix() : NRows(0), NCols(0), Data() {}
+	inline MexCoWMatrix(size_t NRows_, size_t NCols_, const T* Source_) : NRows(NRows_), NCols(NCols_), Data(NRows_*NCols_, Source_) {}
+
+	inline MexCoWMatrix & assign(size_t NRows_, size_t NCols_, const T* Source_) {
+		NRows = NRows_;
+		NCols = NCols_;
+		Data.assign(NRows_*NCols_, Source_);
+		return *this;
+	}
+
+	inline const T& operator()(size_t RowIndex, size_t ColIndex) const {
+		return Data[RowIndex*NCols + ColIndex];
+	}
+	inline T& mut(size_t RowIndex, size_t ColIndex) {
+		return Data.mut(RowIndex*NCols + ColIndex);
+	}
+
+	inline void materialize(MexMatrix<T, Al> &MatrixOut) {
+		MexVector<T, Al> Temp;
+		size_t NRowsOut = NRows, NColsOut = NCols;
+		Data.materialize(Temp);
+		MatrixOut.assign(NRowsOut, NColsOut, Temp.releaseArray(), true);
+		NRows = NCols = 0;
+	}
+	template <class Al2>
+	inline void getMatrix(MexMatrix<T, Al2> &MatrixOut) const {
+		MatrixOut.resize(NRows, NCols);
+		for (size_t i = 0; i < NRows*NCols; ++i)
+			MatrixOut.begin()[i] = Data[i];
+	}
+
+	inline size_t nrows() const {
+		return NRows;
+	}
+	inline size_t ncols() const {
+		return NCols;
+	}
+	inline bool isempty() const {
+		return NRows*NCols == 0;
+	}
+	inline size_t nchunks() const {
+		return Data.nchunks();
+	}
+	inline size_t ncopiedchunks() const {
+		return Data.ncopiedchunks();
+	}
+};
+
+//////////////////////////////////////////////////////////////////
+//////////////////////// COPY-ON-WRITE INPUT /////////////////////
+//////////////////////////////////////////////////////////////////
+
+// -------- From mxArray -------- //
+
+// The class of the mxArray must match T exactly as the data is not
+// converted. An invalid array raises EXCEPTION_INVALID_INPUT.
+
+template <typename T, class Al>
+inline void getCoWInputfrommxArray(const mxArray* InputArray, MexCoWVector<T, Al> &VectorIn) {
+	if (!FieldInfo<MexVector<T> >::CheckType(InputArray))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a vector of the required type.\n");
+	if (InputArray != nullptr && !mxIsEmpty(InputArray))
+		VectorIn.assign(mxGetNumberOfElements(InputArray), reinterpret_cast<const T*>(mxGetData(InputArray)));
+	else
+		VectorIn.assign(0, nullptr);
+}
+
+template <typename T, class Al>
+inline void getCoWInputfrommxArray(const mxArray* InputArray, MexCoWMatrix<T, Al> &MatrixIn) {
+	if (!FieldInfo<MexMatrix<T> >::CheckType(InputArray))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a matrix of the required type.\n");
+	if (InputArray != nullptr && !mxIsEmpty(InputArray))
+		MatrixIn.assign(mxGetN(InputArray), mxGetM(InputArray), reinterpret_cast<const T*>(mxGetData(InputArray)));
+	else
+		MatrixIn.assign(0, 0, nullptr);
+}
+
+// Cell arrays of vectors. The outer vector is allocated, the leaves are
+// copy-on-write views.
+template <typename T, class AlSub, class Al>
+inline void getCoWInputfrommxArray(const mxArray* InputArray, MexVector<MexCoWVector<T, AlSub>, Al> &VectorIn) {
+	if (InputArray == nullptr || mxIsEmpty(InputArray)) {
+		VectorIn.resize(0);
+		return;
+	}
+	if (!mxIsCell(InputArray))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a cell array.\n");
+
+	size_t NumElems = mxGetNumberOfElements(InputArray);
+	VectorIn.resize(NumElems);
+	for (size_t i = 0; i < NumElems; ++i)
+		getCoWInputfrommxArray(mxGetCell(InputArray, i), VectorIn[i]);
+}
+
+// -------- From Structure Field -------- //
+
+template <typename T, class Al>
+inline int getCoWInputfromStruct(
+	const mxArray* InputStruct, const char* FieldName,
+	MexCoWVector<T, Al> &VectorIn,
+	MexMemInputOps InputOps = MexMemInputOps()) {
+
+	const mxArray* StructFieldPtr = getValidStructField<MexVector<T> >(InputStruct, FieldName, InputOps);
+	if (StructFieldPtr != nullptr) {
+		getCoWInputfrommxArray(StructFieldPtr, VectorIn);
+		return 0;
+	}
+	else {
+		return 1;
+	}
+}
+
+template <typename T, class Al>
+inline int getCoWInputfromStruct(
+	const mxArray* InputStruct, const char* FieldName,
+	MexCoWMatrix<T, Al> &MatrixIn,
+	MexMemInputOps InputOps = MexMemInputOps()) {
+
+	const mxArray* StructFieldPtr = getValidStructField<MexMatrix<T> >(InputStruct, FieldName, InputOps);
+	if (StructFieldPtr != nullptr) {
+		getCoWInputfrommxArray(StructFieldPtr, MatrixIn);
+		return 0;
+	}
+	else {
+		return 1;
+	}
+}
+
+template <typename T, class AlSub, class Al>
+inline int getCoWInputfromStruct(
+	const mxArray* InputStruct, const char* FieldName,
+	MexVector<MexCoWVector<T, AlSub>, Al> &VectorIn,
+	MexMemInputOps InputOps = MexMemInputOps()) {
+
+	const mxArray* StructFieldPtr = getValidStructField<MexVector<MexVector<T> > >(InputStruct, FieldName, InputOps);
+	if (StructFieldPtr != nullptr) {
+		getCoWInputfrommxArray(StructFieldPtr, VectorIn);
+		return 0;
+	}
+	else {
+		return 1;
+	}
+}
+
+#endif
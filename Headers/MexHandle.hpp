@@ -0,0 +1,213 @@
+#ifndef MEX_HANDLE_HPP
+#define MEX_HANDLE_HPP
+
+#include <matrix.h>
+#include <mex.h>
+
+#include <chrono>
+#include <cstdint>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+
+// Persistent native objects across MEX calls.
+//
+// Memory allocated by mxAllocator is freed by MATLAB at the end of the MEX
+// call, so data structures that are expensive to build (e.g. a read-only
+// network stored in cell arrays or FlatCellArrays) would have to be
+// re-marshalled on every call. Instead, such an object can be built once,
+// registered in the MexHandleRegistry and returned to MATLAB as a uint64
+// scalar handle. Later calls look the object up by its handle in O(1).
+//
+//   // Call 1
+//   auto Handle = MexHandleRegistry::emplace<NetworkType>();
+//   auto &Network = MexHandleRegistry::get<NetworkType>(Handle);
+//   ... build Network ...
+//   plhs[0] = MexHandleRegistry::getmxHandle(Handle);
+//
+//   // Call 2 .. N
+//   auto &Network = MexHandleRegistry::get<NetworkType>(getHandlefrommxArray(prhs[0]));
+//
+//   // Last call
+//   MexHandleRegistry::destroy(getHandlefrommxArray(prhs[0]));
+//
+// The registered objects are allocated with new and must not hold memory
+// allocated by mxAllocator. Use mxPersistentAllocator (or CAllocator) for
+// their MexVectors, MexMatrices and FlatVectTrees, e.g.
+//
+//   FlatVectTree<float, mxPersistentAllocator> Weights;
+//
+// All objects still registered are destroyed when the MEX file is cleared
+// (via mexAtExit) or, for MEX_EXE, at the exit of the program. A handle
+// encodes the slot of the object, a generation counter of the slot and an
+// identifier of the registry instance, so that handles of destroyed
+// objects, and handles kept by MATLAB across a 'clear mex', are detected
+// as invalid (EXCEPTION_INVALID_INPUT) rather than aliasing a new object.
+//
+// The registry is meant to be used from the thread running mexFunction and
+// is not synchronized.
+
+// An mxAllocator whose memory is not freed at the end of the MEX call. As
+// it derives from mxAllocator, containers using it can still be returned to
+// MATLAB using assignmxArray.
+class mxPersistentAllocator : public mxAllocator {
+public:
+	static inline void * allocate(size_t Size) {
+		void * ReturnPtr = mxAllocator::allocate(Size);
+#ifdef MEX_LIB
+		if (ReturnPtr != nullptr)
+			mexMakeMemoryPersistent(ReturnPtr);
+#endif
+		return ReturnPtr;
+	}
+	static inline void * reallocate(void * PointerIn, size_t SizeNew) {
+		void * ReturnPtr = mxAllocator::reallocate(PointerIn, SizeNew);
+#ifdef MEX_LIB
+		if (ReturnPtr != nullptr)
+			mexMakeMemoryPersistent(ReturnPtr);
+#endif
+		return ReturnPtr;
+	}
+};
+
+class MexHandleRegistry {
+
+	struct Entry {
+		void* Object;
+		void (*Deleter)(void*);
+		const std::type_info* Type;
+		uint32_t Generation;
+	};
+
+	struct Registry {
+		std::vector<Entry> Entries;
+		std::vector<uint32_t> FreeSlots;
+		uint64_t InstanceID;
+		size_t NObjects;
+
+		inline Registry() : Entries(), FreeSlots(), NObjects(0) {
+			// Distinguishes the handles of different loads of the MEX file
+			InstanceID = uint64_t(std::chrono::high_resolution_clock::now().time_since_epoch().count()) & 0xFFFF;
+#ifdef MEX_LIB
+			mexAtExit(MexHandleRegistry::destroyAll);
+#endif
+		}
+		inline ~Registry() {
+			MexHandleRegistry::destroyAll();
+		}
+	};
+
+	static inline Registry& getRegistry() {
+		static Registry RegistryInstance;
+		return RegistryInstance;
+	}
+
+	template <typename T>
+	static inline void deleteObject(void* Object) {
+		delete static_cast<T*>(Object);
+	}
+
+	// Handle = InstanceID (16 bits) | Generation (16 bits) | Slot (32 bits)
+	static inline uint64_t getHandle(uint32_t Slot) {
+		Registry &Reg = getRegistry();
+		return (Reg.InstanceID << 48) | (uint64_t(Reg.Entries[Slot].Generation & 0xFFFF) << 32) | Slot;
+	}
+	static inline Entry& getEntry(uint64_t Handle) {
+		if (!isvalid(Handle))
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given handle (%llu) is not a valid handle (it may have been destroyed).\n", (unsigned long long)Handle);
+		return getRegistry().Entries[uint32_t(Handle & 0xFFFFFFFF)];
+	}
+
+public:
+
+	// Registers Object (allocated with new) and takes ownership of it
+	template <typename T>
+	static inline uint64_t create(T* Object) {
+		Registry &Reg = getRegistry();
+		uint32_t Slot;
+		if (!Reg.FreeSlots.empty()) {
+			Slot = Reg.FreeSlots.back();
+			Reg.FreeSlots.pop_back();
+		}
+		else {
+			Slot = uint32_t(Reg.Entries.size());
+			Reg.Entries.push_back(Entry{ nullptr, nullptr, nullptr, 0 });
+		}
+		Entry &NewEntry = Reg.Entries[Slot];
+		NewEntry.Object = Object;
+		NewEntry.Deleter = deleteObject<T>;
+		NewEntry.Type = &typeid(T);
+		Reg.NObjects++;
+		return getHandle(Slot);
+	}
+	// Constructs a T from Args and registers it
+	template <typename T, typename... Args>
+	static inline uint64_t emplace(Args&&... args) {
+		return create(new T(std::forward<Args>(args)...));
+	}
+
+	// Returns the object of the handle. The object must have been registered
+	// with exactly the type T.
+	template <typename T>
+	static inline T& get(uint64_t Handle) {
+		Entry &HandleEntry = getEntry(Handle);
+		if (*HandleEntry.Type != typeid(T))
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The object of the given handle (%llu) is not of the requested type.\n", (unsigned long long)Handle);
+		return *static_cast<T*>(HandleEntry.Object);
+	}
+	static inline bool isvalid(uint64_t Handle) {
+		Registry &Reg = getRegistry();
+		uint32_t Slot = uint32_t(Handle & 0xFFFFFFFF);
+		return (Handle >> 48) == Reg.InstanceID
+		       && Slot < Reg.Entries.size()
+		       && Reg.Entries[Slot].Object != nullptr
+		       && getHandle(Slot) == Handle;
+	}
+
+	static inline void destroy(uint64_t Handle) {
+		Entry &HandleEntry = getEntry(Handle);
+		void* Object = HandleEntry.Object;
+		auto Deleter = HandleEntry.Deleter;
+
+		// The entry is released before the object is deleted so that the
+		// destructor may itself use the registry
+		Registry &Reg = getRegistry();
+		HandleEntry.Object = nullptr;
+		HandleEntry.Generation++;
+		Reg.FreeSlots.push_back(uint32_t(Handle & 0xFFFFFFFF));
+		Reg.NObjects--;
+		Deleter(Object);
+	}
+	static inline void destroyAll() {
+		Registry &Reg = getRegistry();
+		for (uint32_t Slot = 0; Slot < Reg.Entries.size(); ++Slot) {
+			if (Reg.Entries[Slot].Object != nullptr)
+				destroy(getHandle(Slot));
+		}
+	}
+
+	static inline size_t size() {
+		return getRegistry().NObjects;
+	}
+
+	static inline mxArrayPtr getmxHandle(uint64_t Handle) {
+		mxArrayPtr ReturnPointer = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+		*reinterpret_cast<uint64_t*>(mxGetData(ReturnPointer)) = Handle;
+		return ReturnPointer;
+	}
+};
+
+// Reads a handle returned by MexHandleRegistry::getmxHandle
+inline uint64_t getHandlefrommxArray(const mxArray* InputArray) {
+	if (InputArray == nullptr
+	    || mxGetClassID(InputArray) != mxUINT64_CLASS
+	    || mxGetNumberOfElements(InputArray) != 1) {
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a handle (a uint64 scalar).\n");
+	}
+	return *reinterpret_cast<const uint64_t*>(mxGetData(InputArray));
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef MEX_IN_PLACE_HPP
+#define MEX_IN_PLACE_HPP
+
+#include <matrix.h>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+#include "MexTypeTraits.hpp"
+
+// In-place output for update-style kernels (state = step(state, ...)).
+//
+// getInPlaceOutput takes an input array (one of prhs) and returns an mxArray
+// to be assigned to plhs, with the given MexVector / MexMatrix wrapping the
+// data of the returned array as external memory. The kernel modifies the
+// elements through the container and the result is returned without
+// allocating (or copying) an output buffer.
+//
+// MATLAB may share the data of prhs with other variables (always the case
+// when the caller passes a named variable), and writing into shared data
+// would silently modify those variables. With MEXMEM_INPLACE_UNSHARE
+// defined, the input array is first unshared using the undocumented libmx
+// function mxUnshareArray (which copies the data only if it is shared), and
+// the returned array is a shared data copy of it (mxCreateSharedDataCopy),
+// which costs no data allocation. Without MEXMEM_INPLACE_UNSHARE (the safe
+// default for a MATLAB build), the returned array is always a duplicate of
+// the input, i.e. a single copy instead of the copy in and the copy out of
+// getInputfrommxArray / assignmxArray.
+//
+// The input must be an array of prhs itself (not a cell or field of one),
+// of exactly the class of T (real and non-sparse); otherwise
+// EXCEPTION_INVALID_INPUT is raised. The container cannot be resized (this
+// throws EXCEPTION_EXTMEM_MOD as for any external memory), and it is valid
+// only as long as the returned array is.
+
+#ifdef MEXMEM_INPLACE_UNSHARE
+extern "C" {
+	mxArray* mxCreateSharedDataCopy(const mxArray* Array);
+	bool     mxUnshareArray(mxArray* Array, bool NoDeepCopy);
+	bool     mxIsSharedArray(const mxArray* Array);
+}
+#endif
+
+template <typename T>
+inline bool isInPlaceCompatible(const mxArray* InputArray) {
+	return InputArray != nullptr
+	       && mxGetClassID(InputArray) == GetMexType<T>::typeVal
+	       && !mxIsComplex(InputArray)
+	       && !mxIsSparse(InputArray);
+}
+
+// Returns an array with data that may be modified, and sets isCopied to
+// whether the data of InputArray had to be copied for it
+inline mxArray* getMutableSharedCopy(const mxArray* InputArray, bool &isCopied) {
+#ifdef MEXMEM_INPLACE_UNSHARE
+	isCopied = mxIsSharedArray(InputArray);
+	mxUnshareArray(const_cast<mxArray*>(InputArray), true);
+	return mxCreateSharedDataCopy(InputArray);
+#else
+	isCopied = !mxIsEmpty(InputArray);
+	return mxDuplicateArray(InputArray);
+#endif
+}
+
+template <typename T, class Al>
+inline mxArrayPtr getInPlaceOutput(const mxArray* InputArray, MexVector<T, Al> &VectorInOut, bool* isCopied = nullptr) {
+
+	if (!isInPlaceCompatible<T>(InputArray) || !FieldInfo<MexVector<T> >::CheckType(InputArray))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a vector of the required type.\n");
+
+	bool isDataCopied;
+	mxArrayPtr ReturnPointer = getMutableSharedCopy(InputArray, isDataCopied);
+	if (isCopied != nullptr)
+		*isCopied = isDataCopied;
+
+	if (!mxIsEmpty(ReturnPointer))
+		VectorInOut.assign(mxGetNumberOfElements(ReturnPointer), reinterpret_cast<T*>(mxGetData(ReturnPointer)), false);
+	else
+		VectorInOut = MexVector<T, Al>();
+	return ReturnPointer;
+}
+
+template <typename T, class Al>
+inline mxArrayPtr getInPlaceOutput(const mxArray* InputArray, MexMatrix<T, Al> &MatrixInOut, bool* isCopied = nullptr) {
+
+	if (!isInPlaceCompatible<T>(InputArray) || !FieldInfo<MexMatrix<T> >::CheckType(InputArray))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is not a matrix of the required type.\n");
+
+	bool isDataCopied;
+	mxArrayPtr ReturnPointer = getMutableSharedCopy(InputArray, isDataCopied);
+	if (isCopied != nullptr)
+		*isCopied = isDataCopied;
+
+	if (!mxIsEmpty(ReturnPointer))
+		MatrixInOut.assign(mxGetN(ReturnPointer), mxGetM(ReturnPointer), reinterpret_cast<T*>(mxGetData(ReturnPointer)), false);
+	else
+		MatrixInOut = MexMatrix<T, Al>();
+	return ReturnPointer;
+}
+
+#endif
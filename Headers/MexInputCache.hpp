@@ -0,0 +1,351 @@
+#ifndef MEX_INPUT_CACHE_HPP
+#define MEX_INPUT_CACHE_HPP
+
+#include <matrix.h>
+#include <mex.h>
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <typeinfo>
+#include <vector>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+#include "MexHandle.hpp"
+
+// Cross-call memoization of converted inputs.
+//
+// When the same large input array is passed unchanged to many successive
+// MEX calls, MexInputCache::get converts it once (using
+// getInputfrommxArray or a given conversion function) and returns the
+// cached container on the later calls. Using the cache is opt-in: only the
+// inputs read through MexInputCache are cached.
+//
+//   typedef MexVector<MexVector<float, mxPersistentAllocator>, mxPersistentAllocator> NetworkType;
+//   const NetworkType &Network = MexInputCache::get<NetworkType>(prhs[0]);
+//
+//   const MexVector<float, mxPersistentAllocator> &Weights =
+//       MexInputCache::get<MexVector<float, mxPersistentAllocator> >(prhs[1],
+//           [](const mxArray* Array, MexVector<float, mxPersistentAllocator> &Vect) {
+//               getInputfrommxArray<double>(Array, Vect);
+//           });
+//
+// An entry is identified by the container type, and by the data pointer,
+// class and dimensions of the mxArray along with a fingerprint of its
+// contents, so that an array allocated at the address of a freed one is not
+// mistaken for it. By default, the fingerprint samples
+// MEXMEM_INPUT_CACHE_SAMPLES elements of each array (evenly spread, and
+// including the first and the last), i.e. data words of numeric arrays and
+// cells or struct elements (of which the pointer, class, dimensions and a
+// sample of the data are hashed) of cell and struct arrays. Computing the
+// key of a hit thus costs O(MEXMEM_INPUT_CACHE_SAMPLES) for a given nesting
+// depth, regardless of the number of elements of the input.
+//
+// MATLAB copies an array before modifying it only if it is shared. An
+// unshared variable modified in place (e.g. A(i) = v or C{i} = v in the
+// function owning A or C) keeps its data pointer and dimensions, so a
+// modification of unsampled elements is NOT detected and the stale
+// converted container is returned. For inputs that may be modified in place
+// between calls, enable full hashing (setFullHash(true), or define
+// MEXMEM_INPUT_CACHE_FULL_HASH as 1), in which case every data word and
+// every element of cell and struct arrays is hashed. A hit then costs a
+// pass over the input, about as much as converting a numeric array (the
+// cache then only saves the allocation) and a fraction of converting a cell
+// array of many cells.
+//
+// The containers must use a persistent allocator (mxPersistentAllocator or
+// CAllocator). Their size is measured as the change of MemCounter::MemUsage
+// during the conversion, and the least recently used entries are evicted
+// when the cached bytes exceed the budget (MEXMEM_INPUT_CACHE_BUDGET by
+// default, see setBudget). If the conversion exceeds the limit of an open
+// MemCounter account (EXCEPTION_MEM_FULL), the cache is cleared and the
+// conversion retried once. The entry being returned is never evicted, even
+// if it alone exceeds the budget.
+//
+// The returned reference is valid until the next call to the cache. The
+// cache is cleared when the MEX file is cleared (via mexAtExit) or, for
+// MEX_EXE, at the exit of the program. It is not synchronized.
+
+#ifndef MEXMEM_INPUT_CACHE_BUDGET
+#  define MEXMEM_INPUT_CACHE_BUDGET (size_t(256) << 20)
+#endif
+#ifndef MEXMEM_INPUT_CACHE_SAMPLES
+#  define MEXMEM_INPUT_CACHE_SAMPLES 64
+#endif
+#ifndef MEXMEM_INPUT_CACHE_FULL_HASH
+#  define MEXMEM_INPUT_CACHE_FULL_HASH 0
+#endif
+
+struct MexInputCacheStats {
+	size_t Hits;
+	size_t Misses;
+	size_t Evictions;
+	size_t NEntries;
+	size_t CachedBytes;
+	size_t Budget;
+};
+
+class MexInputCache {
+
+	struct Key {
+		const std::type_info* Type;
+		const void* Data;
+		mxClassID ClassID;
+		std::vector<size_t> Dims;
+		uint64_t Fingerprint;
+
+		inline bool operator == (const Key &Other) const {
+			return *Type == *Other.Type
+			       && Data == Other.Data
+			       && ClassID == Other.ClassID
+			       && Dims == Other.Dims
+			       && Fingerprint == Other.Fingerprint;
+		}
+	};
+
+	struct Entry {
+		Key EntryKey;
+		void* Object;
+		void (*Deleter)(void*);
+		size_t Bytes;
+	};
+
+	struct Cache {
+		std::list<Entry> Entries;	// Most recently used first
+		MexInputCacheStats Stats;
+		bool isFullHash;
+
+		inline Cache() : Entries(), isFullHash(MEXMEM_INPUT_CACHE_FULL_HASH != 0) {
+			Stats = MexInputCacheStats();
+			Stats.Budget = MEXMEM_INPUT_CACHE_BUDGET;
+#ifdef MEX_LIB
+			mexAtExit(MexInputCache::clear);
+#endif
+		}
+		inline ~Cache() {
+			MexInputCache::clear();
+		}
+	};
+
+	static inline Cache& getCache() {
+		static Cache CacheInstance;
+		return CacheInstance;
+	}
+
+	template <typename T>
+	static inline void deleteObject(void* Object) {
+		delete static_cast<T*>(Object);
+	}
+
+	// FNV-1a over 8 byte words (and the remaining bytes). Blocks of 32 bytes
+	// are hashed into 4 independent lanes (folded into Hash at the end), as
+	// the multiplications of a single lane are serially dependent.
+	static inline void hashBytes(uint64_t &Hash, const void* Bytes, size_t NBytes) {
+		const unsigned char* BytePtr = static_cast<const unsigned char*>(Bytes);
+		size_t i = 0;
+		if (NBytes >= 4*sizeof(uint64_t)) {
+			uint64_t Lanes[4] = { Hash, Hash ^ 1, Hash ^ 2, Hash ^ 3 };
+			for (; i + 4*sizeof(uint64_t) <= NBytes; i += 4*sizeof(uint64_t)) {
+				uint64_t Words[4];
+				std::memcpy(Words, BytePtr + i, sizeof(Words));
+				for (int j = 0; j < 4; ++j) {
+					Lanes[j] ^= Words[j];
+					Lanes[j] *= 0x100000001B3ULL;
+				}
+			}
+			for (int j = 0; j < 4; ++j) {
+				Hash ^= Lanes[j];
+				Hash *= 0x100000001B3ULL;
+			}
+		}
+		for (; i + sizeof(uint64_t) <= NBytes; i += sizeof(uint64_t)) {
+			uint64_t Word;
+			std::memcpy(&Word, BytePtr + i, sizeof(uint64_t));
+			Hash ^= Word;
+			Hash *= 0x100000001B3ULL;
+		}
+		for (; i < NBytes; ++i) {
+			Hash ^= BytePtr[i];
+			Hash *= 0x100000001B3ULL;
+		}
+	}
+	// The stride of the sampled elements (0, Stride, 2*Stride, ..., and the
+	// last one) that spreads NSamples of NElems elements evenly (all of them
+	// being sampled if NSamples == 0)
+	static inline size_t getSampleStride(size_t NElems, size_t NSamples) {
+		if (NSamples == 0 || NElems <= NSamples)
+			return 1;
+		return (NElems - 1) / ((NSamples > 1) ? NSamples - 1 : 1);
+	}
+	static inline void hashArray(uint64_t &Hash, const mxArray* Array, size_t NSamples) {
+		if (Array == nullptr) {
+			hashBytes(Hash, &Array, sizeof(Array));
+			return;
+		}
+		mxClassID ClassID = mxGetClassID(Array);
+		size_t NElems = mxGetNumberOfElements(Array);
+		const void* Data = mxGetData(Array);
+		hashBytes(Hash, &ClassID, sizeof(ClassID));
+		hashBytes(Hash, &Data, sizeof(Data));
+		hashBytes(Hash, mxGetDimensions(Array), mxGetNumberOfDimensions(Array)*sizeof(mwSize));
+		if (NElems == 0)
+			return;
+
+		// The elements of cell and struct arrays are hashed with a single
+		// sample of their own elements (or all of them if NSamples == 0)
+		size_t Stride = getSampleStride(NElems, NSamples);
+		size_t SubSamples = (NSamples == 0) ? 0 : 1;
+		if (mxIsCell(Array)) {
+			for (size_t i = 0; i < NElems; i += Stride)
+				hashArray(Hash, mxGetCell(Array, i), SubSamples);
+			hashArray(Hash, mxGetCell(Array, NElems - 1), SubSamples);
+		}
+		else if (mxIsStruct(Array)) {
+			int NFields = mxGetNumberOfFields(Array);
+			for (size_t i = 0; i < NElems; i += Stride)
+				for (int j = 0; j < NFields; ++j)
+					hashArray(Hash, mxGetFieldByNumber(Array, i, j), SubSamples);
+			for (int j = 0; j < NFields; ++j)
+				hashArray(Hash, mxGetFieldByNumber(Array, NElems - 1, j), SubSamples);
+		}
+		else if (Data != nullptr) {
+			size_t ElemSize = mxGetElementSize(Array);
+			const char* Bytes = static_cast<const char*>(Data);
+			if (Stride == 1) {
+				hashBytes(Hash, Bytes, NElems*ElemSize);
+			}
+			else {
+				for (size_t i = 0; i < NElems; i += Stride)
+					hashBytes(Hash, Bytes + i*ElemSize, ElemSize);
+				hashBytes(Hash, Bytes + (NElems - 1)*ElemSize, ElemSize);
+			}
+		}
+	}
+
+	static inline Key getKey(const mxArray* InputArray, const std::type_info &Type) {
+		Key ArrayKey;
+		ArrayKey.Type = &Type;
+		ArrayKey.Data = mxGetData(InputArray);
+		ArrayKey.ClassID = mxGetClassID(InputArray);
+		ArrayKey.Dims.assign(mxGetDimensions(InputArray), mxGetDimensions(InputArray) + mxGetNumberOfDimensions(InputArray));
+		ArrayKey.Fingerprint = 0xCBF29CE484222325ULL;
+		hashArray(ArrayKey.Fingerprint, InputArray, getCache().isFullHash ? 0 : MEXMEM_INPUT_CACHE_SAMPLES);
+		return ArrayKey;
+	}
+
+	static inline void deleteEntry(Entry &CacheEntry) {
+		Cache &CacheRef = getCache();
+		CacheRef.Stats.NEntries--;
+		CacheRef.Stats.CachedBytes -= CacheEntry.Bytes;
+		CacheEntry.Deleter(CacheEntry.Object);
+	}
+
+	// Evicts the least recently used entries (except the first one) until
+	// the cached bytes are within the budget
+	static inline void enforceBudget() {
+		Cache &CacheRef = getCache();
+		while (CacheRef.Stats.CachedBytes > CacheRef.Stats.Budget && CacheRef.Entries.size() > 1) {
+			deleteEntry(CacheRef.Entries.back());
+			CacheRef.Entries.pop_back();
+			CacheRef.Stats.Evictions++;
+		}
+	}
+
+	template <typename T, typename ConvertFunc>
+	static inline T* convertInput(const mxArray* InputArray, ConvertFunc Convert, size_t &Bytes) {
+		size_t MemUsageBefore = MemCounter::MemUsage;
+		T* Object = new T();
+		try {
+			Convert(InputArray, *Object);
+		}
+		catch (...) {
+			delete Object;
+			throw;
+		}
+		Bytes = MemCounter::MemUsage - MemUsageBefore;
+		return Object;
+	}
+
+public:
+
+	// Returns the container converted from InputArray by Convert (which is
+	// called as Convert(InputArray, Container)), converting it only if it
+	// is not cached
+	template <typename T, typename ConvertFunc>
+	static inline const T& get(const mxArray* InputArray, ConvertFunc Convert) {
+		if (InputArray == nullptr)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given mxArray is null.\n");
+
+		Cache &CacheRef = getCache();
+		Key ArrayKey = getKey(InputArray, typeid(T));
+
+		for (auto Iter = CacheRef.Entries.begin(); Iter != CacheRef.Entries.end(); ++Iter) {
+			if (Iter->EntryKey == ArrayKey) {
+				CacheRef.Entries.splice(CacheRef.Entries.begin(), CacheRef.Entries, Iter);
+				CacheRef.Stats.Hits++;
+				return *static_cast<T*>(CacheRef.Entries.front().Object);
+			}
+		}
+
+		CacheRef.Stats.Misses++;
+		T* Object;
+		size_t Bytes;
+		try {
+			Object = convertInput<T>(InputArray, Convert, Bytes);
+		}
+		catch (ExOps::ExCodes ExCode) {
+			if (ExCode != ExOps::EXCEPTION_MEM_FULL || CacheRef.Entries.empty())
+				throw;
+			clear();
+			Object = convertInput<T>(InputArray, Convert, Bytes);
+		}
+
+		CacheRef.Entries.push_front(Entry{ std::move(ArrayKey), Object, deleteObject<T>, Bytes });
+		CacheRef.Stats.NEntries++;
+		CacheRef.Stats.CachedBytes += Bytes;
+		enforceBudget();
+		return *Object;
+	}
+	template <typename T>
+	static inline const T& get(const mxArray* InputArray) {
+		return get<T>(InputArray, [](const mxArray* Array, T &Container) {
+			getInputfrommxArray(Array, Container);
+		});
+	}
+
+	static inline void setBudget(size_t Budget) {
+		getCache().Stats.Budget = Budget;
+		enforceBudget();
+	}
+	// Enables hashing all the elements of the inputs (see above). The cache
+	// is cleared as the fingerprints of its entries no longer apply.
+	static inline void setFullHash(bool isFullHash) {
+		Cache &CacheRef = getCache();
+		if (CacheRef.isFullHash != isFullHash) {
+			clear();
+			CacheRef.isFullHash = isFullHash;
+		}
+	}
+	static inline void clear() {
+		Cache &CacheRef = getCache();
+		for (Entry &CacheEntry : CacheRef.Entries)
+			deleteEntry(CacheEntry);
+		CacheRef.Entries.clear();
+	}
+	static inline void resetStats() {
+		MexInputCacheStats &Stats = getCache().Stats;
+		Stats.Hits = Stats.Misses = Stats.Evictions = 0;
+	}
+
+	static inline MexInputCacheStats getStats() {
+		return getCache().Stats;
+	}
+	static inline void printStats() {
+		const MexInputCacheStats &Stats = getCache().Stats;
+		WriteOutput("MexInputCache: %zu hits, %zu misses, %zu evictions, %zu entries, %zu / %zu bytes\n",
+			Stats.Hits, Stats.Misses, Stats.Evictions, Stats.NEntries, Stats.CachedBytes, Stats.Budget);
+	}
+};
+
+#endif
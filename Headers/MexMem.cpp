@@ -3,4 +3,5 @@
 size_t MemCounter::MemUsageLimitVal = 0xFFFFFFFFFFFFFFFF;
 const size_t & MemCounter::MemUsageLimit = MemCounter::MemUsageLimitVal;
 size_t MemCounter::AccountOpeningKey = 0;
-size_t MemCounter::MemUsageCount = 0;
\ No newline at end of file
+size_t MemCounter::MemUsageCount = 0;
+const size_t & MemCounter::MemUsage = MemCounter::MemUsageCount;
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include <chrono>
 #include <iterator>
 
+#include "MexAllocProfiler.hpp"
+
 typedef mxArray* mxArrayPtr;
 
 class CAllocator;
@@ -28,6 +30,7 @@ class MemCounter{
 	static size_t AccountOpeningKey;
 public:
 	const static size_t &MemUsageLimit;
+	const static size_t &MemUsage;
 
 	template<typename T, class Al >
 	friend class MexVector;
@@ -91,6 +94,92 @@ public:
 	}
 };
 
+/////////////////////////////////////////////////
+// GROWTH POLICIES          /////////////////////
+/////////////////////////////////////////////////
+
+// A growth policy decides the capacity to which a container grows when an
+// append (push_back, push_size, push_row, push_row_size) exceeds its
+// current capacity. getCapacity returns the new capacity (in elements of
+// ElemSize bytes) for a container of capacity CurrCapacity that must hold at
+// least MinCapacity (> CurrCapacity) elements. Explicit reserve / resize
+// calls always allocate exactly the requested capacity.
+//
+// The policy of a container is taken from its allocator: it is
+// Al::GrowthPolicy if Al declares one and MexGrowthGeometric otherwise. Use
+// MexGrowthAllocator to combine an allocator with a policy, e.g.
+//
+//   MexVector<float, MexGrowthAllocator<mxAllocator, MexGrowthDoubling> > Log;
+
+// Grows by a factor of 1.5 starting at 4 elements (the default)
+struct MexGrowthGeometric {
+	static inline size_t getCapacity(size_t CurrCapacity, size_t MinCapacity, size_t /*ElemSize*/) {
+		size_t NewCapacity = CurrCapacity ? CurrCapacity : 4;
+		while (NewCapacity < MinCapacity)
+			NewCapacity += (NewCapacity >> 1) + 1;
+		return NewCapacity;
+	}
+};
+
+// Doubles starting at 4 elements (fewer reallocations for append-heavy
+// containers at the cost of up to 50% slack)
+struct MexGrowthDoubling {
+	static inline size_t getCapacity(size_t CurrCapacity, size_t MinCapacity, size_t /*ElemSize*/) {
+		size_t NewCapacity = CurrCapacity ? CurrCapacity : 4;
+		while (NewCapacity < MinCapacity)
+			NewCapacity *= 2;
+		return NewCapacity;
+	}
+};
+
+// Grows to exactly the required capacity (for containers whose final size
+// is reserved beforehand, or that are appended to rarely)
+struct MexGrowthExact {
+	static inline size_t getCapacity(size_t /*CurrCapacity*/, size_t MinCapacity, size_t /*ElemSize*/) {
+		return MinCapacity;
+	}
+};
+
+// Grows geometrically and then rounds the size of the block up to a power of
+// 2 (at least 32 bytes) below PageSize, and to a multiple of PageSize above
+// it. The rounded sizes match the size classes of the usual allocators (and
+// the pages of large, mmap'ed blocks), so the slack at the end of the block
+// becomes usable capacity rather than being wasted by the allocator.
+template <size_t PageSize = 4096>
+struct MexGrowthRounded {
+	static_assert((PageSize & (PageSize - 1)) == 0, "PageSize must be a power of 2");
+	static inline size_t getCapacity(size_t CurrCapacity, size_t MinCapacity, size_t ElemSize) {
+		size_t NewBytes = MexGrowthGeometric::getCapacity(CurrCapacity, MinCapacity, ElemSize)*ElemSize;
+		if (NewBytes < PageSize) {
+			size_t RoundedBytes = 32;
+			while (RoundedBytes < NewBytes)
+				RoundedBytes *= 2;
+			NewBytes = RoundedBytes;
+		}
+		else {
+			NewBytes = (NewBytes + PageSize - 1) & ~(PageSize - 1);
+		}
+		size_t NewCapacity = NewBytes / ElemSize;
+		return (NewCapacity < MinCapacity) ? MinCapacity : NewCapacity;
+	}
+};
+
+// An allocator Al whose containers grow according to Policy
+template <class Al, class Policy>
+class MexGrowthAllocator : public Al {
+public:
+	typedef Policy GrowthPolicy;
+};
+
+template <class Al, class B = void>
+struct MexGrowthTraits {
+	typedef MexGrowthGeometric GrowthPolicy;
+};
+template <class Al>
+struct MexGrowthTraits<Al, typename std::conditional<true, void, typename Al::GrowthPolicy>::type> {
+	typedef typename Al::GrowthPolicy GrowthPolicy;
+};
+
 template<typename T, class Al >
 class MexVector{
 	bool isCurrentMemExternal;
@@ -98,10 +187,15 @@ class MexVector{
 	T* Array_Last;	// Note Not Array_End as it is not representative
 					// of the capacity
 	T* Array_End;	// Note Array End is true end of allocated array
+#ifdef MEXMEM_PROFILE_ALLOCATIONS
+	MexAllocSite AllocSite;	// Construction site (see MexAllocProfiler.hpp)
+#endif
 
 	template<typename T2, typename Al2>
 	friend class MexVector;
 
+	typedef typename MexGrowthTraits<Al>::GrowthPolicy GrowthPolicy;
+
 	void ShiftElemsBackward(T* BeginIter, T* EndIter, size_t Offset) {
 		// This function does not attempt any resizing / reallocation
 		// it is the responsibility of any function calling this to 
@@ -134,13 +228,17 @@ public:
 	// Each instance of templated constructor has an overload that 
 	// corresponds to the actual copy assignment operator for current 
 	// class
-	inline MexVector() : Array_End(NULL), isCurrentMemExternal(false), Array_Beg(NULL), Array_Last(NULL){};
-	inline explicit MexVector(size_t Size){
+	inline MexVector(MEXMEM_ALLOC_SITE_PARAM) : Array_End(NULL), isCurrentMemExternal(false), Array_Beg(NULL), Array_Last(NULL){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
+	};
+	inline explicit MexVector(size_t Size MEXMEM_ALLOC_SITE_NEXT_PARAM){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		if (Size > 0){
 			size_t NumExtraBytes = Size*sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(Size*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL; // Memory Quota Exceeded
@@ -159,13 +257,15 @@ public:
 		isCurrentMemExternal = false;
 	}
 	template<typename Al2>
-	inline MexVector(const MexVector<T, Al2> &M) {
+	inline MexVector(const MexVector<T, Al2> &M MEXMEM_ALLOC_SITE_NEXT_PARAM) {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		size_t Size = M.size();
 		if (Size > 0){
 			size_t NumExtraBytes = Size*sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(Size*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL; // Memory Quota Exceeded
@@ -184,13 +284,15 @@ public:
 		Array_End = Array_Beg + Size;
 		isCurrentMemExternal = false;
 	}
-	inline MexVector(const MexVector &M) {
+	inline MexVector(const MexVector &M MEXMEM_ALLOC_SITE_NEXT_PARAM) {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		size_t Size = M.size();
 		if (Size > 0) {
 			size_t NumExtraBytes = Size*sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit) {
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(Size*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else {
 				throw ExOps::EXCEPTION_MEM_FULL; // Memory Quota Exceeded
@@ -209,7 +311,8 @@ public:
 		Array_End = Array_Beg + Size;
 		isCurrentMemExternal = false;
 	}
-	inline MexVector(MexVector &&M) {
+	inline MexVector(MexVector &&M MEXMEM_ALLOC_SITE_NEXT_PARAM) {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		isCurrentMemExternal = M.isCurrentMemExternal;
 		Array_Beg = M.Array_Beg;
 		Array_Last = M.Array_Last;
@@ -218,7 +321,8 @@ public:
 			M.isCurrentMemExternal = true;
 		}
 	}
-	inline MexVector(const std::initializer_list<T> &ConstructorList_) {
+	inline MexVector(const std::initializer_list<T> &ConstructorList_ MEXMEM_ALLOC_SITE_NEXT_PARAM) {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		Array_Beg = Array_Last = Array_End = nullptr;
 		isCurrentMemExternal = false;
 
@@ -228,12 +332,14 @@ public:
 			Array_Beg[j] = *(ConstructorList_.begin() + j);
 		}
 	}
-	inline explicit MexVector(size_t Size, const T &Elem){
+	inline explicit MexVector(size_t Size, const T &Elem MEXMEM_ALLOC_SITE_NEXT_PARAM){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		if (Size > 0){
 			size_t NumExtraBytes = Size*sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(Size*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL; // Memory Quota Exceeded
@@ -251,17 +357,21 @@ public:
 		for (T* i = Array_Beg; i < Array_Last; ++i)
 			new (i) T(Elem);
 	}
-	inline explicit MexVector(size_t Size, T* Array_, bool SelfManage = 1) :
+	inline explicit MexVector(size_t Size, T* Array_, bool SelfManage = 1 MEXMEM_ALLOC_SITE_NEXT_PARAM) :
 		Array_Beg(Size ? Array_ : NULL), 
 		Array_Last(Array_ + Size), 
 		Array_End(Array_ + Size), 
-		isCurrentMemExternal(Size ? !SelfManage : false){}
+		isCurrentMemExternal(Size ? !SelfManage : false){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
+	}
 	// STL Interfacing constructor
 	template <typename InputIterator, class B=typename std::iterator_traits<InputIterator>::iterator_category>
 	inline MexVector(
 		const InputIterator &Begin,
-		const InputIterator &End)
+		const InputIterator &End
+		MEXMEM_ALLOC_SITE_NEXT_PARAM)
 		: MexVector() {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		assign(Begin, End);
 	}
 
@@ -303,6 +413,7 @@ public:
 		if (isCurrentMemExternal)
 			return NULL;
 		else{
+			MEXMEM_PROFILE_ALLOC(if (Array_Beg != NULL) MexAllocProfiler::onRelease(AllocSite, this->capacity()*sizeof(T)));
 			isCurrentMemExternal = false;
 			T* temp = Array_Beg;
 			Array_Beg = NULL;
@@ -324,6 +435,7 @@ public:
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(ExtSize*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL; // Memory Quota Exceeded
@@ -417,8 +529,7 @@ public:
 		}
 		else {
 			size_t Capacity = this->capacity();
-			Capacity = Capacity ? Capacity + (Capacity >> 1) + 1 : 4;
-			reserve(Capacity);
+			reserve(GrowthPolicy::getCapacity(Capacity, Capacity + 1, sizeof(T)));
 			*Array_Last = Val;
 			++Array_Last;
 		}
@@ -430,8 +541,7 @@ public:
 		}
 		else {
 			size_t Capacity = this->capacity();
-			Capacity = Capacity ? Capacity + (Capacity >> 1) + 1 : 4;
-			reserve(Capacity);
+			reserve(GrowthPolicy::getCapacity(Capacity, Capacity + 1, sizeof(T)));
 			*Array_Last = std::move(Val);
 			++Array_Last;
 		}
@@ -439,13 +549,7 @@ public:
 
 	inline void push_size(size_t Increment){
 		if (Array_Last + Increment> Array_End){
-			size_t CurrCapacity = this->capacity();
-			size_t CurrSize = this->size();
-			CurrCapacity = CurrCapacity ? CurrCapacity : 4;
-			while (CurrCapacity <= CurrSize + Increment){
-				CurrCapacity += ((CurrCapacity >> 1) + 1);
-			}
-			reserve(CurrCapacity);
+			reserve(GrowthPolicy::getCapacity(this->capacity(), this->size() + Increment, sizeof(T)));
 		}
 		Array_Last += Increment;
 	}
@@ -571,6 +675,8 @@ public:
 				}
 			}
 			if (Temp != NULL){
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, currCapacity*sizeof(T), Cap*sizeof(T),
+					(Temp != Array_Beg) ? currCapacity*sizeof(T) : 0));
 				Array_Beg = Temp;
 				for (size_t i = currCapacity; i < Cap; ++i)
 					new (Array_Beg + i) T;
@@ -627,25 +733,13 @@ public:
 		}
 	}
 	inline void swap(MexVector<T, Al> &M) {
-		T* Temp_Beg;
-		int Temp_Size;
-		int Temp_Capacity;
-		bool Temp_isCurrentMemExternal;
-
-		Temp_Size = M.size();
-		Temp_Capacity = M.capacity();
-		Temp_isCurrentMemExternal = M.ismemext();
-		Temp_Beg = M.releaseArray();
-
-		M.Array_Beg = Array_Beg;
-		M.Array_Last = Array_Last;
-		M.Array_End = Array_End;
-		M.isCurrentMemExternal = isCurrentMemExternal;
-
-		Array_Beg = Temp_Beg;
-		Array_Last = Temp_Beg + Temp_Size;
-		Array_End = Temp_Beg + Temp_Capacity;
-		isCurrentMemExternal = Temp_isCurrentMemExternal;
+		// The arrays are swapped directly (not via releaseArray) so that no
+		// release is profiled, and each array keeps its construction site
+		std::swap(Array_Beg, M.Array_Beg);
+		std::swap(Array_Last, M.Array_Last);
+		std::swap(Array_End, M.Array_End);
+		std::swap(isCurrentMemExternal, M.isCurrentMemExternal);
+		MEXMEM_PROFILE_ALLOC(std::swap(AllocSite, M.AllocSite));
 	}
 	inline void trim(){
 		if (!isCurrentMemExternal){
@@ -662,6 +756,7 @@ public:
 			MemCounter::MemUsageCount -= NumExtraBytes;
 
 			if (currSize == 0 && Array_Beg != nullptr) {
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onRelease(AllocSite, this->capacity()*sizeof(T)));
 				Al::deallocate(Array_Beg);
 				Array_Beg = nullptr;
 				Array_Last = nullptr;
@@ -671,6 +766,8 @@ public:
 			else if (Array_Beg != nullptr) {
 				Temp = reinterpret_cast<T*>(Al::reallocate(Array_Beg, currSize*sizeof(T)));
 				if (Temp != NULL) {
+					MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onTrim(AllocSite, this->capacity()*sizeof(T), currSize*sizeof(T),
+						(Temp != Array_Beg) ? currSize*sizeof(T) : 0));
 					Array_Beg = Temp;
 					Array_Last = Array_Beg + currSize;
 					Array_End = Array_Beg + currSize;
@@ -723,23 +820,32 @@ class MexMatrix{
 	MexVector<T, Al> RowReturnVector;
 	T* Array_Beg;
 	bool isCurrentMemExternal;
+#ifdef MEXMEM_PROFILE_ALLOCATIONS
+	MexAllocSite AllocSite;	// Construction site (see MexAllocProfiler.hpp)
+#endif
 
 	template <typename T2, class Al2>
 	friend class MexMatrix;
 
+	typedef typename MexGrowthTraits<Al>::GrowthPolicy GrowthPolicy;
+
 public:
 	typedef T* iterator;
 
 	// Each instance of templated constructor has an overload that 
 	// corresponds to the actual copy assignment operator for current 
 	// class
-	inline MexMatrix() : NRows(0), NCols(0), Capacity(0), isCurrentMemExternal(false), Array_Beg(NULL), RowReturnVector(){};
-	inline explicit MexMatrix(size_t NRows_, size_t NCols_) : RowReturnVector() {
+	inline MexMatrix(MEXMEM_ALLOC_SITE_PARAM) : NRows(0), NCols(0), Capacity(0), isCurrentMemExternal(false), Array_Beg(NULL), RowReturnVector(){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
+	};
+	inline explicit MexMatrix(size_t NRows_, size_t NCols_ MEXMEM_ALLOC_SITE_NEXT_PARAM) : RowReturnVector() {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		if (NRows_*NCols_ > 0){
 			size_t NumExtraBytes = NRows_ * NCols_ * sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(NRows_ * NCols_ * sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL;
@@ -758,13 +864,15 @@ public:
 		Capacity = NRows_*NCols_;
 		isCurrentMemExternal = false;
 	}
-	template<typename Al2> inline MexMatrix(const MexMatrix<T, Al2> &M) : RowReturnVector() {
+	template<typename Al2> inline MexMatrix(const MexMatrix<T, Al2> &M MEXMEM_ALLOC_SITE_NEXT_PARAM) : RowReturnVector() {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		size_t MNumElems = M.NRows * M.NCols;
 		if (MNumElems > 0){
 			int NumExtraBytes = MNumElems * sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(MNumElems*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL;
@@ -784,13 +892,15 @@ public:
 		Capacity = MNumElems;
 		isCurrentMemExternal = false;
 	}
-	                       inline MexMatrix(const MexMatrix  &M) : RowReturnVector() {
+	                       inline MexMatrix(const MexMatrix  &M MEXMEM_ALLOC_SITE_NEXT_PARAM) : RowReturnVector() {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		size_t MNumElems = M.NRows * M.NCols;
 		if (MNumElems > 0) {
 			int NumExtraBytes = MNumElems * sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit) {
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(MNumElems*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else {
 				throw ExOps::EXCEPTION_MEM_FULL;
@@ -810,7 +920,8 @@ public:
 		Capacity = MNumElems;
 		isCurrentMemExternal = false;
 	}
-	inline MexMatrix(MexMatrix &&M) : RowReturnVector() {
+	inline MexMatrix(MexMatrix &&M MEXMEM_ALLOC_SITE_NEXT_PARAM) : RowReturnVector() {
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		isCurrentMemExternal = M.isCurrentMemExternal;
 		NRows = M.NRows;
 		NCols = M.NCols;
@@ -820,13 +931,15 @@ public:
 			M.isCurrentMemExternal = true;
 		}
 	}
-	inline explicit MexMatrix(size_t NRows_, size_t NCols_, const T &Elem) : RowReturnVector(){
+	inline explicit MexMatrix(size_t NRows_, size_t NCols_, const T &Elem MEXMEM_ALLOC_SITE_NEXT_PARAM) : RowReturnVector(){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
 		size_t NumElems = NRows_*NCols_;
 		if (NumElems > 0){
 			int NumExtraBytes = NumElems * sizeof(T);
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(NumElems*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL;
@@ -847,12 +960,14 @@ public:
 			Array_Beg[i] = Elem;
 		}
 	}
-	inline MexMatrix(size_t NRows_, size_t NCols_, T* Array_, bool SelfManage = 1) :
+	inline MexMatrix(size_t NRows_, size_t NCols_, T* Array_, bool SelfManage = 1 MEXMEM_ALLOC_SITE_NEXT_PARAM) :
 		RowReturnVector(),
 		Array_Beg((NRows_*NCols_) ? Array_ : NULL),
 		NRows(NRows_), NCols(NCols_),
 		Capacity(NRows_*NCols_),
-		isCurrentMemExternal((NRows_*NCols_) ? ~SelfManage : false){}
+		isCurrentMemExternal((NRows_*NCols_) ? ~SelfManage : false){
+		MEXMEM_PROFILE_ALLOC(AllocSite = AllocSite_);
+	}
 
 	inline ~MexMatrix(){
 		if (!isCurrentMemExternal && Array_Beg != NULL){
@@ -893,6 +1008,7 @@ public:
 		if (isCurrentMemExternal)
 			return NULL;
 		else{
+			MEXMEM_PROFILE_ALLOC(if (Array_Beg != NULL) MexAllocProfiler::onRelease(AllocSite, Capacity*sizeof(T)));
 			isCurrentMemExternal = false;
 			T* temp = Array_Beg;
 			Array_Beg = NULL;
@@ -916,6 +1032,7 @@ public:
 			if (MemCounter::MemUsageCount + NumExtraBytes <= MemCounter::MemUsageLimit){
 				MemCounter::MemUsageCount += NumExtraBytes;
 				Array_Beg = reinterpret_cast<T*>(Al::allocate(MNumElems*sizeof(T)));
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, NumExtraBytes, 0));
 			}
 			else{
 				throw ExOps::EXCEPTION_MEM_FULL;
@@ -1020,6 +1137,7 @@ public:
 			}
 			
 			if (temp != NULL){
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, 0, Cap*sizeof(T), 0));
 				Array_Beg = temp;
 				Capacity = Cap;
 				for (int i = 0; i < Cap; ++i){
@@ -1078,6 +1196,8 @@ public:
 			}
 
 			if (temp != NULL) {
+				MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onReserve(AllocSite, Capacity*sizeof(T), NewCapacity*sizeof(T),
+					(Array_Beg != NULL && temp != Array_Beg) ? Capacity*sizeof(T) : 0));
 				Array_Beg = temp;
 				for (int i = Capacity; i < NewCapacity; ++i) {
 					new (Array_Beg + i) T;	// Defult constructing memory locations.
@@ -1107,15 +1227,12 @@ public:
 			this->operator[](j) = RowVal;
 		}
 	}
+	// A matrix with no columns takes (empty) rows without allocating
 	template<typename Al2> inline void push_row(const MexVector<T, Al2> &NewRow) {
 		size_t NewCapacity = (1 + NRows)*NCols;
-		if (NewCapacity > Capacity) {
-			size_t CurrNRows = NRows;
-			CurrNRows = CurrNRows ? CurrNRows : 1;
-			while (CurrNRows*NCols <= NewCapacity) {
-				CurrNRows += ((CurrNRows >> 2) + (CurrNRows >> 4) + 1);
-			}
-			reserveRows(CurrNRows);
+		if (NCols != 0 && NewCapacity > Capacity) {
+			// The growth policy operates on rows
+			reserveRows(GrowthPolicy::getCapacity(Capacity / NCols, NRows + 1, NCols*sizeof(T)));
 		}
 		NRows += 1;
 
@@ -1123,13 +1240,9 @@ public:
 	}
 	inline void push_row_size(size_t NumExtraRows) {
 		size_t NewCapacity = (NumExtraRows + NRows)*NCols;
-		if (NewCapacity > Capacity) {
-			size_t CurrMaxNRows = Capacity / NCols;
-			CurrMaxNRows = CurrMaxNRows ? CurrMaxNRows : 1;
-			while (CurrMaxNRows*NCols <= NewCapacity) {
-				CurrMaxNRows += ((CurrMaxNRows >> 2) + (CurrMaxNRows >> 4) + 1);
-			}
-			reserveRows(CurrMaxNRows);
+		if (NCols != 0 && NewCapacity > Capacity) {
+			// The growth policy operates on rows
+			reserveRows(GrowthPolicy::getCapacity(Capacity / NCols, NRows + NumExtraRows, NCols*sizeof(T)));
 		}
 		NRows += NumExtraRows;
 	}
@@ -1143,6 +1256,8 @@ public:
 			if (NRows*NCols > 0){
 				T* Temp = reinterpret_cast<T*>(Al::reallocate(Array_Beg, NRows*NCols*sizeof(T)));
 				MemCounter::MemUsageCount -= (this->Capacity - this->NRows*this->NCols)*sizeof(T);
+				MEXMEM_PROFILE_ALLOC(if (Temp != NULL) MexAllocProfiler::onTrim(AllocSite, Capacity*sizeof(T), NRows*NCols*sizeof(T),
+					(Temp != Array_Beg) ? NRows*NCols*sizeof(T) : 0));
 				if (Temp != NULL)
 					Array_Beg = Temp;
 				else
@@ -1150,6 +1265,7 @@ public:
 			}
 			else{
 				if (Array_Beg != NULL){
+					MEXMEM_PROFILE_ALLOC(MexAllocProfiler::onRelease(AllocSite, Capacity*sizeof(T)));
 					MemCounter::MemUsageCount -= (this->Capacity)*sizeof(T);
 					Al::deallocate(Array_Beg);
 				}
@@ -1182,24 +1298,13 @@ public:
 		}
 	}
 	inline void swap(MexMatrix &M) {
-		size_t Temp_nRows, Temp_nCols;
-		size_t Temp_Capacity;
-		T* Temp_Beg;
-
-		Temp_nRows = M.NRows;
-		Temp_nCols = M.NCols;
-		Temp_Capacity = M.Capacity;
-		Temp_Beg = M.releaseArray();
-
-		M.Array_Beg = Array_Beg;
-		M.NRows = NRows;
-		M.NCols = NCols;
-		M.Capacity = Capacity;
-
-		Array_Beg = Temp_Beg;
-		NRows = Temp_nRows;
-		NCols = Temp_nCols;
-		Capacity = Temp_Capacity;
+		// As for MexVector, without releaseArray
+		std::swap(Array_Beg, M.Array_Beg);
+		std::swap(NRows, M.NRows);
+		std::swap(NCols, M.NCols);
+		std::swap(Capacity, M.Capacity);
+		std::swap(isCurrentMemExternal, M.isCurrentMemExternal);
+		MEXMEM_PROFILE_ALLOC(std::swap(AllocSite, M.AllocSite));
 	}
 	inline void clear(){
 		if (!isCurrentMemExternal)
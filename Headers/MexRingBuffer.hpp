@@ -0,0 +1,324 @@
+#ifndef MEX_RING_BUFFER_HPP
+#define MEX_RING_BUFFER_HPP
+
+#include <matrix.h>
+#include <cstring>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+#include "MexTypeTraits.hpp"
+
+// Fixed capacity recorders for time-stepped kernels.
+//
+// MexRingBuffer keeps the last Capacity values pushed into it, and
+// MexRingMatrix the last Capacity rows (of NCols elements, e.g. the state
+// vector of a step). Both hold a single allocation made on construction
+// (a MexVector, so it is counted by MemCounter, of a non-zero capacity),
+// and a push costs a store and the wraparound check.
+//
+// For decimated recording, record() (record_row() / next_recorded_row()
+// for MexRingMatrix) is called on every step and stores only every
+// Stride-th value, starting with the first. push_back / push_row always
+// store. Recording every k-th step of a whole simulation is a MexRingBuffer
+// of capacity ceil(NSteps / k) with Stride k.
+//
+// Indexing is in time order (0 being the oldest stored value), and
+// assignmxArray returns the stored values in time order, unwrapped by (at
+// most two) memcpy's into the data of the returned array. For MexRingMatrix,
+// as for MexMatrix, each row is a column of the returned array. If the
+// buffer has not wrapped around and Al is an mxAllocator, the storage is
+// instead trimmed and released to the returned array without copying, as
+// assignmxArray does for MexVector, leaving the recorder empty with no
+// capacity.
+//
+// The capacity is checked once, on construction (EXCEPTION_INVALID_INPUT if
+// zero), and recorders cannot be default constructed, so that a push needs
+// no other check than the wraparound. The number of stored values is derived
+// from the number of pushes when queried. After releaseArray, the recorder
+// has no storage and must be assigned a newly constructed recorder before
+// it is pushed into again.
+
+template <typename T, class Al = mxAllocator>
+class MexRingBuffer {
+
+	static_assert(std::is_trivially_copyable<T>::value, "MexRingBuffer requires trivially copyable elements");
+
+	MexVector<T, Al> Storage;
+	size_t Head;        // position of the next push
+	size_t NPushed;     // pushes since the last clear (size() is capped by the capacity)
+	size_t Stride;
+	size_t Countdown;   // calls to record() until the next value is stored
+
+	inline size_t getStart() const {
+		return (NPushed < Storage.size()) ? 0 : Head;
+	}
+
+public:
+
+	inline explicit MexRingBuffer(size_t Capacity, size_t Stride_ = 1) :
+		Storage(Capacity), Head(0), NPushed(0), Stride(Stride_ ? Stride_ : 1), Countdown(1) {
+		if (Capacity == 0)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The capacity of a MexRingBuffer must be non-zero.\n");
+	}
+
+	inline void push_back(const T &Value) {
+		Storage[Head] = Value;
+		if (++Head == Storage.size())
+			Head = 0;
+		NPushed++;
+	}
+	inline void record(const T &Value) {
+		if (--Countdown == 0) {
+			Countdown = Stride;
+			push_back(Value);
+		}
+	}
+
+	// Element Index in time order (0 is the oldest)
+	inline T& operator[] (size_t Index) const {
+		size_t Position = getStart() + Index;
+		return Storage[(Position < Storage.size()) ? Position : Position - Storage.size()];
+	}
+	inline T& front() const {
+		return (*this)[0];
+	}
+	inline T& back() const {
+		return Storage[(Head ? Head : Storage.size()) - 1];
+	}
+
+	// Empties the buffer (and restarts the decimation)
+	inline void clear() {
+		Head = 0;
+		NPushed = 0;
+		Countdown = 1;
+	}
+
+	inline size_t size() const {
+		return (NPushed < Storage.size()) ? NPushed : Storage.size();
+	}
+	inline size_t capacity() const {
+		return Storage.size();
+	}
+	inline size_t stride() const {
+		return Stride;
+	}
+	inline bool isempty() const {
+		return NPushed == 0;
+	}
+	inline bool isfull() const {
+		return NPushed >= Storage.size();
+	}
+	inline bool iswrapped() const {
+		return getStart() != 0;
+	}
+
+	// Releases the storage, trimmed to the stored values, if the buffer has
+	// not wrapped around (and returns nullptr otherwise). See above for the
+	// use of the recorder afterwards.
+	inline T* releaseArray() {
+		if (iswrapped())
+			return nullptr;
+		Storage.resize(size());
+		Storage.trim();
+		clear();
+		return Storage.releaseArray();
+	}
+
+	// Copies the stored values in time order to the size() elements at Dest
+	inline void copyTo(T* Dest) const {
+		size_t NStored = size();
+		size_t Start = getStart();
+		size_t FirstPart = (Start + NStored <= Storage.size()) ? NStored : Storage.size() - Start;
+		std::memcpy(Dest, Storage.begin() + Start, FirstPart*sizeof(T));
+		std::memcpy(Dest + FirstPart, Storage.begin(), (NStored - FirstPart)*sizeof(T));
+	}
+	template <class Al2>
+	inline void getVector(MexVector<T, Al2> &VectorOut) const {
+		VectorOut.resize(size());
+		copyTo(VectorOut.begin());
+	}
+};
+
+template <typename T, class Al = mxAllocator>
+class MexRingMatrix {
+
+	static_assert(std::is_trivially_copyable<T>::value, "MexRingMatrix requires trivially copyable elements");
+
+	MexVector<T, Al> Storage;
+	size_t NCols;
+	size_t Capacity;    // in rows
+	size_t Head;        // row of the next push
+	size_t NPushed;     // pushes since the last clear (nrows() is capped by Capacity)
+	size_t Stride;
+	size_t Countdown;
+
+	inline size_t getStart() const {
+		return (NPushed < Capacity) ? 0 : Head;
+	}
+
+public:
+
+	inline MexRingMatrix(size_t Capacity_, size_t NCols_, size_t Stride_ = 1) :
+		Storage(Capacity_*NCols_), NCols(NCols_), Capacity(Capacity_), Head(0), NPushed(0),
+		Stride(Stride_ ? Stride_ : 1), Countdown(1) {
+		if (Capacity_ == 0 || NCols_ == 0)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The capacity and the number of columns of a MexRingMatrix must be non-zero.\n");
+	}
+
+	// Returns the row to be written by the current push (its previous
+	// contents being those of the oldest row if the buffer is full). This
+	// avoids copying a row that is computed in place.
+	inline T* next_row() {
+		T* Row = Storage.begin() + Head*NCols;
+		if (++Head == Capacity)
+			Head = 0;
+		NPushed++;
+		return Row;
+	}
+	// As next_row on every Stride-th call, and nullptr on the others
+	inline T* next_recorded_row() {
+		if (--Countdown == 0) {
+			Countdown = Stride;
+			return next_row();
+		}
+		return nullptr;
+	}
+
+	inline void push_row(const T* Row) {
+		std::memcpy(next_row(), Row, NCols*sizeof(T));
+	}
+	template <class Al2>
+	inline void push_row(const MexVector<T, Al2> &Row) {
+		if (Row.size() != NCols)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The row to be pushed has %zu elements instead of %zu.\n", Row.size(), NCols);
+		push_row(Row.begin());
+	}
+	inline void record_row(const T* Row) {
+		T* Dest = next_recorded_row();
+		if (Dest != nullptr)
+			std::memcpy(Dest, Row, NCols*sizeof(T));
+	}
+	template <class Al2>
+	inline void record_row(const MexVector<T, Al2> &Row) {
+		if (Row.size() != NCols)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The row to be recorded has %zu elements instead of %zu.\n", Row.size(), NCols);
+		record_row(Row.begin());
+	}
+
+	// Row RowIndex in time order (0 is the oldest)
+	inline T* operator[] (size_t RowIndex) const {
+		size_t Position = getStart() + RowIndex;
+		return Storage.begin() + ((Position < Capacity) ? Position : Position - Capacity)*NCols;
+	}
+	inline T& operator()(size_t RowIndex, size_t ColIndex) const {
+		return (*this)[RowIndex][ColIndex];
+	}
+	inline T* lastrow() const {
+		return Storage.begin() + (Head ? Head - 1 : Capacity - 1)*NCols;
+	}
+
+	inline void clear() {
+		Head = 0;
+		NPushed = 0;
+		Countdown = 1;
+	}
+
+	inline size_t nrows() const {
+		return (NPushed < Capacity) ? NPushed : Capacity;
+	}
+	inline size_t ncols() const {
+		return NCols;
+	}
+	inline size_t capacity() const {
+		return Capacity;
+	}
+	inline size_t stride() const {
+		return Stride;
+	}
+	inline bool isempty() const {
+		return NPushed == 0;
+	}
+	inline bool isfull() const {
+		return NPushed >= Capacity;
+	}
+	inline bool iswrapped() const {
+		return getStart() != 0;
+	}
+
+	inline T* releaseArray() {
+		if (iswrapped())
+			return nullptr;
+		Storage.resize(nrows()*NCols);
+		Storage.trim();
+		clear();
+		Capacity = 0;
+		return Storage.releaseArray();
+	}
+
+	// Copies the stored rows in time order to the nrows()*ncols() elements
+	// at Dest
+	inline void copyTo(T* Dest) const {
+		size_t NStored = nrows();
+		size_t Start = getStart();
+		size_t FirstPart = (Start + NStored <= Capacity) ? NStored : Capacity - Start;
+		std::memcpy(Dest, Storage.begin() + Start*NCols, FirstPart*NCols*sizeof(T));
+		std::memcpy(Dest + FirstPart*NCols, Storage.begin(), (NStored - FirstPart)*NCols*sizeof(T));
+	}
+	template <class Al2>
+	inline void getMatrix(MexMatrix<T, Al2> &MatrixOut) const {
+		MatrixOut.resize(nrows(), NCols);
+		copyTo(MatrixOut.begin());
+	}
+};
+
+template <typename T, class Al>
+inline mxArrayPtr assignmxArray(MexRingBuffer<T, Al> &RingOut) {
+
+	mxClassID ClassID = GetMexType<T>::typeVal;
+	mxArrayPtr ReturnPointer = mxCreateNumericMatrix_730(0, 0, ClassID, mxREAL);
+
+	size_t NElems = RingOut.size();
+	if (NElems) {
+		T* Data;
+		if (std::is_base_of<mxAllocator, Al>::value && !RingOut.iswrapped()) {
+			Data = RingOut.releaseArray();
+		}
+		else {
+			Data = reinterpret_cast<T*>(mxMalloc(NElems*sizeof(T)));
+			if (Data == nullptr)
+				throw ExOps::EXCEPTION_MEM_FULL;
+			RingOut.copyTo(Data);
+		}
+		mxSetM(ReturnPointer, NElems);
+		mxSetN(ReturnPointer, 1);
+		mxSetData(ReturnPointer, Data);
+	}
+	return ReturnPointer;
+}
+
+template <typename T, class Al>
+inline mxArrayPtr assignmxArray(MexRingMatrix<T, Al> &RingOut) {
+
+	mxClassID ClassID = GetMexType<T>::typeVal;
+	mxArrayPtr ReturnPointer = mxCreateNumericMatrix_730(0, 0, ClassID, mxREAL);
+
+	size_t NRows = RingOut.nrows(), NCols = RingOut.ncols();
+	if (NRows && NCols) {
+		T* Data;
+		if (std::is_base_of<mxAllocator, Al>::value && !RingOut.iswrapped()) {
+			Data = RingOut.releaseArray();
+		}
+		else {
+			Data = reinterpret_cast<T*>(mxMalloc(NRows*NCols*sizeof(T)));
+			if (Data == nullptr)
+				throw ExOps::EXCEPTION_MEM_FULL;
+			RingOut.copyTo(Data);
+		}
+		mxSetM(ReturnPointer, NCols);
+		mxSetN(ReturnPointer, NRows);
+		mxSetData(ReturnPointer, Data);
+	}
+	return ReturnPointer;
+}
+
+#endif
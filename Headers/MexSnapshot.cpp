@@ -0,0 +1,293 @@
+#include "MexSnapshot.hpp"
+
+#if defined(_WIN32)
+#  define NOMINMAX
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+#define MEXSNAP_MAGIC      "MEXSNAP"
+#define MEXSNAP_ENDIAN_TAG 0x01020304u
+
+/////////////////////////////////////////////////
+// WRITER ///////////////////////////////////////
+/////////////////////////////////////////////////
+
+MexSnapshotWriter::MexSnapshotWriter(const char* FileName) : File(nullptr), CurrOffset(0), Sections() {
+
+	File = std::fopen(FileName, "wb");
+	if (File == nullptr)
+		WriteException(MS_IO_ERROR, "Could not open '%s' for writing the snapshot\n", FileName);
+
+	// The header is rewritten with the correct contents in close()
+	MexSnapshotHeader Header;
+	std::memset(&Header, 0, sizeof(Header));
+	writeBytes(&Header, sizeof(Header));
+}
+
+MexSnapshotWriter::~MexSnapshotWriter() {
+	if (File != nullptr) {
+		try {
+			close();
+		}
+		catch (...) {
+			// Destructors must not throw
+		}
+	}
+}
+
+void MexSnapshotWriter::writeBytes(const void* Bytes, uint64_t NBytes) {
+	if (NBytes > 0 && std::fwrite(Bytes, 1, NBytes, File) != NBytes) {
+		std::fclose(File);
+		File = nullptr;
+		WriteException(MS_IO_ERROR, "Failed to write %llu bytes to the snapshot\n", (unsigned long long)NBytes);
+	}
+	CurrOffset += NBytes;
+}
+
+void MexSnapshotWriter::checkName(const char* Name) const {
+	if (std::strlen(Name) >= MEXSNAP_MAX_NAME)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The array name '%s' is longer than %d characters\n", Name, MEXSNAP_MAX_NAME - 1);
+	for (size_t i = 0; i < Sections.size(); ++i) {
+		if (Sections[i].Part == 0 && !std::strncmp(Sections[i].Name, Name, MEXSNAP_MAX_NAME))
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The snapshot already contains an array named '%s'\n", Name);
+	}
+}
+
+void MexSnapshotWriter::writeSection(const char* Name, uint32_t Kind, uint32_t Part, uint32_t ClassID, uint32_t ElemSize,
+                                     uint64_t NRows, uint64_t NCols, const void* Payload) {
+
+	if (File == nullptr)
+		WriteException(MS_IO_ERROR, "The snapshot has already been closed\n");
+	if (Part == 0)
+		checkName(Name);
+
+	// Pad to the alignment of the payload
+	static const char Padding[MEXSNAP_ALIGNMENT] = {0};
+	uint64_t PaddingSize = (MEXSNAP_ALIGNMENT - CurrOffset % MEXSNAP_ALIGNMENT) % MEXSNAP_ALIGNMENT;
+	writeBytes(Padding, PaddingSize);
+
+	MexSnapshotSection Section;
+	std::memset(&Section, 0, sizeof(Section));
+	std::strncpy(Section.Name, Name, MEXSNAP_MAX_NAME - 1);
+	Section.Kind     = Kind;
+	Section.ClassID  = ClassID;
+	Section.ElemSize = ElemSize;
+	Section.Part     = Part;
+	Section.NRows    = NRows;
+	Section.NCols    = NCols;
+	Section.Offset   = CurrOffset;
+	Section.NBytes   = NRows*NCols*ElemSize;
+
+	writeBytes(Payload, Section.NBytes);
+	Sections.push_back(Section);
+}
+
+void MexSnapshotWriter::close() {
+
+	if (File == nullptr)
+		return;
+
+	static const char Padding[MEXSNAP_ALIGNMENT] = {0};
+	uint64_t PaddingSize = (MEXSNAP_ALIGNMENT - CurrOffset % MEXSNAP_ALIGNMENT) % MEXSNAP_ALIGNMENT;
+	writeBytes(Padding, PaddingSize);
+
+	MexSnapshotHeader Header;
+	std::memset(&Header, 0, sizeof(Header));
+	std::memcpy(Header.Magic, MEXSNAP_MAGIC, sizeof(MEXSNAP_MAGIC));
+	Header.Version            = MEXSNAP_VERSION;
+	Header.EndianTag          = MEXSNAP_ENDIAN_TAG;
+	Header.NSections          = Sections.size();
+	Header.SectionTableOffset = CurrOffset;
+	Header.FileSize           = CurrOffset + Sections.size()*sizeof(MexSnapshotSection);
+
+	writeBytes(Sections.data(), Sections.size()*sizeof(MexSnapshotSection));
+
+	bool isSuccess = (std::fseek(File, 0, SEEK_SET) == 0)
+	              && (std::fwrite(&Header, sizeof(Header), 1, File) == 1);
+	isSuccess = (std::fclose(File) == 0) && isSuccess;
+	File = nullptr;
+
+	if (!isSuccess)
+		WriteException(MS_IO_ERROR, "Failed to finalize the snapshot\n");
+}
+
+/////////////////////////////////////////////////
+// READER ///////////////////////////////////////
+/////////////////////////////////////////////////
+
+#if defined(_WIN32)
+MexSnapshot::MexSnapshot() : MappedBase(nullptr), MappedSize(0), FileHandle(INVALID_HANDLE_VALUE), MappingHandle(nullptr), Sections(nullptr), NSections(0) {}
+#else
+MexSnapshot::MexSnapshot() : MappedBase(nullptr), MappedSize(0), FileDesc(-1), Sections(nullptr), NSections(0) {}
+#endif
+
+MexSnapshot::MexSnapshot(const char* FileName) : MexSnapshot() {
+	open(FileName);
+}
+
+MexSnapshot::~MexSnapshot() {
+	close();
+}
+
+void MexSnapshot::open(const char* FileName) {
+
+	close();
+
+	// The file is mapped copy-on-write, so that the wrapped containers are
+	// writable without modifying the file
+#if defined(_WIN32)
+	FileHandle = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (FileHandle == INVALID_HANDLE_VALUE)
+		WriteException(MS_IO_ERROR, "Could not open the snapshot '%s'\n", FileName);
+
+	LARGE_INTEGER FileSize;
+	if (!GetFileSizeEx(FileHandle, &FileSize)) {
+		close();
+		WriteException(MS_IO_ERROR, "Could not determine the size of the snapshot '%s'\n", FileName);
+	}
+	MappedSize = FileSize.QuadPart;
+	if (MappedSize < sizeof(MexSnapshotHeader)) {
+		close();
+		WriteException(MS_INVALID_FILE, "'%s' is not a valid snapshot (too small)\n", FileName);
+	}
+
+	MappingHandle = CreateFileMappingA(FileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (MappingHandle != nullptr)
+		MappedBase = static_cast<char*>(MapViewOfFile(MappingHandle, FILE_MAP_COPY, 0, 0, 0));
+	if (MappedBase == nullptr) {
+		close();
+		WriteException(MS_IO_ERROR, "Could not map the snapshot '%s' into memory\n", FileName);
+	}
+#else
+	FileDesc = ::open(FileName, O_RDONLY);
+	if (FileDesc < 0)
+		WriteException(MS_IO_ERROR, "Could not open the snapshot '%s'\n", FileName);
+
+	struct stat FileStat;
+	if (fstat(FileDesc, &FileStat) != 0) {
+		close();
+		WriteException(MS_IO_ERROR, "Could not determine the size of the snapshot '%s'\n", FileName);
+	}
+	MappedSize = FileStat.st_size;
+	if (MappedSize < sizeof(MexSnapshotHeader)) {
+		close();
+		WriteException(MS_INVALID_FILE, "'%s' is not a valid snapshot (too small)\n", FileName);
+	}
+
+	void* MappedAddr = mmap(NULL, MappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, FileDesc, 0);
+	if (MappedAddr == MAP_FAILED) {
+		close();
+		WriteException(MS_IO_ERROR, "Could not map the snapshot '%s' into memory\n", FileName);
+	}
+	MappedBase = static_cast<char*>(MappedAddr);
+#endif
+
+	try {
+		validateLayout();
+	}
+	catch (...) {
+		close();
+		throw;
+	}
+}
+
+void MexSnapshot::close() {
+#if defined(_WIN32)
+	if (MappedBase != nullptr)
+		UnmapViewOfFile(MappedBase);
+	if (MappingHandle != nullptr)
+		CloseHandle(MappingHandle);
+	if (FileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(FileHandle);
+	MappingHandle = nullptr;
+	FileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (MappedBase != nullptr)
+		munmap(MappedBase, MappedSize);
+	if (FileDesc >= 0)
+		::close(FileDesc);
+	FileDesc = -1;
+#endif
+	MappedBase = nullptr;
+	MappedSize = 0;
+	Sections = nullptr;
+	NSections = 0;
+}
+
+void MexSnapshot::validateLayout() {
+
+	// Validates the header and the section table so that every section
+	// returned by getSection lies (aligned) within the mapped file
+
+	const MexSnapshotHeader &Header = *reinterpret_cast<const MexSnapshotHeader*>(MappedBase);
+
+	if (std::memcmp(Header.Magic, MEXSNAP_MAGIC, sizeof(MEXSNAP_MAGIC)))
+		WriteException(MS_INVALID_FILE, "The file is not a snapshot (invalid magic number)\n");
+	if (Header.EndianTag != MEXSNAP_ENDIAN_TAG)
+		WriteException(MS_INVALID_FILE, "The snapshot was written on a machine of different byte order\n");
+	if (Header.Version != MEXSNAP_VERSION)
+		WriteException(MS_INVALID_FILE, "The snapshot version (%u) is not supported (expected %u)\n", Header.Version, MEXSNAP_VERSION);
+	if (Header.FileSize != MappedSize)
+		WriteException(MS_INVALID_FILE, "The snapshot is truncated or corrupted (size %llu, expected %llu)\n",
+			(unsigned long long)MappedSize, (unsigned long long)Header.FileSize);
+
+	uint64_t TableOffset = Header.SectionTableOffset;
+	if (TableOffset < sizeof(MexSnapshotHeader) || TableOffset % MEXSNAP_ALIGNMENT != 0 || TableOffset > MappedSize
+		|| Header.NSections > (MappedSize - TableOffset)/sizeof(MexSnapshotSection))
+		WriteException(MS_INVALID_FILE, "The section table of the snapshot is corrupted\n");
+
+	const MexSnapshotSection* SectionTable = reinterpret_cast<const MexSnapshotSection*>(MappedBase + TableOffset);
+
+	for (uint64_t i = 0; i < Header.NSections; ++i) {
+		const MexSnapshotSection &Section = SectionTable[i];
+		bool isValid =
+			   Section.Name[MEXSNAP_MAX_NAME - 1] == '\0'
+			&& Section.ElemSize > 0
+			&& Section.Offset % MEXSNAP_ALIGNMENT == 0
+			&& Section.Offset >= sizeof(MexSnapshotHeader)
+			&& Section.Offset <= TableOffset
+			&& Section.NBytes <= TableOffset - Section.Offset
+			&& (Section.NCols == 0 || Section.NRows <= Section.NBytes / Section.NCols)
+			&& Section.NRows*Section.NCols*Section.ElemSize == Section.NBytes;
+		if (!isValid)
+			WriteException(MS_INVALID_FILE, "The section %llu of the snapshot is corrupted\n", (unsigned long long)i);
+	}
+
+	Sections = SectionTable;
+	NSections = Header.NSections;
+}
+
+const MexSnapshotSection* MexSnapshot::findSection(const char* Name, uint32_t Kind, uint32_t Part) const {
+	for (uint64_t i = 0; i < NSections; ++i) {
+		if (Sections[i].Kind == Kind && Sections[i].Part == Part && !std::strncmp(Sections[i].Name, Name, MEXSNAP_MAX_NAME))
+			return Sections + i;
+	}
+	return nullptr;
+}
+
+const MexSnapshotSection& MexSnapshot::getSection(const char* Name, uint32_t Kind, uint32_t Part, uint32_t ClassID, uint32_t ElemSize) const {
+
+	if (!this->isopen())
+		WriteException(MS_INVALID_FETCH, "The snapshot is not open\n");
+
+	const MexSnapshotSection* Section = findSection(Name, Kind, Part);
+	if (Section == nullptr)
+		WriteException(MS_INVALID_FETCH, "The snapshot does not contain an array named '%s' of the requested kind\n", Name);
+	if (Section->ClassID != ClassID || Section->ElemSize != ElemSize)
+		WriteException(MS_INVALID_FETCH, "The array '%s' in the snapshot is of a different type (ClassID %u) than requested (ClassID %u)\n",
+			Name, Section->ClassID, ClassID);
+	return *Section;
+}
+
+bool MexSnapshot::contains(const char* Name) const {
+	for (uint64_t i = 0; i < NSections; ++i) {
+		if (!std::strncmp(Sections[i].Name, Name, MEXSNAP_MAX_NAME))
+			return true;
+	}
+	return false;
+}
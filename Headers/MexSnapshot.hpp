@@ -0,0 +1,243 @@
+#ifndef MEX_SNAPSHOT_HPP
+#define MEX_SNAPSHOT_HPP
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+#include "MexTypeTraits.hpp"
+#include "FlatVectTree/FlatVectTree.hpp"
+
+// A MexSnapshot file is a versioned binary container of named arrays
+// (MexVector, MexMatrix and FlatVectTree, nested MexVectors being stored as
+// FlatVectTrees). The layout is
+//
+//   MexSnapshotHeader  (64 bytes, at offset 0)
+//   Payloads           (each aligned to MEXSNAP_ALIGNMENT bytes)
+//   Section Table      (NSections MexSnapshotSection entries)
+//
+// Each section is a contiguous array. A MexVector or MexMatrix is stored in
+// a single section, a FlatVectTree of depth D in D + 1 sections (the levels
+// of PartitionIndex with Part = 0 .. D-1 followed by Data with Part = D).
+// Matrices are stored in the layout of MexMatrix. All values are stored in
+// the native byte order, which is verified on reading.
+//
+// MexSnapshotWriter writes a file sequentially. MexSnapshot maps a file into
+// memory (mmap / CreateFileMapping, copy-on-write) and wraps its sections as
+// external memory containers (ismemext() == true) without reading them, so
+// that opening even a very large file takes microseconds and the data is
+// paged in on demand. The containers remain valid only as long as the
+// MexSnapshot is open. Modifying their elements does not modify the file.
+
+#define MEXSNAP_VERSION   1
+#define MEXSNAP_ALIGNMENT 64
+#define MEXSNAP_MAX_NAME  32
+
+enum MS_ExCodes {
+	MS_IO_ERROR      = 0x01,
+	MS_INVALID_FILE  = 0x02,
+	MS_INVALID_FETCH = 0x04
+};
+
+enum MexSnapshotKind {
+	MEXSNAP_VECTOR    = 1,
+	MEXSNAP_MATRIX    = 2,
+	MEXSNAP_FVT_INDEX = 3,
+	MEXSNAP_FVT_DATA  = 4
+};
+
+struct MexSnapshotHeader {
+	char     Magic[8];           // "MEXSNAP"
+	uint32_t Version;            // MEXSNAP_VERSION
+	uint32_t EndianTag;          // 0x01020304 in the byte order of the writer
+	uint64_t NSections;
+	uint64_t SectionTableOffset;
+	uint64_t FileSize;
+	uint8_t  Reserved[24];
+};
+
+struct MexSnapshotSection {
+	char     Name[MEXSNAP_MAX_NAME];  // Name of the array (null terminated)
+	uint32_t Kind;                    // MexSnapshotKind
+	uint32_t ClassID;                 // mxClassID of the elements
+	uint32_t ElemSize;                // size of each element in bytes
+	uint32_t Part;                    // Part of the array (see above)
+	uint64_t NRows;                   // Number of elements (rows for matrices)
+	uint64_t NCols;                   // Number of columns (1 for vectors)
+	uint64_t Offset;                  // Offset of the payload from the beginning of the file
+	uint64_t NBytes;                  // Size of the payload in bytes
+	uint8_t  Reserved[16];
+};
+
+static_assert(sizeof(MexSnapshotHeader) == 64, "MexSnapshotHeader must be 64 bytes");
+static_assert(sizeof(MexSnapshotSection) == 96, "MexSnapshotSection must be 96 bytes");
+
+class MexSnapshotWriter {
+
+	FILE* File;
+	uint64_t CurrOffset;
+	std::vector<MexSnapshotSection> Sections;
+
+	void writeSection(const char* Name, uint32_t Kind, uint32_t Part, uint32_t ClassID, uint32_t ElemSize,
+	                  uint64_t NRows, uint64_t NCols, const void* Payload);
+	void writeBytes(const void* Bytes, uint64_t NBytes);
+	void checkName(const char* Name) const;
+
+	MexSnapshotWriter(const MexSnapshotWriter &) = delete;
+	MexSnapshotWriter & operator= (const MexSnapshotWriter &) = delete;
+
+public:
+	explicit MexSnapshotWriter(const char* FileName);
+	~MexSnapshotWriter();
+
+	// Writing Functions
+	template <typename T, class Al>
+	inline void write(const char* Name, const MexVector<T, Al> &VectIn);
+	template <typename T, class Al>
+	inline void write(const char* Name, const MexMatrix<T, Al> &MatrixIn);
+	template <typename T, class Al, typename IndexT>
+	inline void write(const char* Name, const FlatVectTree<T, Al, IndexT> &FlatVectTreeIn);
+	template <typename IndexT = uint32_t, typename SubElemT, class AlSub, class Al>
+	inline void write(const char* Name, const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeIn);
+
+	// Writes the section table and the header and closes the file. This is
+	// called by the destructor if not called explicitly (in which case
+	// errors cannot be reported).
+	void close();
+	inline bool isopen() const { return File != nullptr; }
+};
+
+class MexSnapshot {
+
+	char* MappedBase;
+	uint64_t MappedSize;
+#if defined(_WIN32)
+	void* FileHandle;
+	void* MappingHandle;
+#else
+	int FileDesc;
+#endif
+	const MexSnapshotSection* Sections;
+	uint64_t NSections;
+
+	const MexSnapshotSection* findSection(const char* Name, uint32_t Kind, uint32_t Part) const;
+	const MexSnapshotSection& getSection(const char* Name, uint32_t Kind, uint32_t Part, uint32_t ClassID, uint32_t ElemSize) const;
+	void validateLayout();
+
+	MexSnapshot(const MexSnapshot &) = delete;
+	MexSnapshot & operator= (const MexSnapshot &) = delete;
+
+public:
+	MexSnapshot();
+	explicit MexSnapshot(const char* FileName);
+	~MexSnapshot();
+
+	// Opening and closing (closing invalidates all wrapped containers)
+	void open(const char* FileName);
+	void close();
+	inline bool isopen() const { return MappedBase != nullptr; }
+
+	// Section Table Access
+	inline uint64_t nSections() const { return NSections; }
+	inline const MexSnapshotSection& section(uint64_t Index) const { return Sections[Index]; }
+	bool contains(const char* Name) const;
+
+	// Wrapping Functions. These throw MS_INVALID_FETCH if the array does not
+	// exist or is of a different kind or type. For FlatVectTrees, the
+	// partition indices are validated (O(size)) unless Validate is false,
+	// which should only be used for trusted files (the validation can then
+	// be performed later by FlatVectTree::validate).
+	template <typename T, class Al>
+	inline void get(const char* Name, MexVector<T, Al> &VectOut) const;
+	template <typename T, class Al>
+	inline void get(const char* Name, MexMatrix<T, Al> &MatrixOut) const;
+	template <typename T, class Al, typename IndexT>
+	inline void get(const char* Name, FlatVectTree<T, Al, IndexT> &FlatVectTreeOut, bool Validate = true) const;
+};
+
+/////////////////////////////////////////////////
+// WRITER TEMPLATE FUNCTIONS ////////////////////
+/////////////////////////////////////////////////
+
+template <typename T, class Al>
+inline void MexSnapshotWriter::write(const char* Name, const MexVector<T, Al> &VectIn) {
+	writeSection(Name, MEXSNAP_VECTOR, 0, GetMexType<T>::typeVal, sizeof(T), VectIn.size(), 1, VectIn.begin());
+}
+
+template <typename T, class Al>
+inline void MexSnapshotWriter::write(const char* Name, const MexMatrix<T, Al> &MatrixIn) {
+	writeSection(Name, MEXSNAP_MATRIX, 0, GetMexType<T>::typeVal, sizeof(T), MatrixIn.nrows(), MatrixIn.ncols(), MatrixIn.begin());
+}
+
+template <typename T, class Al, typename IndexT>
+inline void MexSnapshotWriter::write(const char* Name, const FlatVectTree<T, Al, IndexT> &FlatVectTreeIn) {
+
+	uint32_t TreeDepth = FlatVectTreeIn.depth();
+	for (uint32_t i = 0; i < TreeDepth; ++i) {
+		const MexVector<IndexT, Al> &Level = FlatVectTreeIn.PartitionIndex[i];
+		writeSection(Name, MEXSNAP_FVT_INDEX, i, GetMexType<IndexT>::typeVal, sizeof(IndexT), Level.size(), 1, Level.begin());
+	}
+	writeSection(Name, MEXSNAP_FVT_DATA, TreeDepth, GetMexType<T>::typeVal, sizeof(T), FlatVectTreeIn.Data.size(), 1, FlatVectTreeIn.Data.begin());
+}
+
+template <typename IndexT, typename SubElemT, class AlSub, class Al>
+inline void MexSnapshotWriter::write(const char* Name, const MexVector<MexVector<SubElemT, AlSub>, Al> &VectTreeIn) {
+
+	// Nested vectors are flattened (by the bulk construction of FlatVectTree)
+	// and are read back as FlatVectTrees
+
+	typedef typename getTreeInfo<MexVector<MexVector<SubElemT, AlSub>, Al> >::type TypeofData;
+
+	FlatVectTree<TypeofData, CAllocator, IndexT> FlatVectTreeIn;
+	FlatVectTreeIn.build(VectTreeIn);
+	write(Name, FlatVectTreeIn);
+}
+
+/////////////////////////////////////////////////
+// READER TEMPLATE FUNCTIONS ////////////////////
+/////////////////////////////////////////////////
+
+template <typename T, class Al>
+inline void MexSnapshot::get(const char* Name, MexVector<T, Al> &VectOut) const {
+	const MexSnapshotSection &Section = getSection(Name, MEXSNAP_VECTOR, 0, GetMexType<T>::typeVal, sizeof(T));
+	VectOut.assign(Section.NRows, reinterpret_cast<T*>(MappedBase + Section.Offset), false);
+}
+
+template <typename T, class Al>
+inline void MexSnapshot::get(const char* Name, MexMatrix<T, Al> &MatrixOut) const {
+	const MexSnapshotSection &Section = getSection(Name, MEXSNAP_MATRIX, 0, GetMexType<T>::typeVal, sizeof(T));
+	MatrixOut.assign(Section.NRows, Section.NCols, reinterpret_cast<T*>(MappedBase + Section.Offset), false);
+}
+
+template <typename T, class Al, typename IndexT>
+inline void MexSnapshot::get(const char* Name, FlatVectTree<T, Al, IndexT> &FlatVectTreeOut, bool Validate) const {
+
+	// The depth of the FlatVectTree is the Part of its Data section
+
+	const MexSnapshotSection* DataSection = nullptr;
+	for (uint64_t i = 0; i < NSections && DataSection == nullptr; ++i) {
+		if (Sections[i].Kind == MEXSNAP_FVT_DATA && !std::strncmp(Sections[i].Name, Name, MEXSNAP_MAX_NAME))
+			DataSection = Sections + i;
+	}
+	if (DataSection == nullptr)
+		WriteException(MS_INVALID_FETCH, "The snapshot does not contain a FlatVectTree named '%s'\n", Name);
+
+	uint32_t TreeDepth = DataSection->Part;
+	getSection(Name, MEXSNAP_FVT_DATA, TreeDepth, GetMexType<T>::typeVal, sizeof(T));
+
+	MexVector<MexVector<IndexT, Al>, Al> PartitionIndex(TreeDepth);
+	MexVector<T, Al> Data;
+
+	for (uint32_t i = 0; i < TreeDepth; ++i) {
+		const MexSnapshotSection &Level = getSection(Name, MEXSNAP_FVT_INDEX, i, GetMexType<IndexT>::typeVal, sizeof(IndexT));
+		PartitionIndex[i].assign(Level.NRows, reinterpret_cast<IndexT*>(MappedBase + Level.Offset), false);
+	}
+	Data.assign(DataSection->NRows, reinterpret_cast<T*>(MappedBase + DataSection->Offset), false);
+
+	FlatVectTreeOut.assign(PartitionIndex, Data, false, !Validate);
+}
+
+#endif
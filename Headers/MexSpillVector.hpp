@@ -0,0 +1,364 @@
+#ifndef MEX_SPILL_VECTOR_HPP
+#define MEX_SPILL_VECTOR_HPP
+
+#include <matrix.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "MexMem.hpp"
+#include "GenericMexIO.hpp"
+#include "MexTypeTraits.hpp"
+
+// Out-of-core vector for outputs larger than the memory (or than the limit
+// of MemCounter), e.g. the spike lists and state traces accumulated over a
+// long simulation.
+//
+// MexSpillVector appends into fixed size chunks of MEXMEM_SPILL_CHUNK_SIZE
+// bytes. A full chunk is handed to a writer thread which appends it to a
+// spill file (a temporary file unless a path is given), while the appends
+// continue into the next chunk. At most MEXMEM_SPILL_BUFFERS chunks are in
+// memory at any time; when all of them are waiting to be written, the
+// append blocks until one has been.
+//
+// The contents are read back sequentially, chunk by chunk, using a
+// ChunkReader (which reads the next chunk in the background while the
+// current one is processed), or streamed into the output using
+// assignmxArray (directly into the data of the returned mxArray) or
+// writeToFile (through a single chunk buffer).
+//
+// The chunks are allocated by Al in the calling thread (the writer thread
+// only reads them and the file), so mxAllocator may be used. The vector
+// must not be appended to while a ChunkReader is in use. An I/O error
+// raises EXCEPTION_MEM_FULL (when detected on the writer thread, on the
+// next append or flush).
+
+#ifndef MEXMEM_SPILL_CHUNK_SIZE
+#  define MEXMEM_SPILL_CHUNK_SIZE (size_t(4) << 20)
+#endif
+#ifndef MEXMEM_SPILL_BUFFERS
+#  define MEXMEM_SPILL_BUFFERS 3
+#endif
+
+#ifdef _MSC_VER
+#  define MEXMEM_FSEEK64 _fseeki64
+#else
+#  define MEXMEM_FSEEK64 fseeko
+#endif
+
+template <typename T, class Al = mxAllocator>
+class MexSpillVector {
+
+	static_assert(std::is_trivially_copyable<T>::value, "MexSpillVector requires trivially copyable elements");
+	static_assert(MEXMEM_SPILL_BUFFERS >= 2, "MexSpillVector requires at least 2 buffers");
+
+	size_t ChunkLength;                     // elements per chunk
+	size_t Size;
+	size_t NSpilledChunks;
+
+	MexVector<MexVector<T, Al> > Buffers;   // fixed size pool of chunks
+	size_t CurrBuffer;
+	T* CurrPtr;                             // next element of the current chunk
+	T* CurrEnd;
+
+	std::FILE* SpillFile;
+	std::thread Writer;
+	std::mutex QueueMutex;
+	std::condition_variable QueueCond;
+	std::deque<size_t> PendingBuffers;      // full, waiting to be written
+	std::deque<size_t> FreeBuffers;
+	bool isWriting;                         // the writer holds a buffer
+	bool isStopping;
+	bool isIOFailed;
+
+	inline void writerLoop() {
+		std::unique_lock<std::mutex> Lock(QueueMutex);
+		while (true) {
+			QueueCond.wait(Lock, [this]() { return !PendingBuffers.empty() || isStopping; });
+			if (PendingBuffers.empty())
+				return;
+			size_t BufferIndex = PendingBuffers.front();
+			PendingBuffers.pop_front();
+			isWriting = true;
+			Lock.unlock();
+
+			// The file position may have been moved by reading back
+			bool isWritten = MEXMEM_FSEEK64(SpillFile, 0, SEEK_END) == 0
+			                 && std::fwrite(Buffers[BufferIndex].begin(), sizeof(T), ChunkLength, SpillFile) == ChunkLength;
+
+			Lock.lock();
+			isWriting = false;
+			isIOFailed = isIOFailed || !isWritten;
+			FreeBuffers.push_back(BufferIndex);
+			QueueCond.notify_all();
+		}
+	}
+
+	inline void checkIO() {
+		bool isFailed;
+		{
+			std::lock_guard<std::mutex> Lock(QueueMutex);
+			isFailed = isIOFailed;
+		}
+		if (isFailed)
+			WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: writing to the spill file failed.\n");
+	}
+
+	inline void setCurrBuffer(size_t BufferIndex) {
+		CurrBuffer = BufferIndex;
+		if (Buffers[BufferIndex].istrulyempty())
+			Buffers[BufferIndex].resize(ChunkLength);
+		CurrPtr = Buffers[BufferIndex].begin();
+		CurrEnd = CurrPtr + ChunkLength;
+	}
+
+	// Queues the (full) current chunk for writing and continues into a free
+	// one, waiting for the writer if there is none
+	inline void spillCurrent() {
+		if (SpillFile == nullptr) {
+			SpillFile = std::tmpfile();
+			if (SpillFile == nullptr)
+				WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: the spill file could not be created.\n");
+		}
+		if (!Writer.joinable())
+			Writer = std::thread(&MexSpillVector::writerLoop, this);
+
+		size_t NextBuffer;
+		{
+			std::unique_lock<std::mutex> Lock(QueueMutex);
+			PendingBuffers.push_back(CurrBuffer);
+			QueueCond.notify_all();
+			QueueCond.wait(Lock, [this]() { return !FreeBuffers.empty(); });
+			NextBuffer = FreeBuffers.front();
+			FreeBuffers.pop_front();
+		}
+		NSpilledChunks++;
+		checkIO();
+		setCurrBuffer(NextBuffer);
+	}
+
+	inline size_t nbufferedelems() const {
+		return CurrPtr - Buffers[CurrBuffer].begin();
+	}
+
+	// Reads the elements [Offset, Offset + NElems) of the spilled data
+	inline void readSpilled(T* Dest, size_t Offset, size_t NElems) {
+		if (NElems == 0)
+			return;
+		if (MEXMEM_FSEEK64(SpillFile, Offset*sizeof(T), SEEK_SET) != 0
+		    || std::fread(Dest, sizeof(T), NElems, SpillFile) != NElems) {
+			WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: reading from the spill file failed.\n");
+		}
+	}
+
+public:
+
+	// Spills to a temporary file (deleted when the vector is destroyed) or,
+	// if SpillPath is given, to the file at SpillPath (overwritten)
+	inline explicit MexSpillVector(const char* SpillPath = nullptr) :
+		ChunkLength((MEXMEM_SPILL_CHUNK_SIZE / sizeof(T) > 0) ? MEXMEM_SPILL_CHUNK_SIZE / sizeof(T) : 1),
+		Size(0), NSpilledChunks(0), Buffers(MEXMEM_SPILL_BUFFERS), SpillFile(nullptr),
+		isWriting(false), isStopping(false), isIOFailed(false) {
+
+		if (SpillPath != nullptr) {
+			SpillFile = std::fopen(SpillPath, "w+b");
+			if (SpillFile == nullptr)
+				WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: the spill file %s could not be created.\n", SpillPath);
+		}
+		for (size_t i = 1; i < MEXMEM_SPILL_BUFFERS; ++i)
+			FreeBuffers.push_back(i);
+		setCurrBuffer(0);
+	}
+	MexSpillVector(const MexSpillVector &) = delete;
+	MexSpillVector & operator = (const MexSpillVector &) = delete;
+
+	inline ~MexSpillVector() {
+		if (Writer.joinable()) {
+			{
+				std::lock_guard<std::mutex> Lock(QueueMutex);
+				isStopping = true;
+				QueueCond.notify_all();
+			}
+			Writer.join();
+		}
+		if (SpillFile != nullptr)
+			std::fclose(SpillFile);
+	}
+
+	inline void push_back(const T &Value) {
+		if (CurrPtr == CurrEnd)
+			spillCurrent();
+		*CurrPtr++ = Value;
+		Size++;
+	}
+	inline void append(const T* Values, size_t NValues) {
+		while (NValues > 0) {
+			if (CurrPtr == CurrEnd)
+				spillCurrent();
+			size_t NCopy = (size_t(CurrEnd - CurrPtr) < NValues) ? size_t(CurrEnd - CurrPtr) : NValues;
+			std::memcpy(CurrPtr, Values, NCopy*sizeof(T));
+			CurrPtr += NCopy;
+			Values += NCopy;
+			NValues -= NCopy;
+			Size += NCopy;
+		}
+	}
+
+	// Waits until all the full chunks have been written
+	inline void flush() {
+		if (Writer.joinable()) {
+			std::unique_lock<std::mutex> Lock(QueueMutex);
+			QueueCond.wait(Lock, [this]() { return PendingBuffers.empty() && !isWriting; });
+		}
+		if (SpillFile != nullptr && std::fflush(SpillFile) != 0) {
+			std::lock_guard<std::mutex> Lock(QueueMutex);
+			isIOFailed = true;
+		}
+		checkIO();
+	}
+
+	inline size_t size() const {
+		return Size;
+	}
+	inline bool isempty() const {
+		return Size == 0;
+	}
+	inline size_t chunklength() const {
+		return ChunkLength;
+	}
+	inline size_t nspilledchunks() const {
+		return NSpilledChunks;
+	}
+
+	// Sequential reader of the contents (flushes the vector). Each call to
+	// next returns the next chunk, which remains valid until the following
+	// call, while the chunk after it is read in the background.
+	class ChunkReader {
+		MexSpillVector &Vector;
+		MexVector<T, Al> ReadBuffers[2];
+		size_t NextChunk;                 // index of the next chunk to return
+		std::future<void> Prefetch;       // reads chunk NextChunk into ReadBuffers[NextChunk % 2]
+
+		inline void startPrefetch() {
+			if (NextChunk < Vector.NSpilledChunks) {
+				T* Dest = ReadBuffers[NextChunk % 2].begin();
+				size_t Offset = NextChunk*Vector.ChunkLength;
+				size_t NElems = Vector.ChunkLength;
+				std::FILE* SpillFile = Vector.SpillFile;
+				Prefetch = std::async(std::launch::async, [SpillFile, Dest, Offset, NElems]() {
+					if (MEXMEM_FSEEK64(SpillFile, Offset*sizeof(T), SEEK_SET) != 0
+					    || std::fread(Dest, sizeof(T), NElems, SpillFile) != NElems)
+						throw ExOps::EXCEPTION_MEM_FULL;
+				});
+			}
+		}
+
+	public:
+		inline explicit ChunkReader(MexSpillVector &Vector_) : Vector(Vector_), NextChunk(0) {
+			Vector.flush();
+			if (Vector.NSpilledChunks > 0) {
+				ReadBuffers[0].resize(Vector.ChunkLength);
+				ReadBuffers[1].resize(Vector.ChunkLength);
+			}
+			startPrefetch();
+		}
+		ChunkReader(ChunkReader &&) = default;
+		inline ~ChunkReader() {
+			if (Prefetch.valid())
+				Prefetch.wait();
+		}
+
+		// Returns the next chunk (and its length in NElems), or nullptr after
+		// the last one
+		inline const T* next(size_t &NElems) {
+			if (NextChunk < Vector.NSpilledChunks) {
+				try {
+					Prefetch.get();
+				}
+				catch (ExOps::ExCodes) {
+					WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: reading from the spill file failed.\n");
+				}
+				const T* Chunk = ReadBuffers[NextChunk % 2].begin();
+				NextChunk++;
+				startPrefetch();
+				NElems = Vector.ChunkLength;
+				return Chunk;
+			}
+			else if (NextChunk == Vector.NSpilledChunks) {
+				NextChunk++;
+				NElems = Vector.nbufferedelems();
+				return (NElems > 0) ? Vector.Buffers[Vector.CurrBuffer].begin() : nullptr;
+			}
+			NElems = 0;
+			return nullptr;
+		}
+	};
+
+	inline ChunkReader getReader() {
+		return ChunkReader(*this);
+	}
+
+	// Streams the contents to a binary file (the elements in their native
+	// representation, without any header)
+	inline void writeToFile(const char* FilePath) {
+		std::FILE* OutFile = std::fopen(FilePath, "wb");
+		if (OutFile == nullptr)
+			WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: the file %s could not be created.\n", FilePath);
+
+		bool isWritten = true;
+		{
+			ChunkReader Reader(*this);
+			size_t NElems;
+			const T* Chunk;
+			while (isWritten && (Chunk = Reader.next(NElems)) != nullptr)
+				isWritten = std::fwrite(Chunk, sizeof(T), NElems, OutFile) == NElems;
+		}
+		isWritten = (std::fclose(OutFile) == 0) && isWritten;
+		if (!isWritten)
+			WriteException(ExOps::EXCEPTION_MEM_FULL, "MexSpillVector: writing to the file %s failed.\n", FilePath);
+	}
+
+	// Reads the contents into the Size elements at Dest
+	inline void copyTo(T* Dest) {
+		flush();
+		size_t NSpilledElems = NSpilledChunks*ChunkLength;
+		if (NSpilledElems > 0)
+			readSpilled(Dest, 0, NSpilledElems);
+		std::memcpy(Dest + NSpilledElems, Buffers[CurrBuffer].begin(), nbufferedelems()*sizeof(T));
+	}
+};
+
+// Returns the contents as a column vector. The data is read from the spill
+// file directly into the data of the returned array.
+template <typename T, class Al>
+inline mxArrayPtr assignmxArray(MexSpillVector<T, Al> &VectorOut) {
+
+	mxClassID ClassID = GetMexType<T>::typeVal;
+	mxArrayPtr ReturnPointer = mxCreateNumericMatrix_730(0, 0, ClassID, mxREAL);
+
+	if (VectorOut.size()) {
+		T* Data = reinterpret_cast<T*>(mxMalloc(VectorOut.size()*sizeof(T)));
+		if (Data == nullptr)
+			throw ExOps::EXCEPTION_MEM_FULL;
+		try {
+			VectorOut.copyTo(Data);
+		}
+		catch (...) {
+			mxFree(Data);
+			mxDestroyArray(ReturnPointer);
+			throw;
+		}
+		mxSetM(ReturnPointer, VectorOut.size());
+		mxSetN(ReturnPointer, 1);
+		mxSetData(ReturnPointer, Data);
+	}
+	return ReturnPointer;
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include <type_traits>
 
 #include "MexMem.hpp"
+#include "ParallelHelpers.hpp"
 
 template <typename T>
 struct GetMexType {
@@ -24,8 +25,8 @@ template <> struct GetMexType < uint64_t > { static constexpr mxClassID typeVal
 template <> struct GetMexType < float    > { static constexpr mxClassID typeVal = ::mxSINGLE_CLASS ; };
 template <> struct GetMexType < double   > { static constexpr mxClassID typeVal = ::mxDOUBLE_CLASS ; };
 
-template <typename T, class Al>              struct GetMexType<MexVector<T, Al> >                   { static constexpr uint32_t typeVal = GetMexType<T>::typeVal; };
-template <typename T, class AlSub, class Al> struct GetMexType<MexVector<MexVector<T, AlSub>, Al> > { static constexpr uint32_t typeVal = mxCELL_CLASS; };
+template <typename T, class Al>              struct GetMexType<MexVector<T, Al> >                   { static constexpr mxClassID typeVal = GetMexType<T>::typeVal; };
+template <typename T, class AlSub, class Al> struct GetMexType<MexVector<MexVector<T, AlSub>, Al> > { static constexpr mxClassID typeVal = mxCELL_CLASS; };
 
 // Type Traits extraction for Vectors
 template <typename T, typename B = void> 
@@ -89,7 +90,7 @@ struct FieldInfo {
 	static inline bool CheckType(const mxArray* InputmxArray) {
 		return false;
 	}
-	static inline uint32_t getSize(const mxArray* InputmxArray) {
+	static inline size_t getSize(const mxArray* InputmxArray) {
 		return 0;
 	}
 };
@@ -100,7 +101,7 @@ struct FieldInfo<void> {
 	static inline bool CheckType(const mxArray* InputmxArray) {
 		return true;
 	}
-	static inline uint32_t getSize(const mxArray* InputmxArray) {
+	static inline size_t getSize(const mxArray* InputmxArray) {
 		size_t NumElems = 0;
 
 		// If array is non-empty, calculate size
@@ -117,7 +118,7 @@ struct FieldInfo<T, typename std::enable_if<std::is_arithmetic<T>::value >::type
 	static inline bool CheckType(const mxArray* InputmxArray) {
 		return (InputmxArray == nullptr || mxIsEmpty(InputmxArray) || mxGetClassID(InputmxArray) == GetMexType<T>::typeVal);
 	}
-	static inline uint32_t getSize(const mxArray* InputmxArray) {
+	static inline size_t getSize(const mxArray* InputmxArray) {
 		size_t NumElems = 0;
 
 		// If array is non-empty, calculate size
@@ -139,7 +140,7 @@ struct FieldInfo<T, typename std::enable_if<isMexVector<T>::value>::type> {
 		           && (mxGetN(InputmxArray) == 1 || mxGetM(InputmxArray) == 1)  // Check if 1-D
 		           && mxGetClassID(InputmxArray) == GetMexType<typename isMexVector<T>::type>::typeVal); // Check Type
 	}
-	static inline uint32_t getSize(const mxArray* InputmxArray) {
+	static inline size_t getSize(const mxArray* InputmxArray) {
 		size_t NumElems = 0;
 
 		// If array is non-empty, calculate size
@@ -159,12 +160,12 @@ struct FieldInfo<T, typename std::enable_if<isMexMatrix<T>::value>::type> {
 		        || mxGetNumberOfDimensions(InputmxArray) == 2
 		           && mxGetClassID(InputmxArray) == GetMexType<typename isMexMatrix<T>::type>::typeVal);
 	}
-	static inline uint32_t getSize(const mxArray* InputmxArray, uint32_t Dimension=0) {
+	static inline size_t getSize(const mxArray* InputmxArray, uint32_t Dimension=0) {
 		// Ths function assumes tat InputmxArray represents a valid Matrix. If not
 		// then the result is undefined. Validate using CheckType prior to calling
 		// this function.
 
-		uint32_t NumElems = 0;
+		size_t NumElems = 0;
 
 		// If array is non-empty, calculate size
 		if (InputmxArray != nullptr && !mxIsEmpty(InputmxArray)) {
@@ -185,11 +186,29 @@ struct FieldInfo<T, typename std::enable_if<isMexVectVector<T>::value>::type> {
 			const mxArray* * SubVectorArray = reinterpret_cast<const mxArray* *>(mxGetData(InputmxArray));
 			size_t NSubElems = mxGetNumberOfElements(InputmxArray);
 			// Validate each subvector
-			for (int i = 0; i < NSubElems; ++i) {
-				if (!FieldInfo<typename isMexVectVector<T>::elemType>::CheckType(SubVectorArray[i])) {
-					isValid = false;
-					break;
+			if (NSubElems < MEXMEM_PARALLEL_THRESHOLD) {
+				for (size_t i = 0; i < NSubElems; ++i) {
+					if (!FieldInfo<typename isMexVectVector<T>::elemType>::CheckType(SubVectorArray[i])) {
+						isValid = false;
+						break;
+					}
+				}
+			}
+			else {
+				// Large cell arrays are validated in parallel. Once any thread
+				// finds an invalid subvector, the remaining iterations are
+				// skipped (OpenMP 2.0 has no cancellation so this is done via
+				// the shared flag)
+				std::atomic<bool> isValidShared(true);
+				int64_t NSubElemsSigned = NSubElems;
+				#pragma omp parallel for schedule(dynamic, 1024)
+				for (int64_t i = 0; i < NSubElemsSigned; ++i) {
+					if (isValidShared.load(std::memory_order_relaxed)
+					    && !FieldInfo<typename isMexVectVector<T>::elemType>::CheckType(SubVectorArray[i])) {
+						isValidShared.store(false, std::memory_order_relaxed);
+					}
 				}
+				isValid = isValidShared.load();
 			}
 		}
 		else if (InputmxArray != nullptr && !mxIsEmpty(InputmxArray)) {
@@ -200,7 +219,7 @@ struct FieldInfo<T, typename std::enable_if<isMexVectVector<T>::value>::type> {
 		}
 		return isValid;
 	}
-	static inline uint32_t getSize(const mxArray* InputmxArray) {
+	static inline size_t getSize(const mxArray* InputmxArray) {
 		size_t NumElems = 0;
 
 		// If array is non-empty, calculate size
@@ -0,0 +1,97 @@
+#ifndef PARALLEL_HELPERS_HPP
+#define PARALLEL_HELPERS_HPP
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+// All parallel loops in these headers are written as OpenMP pragmas. When the
+// code is compiled without OpenMP support (/openmp or -fopenmp), the pragmas
+// are ignored and the loops run serially with identical results.
+//
+// NOTE: The MATLAB API (mxMalloc, mxCreate*, mxSetField etc.) is NOT thread
+// safe. Parallel regions must therefore restrict themselves to read-only
+// accessors (mxGetData, mxGetClassID, mxGetNumberOfElements etc.) and to
+// reading / writing memory that has been allocated beforehand.
+
+// Loops over fewer elements than this are run serially as the cost of
+// starting a parallel region dominates for small arrays.
+#ifndef MEXMEM_PARALLEL_THRESHOLD
+#  define MEXMEM_PARALLEL_THRESHOLD 16384
+#endif
+
+// Number of shards per thread used by the parallel functions with dynamic
+// load balancing. Idle threads pick up the remaining shards, so a larger
+// value gives better balance at the cost of more scheduling overhead.
+#ifndef MEXMEM_SHARDS_PER_THREAD
+#  define MEXMEM_SHARDS_PER_THREAD 8
+#endif
+
+// Hint to fetch the cache line containing Address for reading. This is a
+// no-op on compilers without a prefetch intrinsic.
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <xmmintrin.h>
+#  define MEXMEM_PREFETCH(Address) _mm_prefetch((const char*)(Address), _MM_HINT_T0)
+#elif defined(__GNUC__)
+#  define MEXMEM_PREFETCH(Address) __builtin_prefetch((const void*)(Address))
+#else
+#  define MEXMEM_PREFETCH(Address) ((void)0)
+#endif
+
+inline int getMaxThreads() {
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+// Replaces Array[0..N) with its inclusive prefix sum in place and returns the
+// total. For large arrays, the sum is computed in parallel in two passes, the
+// first computing the sum of each block (one block per thread) and the second
+// scanning each block starting from the offset of the block.
+template <typename SumT>
+inline SumT InclusivePrefixSum(SumT* Array, size_t N) {
+
+	int NBlocks = getMaxThreads();
+
+	if (N < MEXMEM_PARALLEL_THRESHOLD || NBlocks == 1) {
+		SumT RunningSum = 0;
+		for (size_t i = 0; i < N; ++i) {
+			RunningSum += Array[i];
+			Array[i] = RunningSum;
+		}
+		return RunningSum;
+	}
+
+	std::vector<SumT> BlockOffsets(NBlocks + 1, SumT(0));
+
+	#pragma omp parallel for schedule(static, 1)
+	for (int b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = N*b/NBlocks, BlockEnd = N*(b + 1)/NBlocks;
+		SumT BlockSum = 0;
+		for (size_t i = BlockBeg; i < BlockEnd; ++i)
+			BlockSum += Array[i];
+		BlockOffsets[b + 1] = BlockSum;
+	}
+	for (int b = 0; b < NBlocks; ++b) {
+		BlockOffsets[b + 1] += BlockOffsets[b];
+	}
+
+	#pragma omp parallel for schedule(static, 1)
+	for (int b = 0; b < NBlocks; ++b) {
+		size_t BlockBeg = N*b/NBlocks, BlockEnd = N*(b + 1)/NBlocks;
+		SumT RunningSum = BlockOffsets[b];
+		for (size_t i = BlockBeg; i < BlockEnd; ++i) {
+			RunningSum += Array[i];
+			Array[i] = RunningSum;
+		}
+	}
+	return BlockOffsets[NBlocks];
+}
+
+#endif
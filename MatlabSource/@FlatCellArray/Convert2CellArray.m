@@ -8,6 +8,19 @@ function CellArray = Convert2CellArray(obj)
 %   that do not conform to the requirements, then the behaviour is
 %   undefined and may lead to exceptions being thrown
 	
+	% Use the compiled kernel if available. Classes of Data that it does not
+	% support (char, logical) are handled by the code below.
+	if isFlatCellArrayMexAvailable()
+		try
+			CellArray = FlatCellArrayMex('unflatten', obj.Convert2Struct());
+			return;
+		catch ME
+			if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+				rethrow(ME);
+			end
+		end
+	end
+	
 	% calculating Begin and End Arrays and calling Convert2CellArrayPartial
 	FlatCellArrDepth = length(obj.PartitionIndex);
 	BeginInds = zeros(FlatCellArrDepth, 1);
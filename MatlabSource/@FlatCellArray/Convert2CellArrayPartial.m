@@ -33,6 +33,21 @@ function CellArray = Convert2CellArrayPartial(obj, DepthStartInd, BegInds, EndIn
 %              to be a part of the partial Flat Cell Array which is to be 
 %              converted
 
+	% Use the compiled kernel if available (only the range of the first level
+	% is required, the ranges of the lower levels being implied by it).
+	% Classes of Data that it does not support (char, logical) are handled
+	% by the code below.
+	if isFlatCellArrayMexAvailable()
+		try
+			CellArray = FlatCellArrayMex('unflatten', obj.Convert2Struct(), DepthStartInd, BegInds(1), EndInds(1));
+			return;
+		catch ME
+			if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+				rethrow(ME);
+			end
+		end
+	end
+	
 	FullDepth = length(obj.PartitionIndex);
 	ActualDepth = FullDepth - DepthStartInd + 1;
 
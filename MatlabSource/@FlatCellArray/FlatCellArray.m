@@ -23,6 +23,13 @@ classdef FlatCellArray < hgsetget
 		% the FlatCellArray. It is equal to the number of cells in 
 		% PartitionIndex
 		Depth;
+
+		% IndexClass - The class of the Partition Indices
+		% This is the class ('uint32' or 'uint64') of all the vectors in
+		% PartitionIndex. uint64 indices are required when the number of
+		% elements in any level (or in Data) exceeds intmax('uint32'). For
+		% a FlatCellArray of Depth 0, it is 'uint32'.
+		IndexClass;
 	end
 	
 	% Proerty setget interfaces
@@ -30,6 +37,13 @@ classdef FlatCellArray < hgsetget
 		function Val = get.Depth(obj)
 			Val = length(obj.PartitionIndex);
 		end
+		function Val = get.IndexClass(obj)
+			if isempty(obj.PartitionIndex)
+				Val = 'uint32';
+			else
+				Val = class(obj.PartitionIndex{1});
+			end
+		end
 		function set.Depth(obj, Val)
 			% SET.DEPTH - Adjusts the depth of the flat cell array
 			% The depth can be increased unconditionally, it can be
@@ -48,7 +62,7 @@ classdef FlatCellArray < hgsetget
 			elseif obj.Depth < Val
 				% Push the existing array deeper
 				NewPartitionIndex = cell(Val, 1);
-				NewPartitionIndex(:) = {zeros(1,1, 'uint32')};
+				NewPartitionIndex(:) = {zeros(1,1, obj.IndexClass)};
 				newDepth = length(NewPartitionIndex); % possibly different from Val if Val is not an integer
 				NewPartitionIndex(newDepth-obj.Depth+1:end) = obj.PartitionIndex;
 				
@@ -62,7 +76,7 @@ classdef FlatCellArray < hgsetget
 
 					% Notify all higher levels of the position of exactly one
 					% element below them
-					NewPartitionIndex(1:newDepth-obj.Depth-1) = {uint32([0; 1])};
+					NewPartitionIndex(1:newDepth-obj.Depth-1) = {cast([0; 1], obj.IndexClass)};
 				end
 				
 				obj.PartitionIndex = NewPartitionIndex;
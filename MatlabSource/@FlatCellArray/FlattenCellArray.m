@@ -10,6 +10,51 @@ function obj = FlattenCellArray(CellArray, InputArrayType, ActualDepth)
 
 	obj = FlatCellArray();
 	
+	% Use the compiled kernel if available. The leaves are flattened level by
+	% level without recursion. Arrays of classes not supported by the kernel
+	% (char, logical) are flattened by the MATLAB implementation below.
+	if isFlatCellArrayMexAvailable()
+		if nargin < 2
+			InputArrayType = '';
+		end
+		if nargin < 3
+			MexActualDepth = 0;
+		else
+			MexActualDepth = ActualDepth;
+		end
+		
+		try
+			[FlatStruct, CellArrayDepth, isUndecided] = FlatCellArrayMex('flatten', CellArray, InputArrayType, MexActualDepth);
+		catch ME
+			if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+				rethrow(ME);
+			end
+			FlatStruct = [];
+		end
+		
+		if ~isempty(FlatStruct)
+			if isUndecided && strcmp(InputArrayType, '')
+				warning('FlatCellArray:UndecidedType', ...
+						['The cell array does not seem to contain any vectors and thus,' ...
+						 ' the type is taken to be double by default. Specify type as' ...
+						 ' additional argument if otherwise required']);
+			end
+			if isUndecided && nargin < 3
+				warning('FlatCellArray:UndecidedDepth', ...
+						['The cell array does not seem to contain any vectors and thus,' ...
+						 ' the Depth of the cell array may possibly be incorrectly judged.' ...
+						 ' Specify Actual Depth as additional argument if otherwise required']);
+			end
+			if ~isUndecided && nargin == 3 && ActualDepth ~= CellArrayDepth
+				warning('FlatCellArray:RedundantDepthInput', 'The Depth for the cell array is NOT undecided. Ignoring given ActualDepth');
+			end
+			
+			obj.PartitionIndex = FlatStruct.PartitionIndex;
+			obj.Data = FlatStruct.Data;
+			return;
+		end
+	end
+	
 	% Setting Array Type and validating cell array
 	ArrayTypeCalc = FlatCellArray.getCellType(CellArray);
 	ArrayType = ArrayTypeCalc;
@@ -54,13 +99,19 @@ function obj = FlattenCellArray(CellArray, InputArrayType, ActualDepth)
 		ActualDepth = CellArrayDepth;
 	end
 	
-	% Initializing PartitionIndex
+	% Initializing PartitionIndex (uint64 indices are used only if the
+	% number of elements of some level exceeds the range of uint32)
+	if any(CellLevelSizes > intmax('uint32'))
+		IndexClass = 'uint64';
+	else
+		IndexClass = 'uint32';
+	end
 	obj.PartitionIndex = cell(ActualDepth, 1);
 	for i = 1:CellArrayDepth
-		obj.PartitionIndex{i} = zeros(CellLevelSizes(i)+1, 1, 'uint32');
+		obj.PartitionIndex{i} = zeros(CellLevelSizes(i)+1, 1, IndexClass);
 	end
 	for i = CellArrayDepth+1:ActualDepth
-		obj.PartitionIndex{i} = zeros(1,1,'uint32');
+		obj.PartitionIndex{i} = zeros(1,1,IndexClass);
 	end
 	
 	% Initializing Data
@@ -8,10 +8,19 @@ Ex = [];
 if iscell(PartitionIndexIn)
 	InitDepth = length(PartitionIndexIn);
 
-	% validate if NonEmpty uint32 vectors
+	% validate if NonEmpty uint32 or uint64 vectors
 	for i = 1:InitDepth
-		if ~isa(PartitionIndexIn{i}, 'uint32') || isempty(PartitionIndexIn{i})
-			Ex = MException('FlatCellArray:InvalidInput','PartitionIndex{%d} expected to be a non-empty uint32 vector', i);
+		if ~(isa(PartitionIndexIn{i}, 'uint32') || isa(PartitionIndexIn{i}, 'uint64')) || isempty(PartitionIndexIn{i})
+			Ex = MException('FlatCellArray:InvalidInput','PartitionIndex{%d} expected to be a non-empty uint32 or uint64 vector', i);
+			isValid = false;
+			return;
+		end
+	end
+
+	% validate if all levels are of the same class
+	for i = 2:InitDepth
+		if ~isa(PartitionIndexIn{i}, class(PartitionIndexIn{1}))
+			Ex = MException('FlatCellArray:InvalidInput','PartitionIndex{%d} expected to be of the same class (%s) as PartitionIndex{1}', i, class(PartitionIndexIn{1}));
 			isValid = false;
 			return;
 		end
@@ -153,17 +153,56 @@ function append(FlatCellArr, Cell2Push, DepthStartInd, InputType, ActualCell2Pus
 		Cell2Push = FlatCellArray.FlattenCellArray(Cell2Push, InputType, PushCellArrDepth);
 	end
 	
+	% Use the compiled kernel if available. The Data of Cell2Push is
+	% converted to the class of FlatCellArr.Data (unless FlatCellArr is
+	% empty) as is done by the assignment below. Classes of Data that it
+	% does not support (char, logical) are handled by the code below.
+	if isFlatCellArrayMexAvailable()
+		if isa(Cell2Push, 'FlatCellArray')
+			PushStruct = Cell2Push.Convert2Struct();
+		else
+			PushStruct = struct('ClassName', 'FlatCellArray', 'PartitionIndex', {cell(0,1)}, 'Data', Cell2Push(:));
+		end
+		CurrStruct = FlatCellArr.Convert2Struct();
+		if FlatCellArr.Depth == 0
+			CurrStruct.Data = zeros(0, 1, class(PushStruct.Data));
+		elseif ~strcmp(class(PushStruct.Data), class(CurrStruct.Data))
+			PushStruct.Data = cast(PushStruct.Data, class(CurrStruct.Data));
+		end
+		
+		try
+			AppendedStruct = FlatCellArrayMex('append', CurrStruct, PushStruct, DepthStartInd);
+			FlatCellArr.PartitionIndex = AppendedStruct.PartitionIndex;
+			FlatCellArr.Data = AppendedStruct.Data;
+			return;
+		catch ME
+			if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+				rethrow(ME);
+			end
+		end
+	end
+	
 	% Initializing FlatCellArr.PartitionIndex in case FlatCellArr.Depth == 0
 	if FlatCellArr.Depth == 0
 		CurrFlatArrayDepth = DepthStartInd + PushCellArrDepth - 1;
 		FlatCellArr.PartitionIndex = cell(CurrFlatArrayDepth, 1);
 		
-		FlatCellArr.PartitionIndex(1:DepthStartInd-1) = {zeros(2,1,'uint32')};
-		FlatCellArr.PartitionIndex(DepthStartInd:end) = {zeros(1,1,'uint32')};
+		FlatCellArr.PartitionIndex(1:DepthStartInd-1) = {zeros(2,1,Cell2Push.IndexClass)};
+		FlatCellArr.PartitionIndex(DepthStartInd:end) = {zeros(1,1,Cell2Push.IndexClass)};
 		
 		FlatCellArr.Data = zeros(0,1, class(Cell2Push.Data));
 	end
 	
+	% Making the classes of the partition indices consistent. Both are
+	% widened to uint64 if either of them is uint64 or if the appended Data
+	% exceeds the range of uint32 indices.
+	Cell2PushPartitionIndex = Cell2Push.PartitionIndex;
+	if ~strcmp(FlatCellArr.IndexClass, Cell2Push.IndexClass) || ...
+	   length(FlatCellArr.Data) + length(Cell2Push.Data) > intmax(FlatCellArr.IndexClass)
+		FlatCellArr.PartitionIndex = cellfun(@uint64, FlatCellArr.PartitionIndex, 'UniformOutput', false);
+		Cell2PushPartitionIndex = cellfun(@uint64, Cell2PushPartitionIndex, 'UniformOutput', false);
+	end
+	
 	% Storing Insert Indices for all the levels into which appending needs
 	% to be done (these indices are 0-start indices)
 	BegInds = cellfun(@(x) length(x)-1, FlatCellArr.PartitionIndex(DepthStartInd:end)); % length(all except Beyond the end elem)
@@ -176,14 +215,14 @@ function append(FlatCellArr, Cell2Push, DepthStartInd, InputType, ActualCell2Pus
 	
 	for i = CurrFlatArrayDepth:-1:DepthStartInd
 		% Initializing variables
-		LevelExpandLength = length(Cell2Push.PartitionIndex{i+1-DepthStartInd}) - 1; % -1 discounts beyond the end element
+		LevelExpandLength = length(Cell2PushPartitionIndex{i+1-DepthStartInd}) - 1; % -1 discounts beyond the end element
 		LevelInsertIndex = BegInds(i-DepthStartInd+1) + 1; % Converting to 1-start
 		
 		% Reallocation and pushing
 		FlatCellArr.PartitionIndex{i}(end+1:end+LevelExpandLength) = 0;
 		FlatCellArr.PartitionIndex{i}(LevelInsertIndex:LevelInsertIndex+LevelExpandLength-1) = ...
 			... 1:end-1 to exclude BTE Elem in Cell2Push + offset by prev Beyond-The-End Elem
-			Cell2Push.PartitionIndex{i+1-DepthStartInd}(1:end-1) + FlatCellArr.PartitionIndex{i}(LevelInsertIndex); 
+			Cell2PushPartitionIndex{i+1-DepthStartInd}(1:end-1) + FlatCellArr.PartitionIndex{i}(LevelInsertIndex); 
 		
 		% Assigning Beyond-The-end Element and updating BegInds
 		FlatCellArr.PartitionIndex{i}(end) = BegInds(i+1-DepthStartInd+1);
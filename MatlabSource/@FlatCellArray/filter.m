@@ -24,6 +24,21 @@ if Depth <= 0 || Depth > FlatCellArr.Depth + 1
     throw(ME);
 end
 
+% Use the compiled kernel if available. Classes of Data that it does not
+% support (char, logical) are filtered by the code below.
+if isFlatCellArrayMexAvailable()
+    try
+        FiltStruct = FlatCellArrayMex('filter', FlatCellArr.Convert2Struct(), Depth, FiltIndexVect);
+        FlatCellArr.PartitionIndex = FiltStruct.PartitionIndex;
+        FlatCellArr.Data = FiltStruct.Data;
+        return;
+    catch ME
+        if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+            rethrow(ME);
+        end
+    end
+end
+
 % Recursion Initialization Step
 if islogical(FiltIndexVect)
     FiltIndexVect = find(FiltIndexVect);
@@ -68,7 +83,7 @@ if Depth > 1
        ChildrenCount = zeros(length(FlatCellArr.PartitionIndex{Depth-1})-1, 1);
    end
    % calculate new parent vector y cumsumming no. of children
-   FlatCellArr.PartitionIndex{Depth-1} = uint32([0; cumsum(ChildrenCount)]);
+   FlatCellArr.PartitionIndex{Depth-1} = cast([0; cumsum(ChildrenCount)], FlatCellArr.IndexClass);
 end
 
 % Filter relevant vector
@@ -8,6 +8,26 @@ function FlatCellArrOut = getSubFlatCellArr(FlatCellArrIn, Level, Indices )
 %   If the Level = FlatCellArrIn.Depth + 1, the corresponding vector is
 %   returned instead of a FlatCellArray
 	
+	% Use the compiled kernel if available. Classes of Data that it does not
+	% support (char, logical) are handled by the code below.
+	if isFlatCellArrayMexAvailable()
+		try
+			SubStruct = FlatCellArrayMex('extract', FlatCellArrIn.Convert2Struct(), Level, Indices);
+			if Level == FlatCellArrIn.Depth + 1
+				FlatCellArrOut = SubStruct;
+			else
+				FlatCellArrOut = FlatCellArray();
+				FlatCellArrOut.PartitionIndex = SubStruct.PartitionIndex;
+				FlatCellArrOut.Data = SubStruct.Data;
+			end
+			return;
+		catch ME
+			if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+				rethrow(ME);
+			end
+		end
+	end
+	
 	if Level == FlatCellArrIn.Depth + 1
 		FlatCellArrOut = FlatCellArrIn.Data(Indices);
 	else
@@ -17,7 +37,7 @@ function FlatCellArrOut = getSubFlatCellArr(FlatCellArrIn, Level, Indices )
 			% Calculating current level entries by performing cumsum over
 			% the sizes of the current level elements
 			CurrLevelElemSizes = [0; FlatCellArrIn.PartitionIndex{i+Level-1}(CurrLevelIndices+1) - FlatCellArrIn.PartitionIndex{i+Level-1}(CurrLevelIndices)];
-			CurrLevelEntries = uint32(cumsum(CurrLevelElemSizes));
+			CurrLevelEntries = cast(cumsum(CurrLevelElemSizes), FlatCellArrIn.IndexClass);
 			PartitionIndexOut{i} = CurrLevelEntries;
 			
 			% Getting the next level indices using the values stored in the
@@ -0,0 +1,580 @@
+// FlatCellArrayMex - Compiled kernels for the methods of FlatCellArray
+//
+// Syntax:
+//
+//   FlatCellArrStruct = FlatCellArrayMex('filter' , FlatCellArrStruct, Level, Indices)
+//   Out               = FlatCellArrayMex('extract', FlatCellArrStruct, Level, Indices)
+//   [FlatCellArrStruct, CellArrayDepth, isUndecided] = ...
+//                       FlatCellArrayMex('flatten', CellArray, ArrayType, ActualDepth)
+//   CellArray         = FlatCellArrayMex('unflatten', FlatCellArrStruct)
+//   CellArray         = FlatCellArrayMex('unflatten', FlatCellArrStruct, Level, Beg, End)
+//   FlatCellArrStruct = FlatCellArrayMex('append' , FlatCellArrStruct, AppendStruct, DepthStartInd)
+//   Out               = FlatCellArrayMex('index'  , FlatCellArrStruct, IndexTypes, IndexSubs)
+//
+// FlatCellArrStruct is the struct returned by FlatCellArray.Convert2Struct.
+// Level and Indices are 1-based as in FlatCellArray.filter and
+// FlatCellArray.getSubFlatCellArr, Level = Depth + 1 referring to Data. For
+// 'filter', Indices may also be a logical mask. For 'extract', Out is the
+// FlatCellArray struct of the extracted sub-array, or the vector of the
+// indexed elements of Data if Level = Depth + 1.
+//
+// 'flatten' flattens CellArray as FlatCellArray.FlattenCellArray. ArrayType
+// may be '' (the class of the leaves, double if undecided) and ActualDepth
+// may be 0 (the depth of CellArray). 'unflatten' is the inverse, optionally
+// restricted to the elements [Beg, End) (0-based) of Level (1-based) as in
+// FlatCellArray.Convert2CellArrayPartial. 'append' appends the FlatCellArray
+// struct AppendStruct (whose Data must be of the same class) as in
+// FlatCellArray.append (DepthStartInd may be []). 'index' performs the
+// indexing of FlatCellArray.subsref, IndexTypes being a char array
+// containing '{' or '(' for each level of indexing and IndexSubs the cell
+// array of the corresponding subscripts (':' or 1-based indices).
+//
+// The commands are implemented by the corresponding functions of
+// FlatVectTree and are dispatched over the class of Data and the class of
+// the partition indices (uint32 or uint64). If the class of Data is not
+// supported, the error identifier is FlatCellArray:UnsupportedClass.
+//
+// This is compiled by buildFlatCellArrayMex.m (in MatlabSource).
+
+#include <matrix.h>
+#include <mex.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "../../../Headers/MexMem.hpp"
+#include "../../../Headers/GenericMexIO.hpp"
+#include "../../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+// The FlatCellArray struct (or the cell array for 'flatten') is always the
+// argument following the command
+#define FCA_STRUCT_ARG 1
+
+enum FCA_ExCodes {
+	FCA_UNSUPPORTED_CLASS = 0x01
+};
+
+// The levels of a cell array to be flattened (see getCellArrayLevels)
+struct CellArrayLevels {
+	MexVector<MexVector<const mxArray*> > LevelNodes;
+	mxClassID LeafClass;
+	uint32_t Depth;
+};
+
+//////////////////////////////////////////////////////////////////
+//////////////////////// INPUT HELPERS ///////////////////////////
+//////////////////////////////////////////////////////////////////
+
+template <typename T, typename IndexT>
+inline void getFlatVectTreeWrapper(const mxArray* FlatCellArrStruct, FlatVectTree<T, mxAllocator, IndexT> &FlatVectTreeOut) {
+
+	// Wraps the vectors of the given FlatCellArray struct in FlatVectTreeOut
+	// without copying them (except for uint32 partition indices which are
+	// widened if IndexT is uint64_t). FlatVectTreeOut must hence only be
+	// used for read-only operations.
+
+	typedef FlatVectTree<T, mxAllocator, IndexT> FVTType;
+
+	MexVector<MexVector<IndexT> > PartitionIndex;
+	MexVector<T> Data;
+
+	FieldInfo<FVTType>::moveIntoVectors(FlatCellArrStruct, PartitionIndex, Data);
+	FlatVectTreeOut.assign(PartitionIndex, Data, false);
+}
+
+template <typename IndexT, typename SrcT>
+inline void convertIndices(const SrcT* SrcIndices, size_t NIndices, MexVector<IndexT> &IndicesOut) {
+
+	// Converts the given 1-based MATLAB indices into 0-based indices. An
+	// exception is thrown if any index is not a positive integer or does not
+	// fit in IndexT (this includes NaN and Inf). Invalid indices are never
+	// cast to IndexT.
+
+	int64_t NIndicesSigned = NIndices;
+	int isInvalid = 0;
+
+	// Every valid 0-based index is strictly less than IndexLimit
+	const double IndexLimit = (double)std::numeric_limits<IndexT>::max() + 1;
+
+	IndicesOut.resize(NIndices);
+	#pragma omp parallel for reduction(|:isInvalid) if(NIndicesSigned >= MEXMEM_PARALLEL_THRESHOLD)
+	for (int64_t i = 0; i < NIndicesSigned; ++i) {
+		double CurrIndex = (double)SrcIndices[i];
+		bool isCurrValid = (CurrIndex >= 1 && CurrIndex - 1 < IndexLimit && CurrIndex == std::floor(CurrIndex));
+		isInvalid |= !isCurrValid;
+		IndicesOut[i] = isCurrValid ? (IndexT)(CurrIndex - 1) : 0;
+	}
+	if (isInvalid)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The indices must be positive integers within the range of the partition indices\n");
+}
+
+template <typename IndexT>
+inline void getIndicesfrommxArray(const mxArray* IndicesmxArr, MexVector<IndexT> &IndicesOut) {
+
+	// Gets the 0-based indices from the given MATLAB index vector which may
+	// be numeric (1-based) or logical
+
+	size_t NIndices = mxGetNumberOfElements(IndicesmxArr);
+	void* IndicesPtr = mxGetData(IndicesmxArr);
+
+	switch (mxGetClassID(IndicesmxArr)) {
+		case mxDOUBLE_CLASS : convertIndices(static_cast<double   *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxSINGLE_CLASS : convertIndices(static_cast<float    *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxINT8_CLASS   : convertIndices(static_cast<int8_t   *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxUINT8_CLASS  : convertIndices(static_cast<uint8_t  *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxINT16_CLASS  : convertIndices(static_cast<int16_t  *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxUINT16_CLASS : convertIndices(static_cast<uint16_t *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxINT32_CLASS  : convertIndices(static_cast<int32_t  *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxUINT32_CLASS : convertIndices(static_cast<uint32_t *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxINT64_CLASS  : convertIndices(static_cast<int64_t  *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxUINT64_CLASS : convertIndices(static_cast<uint64_t *>(IndicesPtr), NIndices, IndicesOut); break;
+		case mxLOGICAL_CLASS: {
+			const mxLogical* Mask = mxGetLogicals(IndicesmxArr);
+			IndicesOut.clear();
+			for (size_t i = 0; i < NIndices; ++i)
+				if (Mask[i])
+					IndicesOut.push_back(IndexT(i));
+			break;
+		}
+		default:
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The indices must be a numeric or logical vector\n");
+	}
+}
+
+inline uint32_t getLevelfrommxArray(const mxArray* LevelmxArr) {
+
+	// Gets the 0-based level from the given 1-based MATLAB level
+
+	if (LevelmxArr == nullptr || !mxIsNumeric(LevelmxArr) || mxGetNumberOfElements(LevelmxArr) != 1)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The Level must be a numeric scalar\n");
+
+	double Level = mxGetScalar(LevelmxArr);
+	if (Level < 1 || Level != std::floor(Level))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The Level (%g) must be a positive integer\n", Level);
+
+	return uint32_t(Level - 1);
+}
+
+inline void checkNumArgs(int nrhs, int NRequired, const char* Command) {
+	if (nrhs != NRequired)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The command '%s' requires %d input arguments (%d given)\n", Command, NRequired, nrhs);
+}
+
+inline size_t getScalarfrommxArray(const mxArray* ScalarmxArr, const char* Name) {
+
+	// Gets the given non-negative integer scalar
+
+	if (ScalarmxArr == nullptr || !mxIsNumeric(ScalarmxArr) || mxGetNumberOfElements(ScalarmxArr) != 1)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "%s must be a numeric scalar\n", Name);
+
+	double Scalar = mxGetScalar(ScalarmxArr);
+	if (Scalar < 0 || Scalar != std::floor(Scalar))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "%s (%g) must be a non-negative integer\n", Name, Scalar);
+
+	return size_t(Scalar);
+}
+
+inline mxClassID getClassIDfromName(const mxArray* ClassNamemxArr) {
+
+	// Gets the class from the given class name. An unknown class name is
+	// reported as an unsupported class
+
+	const char* ClassNames[] = {
+		"double", "single", "int8", "uint8", "int16", "uint16",
+		"int32", "uint32", "int64", "uint64", "logical", "char"
+	};
+	const mxClassID ClassIDs[] = {
+		mxDOUBLE_CLASS, mxSINGLE_CLASS, mxINT8_CLASS, mxUINT8_CLASS, mxINT16_CLASS, mxUINT16_CLASS,
+		mxINT32_CLASS, mxUINT32_CLASS, mxINT64_CLASS, mxUINT64_CLASS, mxLOGICAL_CLASS, mxCHAR_CLASS
+	};
+
+	char ClassName[32];
+	if (ClassNamemxArr == nullptr || !mxIsChar(ClassNamemxArr) || mxGetString(ClassNamemxArr, ClassName, sizeof(ClassName)))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The array type must be a class name\n");
+
+	for (size_t i = 0; i < sizeof(ClassIDs)/sizeof(mxClassID); ++i) {
+		if (!std::strcmp(ClassName, ClassNames[i]))
+			return ClassIDs[i];
+	}
+	WriteException(FCA_UNSUPPORTED_CLASS, "The array type '%s' is not supported\n", ClassName);
+	return mxUNKNOWN_CLASS;
+}
+
+inline size_t getFlatCellArrayMaxLevelSize(const mxArray* FlatCellArrStruct) {
+
+	// Returns the maximum number of elements in any level (including Data) of
+	// the given FlatCellArray struct
+
+	const mxArray* PartitionIndexmxArr = mxGetField(FlatCellArrStruct, 0, "PartitionIndex");
+	const mxArray* DatamxArr           = mxGetField(FlatCellArrStruct, 0, "Data");
+
+	size_t MaxLevelSize = (DatamxArr != nullptr) ? mxGetNumberOfElements(DatamxArr) : 0;
+	size_t TreeDepth = (PartitionIndexmxArr != nullptr && mxIsCell(PartitionIndexmxArr)) ? mxGetNumberOfElements(PartitionIndexmxArr) : 0;
+
+	for (size_t i = 0; i < TreeDepth; ++i) {
+		const mxArray* LevelmxArr = mxGetCell(PartitionIndexmxArr, i);
+		size_t LevelSize = (LevelmxArr != nullptr && !mxIsEmpty(LevelmxArr)) ? mxGetNumberOfElements(LevelmxArr) - 1 : 0;
+		MaxLevelSize = (LevelSize > MaxLevelSize) ? LevelSize : MaxLevelSize;
+	}
+	return MaxLevelSize;
+}
+
+//////////////////////////////////////////////////////////////////
+/////////////////////////// COMMANDS /////////////////////////////
+//////////////////////////////////////////////////////////////////
+
+template <typename T, typename IndexT>
+inline void filterCommand(int /*nlhs*/, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	checkNumArgs(nrhs, 4, "filter");
+
+	// The FlatVectTree is copied as it is modified by filter
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeIn;
+	getInputfrommxArray(prhs[FCA_STRUCT_ARG], FlatVectTreeIn);
+
+	uint32_t Level = getLevelfrommxArray(prhs[2]);
+	const mxArray* IndicesmxArr = prhs[3];
+
+	// A logical mask covering the entire level is used directly
+	uint32_t TreeDepth = FlatVectTreeIn.depth();
+	size_t NLevelElems = (Level < TreeDepth) ? FlatVectTreeIn.LevelSize(Level) : mxGetNumberOfElements(mxGetField(prhs[FCA_STRUCT_ARG], 0, "Data"));
+
+	if (mxIsLogical(IndicesmxArr) && mxGetNumberOfElements(IndicesmxArr) == NLevelElems) {
+		MexVector<bool> Mask(NLevelElems, reinterpret_cast<bool*>(mxGetLogicals(IndicesmxArr)), false);
+		FlatVectTreeIn.filter(Level, Mask);
+	}
+	else {
+		MexVector<IndexT> Indices;
+		getIndicesfrommxArray(IndicesmxArr, Indices);
+		FlatVectTreeIn.filter(Level, Indices);
+	}
+
+	plhs[0] = assignmxArray(FlatVectTreeIn);
+}
+
+template <typename T, typename IndexT>
+inline void extractCommand(int /*nlhs*/, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	checkNumArgs(nrhs, 4, "extract");
+
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeIn;
+	getFlatVectTreeWrapper(prhs[FCA_STRUCT_ARG], FlatVectTreeIn);
+
+	uint32_t Level = getLevelfrommxArray(prhs[2]);
+	MexVector<IndexT> Indices;
+	getIndicesfrommxArray(prhs[3], Indices);
+
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeOut;
+	FlatVectTreeIn.extract(FlatVectTreeOut, Level, Indices);
+
+	if (Level == FlatVectTreeIn.depth()) {
+		// Return the vector of Data elements
+		MexVector<MexVector<IndexT> > PartitionIndex;
+		MexVector<T> Data;
+		FlatVectTreeOut.releaseMem(PartitionIndex, Data);
+		plhs[0] = assignmxArray(Data);
+	}
+	else {
+		plhs[0] = assignmxArray(FlatVectTreeOut);
+	}
+}
+
+template <typename T, typename IndexT>
+inline void flattenCommand(int /*nlhs*/, mxArray *plhs[], int /*nrhs*/, const mxArray * /*prhs*/[], const CellArrayLevels *CellLevels) {
+
+	// The cell array has already been traversed (and validated) in
+	// dispatchFlatten in order to decide the classes
+
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeOut;
+	FieldInfo<FlatVectTree<T, mxAllocator, IndexT> >::assignCellArrayLevels(CellLevels->LevelNodes, CellLevels->LeafClass, CellLevels->Depth, FlatVectTreeOut);
+
+	plhs[0] = assignmxArray(FlatVectTreeOut);
+}
+
+template <typename T, typename IndexT>
+inline void unflattenCommand(int /*nlhs*/, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	if (nrhs != 2 && nrhs != 5)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The command 'unflatten' requires 2 or 5 input arguments (%d given)\n", nrhs);
+
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeIn;
+	getFlatVectTreeWrapper(prhs[FCA_STRUCT_ARG], FlatVectTreeIn);
+
+	if (nrhs == 2) {
+		plhs[0] = assignmxCellArray(FlatVectTreeIn);
+	}
+	else {
+		uint32_t Level = getLevelfrommxArray(prhs[2]);
+		IndexT LevelBeg = getScalarfrommxArray(prhs[3], "Beg");
+		IndexT LevelEnd = getScalarfrommxArray(prhs[4], "End");
+		plhs[0] = assignmxCellArray(FlatVectTreeIn.view(Level, LevelBeg, LevelEnd));
+	}
+}
+
+template <typename T, typename IndexT>
+inline void appendCommand(int /*nlhs*/, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	checkNumArgs(nrhs, 4, "append");
+
+	if (!FieldInfo<FlatVectTree<T, mxAllocator, IndexT> >::isFlatCellArrayStruct(prhs[2]))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The FlatCellArray to append must be a FlatCellArray struct\n");
+
+	// The FlatVectTree appended to is copied as it is modified
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeIn, AppendVectTree;
+	getInputfrommxArray(prhs[FCA_STRUCT_ARG], FlatVectTreeIn);
+	getFlatVectTreeWrapper(prhs[2], AppendVectTree);
+
+	uint32_t InsertDepth = mxIsEmpty(prhs[3]) ? uint32_t(-1) : getLevelfrommxArray(prhs[3]);
+
+	FlatVectTreeIn.append(AppendVectTree, InsertDepth);
+	plhs[0] = assignmxArray(FlatVectTreeIn);
+}
+
+template <typename IndexT>
+inline IndexT getFirstSubscript(const mxArray* SubsmxArr) {
+
+	// Gets the (0-based) subscript of a {} indexing. ':' refers to the first
+	// element and only the first of multiple subscripts is considered.
+
+	if (mxIsChar(SubsmxArr))
+		return 0;
+
+	MexVector<IndexT> Indices;
+	getIndicesfrommxArray(SubsmxArr, Indices);
+	if (Indices.size() == 0)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "Empty cell indexing is undefined\n");
+	return Indices[0];
+}
+
+template <typename T, typename IndexT>
+inline void indexCommand(int /*nlhs*/, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	// Each {} indexing selects a single element and descends to its
+	// children (navigated by FlatVectTreeView without any allocation). The
+	// final () indexing (if any) selects a subset of the current elements.
+	// The selected elements are then extracted as in 'extract'.
+
+	checkNumArgs(nrhs, 4, "index");
+
+	const mxArray* IndexTypesmxArr = prhs[2];
+	const mxArray* IndexSubsmxArr  = prhs[3];
+	size_t IndexingDepth = mxIsChar(IndexTypesmxArr) ? mxGetNumberOfElements(IndexTypesmxArr) : 0;
+
+	if (IndexingDepth == 0 || !mxIsCell(IndexSubsmxArr) || mxGetNumberOfElements(IndexSubsmxArr) != IndexingDepth)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "IndexTypes must be a non-empty char array with one element per element of IndexSubs\n");
+
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeIn;
+	getFlatVectTreeWrapper(prhs[FCA_STRUCT_ARG], FlatVectTreeIn);
+
+	const mxChar* IndexTypes = (const mxChar*)mxGetData(IndexTypesmxArr);
+	FlatVectTreeView<T, mxAllocator, IndexT> CurrView = FlatVectTreeIn.view();
+	MexVector<IndexT> LevelIndices;
+
+	for (size_t i = 0; i < IndexingDepth; ++i) {
+		const mxArray* CurrSubsmxArr = mxGetCell(IndexSubsmxArr, i);
+		if (CurrSubsmxArr == nullptr)
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The subscripts of indexing %d are invalid\n", int(i + 1));
+
+		if (IndexTypes[i] == '{') {
+			CurrView = CurrView.at(getFirstSubscript<IndexT>(CurrSubsmxArr));
+		}
+		else if (IndexTypes[i] == '(' && i == IndexingDepth - 1) {
+			if (mxIsChar(CurrSubsmxArr)) {
+				LevelIndices.resize(CurrView.size());
+				for (size_t j = 0; j < CurrView.size(); ++j)
+					LevelIndices[j] = CurrView.levelBeg() + j;
+			}
+			else {
+				getIndicesfrommxArray(CurrSubsmxArr, LevelIndices);
+				int64_t NIndices = LevelIndices.size();
+				IndexT NCurrElems = CurrView.size(), CurrBeg = CurrView.levelBeg();
+				int isInvalid = 0;
+
+				#pragma omp parallel for reduction(|:isInvalid) if(NIndices >= MEXMEM_PARALLEL_THRESHOLD)
+				for (int64_t j = 0; j < NIndices; ++j) {
+					isInvalid |= (LevelIndices[j] >= NCurrElems);
+					LevelIndices[j] += CurrBeg;
+				}
+				if (isInvalid)
+					WriteException(FV_ExCodes::FV_INVALID_FETCH, "The indices exceed the number of elements (%llu)\n", (unsigned long long)NCurrElems);
+			}
+		}
+		else {
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "Only {} indexing followed by an optional final () indexing is allowed\n");
+		}
+	}
+
+	// After a final {} indexing, all the children are selected
+	if (IndexTypes[IndexingDepth - 1] == '{') {
+		LevelIndices.resize(CurrView.size());
+		for (size_t j = 0; j < CurrView.size(); ++j)
+			LevelIndices[j] = CurrView.levelBeg() + j;
+	}
+
+	uint32_t Level = CurrView.level();
+	FlatVectTree<T, mxAllocator, IndexT> FlatVectTreeOut;
+	FlatVectTreeIn.extract(FlatVectTreeOut, Level, LevelIndices);
+
+	if (Level == FlatVectTreeIn.depth()) {
+		MexVector<MexVector<IndexT> > PartitionIndex;
+		MexVector<T> Data;
+		FlatVectTreeOut.releaseMem(PartitionIndex, Data);
+		plhs[0] = assignmxArray(Data);
+	}
+	else {
+		plhs[0] = assignmxArray(FlatVectTreeOut);
+	}
+}
+
+//////////////////////////////////////////////////////////////////
+/////////////////////////// DISPATCH /////////////////////////////
+//////////////////////////////////////////////////////////////////
+
+template <typename T, typename IndexT>
+inline void runCommand(const char* Command, int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[], const CellArrayLevels *CellLevels) {
+	if (!std::strcmp(Command, "filter"))
+		filterCommand<T, IndexT>(nlhs, plhs, nrhs, prhs);
+	else if (!std::strcmp(Command, "extract"))
+		extractCommand<T, IndexT>(nlhs, plhs, nrhs, prhs);
+	else if (!std::strcmp(Command, "flatten"))
+		flattenCommand<T, IndexT>(nlhs, plhs, nrhs, prhs, CellLevels);
+	else if (!std::strcmp(Command, "unflatten"))
+		unflattenCommand<T, IndexT>(nlhs, plhs, nrhs, prhs);
+	else if (!std::strcmp(Command, "append"))
+		appendCommand<T, IndexT>(nlhs, plhs, nrhs, prhs);
+	else if (!std::strcmp(Command, "index"))
+		indexCommand<T, IndexT>(nlhs, plhs, nrhs, prhs);
+	else
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "Unknown command '%s'\n", Command);
+}
+
+template <typename IndexT>
+inline void dispatchDataClass(mxClassID DataClass, const char* Command, int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[], const CellArrayLevels *CellLevels) {
+	switch (DataClass) {
+		case mxDOUBLE_CLASS: runCommand<double  , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxSINGLE_CLASS: runCommand<float   , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxINT8_CLASS  : runCommand<int8_t  , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxUINT8_CLASS : runCommand<uint8_t , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxINT16_CLASS : runCommand<int16_t , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxUINT16_CLASS: runCommand<uint16_t, IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxINT32_CLASS : runCommand<int32_t , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxUINT32_CLASS: runCommand<uint32_t, IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxINT64_CLASS : runCommand<int64_t , IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxUINT64_CLASS: runCommand<uint64_t, IndexT>(Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		default:
+			WriteException(FCA_UNSUPPORTED_CLASS, "The class of Data (%d) is not supported\n", int(DataClass));
+	}
+}
+
+inline void dispatchCommand(mxClassID DataClass, mxClassID IndexClass, const char* Command, int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[], const CellArrayLevels *CellLevels = nullptr) {
+	switch (IndexClass) {
+		case mxUINT32_CLASS: dispatchDataClass<uint32_t>(DataClass, Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		case mxUINT64_CLASS: dispatchDataClass<uint64_t>(DataClass, Command, nlhs, plhs, nrhs, prhs, CellLevels); break;
+		default:
+			WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The partition indices must be uint32 or uint64\n");
+	}
+}
+
+inline void dispatchFlatten(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	// The classes are decided by the cell array (and ArrayType) instead of a
+	// FlatCellArray struct. The partition indices are uint64 only if the
+	// largest level does not fit in uint32.
+
+	checkNumArgs(nrhs, 4, "flatten");
+
+	CellArrayLevels CellLevels;
+	if (!getCellArrayLevels(prhs[FCA_STRUCT_ARG], CellLevels.LevelNodes, CellLevels.LeafClass))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The given input is not a cell array of uniform depth and type\n");
+
+	uint32_t CellArrayDepth = CellLevels.LevelNodes.size();
+	bool isUndecided = (CellLevels.LeafClass == mxUNKNOWN_CLASS);
+
+	mxClassID DataClass;
+	if (!mxIsEmpty(prhs[2]))
+		DataClass = getClassIDfromName(prhs[2]);
+	else
+		DataClass = isUndecided ? mxDOUBLE_CLASS : CellLevels.LeafClass;
+
+	uint32_t ActualDepth = getScalarfrommxArray(prhs[3], "ActualDepth");
+	if (ActualDepth > 0 && ActualDepth < CellArrayDepth)
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The Depth specified (%d) is smaller than the depth of the cell array (%d)\n", ActualDepth, CellArrayDepth);
+	CellLevels.Depth = (isUndecided && ActualDepth > 0) ? ActualDepth : CellArrayDepth;
+
+	mxClassID IndexClass = (getCellArrayMaxLevelSize(CellLevels.LevelNodes) > std::numeric_limits<uint32_t>::max()) ? mxUINT64_CLASS : mxUINT32_CLASS;
+
+	dispatchCommand(DataClass, IndexClass, "flatten", nlhs, plhs, nrhs, prhs, &CellLevels);
+
+	if (nlhs > 1)
+		plhs[1] = mxCreateDoubleScalar(CellArrayDepth);
+	if (nlhs > 2)
+		plhs[2] = mxCreateLogicalScalar(isUndecided);
+}
+
+inline void dispatchFlatCellArray(const char* Command, int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	// The classes of Data and of the partition indices are read from the
+	// given FlatCellArray struct. The partition indices of a FlatCellArray of
+	// depth 0 are taken to be uint32. For 'append', uint64 indices are used
+	// if either FlatCellArray has them or if the result may not fit in uint32.
+
+	if (nrhs <= FCA_STRUCT_ARG || !FieldInfo<FlatVectTree<double> >::isFlatCellArrayStruct(prhs[FCA_STRUCT_ARG]))
+		WriteException(ExOps::EXCEPTION_INVALID_INPUT, "The second argument must be a FlatCellArray struct (see FlatCellArray.Convert2Struct)\n");
+
+	const mxArray* PartitionIndexmxArr = mxGetField(prhs[FCA_STRUCT_ARG], 0, "PartitionIndex");
+	const mxArray* DatamxArr           = mxGetField(prhs[FCA_STRUCT_ARG], 0, "Data");
+
+	mxClassID IndexClass = mxUINT32_CLASS;
+	if (PartitionIndexmxArr != nullptr && mxIsCell(PartitionIndexmxArr) && mxGetNumberOfElements(PartitionIndexmxArr) > 0
+	    && mxGetCell(PartitionIndexmxArr, 0) != nullptr)
+		IndexClass = mxGetClassID(mxGetCell(PartitionIndexmxArr, 0));
+	mxClassID DataClass = (DatamxArr != nullptr) ? mxGetClassID(DatamxArr) : mxDOUBLE_CLASS;
+
+	if (!std::strcmp(Command, "append") && nrhs > 2 && FieldInfo<FlatVectTree<double> >::isFlatCellArrayStruct(prhs[2])) {
+		const mxArray* AppendPartitionIndexmxArr = mxGetField(prhs[2], 0, "PartitionIndex");
+		if (AppendPartitionIndexmxArr != nullptr && mxIsCell(AppendPartitionIndexmxArr) && mxGetNumberOfElements(AppendPartitionIndexmxArr) > 0
+		    && mxGetCell(AppendPartitionIndexmxArr, 0) != nullptr && mxGetClassID(mxGetCell(AppendPartitionIndexmxArr, 0)) == mxUINT64_CLASS)
+			IndexClass = mxUINT64_CLASS;
+		if (getFlatCellArrayMaxLevelSize(prhs[FCA_STRUCT_ARG]) + getFlatCellArrayMaxLevelSize(prhs[2]) > std::numeric_limits<uint32_t>::max())
+			IndexClass = mxUINT64_CLASS;
+	}
+
+	dispatchCommand(DataClass, IndexClass, Command, nlhs, plhs, nrhs, prhs);
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[]) {
+
+	if (nrhs < 1 || !mxIsChar(prhs[0]))
+		mexErrMsgIdAndTxt("FlatCellArray:InvalidInput", "The first argument must be the command string");
+
+	char Command[32];
+	mxGetString(prhs[0], Command, sizeof(Command));
+
+	// Exceptions must not cross the mex boundary. The error messages have
+	// already been printed by WriteException.
+	// An unsupported class is reported with a distinct identifier so that the
+	// MATLAB methods can fall back to their MATLAB implementation.
+	const char* ErrorID = nullptr;
+	try {
+		// Prints the allocation profile if built with MEXMEM_PROFILE_ALLOCATIONS
+		MexAllocProfileScope ProfileScope;
+
+		if (!std::strcmp(Command, "flatten"))
+			dispatchFlatten(nlhs, plhs, nrhs, prhs);
+		else
+			dispatchFlatCellArray(Command, nlhs, plhs, nrhs, prhs);
+	}
+	catch (ExOps::ExCodes ExCode) {
+		ErrorID = (ExCode == ExOps::EXCEPTION_INVALID_INPUT) ? "FlatCellArray:InvalidInput" : "FlatCellArray:MexError";
+	}
+	catch (FV_ExCodes) {
+		ErrorID = "FlatCellArray:MexError";
+	}
+	catch (FCA_ExCodes) {
+		ErrorID = "FlatCellArray:UnsupportedClass";
+	}
+
+	if (ErrorID != nullptr)
+		mexErrMsgIdAndTxt(ErrorID, "FlatCellArrayMex('%s', ...) failed (see message above)", Command);
+}
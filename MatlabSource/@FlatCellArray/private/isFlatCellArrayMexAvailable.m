@@ -0,0 +1,11 @@
+function isAvailable = isFlatCellArrayMexAvailable()
+%ISFLATCELLARRAYMEXAVAILABLE Returns true if the mex file FlatCellArrayMex
+%has been built (see buildFlatCellArrayMex). The result is cached.
+
+persistent isAvailableCached;
+if isempty(isAvailableCached)
+	isAvailableCached = (exist('FlatCellArrayMex', 'file') == 3);
+end
+isAvailable = isAvailableCached;
+
+end
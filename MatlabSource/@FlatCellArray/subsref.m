@@ -86,18 +86,47 @@ function varargout = subsref(obj, Inds)
 		throw(ME);
 	end
 	
-	% Calculate LevelIndices
-	LevelIndices = 1:length(obj.PartitionIndex{1})-1;
-	for i = 1:length(Inds)
-		if strcmp(Inds(i).type, '{}')
-			CurrentIndex = LevelIndices(Inds(i).subs{1});
-			LevelIndices = obj.PartitionIndex{i}(CurrentIndex)+1:obj.PartitionIndex{i}(CurrentIndex+1);
-		else
-			LevelIndices = LevelIndices(Inds(i).subs{1});
+	% Use the compiled kernel if available. The {} indexing is performed by
+	% navigating the tree without computing the intermediate LevelIndices.
+	% Classes of Data that it does not support (char, logical) are indexed
+	% by the code below.
+	isIndexed = false;
+	if isFlatCellArrayMexAvailable()
+		IndexTypes = arrayfun(@(x) x.type(1), Inds);
+		IndexSubs = arrayfun(@(x) x.subs{1}, Inds, 'UniformOutput', false);
+		try
+			SubStruct = FlatCellArrayMex('index', obj.Convert2Struct(), IndexTypes, IndexSubs);
+			isIndexed = true;
+		catch ME
+			if ~strcmp(ME.identifier, 'FlatCellArray:UnsupportedClass')
+				rethrow(ME);
+			end
+		end
+		if isIndexed
+			if Level == obj.Depth + 1
+				varargout{1} = SubStruct;
+			else
+				SubFlatCellArr = FlatCellArray();
+				SubFlatCellArr.PartitionIndex = SubStruct.PartitionIndex;
+				SubFlatCellArr.Data = SubStruct.Data;
+				varargout{1} = SubFlatCellArr;
+			end
 		end
 	end
-	
-	varargout{1} = obj.getSubFlatCellArr(Level, LevelIndices);
+	if ~isIndexed
+		% Calculate LevelIndices
+		LevelIndices = 1:length(obj.PartitionIndex{1})-1;
+		for i = 1:length(Inds)
+			if strcmp(Inds(i).type, '{}')
+				CurrentIndex = LevelIndices(Inds(i).subs{1});
+				LevelIndices = obj.PartitionIndex{i}(CurrentIndex)+1:obj.PartitionIndex{i}(CurrentIndex+1);
+			else
+				LevelIndices = LevelIndices(Inds(i).subs{1});
+			end
+		end
+		
+		varargout{1} = obj.getSubFlatCellArr(Level, LevelIndices);
+	end
 	
 	% Perform Default Indexing
 	if ~isempty(DefaultInds)
@@ -108,4 +137,3 @@ function varargout = subsref(obj, Inds)
 		end
 	end
 end
-
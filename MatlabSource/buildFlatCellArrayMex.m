@@ -0,0 +1,36 @@
+function buildFlatCellArrayMex()
+%BUILDFLATCELLARRAYMEX Compiles the mex file FlatCellArrayMex used by the
+%methods of FlatCellArray.
+%
+% Syntax:
+%
+%   buildFlatCellArrayMex()
+%
+% Notes:
+%
+%   The mex file is placed in @FlatCellArray/private. The methods of
+%   FlatCellArray that use it (FlattenCellArray, Convert2CellArray,
+%   Convert2CellArrayPartial, append, filter, getSubFlatCellArr and
+%   subsref) fall back to their MATLAB implementation if it has not been
+%   built or if the class of Data is not supported by it (char, logical).
+%   MATLAB must be restarted (or 'clear classes' executed) after the first
+%   build for the methods to detect it. OpenMP is enabled for gcc and
+%   Visual Studio.
+
+SourceDir  = fileparts(mfilename('fullpath'));
+PrivateDir = fullfile(SourceDir, '@FlatCellArray', 'private');
+HeaderDir  = fullfile(SourceDir, '..', 'Headers');
+
+if ispc
+	OpenMPFlags = {'COMPFLAGS=$COMPFLAGS /openmp'};
+else
+	OpenMPFlags = {'CXXFLAGS=$CXXFLAGS -std=c++11 -fopenmp', 'LDFLAGS=$LDFLAGS -fopenmp'};
+end
+
+mex('-largeArrayDims', '-DMEX_LIB', OpenMPFlags{:}, ...
+    ['-I' HeaderDir], ...
+    fullfile(PrivateDir, 'FlatCellArrayMex.cpp'), ...
+    fullfile(HeaderDir, 'MexMem.cpp'), ...
+    '-outdir', PrivateDir);
+
+end
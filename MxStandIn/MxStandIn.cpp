@@ -0,0 +1,636 @@
+// Implementation of the stand-in for libmx / libmex (see include/matrix.h).
+
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "mex.h"
+
+struct mxArray_tag {
+	mxClassID ClassID;
+	std::vector<mwSize> Dims;
+	void* Data;                            // mxArray** for cell and struct arrays
+	std::vector<std::string> FieldNames;   // only for struct arrays
+	size_t* ShareCount = nullptr;          // arrays sharing Data (nullptr if unshared)
+};
+
+/////////////////////////////////////////////////
+// HELPER FUNCTIONS         /////////////////////
+/////////////////////////////////////////////////
+
+static size_t getClassElemSize(mxClassID ClassID) {
+	switch (ClassID) {
+		case mxDOUBLE_CLASS  :
+		case mxINT64_CLASS   :
+		case mxUINT64_CLASS  : return 8;
+		case mxSINGLE_CLASS  :
+		case mxINT32_CLASS   :
+		case mxUINT32_CLASS  : return 4;
+		case mxINT16_CLASS   :
+		case mxUINT16_CLASS  : return 2;
+		case mxINT8_CLASS    :
+		case mxUINT8_CLASS   : return 1;
+		case mxLOGICAL_CLASS : return sizeof(mxLogical);
+		case mxCHAR_CLASS    : return sizeof(mxChar);
+		case mxCELL_CLASS    :
+		case mxSTRUCT_CLASS  : return sizeof(mxArray*);
+		default              : return 0;
+	}
+}
+
+static inline bool isContainerClass(mxClassID ClassID) {
+	return ClassID == mxCELL_CLASS || ClassID == mxSTRUCT_CLASS;
+}
+
+static size_t getNumElems(const mxArray* Array) {
+	size_t NElems = 1;
+	for (mwSize Dim : Array->Dims)
+		NElems *= Dim;
+	return NElems;
+}
+
+// Number of mxArray* slots (for cell and struct arrays) or of elements
+static size_t getNumSlots(const mxArray* Array) {
+	size_t NElems = getNumElems(Array);
+	return (Array->ClassID == mxSTRUCT_CLASS) ? NElems*Array->FieldNames.size() : NElems;
+}
+
+static mxArray* createArray(mxClassID ClassID, mwSize NDims, const mwSize* Dims, const char** FieldNames = nullptr, int NFields = 0) {
+
+	mxArray* Array = new mxArray_tag;
+	Array->ClassID = ClassID;
+	Array->Dims.assign(Dims, Dims + NDims);
+	// MATLAB arrays have at least 2 dimensions and no trailing singleton
+	// dimensions beyond the second
+	while (Array->Dims.size() < 2)
+		Array->Dims.push_back(1);
+	while (Array->Dims.size() > 2 && Array->Dims.back() == 1)
+		Array->Dims.pop_back();
+	for (int i = 0; i < NFields; ++i)
+		Array->FieldNames.push_back(FieldNames[i]);
+
+	size_t NSlots = getNumSlots(Array);
+	Array->Data = (NSlots > 0) ? mxCalloc(NSlots, getClassElemSize(ClassID)) : nullptr;
+	return Array;
+}
+
+static mxArray** getSlots(const mxArray* Array) {
+	return reinterpret_cast<mxArray**>(Array->Data);
+}
+
+/////////////////////////////////////////////////
+// MEMORY ALLOCATION        /////////////////////
+/////////////////////////////////////////////////
+
+// MATLAB's mxRealloc does not (in general) grow blocks in place. Defining
+// MX_STANDIN_COPYING_REALLOC makes mxRealloc always allocate a new block and
+// copy, which reproduces the cost of growing MexVectors under MATLAB. The
+// size of each block is then stored in a header preceding it.
+
+#ifdef MX_STANDIN_COPYING_REALLOC
+
+static const size_t BlockHeaderSize = 16;
+
+void* mxMalloc(size_t Size) {
+	char* Block = static_cast<char*>(std::malloc(Size + BlockHeaderSize));
+	if (Block == nullptr)
+		return nullptr;
+	*reinterpret_cast<size_t*>(Block) = Size;
+	return Block + BlockHeaderSize;
+}
+
+void mxFree(void* Pointer) {
+	if (Pointer != nullptr)
+		std::free(static_cast<char*>(Pointer) - BlockHeaderSize);
+}
+
+void* mxRealloc(void* Pointer, size_t Size) {
+	void* NewPointer = mxMalloc(Size);
+	if (NewPointer != nullptr && Pointer != nullptr) {
+		size_t OldSize = *reinterpret_cast<size_t*>(static_cast<char*>(Pointer) - BlockHeaderSize);
+		std::memcpy(NewPointer, Pointer, (OldSize < Size) ? OldSize : Size);
+		mxFree(Pointer);
+	}
+	return NewPointer;
+}
+
+#else
+
+void* mxMalloc(size_t Size) {
+	return std::malloc(Size > 0 ? Size : 1);
+}
+
+void mxFree(void* Pointer) {
+	std::free(Pointer);
+}
+
+void* mxRealloc(void* Pointer, size_t Size) {
+	return std::realloc(Pointer, Size > 0 ? Size : 1);
+}
+
+#endif
+
+void* mxCalloc(size_t NElems, size_t ElemSize) {
+	size_t Size = NElems*ElemSize;
+	void* Pointer = mxMalloc(Size);
+	if (Pointer != nullptr)
+		std::memset(Pointer, 0, Size);
+	return Pointer;
+}
+
+/////////////////////////////////////////////////
+// CREATION AND DESTRUCTION /////////////////////
+/////////////////////////////////////////////////
+
+mxArray* mxCreateNumericMatrix_730(mwSize M, mwSize N, mxClassID ClassID, mxComplexity Complexity) {
+	mwSize Dims[2] = { M, N };
+	return mxCreateNumericArray_730(2, Dims, ClassID, Complexity);
+}
+
+mxArray* mxCreateNumericArray_730(mwSize NDims, const mwSize* Dims, mxClassID ClassID, mxComplexity Complexity) {
+	if (Complexity != mxREAL)
+		mexErrMsgIdAndTxt("MxStandIn:Unsupported", "Complex arrays are not supported by the mx stand-in");
+	if (!(ClassID >= mxDOUBLE_CLASS && ClassID <= mxUINT64_CLASS) && ClassID != mxLOGICAL_CLASS && ClassID != mxCHAR_CLASS)
+		mexErrMsgIdAndTxt("MxStandIn:InvalidClass", "mxCreateNumericArray called with a non-numeric class");
+	return createArray(ClassID, NDims, Dims);
+}
+
+mxArray* mxCreateLogicalMatrix_730(mwSize M, mwSize N) {
+	mwSize Dims[2] = { M, N };
+	return createArray(mxLOGICAL_CLASS, 2, Dims);
+}
+
+mxArray* mxCreateCellMatrix_730(mwSize M, mwSize N) {
+	mwSize Dims[2] = { M, N };
+	return createArray(mxCELL_CLASS, 2, Dims);
+}
+
+mxArray* mxCreateCellArray_730(mwSize NDims, const mwSize* Dims) {
+	return createArray(mxCELL_CLASS, NDims, Dims);
+}
+
+mxArray* mxCreateStructMatrix_730(mwSize M, mwSize N, int NFields, const char** FieldNames) {
+	mwSize Dims[2] = { M, N };
+	return createArray(mxSTRUCT_CLASS, 2, Dims, FieldNames, NFields);
+}
+
+mxArray* mxCreateStructArray_730(mwSize NDims, const mwSize* Dims, int NFields, const char** FieldNames) {
+	return createArray(mxSTRUCT_CLASS, NDims, Dims, FieldNames, NFields);
+}
+
+mxArray* mxCreateDoubleMatrix_730(mwSize M, mwSize N, mxComplexity Complexity) {
+	return mxCreateNumericMatrix_730(M, N, mxDOUBLE_CLASS, Complexity);
+}
+
+mxArray* mxCreateDoubleScalar(double Value) {
+	mxArray* Array = mxCreateNumericMatrix_730(1, 1, mxDOUBLE_CLASS, mxREAL);
+	*static_cast<double*>(Array->Data) = Value;
+	return Array;
+}
+
+mxArray* mxCreateLogicalScalar(mxLogical Value) {
+	mxArray* Array = mxCreateLogicalMatrix_730(1, 1);
+	*static_cast<mxLogical*>(Array->Data) = Value;
+	return Array;
+}
+
+mxArray* mxCreateString(const char* String) {
+	// As in MATLAB, the empty string is a 0x0 char array
+	size_t Length = std::strlen(String);
+	mwSize Dims[2] = { (Length > 0) ? mwSize(1) : mwSize(0), Length };
+	mxArray* Array = createArray(mxCHAR_CLASS, 2, Dims);
+	mxChar* Chars = static_cast<mxChar*>(Array->Data);
+	for (size_t i = 0; i < Length; ++i)
+		Chars[i] = mxChar(static_cast<unsigned char>(String[i]));
+	return Array;
+}
+
+mxArray* mxDuplicateArray(const mxArray* Array) {
+	if (Array == nullptr)
+		return nullptr;
+
+	mxArray* Duplicate = new mxArray_tag(*Array);
+	Duplicate->ShareCount = nullptr;
+	size_t NSlots = getNumSlots(Array);
+	size_t SlotSize = getClassElemSize(Array->ClassID);
+	Duplicate->Data = (NSlots > 0 && Array->Data != nullptr) ? mxMalloc(NSlots*SlotSize) : nullptr;
+
+	if (Duplicate->Data == nullptr)
+		return Duplicate;
+	if (isContainerClass(Array->ClassID)) {
+		for (size_t i = 0; i < NSlots; ++i)
+			getSlots(Duplicate)[i] = mxDuplicateArray(getSlots(Array)[i]);
+	}
+	else {
+		std::memcpy(Duplicate->Data, Array->Data, NSlots*SlotSize);
+	}
+	return Duplicate;
+}
+
+// Removes Array from the arrays sharing its data. Returns true if the data
+// is still referenced by another array.
+static bool detachSharedData(mxArray* Array) {
+	if (Array->ShareCount == nullptr)
+		return false;
+	bool isStillShared = --(*Array->ShareCount) > 0;
+	if (!isStillShared)
+		delete Array->ShareCount;
+	Array->ShareCount = nullptr;
+	return isStillShared;
+}
+
+void mxDestroyArray(mxArray* Array) {
+	if (Array == nullptr)
+		return;
+	if (detachSharedData(Array)) {
+		delete Array;
+		return;
+	}
+	if (isContainerClass(Array->ClassID) && Array->Data != nullptr) {
+		size_t NSlots = getNumSlots(Array);
+		for (size_t i = 0; i < NSlots; ++i)
+			mxDestroyArray(getSlots(Array)[i]);
+	}
+	mxFree(Array->Data);
+	delete Array;
+}
+
+/////////////////////////////////////////////////
+// DATA SHARING             /////////////////////
+/////////////////////////////////////////////////
+
+mxArray* mxCreateSharedDataCopy(const mxArray* Array) {
+	if (Array == nullptr)
+		return nullptr;
+	// Cell and struct arrays are duplicated (MATLAB shares their elements
+	// instead, which the stand-in does not model)
+	if (isContainerClass(Array->ClassID) || Array->Data == nullptr)
+		return mxDuplicateArray(Array);
+
+	mxArray* SharedCopy = new mxArray_tag(*Array);
+	if (Array->ShareCount == nullptr)
+		const_cast<mxArray*>(Array)->ShareCount = new size_t(1);
+	SharedCopy->ShareCount = Array->ShareCount;
+	++(*SharedCopy->ShareCount);
+	return SharedCopy;
+}
+
+bool mxUnshareArray(mxArray* Array, bool) {
+	if (!mxIsSharedArray(Array))
+		return false;
+	size_t DataSize = getNumSlots(Array)*getClassElemSize(Array->ClassID);
+	void* Data = mxMalloc(DataSize);
+	std::memcpy(Data, Array->Data, DataSize);
+	detachSharedData(Array);
+	Array->Data = Data;
+	return true;
+}
+
+bool mxIsSharedArray(const mxArray* Array) {
+	return Array != nullptr && Array->ShareCount != nullptr && *Array->ShareCount > 1;
+}
+
+/////////////////////////////////////////////////
+// CLASS AND TYPE QUERIES   /////////////////////
+/////////////////////////////////////////////////
+
+mxClassID mxGetClassID(const mxArray* Array) {
+	return Array->ClassID;
+}
+
+const char* mxGetClassName(const mxArray* Array) {
+	static const char* ClassNames[] = {
+		"unknown", "cell", "struct", "logical", "char", "void", "double", "single",
+		"int8", "uint8", "int16", "uint16", "int32", "uint32", "int64", "uint64",
+		"function_handle", "opaque", "object"
+	};
+	return ClassNames[Array->ClassID];
+}
+
+size_t mxGetElementSize(const mxArray* Array) {
+	return getClassElemSize(Array->ClassID);
+}
+
+bool mxIsNumeric(const mxArray* Array) {
+	return Array->ClassID >= mxDOUBLE_CLASS && Array->ClassID <= mxUINT64_CLASS;
+}
+
+bool mxIsLogical(const mxArray* Array) { return Array->ClassID == mxLOGICAL_CLASS; }
+bool mxIsChar(const mxArray* Array)    { return Array->ClassID == mxCHAR_CLASS; }
+bool mxIsCell(const mxArray* Array)    { return Array->ClassID == mxCELL_CLASS; }
+bool mxIsStruct(const mxArray* Array)  { return Array->ClassID == mxSTRUCT_CLASS; }
+bool mxIsDouble(const mxArray* Array)  { return Array->ClassID == mxDOUBLE_CLASS; }
+bool mxIsComplex(const mxArray*)       { return false; }
+bool mxIsSparse(const mxArray*)        { return false; }
+
+bool mxIsEmpty(const mxArray* Array) {
+	return getNumElems(Array) == 0;
+}
+
+/////////////////////////////////////////////////
+// DIMENSIONS               /////////////////////
+/////////////////////////////////////////////////
+
+size_t mxGetM(const mxArray* Array) {
+	return Array->Dims[0];
+}
+
+size_t mxGetN(const mxArray* Array) {
+	// The product of all dimensions but the first, as in MATLAB
+	size_t N = 1;
+	for (size_t i = 1; i < Array->Dims.size(); ++i)
+		N *= Array->Dims[i];
+	return N;
+}
+
+void mxSetM_730(mxArray* Array, mwSize M) {
+	Array->Dims[0] = M;
+}
+
+void mxSetN_730(mxArray* Array, mwSize N) {
+	Array->Dims.resize(2);
+	Array->Dims[1] = N;
+}
+
+mwSize mxGetNumberOfDimensions_730(const mxArray* Array) {
+	return Array->Dims.size();
+}
+
+const mwSize* mxGetDimensions_730(const mxArray* Array) {
+	return Array->Dims.data();
+}
+
+size_t mxGetNumberOfElements(const mxArray* Array) {
+	return getNumElems(Array);
+}
+
+/////////////////////////////////////////////////
+// DATA ACCESS              /////////////////////
+/////////////////////////////////////////////////
+
+void* mxGetData(const mxArray* Array) {
+	return Array->Data;
+}
+
+void mxSetData(mxArray* Array, void* Data) {
+	// As in MATLAB, the previous data is not freed (the other arrays sharing
+	// it keep it)
+	detachSharedData(Array);
+	Array->Data = Data;
+}
+
+double* mxGetPr(const mxArray* Array) {
+	return (Array->ClassID == mxDOUBLE_CLASS) ? static_cast<double*>(Array->Data) : nullptr;
+}
+
+mxLogical* mxGetLogicals(const mxArray* Array) {
+	return (Array->ClassID == mxLOGICAL_CLASS) ? static_cast<mxLogical*>(Array->Data) : nullptr;
+}
+
+mxChar* mxGetChars(const mxArray* Array) {
+	return (Array->ClassID == mxCHAR_CLASS) ? static_cast<mxChar*>(Array->Data) : nullptr;
+}
+
+double mxGetScalar(const mxArray* Array) {
+
+	// Returns the first element converted to double (0 if empty)
+
+	if (Array->Data == nullptr || getNumElems(Array) == 0)
+		return 0.0;
+
+	const void* Data = Array->Data;
+	switch (Array->ClassID) {
+		case mxDOUBLE_CLASS  : return *static_cast<const double   *>(Data);
+		case mxSINGLE_CLASS  : return *static_cast<const float    *>(Data);
+		case mxINT8_CLASS    : return *static_cast<const int8_t   *>(Data);
+		case mxUINT8_CLASS   : return *static_cast<const uint8_t  *>(Data);
+		case mxINT16_CLASS   : return *static_cast<const int16_t  *>(Data);
+		case mxUINT16_CLASS  : return *static_cast<const uint16_t *>(Data);
+		case mxINT32_CLASS   : return *static_cast<const int32_t  *>(Data);
+		case mxUINT32_CLASS  : return *static_cast<const uint32_t *>(Data);
+		case mxINT64_CLASS   : return double(*static_cast<const int64_t  *>(Data));
+		case mxUINT64_CLASS  : return double(*static_cast<const uint64_t *>(Data));
+		case mxLOGICAL_CLASS : return *static_cast<const mxLogical*>(Data) ? 1.0 : 0.0;
+		case mxCHAR_CLASS    : return *static_cast<const mxChar   *>(Data);
+		default              : return 0.0;
+	}
+}
+
+/////////////////////////////////////////////////
+// STRINGS                  /////////////////////
+/////////////////////////////////////////////////
+
+char* mxArrayToString(const mxArray* Array) {
+
+	// The returned string is allocated by mxMalloc and is to be freed by
+	// mxFree. Characters beyond ASCII are not converted.
+
+	if (Array->ClassID != mxCHAR_CLASS)
+		return nullptr;
+
+	size_t Length = getNumElems(Array);
+	char* String = static_cast<char*>(mxMalloc(Length + 1));
+	const mxChar* Chars = static_cast<const mxChar*>(Array->Data);
+	for (size_t i = 0; i < Length; ++i)
+		String[i] = char(Chars[i]);
+	String[Length] = 0;
+	return String;
+}
+
+int mxGetString_730(const mxArray* Array, char* Buffer, mwSize BufferLen) {
+
+	// Returns 0 on success and 1 if Array is not a char array or if the
+	// string was truncated to fit into Buffer
+
+	if (BufferLen == 0)
+		return 1;
+	if (Array->ClassID != mxCHAR_CLASS) {
+		Buffer[0] = 0;
+		return 1;
+	}
+
+	size_t Length = getNumElems(Array);
+	size_t NCopied = (Length < BufferLen - 1) ? Length : BufferLen - 1;
+	const mxChar* Chars = static_cast<const mxChar*>(Array->Data);
+	for (size_t i = 0; i < NCopied; ++i)
+		Buffer[i] = char(Chars[i]);
+	Buffer[NCopied] = 0;
+	return (NCopied < Length) ? 1 : 0;
+}
+
+/////////////////////////////////////////////////
+// CELL ARRAYS              /////////////////////
+/////////////////////////////////////////////////
+
+mxArray* mxGetCell_730(const mxArray* Array, mwIndex Index) {
+	if (Array->ClassID != mxCELL_CLASS || Index >= getNumElems(Array))
+		return nullptr;
+	return getSlots(Array)[Index];
+}
+
+void mxSetCell_730(mxArray* Array, mwIndex Index, mxArray* Value) {
+	if (Array->ClassID != mxCELL_CLASS || Index >= getNumElems(Array))
+		mexErrMsgIdAndTxt("MxStandIn:InvalidIndex", "mxSetCell called with an invalid array or index");
+	getSlots(Array)[Index] = Value;
+}
+
+/////////////////////////////////////////////////
+// STRUCT ARRAYS            /////////////////////
+/////////////////////////////////////////////////
+
+int mxGetNumberOfFields(const mxArray* Array) {
+	return (Array->ClassID == mxSTRUCT_CLASS) ? int(Array->FieldNames.size()) : 0;
+}
+
+const char* mxGetFieldNameByNumber(const mxArray* Array, int FieldNumber) {
+	if (Array->ClassID != mxSTRUCT_CLASS || FieldNumber < 0 || size_t(FieldNumber) >= Array->FieldNames.size())
+		return nullptr;
+	return Array->FieldNames[FieldNumber].c_str();
+}
+
+int mxGetFieldNumber(const mxArray* Array, const char* FieldName) {
+	if (Array->ClassID != mxSTRUCT_CLASS)
+		return -1;
+	for (size_t i = 0; i < Array->FieldNames.size(); ++i) {
+		if (Array->FieldNames[i] == FieldName)
+			return int(i);
+	}
+	return -1;
+}
+
+int mxAddField(mxArray* Array, const char* FieldName) {
+
+	// Returns the number of the new field (or of the existing field of the
+	// same name). The slots of each element are reallocated as in MATLAB.
+
+	if (Array->ClassID != mxSTRUCT_CLASS)
+		return -1;
+	int ExistingField = mxGetFieldNumber(Array, FieldName);
+	if (ExistingField >= 0)
+		return ExistingField;
+
+	size_t NElems = getNumElems(Array);
+	size_t NFields = Array->FieldNames.size();
+	mxArray** NewSlots = static_cast<mxArray**>(mxCalloc(NElems*(NFields + 1), sizeof(mxArray*)));
+	for (size_t e = 0; e < NElems; ++e) {
+		for (size_t f = 0; f < NFields; ++f)
+			NewSlots[e*(NFields + 1) + f] = getSlots(Array)[e*NFields + f];
+	}
+	mxFree(Array->Data);
+	Array->Data = NewSlots;
+	Array->FieldNames.push_back(FieldName);
+	return int(NFields);
+}
+
+mxArray* mxGetFieldByNumber_730(const mxArray* Array, mwIndex Index, int FieldNumber) {
+	if (Array->ClassID != mxSTRUCT_CLASS || Index >= getNumElems(Array)
+		|| FieldNumber < 0 || size_t(FieldNumber) >= Array->FieldNames.size())
+		return nullptr;
+	return getSlots(Array)[Index*Array->FieldNames.size() + FieldNumber];
+}
+
+void mxSetFieldByNumber_730(mxArray* Array, mwIndex Index, int FieldNumber, mxArray* Value) {
+	if (Array->ClassID != mxSTRUCT_CLASS || Index >= getNumElems(Array)
+		|| FieldNumber < 0 || size_t(FieldNumber) >= Array->FieldNames.size())
+		mexErrMsgIdAndTxt("MxStandIn:InvalidIndex", "mxSetFieldByNumber called with an invalid array, index or field");
+	getSlots(Array)[Index*Array->FieldNames.size() + FieldNumber] = Value;
+}
+
+mxArray* mxGetField_730(const mxArray* Array, mwIndex Index, const char* FieldName) {
+	return mxGetFieldByNumber_730(Array, Index, mxGetFieldNumber(Array, FieldName));
+}
+
+void mxSetField_730(mxArray* Array, mwIndex Index, const char* FieldName, mxArray* Value) {
+	int FieldNumber = mxGetFieldNumber(Array, FieldName);
+	if (FieldNumber < 0)
+		mexErrMsgIdAndTxt("MxStandIn:InvalidField", "mxSetField called with the nonexistent field '%s'", FieldName);
+	mxSetFieldByNumber_730(Array, Index, FieldNumber, Value);
+}
+
+/////////////////////////////////////////////////
+// MEX FUNCTIONS            /////////////////////
+/////////////////////////////////////////////////
+
+int mexPrintf(const char* Format, ...) {
+	std::va_list Args;
+	va_start(Args, Format);
+	int NChars = std::vprintf(Format, Args);
+	va_end(Args);
+	return NChars;
+}
+
+int mexEvalString(const char*) {
+	// There is no interpreter, only drawnow() etc. are expected here
+	std::fflush(stdout);
+	return 0;
+}
+
+void mexErrMsgTxt(const char* Message) {
+	throw std::runtime_error(Message);
+}
+
+void mexErrMsgIdAndTxt(const char* Identifier, const char* Format, ...) {
+	char Message[1024];
+	std::va_list Args;
+	va_start(Args, Format);
+	std::vsnprintf(Message, sizeof(Message), Format, Args);
+	va_end(Args);
+	throw std::runtime_error(std::string(Identifier) + ": " + Message);
+}
+
+void mexWarnMsgTxt(const char* Message) {
+	std::fprintf(stderr, "Warning: %s\n", Message);
+}
+
+void mexWarnMsgIdAndTxt(const char* Identifier, const char* Format, ...) {
+	std::fprintf(stderr, "Warning (%s): ", Identifier);
+	std::va_list Args;
+	va_start(Args, Format);
+	std::vfprintf(stderr, Format, Args);
+	va_end(Args);
+	std::fprintf(stderr, "\n");
+}
+
+static bool isMexLocked = false;
+
+void mexMakeMemoryPersistent(void*) {}
+void mexMakeArrayPersistent(mxArray*) {}
+int  mexAtExit(void (*ExitFunction)(void)) { return std::atexit(ExitFunction); }
+void mexLock(void)      { isMexLocked = true; }
+void mexUnlock(void)    { isMexLocked = false; }
+bool mexIsLocked(void)  { return isMexLocked; }
+
+/////////////////////////////////////////////////
+// INTERRUPT FUNCTIONS      /////////////////////
+/////////////////////////////////////////////////
+
+// While enabled, Ctrl-C (SIGINT) sets the pending flag instead of
+// terminating the program, as in MATLAB.
+
+static std::atomic<bool> isInterruptPending(false);
+static std::atomic<bool> isInterruptEnabled(false);
+
+static void StandInInterruptHandler(int) {
+	isInterruptPending = true;
+}
+
+bool utIsInterruptPending(void) {
+	return isInterruptPending;
+}
+
+bool utSetInterruptPending(bool Pending) {
+	return isInterruptPending.exchange(Pending);
+}
+
+bool utSetInterruptEnabled(bool Enabled) {
+	bool WasEnabled = isInterruptEnabled.exchange(Enabled);
+	std::signal(SIGINT, Enabled ? StandInInterruptHandler : SIG_DFL);
+	return WasEnabled;
+}
@@ -0,0 +1,177 @@
+#ifndef MX_STANDIN_MATRIX_H
+#define MX_STANDIN_MATRIX_H
+
+// Stand-in for the matrix.h of MATLAB (libmx). This declares the subset of
+// the MATLAB C API used by MexMemoryInterfacing so that the MEX_EXE (and
+// MEX_LIB) code can be compiled, run and profiled on machines without a
+// MATLAB installation. It is selected at build time (see the option
+// MEXMEM_USE_MX_STANDIN in CMakeLists.txt) and must never be mixed with the
+// real libmx.
+//
+// The types and the mxClassID values match those of MATLAB with
+// -largeArrayDims (the default since R2018a), and the *_730 functions are
+// the ones the unsuffixed names map to in MATLAB. The semantics follow the
+// MATLAB documentation:
+//
+//   - The data of numeric, logical and char arrays (and the element arrays
+//     of cell and struct arrays) is allocated by mxMalloc / mxCalloc and may
+//     be replaced by mxSetData with memory allocated by the mxMalloc family.
+//   - mxDestroyArray frees an array along with its data and (recursively)
+//     the cells / fields it contains. mxSetCell and mxSetField do not free
+//     the array they replace.
+//   - Dimensions are column-major and at least 2. mxSetM and mxSetN do not
+//     reallocate the data.
+//
+// The undocumented (but exported by libmx) functions mxCreateSharedDataCopy,
+// mxUnshareArray and mxIsSharedArray are provided for numeric, logical and
+// char arrays: arrays sharing data keep a common reference count, and the
+// data is freed along with the last of them. As in MATLAB, the data of a
+// shared array must not be modified before it is unshared.
+//
+// Unlike MATLAB, the memory is not freed automatically at the end of a MEX
+// call (mexMakeMemoryPersistent is a no-op), and errors raised by
+// mexErrMsgTxt / mexErrMsgIdAndTxt are thrown as std::runtime_error.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef size_t mwSize;
+typedef size_t mwIndex;
+typedef ptrdiff_t mwSignedIndex;
+
+typedef bool mxLogical;
+typedef char16_t mxChar;
+
+typedef enum {
+	mxUNKNOWN_CLASS = 0,
+	mxCELL_CLASS,
+	mxSTRUCT_CLASS,
+	mxLOGICAL_CLASS,
+	mxCHAR_CLASS,
+	mxVOID_CLASS,
+	mxDOUBLE_CLASS,
+	mxSINGLE_CLASS,
+	mxINT8_CLASS,
+	mxUINT8_CLASS,
+	mxINT16_CLASS,
+	mxUINT16_CLASS,
+	mxINT32_CLASS,
+	mxUINT32_CLASS,
+	mxINT64_CLASS,
+	mxUINT64_CLASS,
+	mxFUNCTION_CLASS,
+	mxOPAQUE_CLASS,
+	mxOBJECT_CLASS
+} mxClassID;
+
+typedef enum {
+	mxREAL = 0,
+	mxCOMPLEX
+} mxComplexity;
+
+typedef struct mxArray_tag mxArray;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Memory Allocation
+void* mxMalloc(size_t Size);
+void* mxCalloc(size_t NElems, size_t ElemSize);
+void* mxRealloc(void* Pointer, size_t Size);
+void  mxFree(void* Pointer);
+
+// Creation and Destruction
+mxArray* mxCreateNumericMatrix_730(mwSize M, mwSize N, mxClassID ClassID, mxComplexity Complexity);
+mxArray* mxCreateNumericArray_730(mwSize NDims, const mwSize* Dims, mxClassID ClassID, mxComplexity Complexity);
+mxArray* mxCreateLogicalMatrix_730(mwSize M, mwSize N);
+mxArray* mxCreateCellMatrix_730(mwSize M, mwSize N);
+mxArray* mxCreateCellArray_730(mwSize NDims, const mwSize* Dims);
+mxArray* mxCreateStructMatrix_730(mwSize M, mwSize N, int NFields, const char** FieldNames);
+mxArray* mxCreateStructArray_730(mwSize NDims, const mwSize* Dims, int NFields, const char** FieldNames);
+mxArray* mxCreateDoubleMatrix_730(mwSize M, mwSize N, mxComplexity Complexity);
+mxArray* mxCreateDoubleScalar(double Value);
+mxArray* mxCreateLogicalScalar(mxLogical Value);
+mxArray* mxCreateString(const char* String);
+mxArray* mxDuplicateArray(const mxArray* Array);
+void     mxDestroyArray(mxArray* Array);
+
+// Data Sharing (undocumented in MATLAB)
+mxArray* mxCreateSharedDataCopy(const mxArray* Array);
+bool     mxUnshareArray(mxArray* Array, bool NoDeepCopy);
+bool     mxIsSharedArray(const mxArray* Array);
+
+// Class and Type Queries
+mxClassID   mxGetClassID(const mxArray* Array);
+const char* mxGetClassName(const mxArray* Array);
+size_t      mxGetElementSize(const mxArray* Array);
+bool mxIsNumeric(const mxArray* Array);
+bool mxIsLogical(const mxArray* Array);
+bool mxIsChar(const mxArray* Array);
+bool mxIsCell(const mxArray* Array);
+bool mxIsStruct(const mxArray* Array);
+bool mxIsComplex(const mxArray* Array);
+bool mxIsSparse(const mxArray* Array);
+bool mxIsDouble(const mxArray* Array);
+bool mxIsEmpty(const mxArray* Array);
+
+// Dimensions
+size_t        mxGetM(const mxArray* Array);
+size_t        mxGetN(const mxArray* Array);
+void          mxSetM_730(mxArray* Array, mwSize M);
+void          mxSetN_730(mxArray* Array, mwSize N);
+mwSize        mxGetNumberOfDimensions_730(const mxArray* Array);
+const mwSize* mxGetDimensions_730(const mxArray* Array);
+size_t        mxGetNumberOfElements(const mxArray* Array);
+
+// Data Access
+void*      mxGetData(const mxArray* Array);
+void       mxSetData(mxArray* Array, void* Data);
+double*    mxGetPr(const mxArray* Array);
+mxLogical* mxGetLogicals(const mxArray* Array);
+mxChar*    mxGetChars(const mxArray* Array);
+double     mxGetScalar(const mxArray* Array);
+
+// Strings
+char* mxArrayToString(const mxArray* Array);
+int   mxGetString_730(const mxArray* Array, char* Buffer, mwSize BufferLen);
+
+// Cell Arrays
+mxArray* mxGetCell_730(const mxArray* Array, mwIndex Index);
+void     mxSetCell_730(mxArray* Array, mwIndex Index, mxArray* Value);
+
+// Struct Arrays
+int         mxGetNumberOfFields(const mxArray* Array);
+const char* mxGetFieldNameByNumber(const mxArray* Array, int FieldNumber);
+int         mxGetFieldNumber(const mxArray* Array, const char* FieldName);
+int         mxAddField(mxArray* Array, const char* FieldName);
+mxArray*    mxGetField_730(const mxArray* Array, mwIndex Index, const char* FieldName);
+void        mxSetField_730(mxArray* Array, mwIndex Index, const char* FieldName, mxArray* Value);
+mxArray*    mxGetFieldByNumber_730(const mxArray* Array, mwIndex Index, int FieldNumber);
+void        mxSetFieldByNumber_730(mxArray* Array, mwIndex Index, int FieldNumber, mxArray* Value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define mxCreateNumericMatrix   mxCreateNumericMatrix_730
+#define mxCreateNumericArray    mxCreateNumericArray_730
+#define mxCreateLogicalMatrix   mxCreateLogicalMatrix_730
+#define mxCreateCellMatrix      mxCreateCellMatrix_730
+#define mxCreateCellArray       mxCreateCellArray_730
+#define mxCreateStructMatrix    mxCreateStructMatrix_730
+#define mxCreateStructArray     mxCreateStructArray_730
+#define mxCreateDoubleMatrix    mxCreateDoubleMatrix_730
+#define mxSetM                  mxSetM_730
+#define mxSetN                  mxSetN_730
+#define mxGetNumberOfDimensions mxGetNumberOfDimensions_730
+#define mxGetDimensions         mxGetDimensions_730
+#define mxGetString             mxGetString_730
+#define mxGetCell               mxGetCell_730
+#define mxSetCell               mxSetCell_730
+#define mxGetField              mxGetField_730
+#define mxSetField              mxSetField_730
+#define mxGetFieldByNumber      mxGetFieldByNumber_730
+#define mxSetFieldByNumber      mxSetFieldByNumber_730
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MX_STANDIN_MEX_H
+#define MX_STANDIN_MEX_H
+
+// Stand-in for the mex.h of MATLAB (libmex). See matrix.h.
+
+#include "matrix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Entry point of a MEX file (defined by the MEX file, not by the stand-in)
+void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[]);
+
+int  mexPrintf(const char* Format, ...);
+int  mexEvalString(const char* Command);
+void mexErrMsgTxt(const char* Message);
+void mexErrMsgIdAndTxt(const char* Identifier, const char* Format, ...);
+void mexWarnMsgTxt(const char* Message);
+void mexWarnMsgIdAndTxt(const char* Identifier, const char* Format, ...);
+
+void mexMakeMemoryPersistent(void* Pointer);
+void mexMakeArrayPersistent(mxArray* Array);
+int  mexAtExit(void (*ExitFunction)(void));
+void mexLock(void);
+void mexUnlock(void);
+bool mexIsLocked(void);
+
+// Undocumented interrupt functions of libut (used by InterruptHandling.cpp)
+bool utIsInterruptPending(void);
+bool utSetInterruptPending(bool Pending);
+bool utSetInterruptEnabled(bool Enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
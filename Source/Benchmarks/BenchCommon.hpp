@@ -0,0 +1,48 @@
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+// Timing helpers, seed and sink shared by the benchmarks in
+// Source/Benchmarks.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Seed of the random generators of every benchmark (written to the JSON
+// output of Bench_Suite), so that all of them run on reproducible inputs
+static const uint32_t BenchSeed = 20151102;
+
+// Results are accumulated into this to keep the compiler from discarding
+// the benchmarked code
+static volatile double Sink = 0;
+
+struct BenchTimes {
+	double MinTime;     // in ms
+	double MedianTime;  // in ms
+};
+
+// Runs F NRepeats times (after one untimed run if WarmUp is set) and
+// returns the minimum and median time of the runs
+template <typename Func>
+inline BenchTimes TimeRuns(Func F, int NRepeats, bool WarmUp = false) {
+	std::vector<double> Times;
+	if (WarmUp)
+		F();
+	for (int i = 0; i < NRepeats; ++i) {
+		auto Start = std::chrono::high_resolution_clock::now();
+		F();
+		auto End = std::chrono::high_resolution_clock::now();
+		Times.push_back(std::chrono::duration<double, std::milli>(End - Start).count());
+	}
+	std::sort(Times.begin(), Times.end());
+	return BenchTimes{ Times[0], Times[NRepeats / 2] };
+}
+
+// Minimum time (in ms) of NRepeats runs of F
+template <typename Func>
+inline double TimeIt(Func F, int NRepeats = 5) {
+	return TimeRuns(F, NRepeats).MinTime;
+}
+
+#endif
@@ -0,0 +1,62 @@
+// Benchmark for appending many small trees to a FlatVectTree.
+//
+// Compares calling FlatVectTree::append once per tree with a single call to
+// FlatVectTree::append_batch, for trees given both as nested MexVectors and
+// as FlatVectTrees. Each tree has 20 leaves of 200 elements (5000 trees).
+//
+// The gain of append_batch comes from avoiding the repeated reallocation of
+// the levels and of Data. It is therefore small when the allocator can grow
+// blocks in place (e.g. realloc on Linux for large blocks) and large when
+// each reallocation copies the array (e.g. mxRealloc).
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+typedef MexVector<MexVector<double> > VectTreeType;
+
+int main() {
+
+	const uint32_t NTrees = 5000, NLeaves = 20, NLeafElems = 200;
+
+	// Generating the trees to be appended
+	MexVector<VectTreeType> VectTrees(NTrees);
+	MexVector<FlatVectTree<double> > FlatVectTrees(NTrees);
+	for (uint32_t i = 0; i < NTrees; ++i) {
+		VectTrees[i].resize(NLeaves);
+		for (uint32_t j = 0; j < NLeaves; ++j) {
+			VectTrees[i][j].resize(NLeafElems, double(i + j));
+		}
+		FlatVectTrees[i].build(VectTrees[i]);
+	}
+
+	double AppendTime = TimeIt([&]() {
+		FlatVectTree<double> FlatTree(2);
+		for (auto &VectTree : VectTrees)
+			FlatTree.append(VectTree);
+	});
+	double AppendBatchTime = TimeIt([&]() {
+		FlatVectTree<double> FlatTree(2);
+		FlatTree.append_batch(VectTrees);
+	});
+	double AppendFVTTime = TimeIt([&]() {
+		FlatVectTree<double> FlatTree(2);
+		for (auto &FlatVectTreeIn : FlatVectTrees)
+			FlatTree.append(FlatVectTreeIn);
+	});
+	double AppendBatchFVTTime = TimeIt([&]() {
+		FlatVectTree<double> FlatTree(2);
+		FlatTree.append_batch(FlatVectTrees);
+	});
+
+	WriteOutput("MexVector trees    : append %10.3f ms, append_batch %10.3f ms\n", AppendTime, AppendBatchTime);
+	WriteOutput("FlatVectTree trees : append %10.3f ms, append_batch %10.3f ms\n", AppendFVTTime, AppendBatchFVTTime);
+
+	return 0;
+}
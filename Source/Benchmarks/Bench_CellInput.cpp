@@ -0,0 +1,78 @@
+// Benchmark for the input of deep cell arrays and FlatCellArrays.
+//
+// Compares the two pass input (FieldInfo<...>::CheckType followed by the
+// input function, as performed by getValidStructField prior to the fusion of
+// validation and ingestion) with the single pass input performed by
+// getInputfromStruct / getCheckedInputfrommxArray. The input is a cell array
+// of depth 3 with 1e6 leaves (100 x 100 x 100) and the FlatCellArray built
+// from it.
+//
+// This is to be compiled with MEX_EXE defined (and optionally with OpenMP
+// enabled).
+
+#include <cstdio>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+typedef MexVector<MexVector<MexVector<MexVector<float> > > > CellInputType;
+
+int main() {
+
+	const uint32_t NTop = 100, NMid = 100, NLeaves = 100;
+
+	// Generating the input cell array and FlatCellArray
+	CellInputType CellTree(NTop);
+	for (uint32_t i = 0; i < NTop; ++i) {
+		CellTree[i].resize(NMid);
+		for (uint32_t j = 0; j < NMid; ++j) {
+			CellTree[i][j].resize(NLeaves);
+			for (uint32_t k = 0; k < NLeaves; ++k) {
+				CellTree[i][j][k].resize((i + j + k) % 8, float(k));
+			}
+		}
+	}
+
+	FlatVectTree<float> FlatTree(3);
+	FlatTree.append(CellTree);
+
+	const char* FieldNames[] = { "Cell", "Flat" };
+	mwSize StructSize[] = { 1, 1 };
+	mxArrayPtr InputStruct = mxCreateStructArray(2, StructSize, 2, FieldNames);
+	mxSetField(InputStruct, 0, "Cell", assignmxArray(CellTree));
+	mxSetField(InputStruct, 0, "Flat", assignmxArray(FlatTree));
+
+	const mxArray* CellmxArr = mxGetField(InputStruct, 0, "Cell");
+	const mxArray* FlatmxArr = mxGetField(InputStruct, 0, "Flat");
+
+	// Cell Array Input
+	double TwoPassCell = TimeIt([&]() {
+		CellInputType CellIn;
+		if (FieldInfo<CellInputType>::CheckType(CellmxArr))
+			getInputfrommxArray(CellmxArr, CellIn);
+	});
+	double OnePassCell = TimeIt([&]() {
+		CellInputType CellIn;
+		getInputfromStruct(InputStruct, "Cell", CellIn);
+	});
+
+	// FlatCellArray Input
+	double TwoPassFlat = TimeIt([&]() {
+		FlatVectTree<float> FlatIn;
+		if (FieldInfo<FlatVectTree<float> >::CheckType(FlatmxArr))
+			getInputfrommxArray(FlatmxArr, FlatIn);
+	});
+	double OnePassFlat = TimeIt([&]() {
+		FlatVectTree<float> FlatIn;
+		getInputfromStruct<float>(InputStruct, "Flat", FlatIn, 3);
+	});
+
+	WriteOutput("Cell Array (1e6 leaves)    : Check + Input %10.3f ms, Fused %10.3f ms\n", TwoPassCell, OnePassCell);
+	WriteOutput("FlatCellArray (1e6 leaves) : Check + Input %10.3f ms, Fused %10.3f ms\n", TwoPassFlat, OnePassFlat);
+
+	mxDestroyArray(InputStruct);
+	return 0;
+}
@@ -0,0 +1,67 @@
+// Benchmark for the copy-on-write wrapping of inputs (MexCoW.hpp).
+//
+// A kernel receives a 64 MiB double vector and modifies a fraction of its
+// elements (at random positions, in increasing order). Compares
+//
+//   Copy   - getInputfrommxArray into a MexVector (full copy) and modify it
+//   CoW    - getCoWInputfrommxArray and modify through mut()
+//
+// for modified fractions from 0 to 100%, reporting the time and the number
+// of chunks copied by the MexCoWVector.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/MexCoW.hpp"
+
+#include "BenchCommon.hpp"
+
+int main() {
+
+	const size_t N = size_t(1) << 23;
+	const double Fractions[] = { 0.0, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1.0 };
+
+	mxArray* Input = mxCreateNumericMatrix(N, 1, mxDOUBLE_CLASS, mxREAL);
+	double* InputData = reinterpret_cast<double*>(mxGetData(Input));
+	for (size_t i = 0; i < N; ++i)
+		InputData[i] = double(i);
+
+	for (double Fraction : Fractions) {
+		std::mt19937 Generator(BenchSeed);
+		size_t NModified = size_t(Fraction*N);
+		MexVector<size_t> Indices(NModified);
+		for (size_t i = 0; i < NModified; ++i)
+			Indices[i] = Generator() % N;
+		std::sort(Indices.begin(), Indices.end());
+
+		double CopyTime = TimeIt([&]() {
+			MexVector<double> Vect;
+			getInputfrommxArray<double>(Input, Vect);
+			for (size_t Index : Indices)
+				Vect[Index] += 1.0;
+			Sink += Vect[N / 2];
+		});
+
+		size_t NCopiedChunks = 0, NChunks = 0;
+		double CoWTime = TimeIt([&]() {
+			MexCoWVector<double> Vect;
+			getCoWInputfrommxArray(Input, Vect);
+			for (size_t Index : Indices)
+				Vect.mut(Index) += 1.0;
+			Sink += Vect[N / 2];
+			NCopiedChunks = Vect.ncopiedchunks();
+			NChunks = Vect.nchunks();
+		});
+
+		WriteOutput("%9.5f%% modified : Copy %9.3f ms, CoW %9.3f ms (%zu / %zu chunks copied)\n",
+			100 * Fraction, CopyTime, CoWTime, NCopiedChunks, NChunks);
+	}
+
+	mxDestroyArray(Input);
+	return 0;
+}
@@ -0,0 +1,106 @@
+// Benchmark for the compressed representation of the partition indices of
+// a FlatVectTree (see CompressedIndex).
+//
+// Compares the memory used by the plain and the compressed leaf level of a
+// FlatVectTree of depth 2 with 1e7 tiny leaves (1000 x 10000, 0 to 3
+// elements each), the time taken to compress and decompress it, and the
+// time taken to traverse it sequentially (computing the largest leaf) and
+// randomly (computing the sizes of 1e7 random leaves) using either
+// representation.
+//
+// This is to be compiled with MEX_EXE defined (and optionally with OpenMP
+// and AVX2 enabled).
+
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+int main() {
+
+	const uint32_t NTop = 1000, NLeaves = 10000;
+	const size_t NRandom = 10000000;
+
+	// Generating the FlatVectTree
+	MexVector<MexVector<MexVector<uint8_t> > > VectTree(NTop);
+	for (uint32_t i = 0; i < NTop; ++i) {
+		VectTree[i].resize(NLeaves);
+		for (uint32_t j = 0; j < NLeaves; ++j) {
+			VectTree[i][j].resize((i + j) % 4, uint8_t(j));
+		}
+	}
+	FlatVectTree<uint8_t> FlatTree;
+	FlatTree.build(std::move(VectTree));
+
+	MexVector<CompressedIndex<uint32_t> > CompressedLevels;
+	MexVector<uint32_t> PlainLevel;
+
+	double CompressTime = TimeIt([&]() {
+		FlatTree.compressIndex(CompressedLevels);
+	}, 3);
+	double DecompressTime = TimeIt([&]() {
+		CompressedLevels[1].decompress(PlainLevel);
+	}, 3);
+
+	const CompressedIndex<uint32_t> &CompressedLevel = CompressedLevels[1];
+	size_t NLevelLeaves = PlainLevel.size() - 1;
+
+	// Sequential traversal
+	uint32_t PlainMax = 0, CompressedMax = 0;
+	double PlainSeqTime = TimeIt([&]() {
+		uint32_t MaxSize = 0;
+		for (size_t i = 0; i < NLevelLeaves; ++i) {
+			uint32_t LeafSize = PlainLevel[i + 1] - PlainLevel[i];
+			MaxSize = (LeafSize > MaxSize) ? LeafSize : MaxSize;
+		}
+		PlainMax = MaxSize;
+	}, 3);
+	double CompressedSeqTime = TimeIt([&]() {
+		const size_t BlockSize = CompressedIndex<uint32_t>::BLOCK_SIZE;
+		uint32_t Block[BlockSize];
+		uint32_t MaxSize = 0, Prev = 0;
+		for (size_t b = 0; b < CompressedLevel.nBlocks(); ++b) {
+			CompressedLevel.decodeBlock(b, Block);
+			size_t NBlockIndices = (b*BlockSize + BlockSize <= CompressedLevel.size()) ? BlockSize : CompressedLevel.size() - b*BlockSize;
+			for (size_t j = 0; j < NBlockIndices; ++j) {
+				uint32_t LeafSize = Block[j] - Prev;
+				MaxSize = (LeafSize > MaxSize && (b > 0 || j > 0)) ? LeafSize : MaxSize;
+				Prev = Block[j];
+			}
+		}
+		CompressedMax = MaxSize;
+	}, 3);
+
+	// Random access
+	MexVector<uint32_t> RandomLeaves(NRandom);
+	std::mt19937 Generator(BenchSeed);
+	for (size_t i = 0; i < NRandom; ++i)
+		RandomLeaves[i] = Generator() % NLevelLeaves;
+
+	uint64_t PlainSum = 0, CompressedSum = 0;
+	double PlainRandTime = TimeIt([&]() {
+		uint64_t Sum = 0;
+		for (size_t i = 0; i < NRandom; ++i)
+			Sum += PlainLevel[RandomLeaves[i] + 1] - PlainLevel[RandomLeaves[i]];
+		PlainSum = Sum;
+	}, 3);
+	double CompressedRandTime = TimeIt([&]() {
+		uint64_t Sum = 0;
+		for (size_t i = 0; i < NRandom; ++i)
+			Sum += CompressedLevel[RandomLeaves[i] + 1] - CompressedLevel[RandomLeaves[i]];
+		CompressedSum = Sum;
+	}, 3);
+
+	WriteOutput("Leaf level (1e7 leaves)  : Plain %8.2f MB, Compressed %8.2f MB (%.2f bits per index)\n",
+		PlainLevel.size()*sizeof(uint32_t)/1e6, CompressedLevel.memoryBytes()/1e6, CompressedLevel.memoryBytes()*8.0/CompressedLevel.size());
+	WriteOutput("Compress / Decompress    : %10.3f ms / %10.3f ms\n", CompressTime, DecompressTime);
+	WriteOutput("Sequential (max leaf)    : Plain %10.3f ms, Compressed %10.3f ms (%u, %u)\n", PlainSeqTime, CompressedSeqTime, PlainMax, CompressedMax);
+	WriteOutput("Random (1e7 leaf sizes)  : Plain %10.3f ms, Compressed %10.3f ms (%llu, %llu)\n", PlainRandTime, CompressedRandTime,
+		(unsigned long long)PlainSum, (unsigned long long)CompressedSum);
+
+	return 0;
+}
@@ -0,0 +1,58 @@
+// Benchmark for the construction of a FlatVectTree from nested MexVectors.
+//
+// Compares the serial, element-wise FlatVectTree::append with the bulk
+// construction performed by FlatVectTree::build (copy and move versions).
+// The input is a nested MexVector of depth 2 with 1e7 leaves (1000 x 10000).
+//
+// This is to be compiled with MEX_EXE defined (and optionally with OpenMP
+// enabled).
+
+#include <cstdio>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+typedef MexVector<MexVector<MexVector<float> > > VectTreeType;
+
+int main() {
+
+	const uint32_t NTop = 1000, NLeaves = 10000;
+
+	// Generating the input nested vector
+	VectTreeType VectTree(NTop);
+	for (uint32_t i = 0; i < NTop; ++i) {
+		VectTree[i].resize(NLeaves);
+		for (uint32_t j = 0; j < NLeaves; ++j) {
+			VectTree[i][j].resize((i + j) % 4, float(j));
+		}
+	}
+
+	double AppendTime = TimeIt([&]() {
+		FlatVectTree<float> FlatTree(2);
+		FlatTree.append(VectTree);
+	}, 3);
+	double BuildTime = TimeIt([&]() {
+		FlatVectTree<float> FlatTree;
+		FlatTree.build(VectTree);
+	}, 3);
+
+	// The move version consumes its input, a copy is hence made for each
+	// repetition (outside the timed region)
+	double MoveBuildTime = 1e30;
+	for (int i = 0; i < 3; ++i) {
+		VectTreeType VectTreeCopy(VectTree);
+		double Time = TimeIt([&]() {
+			FlatVectTree<float> FlatTree;
+			FlatTree.build(std::move(VectTreeCopy));
+		}, 1);
+		MoveBuildTime = (Time < MoveBuildTime) ? Time : MoveBuildTime;
+	}
+
+	WriteOutput("Threads: %d\n", getMaxThreads());
+	WriteOutput("FlatVectTree (1e7 leaves) : append %10.3f ms, build %10.3f ms, build (move) %10.3f ms\n", AppendTime, BuildTime, MoveBuildTime);
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+// Benchmark for building a FlatVectTree from unsorted (key, value) pairs.
+//
+// Compares pushing each value into the bucket of its key in a
+// MexVector<MexVector<float> > (followed by FlatVectTree::build) with
+// FlatVectTree::group_by, for 10^7 (neuron, spike time) pairs over 10^5
+// neurons, with and without sorting the spike times of each neuron.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+int main() {
+
+	const uint32_t NNeurons = 100000, NSpikes = 10000000;
+
+	std::mt19937 Generator(BenchSeed);
+	std::uniform_int_distribution<uint32_t> NeuronDist(0, NNeurons - 1);
+	std::uniform_real_distribution<float> TimeDist(0.0f, 1000.0f);
+
+	MexVector<uint32_t> Neurons(NSpikes);
+	MexVector<float> SpikeTimes(NSpikes);
+	for (uint32_t i = 0; i < NSpikes; ++i) {
+		Neurons[i] = NeuronDist(Generator);
+		SpikeTimes[i] = TimeDist(Generator);
+	}
+
+	for (int SortGroups = 0; SortGroups < 2; ++SortGroups) {
+		double PushBackTime = TimeIt([&]() {
+			MexVector<MexVector<float> > Buckets(NNeurons);
+			for (uint32_t i = 0; i < NSpikes; ++i)
+				Buckets[Neurons[i]].push_back(SpikeTimes[i]);
+			if (SortGroups)
+				for (auto &Bucket : Buckets)
+					std::sort(Bucket.begin(), Bucket.end());
+			FlatVectTree<float> FlatTree;
+			FlatTree.build(Buckets);
+		}, 3);
+		double GroupByTime = TimeIt([&]() {
+			FlatVectTree<float> FlatTree;
+			FlatTree.group_by(Neurons, SpikeTimes, NNeurons, SortGroups != 0);
+		}, 3);
+		WriteOutput("%s : push_back + build %10.3f ms, group_by %10.3f ms\n",
+			SortGroups ? "sorted  " : "unsorted", PushBackTime, GroupByTime);
+	}
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+// Benchmark for the growth policies of MexVector and MexMatrix.
+//
+// Compares MexGrowthGeometric (the default), MexGrowthDoubling,
+// MexGrowthExact and MexGrowthRounded on the append patterns typical of our
+// kernels:
+//
+//   Log     - push_back of 10^7 elements into a single vector
+//   Cells   - push_back of 0 - 64 elements into each of 10^5 vectors (as in
+//             the leaves of a MexVector<MexVector<...> >)
+//   Chunks  - push_size of random chunks of 1 - 256 elements up to 10^7
+//             elements
+//   Rows    - push_row of 10^5 rows of 16 columns into a MexMatrix
+//
+// For each, the time, the number of times the capacity changed, and the
+// slack (unused capacity as a percentage of the size) at the end are
+// reported. Exact growth reallocates on every append (quadratic when
+// realloc copies, as mxRealloc does) and is only run on Cells.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+
+#include "BenchCommon.hpp"
+
+struct GrowthResult {
+	double Time;
+	size_t NGrowths;
+	double Slack;
+};
+
+template <class Policy>
+GrowthResult BenchLog(size_t N) {
+	typedef MexGrowthAllocator<mxAllocator, Policy> Al;
+	GrowthResult Result = { 0, 0, 0 };
+	Result.Time = TimeIt([&]() {
+		MexVector<uint32_t, Al> Log;
+		size_t PrevCapacity = 0;
+		Result.NGrowths = 0;
+		for (size_t i = 0; i < N; ++i) {
+			Log.push_back(uint32_t(i));
+			if (Log.capacity() != PrevCapacity) {
+				PrevCapacity = Log.capacity();
+				Result.NGrowths++;
+			}
+		}
+		Result.Slack = 100.0*(Log.capacity() - Log.size()) / Log.size();
+	}, 3);
+	return Result;
+}
+
+template <class Policy>
+GrowthResult BenchCells(size_t NCells) {
+	typedef MexGrowthAllocator<mxAllocator, Policy> Al;
+	GrowthResult Result = { 0, 0, 0 };
+	Result.Time = TimeIt([&]() {
+		std::mt19937 Generator(BenchSeed);
+		MexVector<MexVector<float, Al> > Cells(NCells);
+		size_t TotalSize = 0, TotalCapacity = 0;
+		Result.NGrowths = 0;
+		for (size_t i = 0; i < NCells; ++i) {
+			size_t CellSize = Generator() % 65;
+			size_t PrevCapacity = 0;
+			for (size_t j = 0; j < CellSize; ++j) {
+				Cells[i].push_back(float(j));
+				if (Cells[i].capacity() != PrevCapacity) {
+					PrevCapacity = Cells[i].capacity();
+					Result.NGrowths++;
+				}
+			}
+			TotalSize += Cells[i].size();
+			TotalCapacity += Cells[i].capacity();
+		}
+		Result.Slack = 100.0*(TotalCapacity - TotalSize) / TotalSize;
+	}, 3);
+	return Result;
+}
+
+template <class Policy>
+GrowthResult BenchChunks(size_t N) {
+	typedef MexGrowthAllocator<mxAllocator, Policy> Al;
+	GrowthResult Result = { 0, 0, 0 };
+	Result.Time = TimeIt([&]() {
+		std::mt19937 Generator(BenchSeed);
+		MexVector<float, Al> Buffer;
+		size_t PrevCapacity = 0;
+		Result.NGrowths = 0;
+		while (Buffer.size() < N) {
+			size_t ChunkSize = 1 + Generator() % 256;
+			size_t PrevSize = Buffer.size();
+			Buffer.push_size(ChunkSize);
+			for (size_t j = PrevSize; j < Buffer.size(); ++j)
+				Buffer[j] = float(j);
+			if (Buffer.capacity() != PrevCapacity) {
+				PrevCapacity = Buffer.capacity();
+				Result.NGrowths++;
+			}
+		}
+		Result.Slack = 100.0*(Buffer.capacity() - Buffer.size()) / Buffer.size();
+	}, 3);
+	return Result;
+}
+
+template <class Policy>
+GrowthResult BenchRows(size_t NRows) {
+	typedef MexGrowthAllocator<mxAllocator, Policy> Al;
+	const size_t NCols = 16;
+	GrowthResult Result = { 0, 0, 0 };
+	Result.Time = TimeIt([&]() {
+		MexMatrix<double, Al> Matrix(0, NCols);
+		MexVector<double> Row(NCols, 1.0);
+		size_t PrevCapacity = 0;
+		Result.NGrowths = 0;
+		for (size_t i = 0; i < NRows; ++i) {
+			Matrix.push_row(Row);
+			if (Matrix.capacity() != PrevCapacity) {
+				PrevCapacity = Matrix.capacity();
+				Result.NGrowths++;
+			}
+		}
+		Result.Slack = 100.0*(Matrix.capacity() - Matrix.nrows()*NCols) / (Matrix.nrows()*NCols);
+	}, 3);
+	return Result;
+}
+
+void PrintResult(const char* Pattern, const char* PolicyName, const GrowthResult &Result) {
+	WriteOutput("%-7s %-10s : %10.3f ms, %8zu growths, %6.1f%% slack\n", Pattern, PolicyName, Result.Time, Result.NGrowths, Result.Slack);
+}
+
+int main() {
+
+	const size_t NLog = 10000000, NCells = 100000, NChunks = 10000000, NRows = 100000;
+
+	PrintResult("Log", "Geometric", BenchLog<MexGrowthGeometric>(NLog));
+	PrintResult("Log", "Doubling" , BenchLog<MexGrowthDoubling >(NLog));
+	PrintResult("Log", "Rounded"  , BenchLog<MexGrowthRounded<> >(NLog));
+
+	PrintResult("Cells", "Geometric", BenchCells<MexGrowthGeometric>(NCells));
+	PrintResult("Cells", "Doubling" , BenchCells<MexGrowthDoubling >(NCells));
+	PrintResult("Cells", "Exact"    , BenchCells<MexGrowthExact    >(NCells));
+	PrintResult("Cells", "Rounded"  , BenchCells<MexGrowthRounded<> >(NCells));
+
+	PrintResult("Chunks", "Geometric", BenchChunks<MexGrowthGeometric>(NChunks));
+	PrintResult("Chunks", "Doubling" , BenchChunks<MexGrowthDoubling >(NChunks));
+	PrintResult("Chunks", "Rounded"  , BenchChunks<MexGrowthRounded<> >(NChunks));
+
+	PrintResult("Rows", "Geometric", BenchRows<MexGrowthGeometric>(NRows));
+	PrintResult("Rows", "Doubling" , BenchRows<MexGrowthDoubling >(NRows));
+	PrintResult("Rows", "Rounded"  , BenchRows<MexGrowthRounded<> >(NRows));
+
+	return 0;
+}
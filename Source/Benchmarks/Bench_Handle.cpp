@@ -0,0 +1,67 @@
+// Benchmark for persistent objects accessed through handles (MexHandle.hpp).
+//
+// Simulates the per-call setup of a kernel that reads a network stored as a
+// cell array of 10^5 single vectors (of 0 - 512 elements). Compares
+//
+//   Marshal - getInputfrommxArray of the cell array on every call
+//   Handle  - getHandlefrommxArray + MexHandleRegistry::get on every call
+//             (the network being marshalled once into a registered object)
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/MexHandle.hpp"
+
+#include "BenchCommon.hpp"
+
+typedef MexVector<MexVector<float, mxPersistentAllocator>, mxPersistentAllocator> NetworkType;
+
+int main() {
+
+	const size_t NCells = 100000;
+
+	std::mt19937 Generator(BenchSeed);
+	mxArray* NetworkArray = mxCreateCellMatrix(NCells, 1);
+	for (size_t i = 0; i < NCells; ++i) {
+		size_t CellSize = Generator() % 513;
+		mxArray* Cell = mxCreateNumericMatrix(CellSize, 1, mxSINGLE_CLASS, mxREAL);
+		float* CellData = reinterpret_cast<float*>(mxGetData(Cell));
+		for (size_t j = 0; j < CellSize; ++j)
+			CellData[j] = float(j);
+		mxSetCell(NetworkArray, i, Cell);
+	}
+
+	double MarshalTime = TimeIt([&]() {
+		MexVector<MexVector<float> > Network;
+		getInputfrommxArray(NetworkArray, Network);
+		Sink += Network[NCells / 2].size();
+	});
+
+	double CreateTime = TimeIt([&]() {
+		uint64_t Handle = MexHandleRegistry::emplace<NetworkType>();
+		getInputfrommxArray(NetworkArray, MexHandleRegistry::get<NetworkType>(Handle));
+		MexHandleRegistry::destroy(Handle);
+	}, 1);
+
+	uint64_t Handle = MexHandleRegistry::emplace<NetworkType>();
+	getInputfrommxArray(NetworkArray, MexHandleRegistry::get<NetworkType>(Handle));
+	mxArray* HandleArray = MexHandleRegistry::getmxHandle(Handle);
+
+	double HandleTime = TimeIt([&]() {
+		NetworkType &Network = MexHandleRegistry::get<NetworkType>(getHandlefrommxArray(HandleArray));
+		Sink += Network[NCells / 2].size();
+	});
+
+	WriteOutput("Marshal per call           : %12.6f ms\n", MarshalTime);
+	WriteOutput("Handle (create, once)      : %12.6f ms\n", CreateTime);
+	WriteOutput("Handle (lookup, per call)  : %12.6f ms\n", HandleTime);
+
+	MexHandleRegistry::destroy(Handle);
+	mxDestroyArray(HandleArray);
+	mxDestroyArray(NetworkArray);
+	return 0;
+}
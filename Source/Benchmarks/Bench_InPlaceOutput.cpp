@@ -0,0 +1,88 @@
+// Benchmark for in-place output (MexInPlace.hpp).
+//
+// An update-style kernel (State = step(State)) adds 1 to every element of a
+// 64 MiB double state vector. Compares
+//
+//   CopyInOut - getInputfrommxArray, modify, assignmxArray
+//   InPlace   - getInPlaceOutput, modify
+//
+// both for a temporary input (data not shared, as in step(zeros(...))) and
+// for an input shared with a workspace variable (as in State = step(State)),
+// for which unsharing has to copy the data. Without MEXMEM_INPLACE_UNSHARE,
+// InPlace always copies once and only the temporary input is run (the
+// shared input is simulated with mxCreateSharedDataCopy).
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/MexInPlace.hpp"
+
+#include "BenchCommon.hpp"
+
+mxArray* StepCopyInOut(const mxArray* State) {
+	MexVector<double> Vect;
+	getInputfrommxArray<double>(State, Vect);
+	for (double &Elem : Vect)
+		Elem += 1.0;
+	return assignmxArray(Vect);
+}
+
+mxArray* StepInPlace(const mxArray* State, bool &isCopied) {
+	MexVector<double> Vect;
+	mxArray* ReturnPointer = getInPlaceOutput(State, Vect, &isCopied);
+	for (double &Elem : Vect)
+		Elem += 1.0;
+	return ReturnPointer;
+}
+
+int main() {
+
+	const size_t N = size_t(1) << 23;
+
+#ifdef MEXMEM_INPLACE_UNSHARE
+	const int NCases = 2;
+#else
+	const int NCases = 1;
+#endif
+
+	for (int isShared = 0; isShared < NCases; ++isShared) {
+		bool isCopied = false;
+		mxArray* Workspace = nullptr;
+
+		// Each call consumes its input (as MATLAB destroys prhs after the
+		// call) and the output becomes the next input
+		mxArray* State = mxCreateNumericMatrix(N, 1, mxDOUBLE_CLASS, mxREAL);
+		auto getInput = [&]() {
+#ifdef MEXMEM_INPLACE_UNSHARE
+			if (isShared) {
+				mxDestroyArray(Workspace);
+				Workspace = State;
+				return mxCreateSharedDataCopy(Workspace);
+			}
+#endif
+			return State;
+		};
+
+		double CopyTime = TimeIt([&]() {
+			mxArray* Input = getInput();
+			State = StepCopyInOut(Input);
+			mxDestroyArray(Input);
+		});
+		double InPlaceTime = TimeIt([&]() {
+			mxArray* Input = getInput();
+			State = StepInPlace(Input, isCopied);
+			mxDestroyArray(Input);
+		});
+		Sink += mxGetPr(State)[N - 1];
+
+		WriteOutput("%-9s input : CopyInOut %9.3f ms, InPlace %9.3f ms (data %s)\n",
+			isShared ? "shared" : "temporary", CopyTime, InPlaceTime, isCopied ? "copied" : "not copied");
+
+		mxDestroyArray(Workspace);
+		mxDestroyArray(State);
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+// Benchmark for the cross-call input cache (MexInputCache.hpp).
+//
+// Simulates successive calls receiving the same unchanged inputs:
+//
+//   Cells  - a cell array of 10^5 single vectors (of 0 - 512 elements)
+//   Vector - a 64 MiB double vector converted to single
+//
+// and compares converting the input on every call (getInputfrommxArray)
+// against reading it through MexInputCache (a miss on the first call, then
+// hits whose cost is that of computing the key and fingerprint, with the
+// default sampled fingerprint and with full hashing).
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/MexInputCache.hpp"
+
+#include "BenchCommon.hpp"
+
+typedef MexVector<MexVector<float, mxPersistentAllocator>, mxPersistentAllocator> CellsType;
+typedef MexVector<float, mxPersistentAllocator> VectorType;
+
+int main() {
+
+	const size_t NCells = 100000, NVector = size_t(1) << 23;
+
+	std::mt19937 Generator(BenchSeed);
+	mxArray* CellsArray = mxCreateCellMatrix(NCells, 1);
+	for (size_t i = 0; i < NCells; ++i) {
+		size_t CellSize = Generator() % 513;
+		mxArray* Cell = mxCreateNumericMatrix(CellSize, 1, mxSINGLE_CLASS, mxREAL);
+		float* CellData = reinterpret_cast<float*>(mxGetData(Cell));
+		for (size_t j = 0; j < CellSize; ++j)
+			CellData[j] = float(j);
+		mxSetCell(CellsArray, i, Cell);
+	}
+	mxArray* VectorArray = mxCreateNumericMatrix(NVector, 1, mxDOUBLE_CLASS, mxREAL);
+	double* VectorData = mxGetPr(VectorArray);
+	for (size_t i = 0; i < NVector; ++i)
+		VectorData[i] = double(i);
+
+	auto ConvertVector = [](const mxArray* Array, VectorType &Vect) {
+		getInputfrommxArray<double>(Array, Vect);
+	};
+
+	double CellsConvertTime = TimeIt([&]() {
+		CellsType Cells;
+		getInputfrommxArray(CellsArray, Cells);
+		Sink += Cells[NCells / 2].size();
+	});
+	double VectorConvertTime = TimeIt([&]() {
+		VectorType Vect;
+		ConvertVector(VectorArray, Vect);
+		Sink += Vect[NVector / 2];
+	});
+
+	MexInputCache::setBudget(size_t(1) << 30);
+	double CellsMissTime = TimeIt([&]() {
+		Sink += MexInputCache::get<CellsType>(CellsArray)[NCells / 2].size();
+	}, 1);
+	double VectorMissTime = TimeIt([&]() {
+		Sink += MexInputCache::get<VectorType>(VectorArray, ConvertVector)[NVector / 2];
+	}, 1);
+	double CellsHitTime = TimeIt([&]() {
+		Sink += MexInputCache::get<CellsType>(CellsArray)[NCells / 2].size();
+	});
+	double VectorHitTime = TimeIt([&]() {
+		Sink += MexInputCache::get<VectorType>(VectorArray, ConvertVector)[NVector / 2];
+	});
+
+	MexInputCache::setFullHash(true);
+	Sink += MexInputCache::get<CellsType>(CellsArray)[NCells / 2].size();
+	Sink += MexInputCache::get<VectorType>(VectorArray, ConvertVector)[NVector / 2];
+	double CellsFullHitTime = TimeIt([&]() {
+		Sink += MexInputCache::get<CellsType>(CellsArray)[NCells / 2].size();
+	});
+	double VectorFullHitTime = TimeIt([&]() {
+		Sink += MexInputCache::get<VectorType>(VectorArray, ConvertVector)[NVector / 2];
+	});
+
+	WriteOutput("Cells  : convert %10.3f ms, cache miss %10.3f ms, cache hit %10.3f ms, full hash hit %10.3f ms\n", CellsConvertTime, CellsMissTime, CellsHitTime, CellsFullHitTime);
+	WriteOutput("Vector : convert %10.3f ms, cache miss %10.3f ms, cache hit %10.3f ms, full hash hit %10.3f ms\n", VectorConvertTime, VectorMissTime, VectorHitTime, VectorFullHitTime);
+	MexInputCache::printStats();
+
+	MexInputCache::clear();
+	mxDestroyArray(CellsArray);
+	mxDestroyArray(VectorArray);
+	return 0;
+}
@@ -0,0 +1,102 @@
+// Scaling benchmark for FlatVectTree::parallel_for_each_leaf.
+//
+// The tree has 2^20 leaves whose sizes follow a power law (a few leaves hold
+// most of the data), and the work per element is a few transcendental
+// operations. For 1, 2, 4, ... up to the maximum number of OpenMP threads,
+// it compares
+//
+//   - splitting manually by top-level index (static schedule over the top
+//     level nodes, each thread getting the same number of nodes)
+//   - parallel_for_each_leaf (shards of equal Data volume, dynamic schedule)
+//
+// and reports the times and the speedup of each over the serial loop.
+//
+// This is to be compiled with MEX_EXE defined and with OpenMP enabled.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/ParallelHelpers.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+inline double LeafWork(const FlatVectTreeSpan<float> &Leaf) {
+	double Sum = 0;
+	for (float Elem : Leaf)
+		Sum += std::sqrt(Elem)*std::log1p(Elem);
+	return Sum;
+}
+
+int main() {
+
+	const uint32_t NTopLevel = 1 << 10, NLeavesPerNode = 1 << 10;
+
+	// Generating a depth 2 tree with power law leaf sizes. The sorted order
+	// puts the largest leaves in the first top-level nodes, which is the worst
+	// case for splitting by top-level index.
+	std::mt19937 Generator(BenchSeed);
+	std::uniform_real_distribution<double> Uniform(0.0, 1.0);
+	MexVector<uint32_t> LeafSizes(NTopLevel*NLeavesPerNode);
+	for (auto &LeafSize : LeafSizes)
+		LeafSize = uint32_t(4.0 / std::pow(1.0 - Uniform(Generator)*0.999999, 0.8));
+	std::sort(LeafSizes.begin(), LeafSizes.end(), [](uint32_t a, uint32_t b) { return a > b; });
+	size_t NElems = 0;
+	for (auto LeafSize : LeafSizes)
+		NElems += LeafSize;
+
+	MexVector<MexVector<MexVector<float> > > VectTree(NTopLevel);
+	for (uint32_t i = 0; i < NTopLevel; ++i) {
+		VectTree[i].resize(NLeavesPerNode);
+		for (uint32_t j = 0; j < NLeavesPerNode; ++j)
+			VectTree[i][j].resize(LeafSizes[i*NLeavesPerNode + j], float(j % 100));
+	}
+	FlatVectTree<float> FlatTree;
+	FlatTree.build(VectTree);
+	VectTree.clear();
+
+	uint32_t NLeaves = FlatTree.LevelSize(1);
+	MexVector<double> LeafResults(NLeaves);
+	FlatVectTreeView<float> TopLevel = FlatTree.view();
+
+	WriteOutput("%u leaves, %llu elements\n", NLeaves, (unsigned long long)NElems);
+
+	double SerialTime = TimeIt([&]() {
+		for (uint32_t i = 0; i < NTopLevel; ++i) {
+			FlatVectTreeView<float> Node = TopLevel[i];
+			for (uint32_t j = 0; j < Node.size(); ++j)
+				LeafResults[i*NLeavesPerNode + j] = LeafWork(Node[j].span());
+		}
+	});
+	WriteOutput("serial loop             : %10.3f ms\n", SerialTime);
+
+	int MaxThreads = getMaxThreads();
+	for (int NThreads = 1; NThreads <= MaxThreads; NThreads *= 2) {
+#ifdef _OPENMP
+		omp_set_num_threads(NThreads);
+#endif
+		double TopLevelSplitTime = TimeIt([&]() {
+			#pragma omp parallel for schedule(static)
+			for (int64_t i = 0; i < NTopLevel; ++i) {
+				FlatVectTreeView<float> Node = TopLevel[i];
+				for (uint32_t j = 0; j < Node.size(); ++j)
+					LeafResults[i*NLeavesPerNode + j] = LeafWork(Node[j].span());
+			}
+		});
+		double ForEachLeafTime = TimeIt([&]() {
+			FlatTree.parallel_for_each_leaf([&](uint32_t LeafIndex, const FlatVectTreeSpan<float> &Leaf) {
+				LeafResults[LeafIndex] = LeafWork(Leaf);
+			});
+		});
+		WriteOutput("%2d threads: top-level split %10.3f ms (x%5.2f), parallel_for_each_leaf %10.3f ms (x%5.2f)\n",
+			NThreads,
+			TopLevelSplitTime, SerialTime / TopLevelSplitTime,
+			ForEachLeafTime, SerialTime / ForEachLeafTime);
+	}
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+// Benchmark for the ring buffer recorders (MexRingBuffer.hpp).
+//
+// A time-stepped kernel with a state of 64 doubles runs for 10^6 steps and
+// records its state
+//
+//   Last     - keeping only the last 1000 steps
+//              (MexMatrix::push_row + erasing the oldest rows in blocks,
+//              vs MexRingMatrix::push_row)
+//   Decimate - every 10th step of the whole run
+//              (MexMatrix::push_row with a step counter, vs
+//              MexRingMatrix::record_row)
+//
+// and also compares a scalar trace of every step kept in a MexVector
+// (push_back) and a MexRingBuffer of the last 10^4 steps. The time of
+// assignmxArray is included.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/MexRingBuffer.hpp"
+
+#include "BenchCommon.hpp"
+
+static const size_t NSteps = 1000000, NState = 64, NLast = 1000, Stride = 10;
+
+inline void step(MexVector<double> &State, size_t StepIndex) {
+	for (size_t j = 0; j < NState; ++j)
+		State[j] = 0.999*State[j] + double(StepIndex & 7);
+}
+
+void consume(mxArray* Output) {
+	Sink += mxGetPr(Output)[mxGetNumberOfElements(Output) - 1];
+	mxDestroyArray(Output);
+}
+
+int main() {
+
+	MexVector<double> State(NState, 0.0);
+
+	double LastMatrixTime = TimeIt([&]() {
+		// Keeps between NLast and 2*NLast rows, dropping the oldest NLast
+		// whenever 2*NLast are reached
+		MexMatrix<double> Record(0, NState);
+		for (size_t i = 0; i < NSteps; ++i) {
+			step(State, i);
+			Record.push_row(State);
+			if (Record.nrows() == 2 * NLast) {
+				for (size_t r = 0; r < NLast; ++r)
+					for (size_t j = 0; j < NState; ++j)
+						Record(r, j) = Record(r + NLast, j);
+				Record.resize(NLast, NState);
+			}
+		}
+		consume(assignmxArray(Record));
+	}, 3);
+	double LastRingTime = TimeIt([&]() {
+		MexRingMatrix<double> Record(NLast, NState);
+		for (size_t i = 0; i < NSteps; ++i) {
+			step(State, i);
+			Record.push_row(State);
+		}
+		consume(assignmxArray(Record));
+	}, 3);
+
+	double DecimateMatrixTime = TimeIt([&]() {
+		MexMatrix<double> Record(0, NState);
+		for (size_t i = 0; i < NSteps; ++i) {
+			step(State, i);
+			if (i % Stride == 0)
+				Record.push_row(State);
+		}
+		consume(assignmxArray(Record));
+	}, 3);
+	double DecimateRingTime = TimeIt([&]() {
+		MexRingMatrix<double> Record((NSteps + Stride - 1) / Stride, NState, Stride);
+		for (size_t i = 0; i < NSteps; ++i) {
+			step(State, i);
+			Record.record_row(State.begin());
+		}
+		consume(assignmxArray(Record));
+	}, 3);
+
+	double TraceVectorTime = TimeIt([&]() {
+		MexVector<double> Trace;
+		for (size_t i = 0; i < NSteps; ++i)
+			Trace.push_back(double(i));
+		consume(assignmxArray(Trace));
+	}, 3);
+	double TraceRingTime = TimeIt([&]() {
+		MexRingBuffer<double> Trace(10000);
+		for (size_t i = 0; i < NSteps; ++i)
+			Trace.push_back(double(i));
+		consume(assignmxArray(Trace));
+	}, 3);
+
+	WriteOutput("Last     : MexMatrix %9.3f ms, MexRingMatrix %9.3f ms\n", LastMatrixTime, LastRingTime);
+	WriteOutput("Decimate : MexMatrix %9.3f ms, MexRingMatrix %9.3f ms\n", DecimateMatrixTime, DecimateRingTime);
+	WriteOutput("Trace    : MexVector %9.3f ms, MexRingBuffer %9.3f ms\n", TraceVectorTime, TraceRingTime);
+	return 0;
+}
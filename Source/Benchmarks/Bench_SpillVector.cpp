@@ -0,0 +1,73 @@
+// Benchmark for the out-of-core MexSpillVector (MexSpillVector.hpp).
+//
+// Appends 5*10^7 uint32 elements (200 MB, as a long simulation accumulating
+// a spike list) and compares
+//
+//   MexVector      - push_back into a MexVector, then assignmxArray
+//   MexSpillVector - push_back into a MexSpillVector (spilling to a
+//                    temporary file), then a sequential read back through
+//                    a ChunkReader and assignmxArray
+//
+// reporting the time of each phase and the peak memory held by the
+// container (as counted by MemCounter).
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/MexSpillVector.hpp"
+
+#include "BenchCommon.hpp"
+
+int main() {
+
+	const size_t N = 50000000;
+
+	{
+		size_t MemUsageBefore = MemCounter::MemUsage;
+		MexVector<uint32_t> Vect;
+		double AppendTime = TimeIt([&]() {
+			for (size_t i = 0; i < N; ++i)
+				Vect.push_back(uint32_t(i));
+		}, 1);
+		size_t PeakMemory = MemCounter::MemUsage - MemUsageBefore;
+		mxArray* Output = nullptr;
+		double OutputTime = TimeIt([&]() {
+			Output = assignmxArray(Vect);
+		}, 1);
+		Sink += reinterpret_cast<uint32_t*>(mxGetData(Output))[N - 1];
+		mxDestroyArray(Output);
+
+		WriteOutput("MexVector      : append %9.3f ms, assignmxArray %9.3f ms, peak memory %6zu MB\n",
+			AppendTime, OutputTime, PeakMemory >> 20);
+	}
+
+	{
+		size_t MemUsageBefore = MemCounter::MemUsage;
+		MexSpillVector<uint32_t> Vect;
+		double AppendTime = TimeIt([&]() {
+			for (size_t i = 0; i < N; ++i)
+				Vect.push_back(uint32_t(i));
+		}, 1);
+		size_t PeakMemory = MemCounter::MemUsage - MemUsageBefore;
+		double ReadTime = TimeIt([&]() {
+			auto Reader = Vect.getReader();
+			size_t NElems;
+			const uint32_t* Chunk;
+			while ((Chunk = Reader.next(NElems)) != nullptr)
+				Sink += Chunk[NElems - 1];
+		}, 1);
+		mxArray* Output = nullptr;
+		double OutputTime = TimeIt([&]() {
+			Output = assignmxArray(Vect);
+		}, 1);
+		Sink += reinterpret_cast<uint32_t*>(mxGetData(Output))[N - 1];
+		mxDestroyArray(Output);
+
+		WriteOutput("MexSpillVector : append %9.3f ms, assignmxArray %9.3f ms, peak memory %6zu MB (read back %9.3f ms, %zu chunks spilled)\n",
+			AppendTime, OutputTime, PeakMemory >> 20, ReadTime, Vect.nspilledchunks());
+	}
+	return 0;
+}
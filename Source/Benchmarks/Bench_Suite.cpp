@@ -0,0 +1,443 @@
+// Microbenchmark suite for MexVector, MexMatrix, FlatVectTree and the
+// input / output functions of GenericMexIO.
+//
+// Each case is timed for the MexMemoryInterfacing implementation and for a
+// baseline using std::vector (or, for the I/O cases, a plain copy of the
+// mxArray data into / out of a std::vector). All inputs are generated from
+// fixed seeds so that the results of two runs (or two commits) are
+// comparable.
+//
+// Usage: Bench_Suite [OutputFile.json]
+//
+// The results are written as JSON to the given file (in which case a table
+// is also printed) or, if no file is given, to the standard output. Each
+// result records the case, the implementation, the problem size, and the
+// minimum and median time (in ms) over the repetitions.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../../Headers/MexMem.hpp"
+#include "../../Headers/GenericMexIO.hpp"
+#include "../../Headers/FlatVectTree/FlatVectTree.hpp"
+
+#include "BenchCommon.hpp"
+
+static const int NRepeats = 7;
+
+struct BenchResult {
+	std::string Case;
+	std::string Impl;
+	size_t      N;
+	double      MinTime;
+	double      MedianTime;
+};
+
+static std::vector<BenchResult> Results;
+
+template <typename Func>
+void RunBench(const char* Case, const char* Impl, size_t N, Func F) {
+	BenchTimes Times = TimeRuns(F, NRepeats, true);
+	Results.push_back(BenchResult{ Case, Impl, N, Times.MinTime, Times.MedianTime });
+}
+
+static void WriteJSON(FILE* OutFile) {
+	std::fprintf(OutFile, "{\n");
+	std::fprintf(OutFile, "  \"seed\": %u,\n", BenchSeed);
+	std::fprintf(OutFile, "  \"repeats\": %d,\n", NRepeats);
+	std::fprintf(OutFile, "  \"threads\": %d,\n", getMaxThreads());
+	std::fprintf(OutFile, "  \"results\": [\n");
+	for (size_t i = 0; i < Results.size(); ++i) {
+		const BenchResult &R = Results[i];
+		std::fprintf(OutFile, "    {\"case\": \"%s\", \"impl\": \"%s\", \"n\": %zu, \"min_ms\": %.6f, \"median_ms\": %.6f}%s\n",
+			R.Case.c_str(), R.Impl.c_str(), R.N, R.MinTime, R.MedianTime, (i + 1 < Results.size()) ? "," : "");
+	}
+	std::fprintf(OutFile, "  ]\n}\n");
+}
+
+static void WriteTable() {
+	WriteOutput("%-24s %-12s %10s %12s %12s\n", "Case", "Impl", "N", "Min (ms)", "Median (ms)");
+	for (const BenchResult &R : Results) {
+		WriteOutput("%-24s %-12s %10zu %12.3f %12.3f\n", R.Case.c_str(), R.Impl.c_str(), R.N, R.MinTime, R.MedianTime);
+	}
+}
+
+/////////////////////////////////////////////////
+// CONTAINER BENCHMARKS     /////////////////////
+/////////////////////////////////////////////////
+
+static void BenchGrowth(size_t N) {
+	RunBench("push_back", "MexVector", N, [&]() {
+		MexVector<uint32_t> V;
+		for (size_t i = 0; i < N; ++i)
+			V.push_back(uint32_t(i));
+		Sink += V.last();
+	});
+	RunBench("push_back", "std::vector", N, [&]() {
+		std::vector<uint32_t> V;
+		for (size_t i = 0; i < N; ++i)
+			V.push_back(uint32_t(i));
+		Sink += V.back();
+	});
+
+	// Growth by chunks of 16 elements
+	RunBench("push_size", "MexVector", N, [&]() {
+		MexVector<uint32_t> V;
+		for (size_t i = 0; i < N; i += 16)
+			V.push_size(16);
+		Sink += V.size();
+	});
+	RunBench("push_size", "std::vector", N, [&]() {
+		std::vector<uint32_t> V;
+		for (size_t i = 0; i < N; i += 16)
+			V.resize(V.size() + 16);
+		Sink += V.size();
+	});
+}
+
+static void BenchInsertErase(size_t N, size_t NOps) {
+
+	std::mt19937 Generator(BenchSeed);
+	std::vector<size_t> Positions(NOps);
+	for (size_t i = 0; i < NOps; ++i)
+		Positions[i] = Generator() % N;
+
+	RunBench("insert/erase", "MexVector", NOps, [&]() {
+		MexVector<uint32_t> V(N, 1u);
+		for (size_t i = 0; i < NOps; ++i)
+			V.insert(Positions[i], uint32_t(i));
+		for (size_t i = 0; i < NOps; ++i)
+			V.erase(Positions[NOps - 1 - i]);
+		Sink += V.size();
+	});
+	RunBench("insert/erase", "std::vector", NOps, [&]() {
+		std::vector<uint32_t> V(N, 1u);
+		for (size_t i = 0; i < NOps; ++i)
+			V.insert(V.begin() + Positions[i], uint32_t(i));
+		for (size_t i = 0; i < NOps; ++i)
+			V.erase(V.begin() + Positions[NOps - 1 - i]);
+		Sink += V.size();
+	});
+}
+
+static void BenchCopyMove(size_t N) {
+
+	MexVector<double> MexSrc(N, 1.0);
+	std::vector<double> StdSrc(N, 1.0);
+
+	RunBench("copy", "MexVector", N, [&]() {
+		MexVector<double> Copy(MexSrc);
+		Sink += Copy[N / 2];
+	});
+	RunBench("copy", "std::vector", N, [&]() {
+		std::vector<double> Copy(StdSrc);
+		Sink += Copy[N / 2];
+	});
+
+	// Moving back and forth 10^6 times
+	RunBench("move", "MexVector", 1000000, [&]() {
+		for (int i = 0; i < 1000000; ++i) {
+			MexVector<double> Temp(std::move(MexSrc));
+			Sink += Temp.size();
+			MexSrc = std::move(Temp);
+		}
+	});
+	RunBench("move", "std::vector", 1000000, [&]() {
+		for (int i = 0; i < 1000000; ++i) {
+			std::vector<double> Temp(std::move(StdSrc));
+			Sink += Temp.size();
+			StdSrc = std::move(Temp);
+		}
+	});
+}
+
+static void BenchMatrixRows(size_t NRows, size_t NCols) {
+
+	std::mt19937 Generator(BenchSeed);
+	std::uniform_real_distribution<float> Dist(0.0f, 1.0f);
+
+	MexMatrix<float> MexMat(NRows, NCols);
+	std::vector<float> StdMat(NRows*NCols);
+	for (size_t i = 0; i < NRows*NCols; ++i)
+		StdMat[i] = MexMat(i / NCols, i % NCols) = Dist(Generator);
+
+	RunBench("MexMatrix row access", "MexMatrix", NRows*NCols, [&]() {
+		double Sum = 0;
+		for (size_t i = 0; i < NRows; ++i) {
+			const MexVector<float> &Row = MexMat[i];
+			for (size_t j = 0; j < NCols; ++j)
+				Sum += Row[j];
+		}
+		Sink += Sum;
+	});
+	RunBench("MexMatrix row access", "std::vector", NRows*NCols, [&]() {
+		double Sum = 0;
+		for (size_t i = 0; i < NRows; ++i) {
+			const float* Row = StdMat.data() + i*NCols;
+			for (size_t j = 0; j < NCols; ++j)
+				Sum += Row[j];
+		}
+		Sink += Sum;
+	});
+}
+
+/////////////////////////////////////////////////
+// INPUT / OUTPUT BENCHMARKS ////////////////////
+/////////////////////////////////////////////////
+
+struct BenchSynapse {
+	int   Start;
+	int   End;
+	float Weight;
+};
+
+static void getSynapse(StructArgTable &ArgumentVects, BenchSynapse &Synapse) {
+	Synapse.Start  = *reinterpret_cast<int32_t*>(ArgumentVects["Start"].first);
+	Synapse.End    = *reinterpret_cast<int32_t*>(ArgumentVects["End"].first);
+	Synapse.Weight = *reinterpret_cast<float*>(ArgumentVects["Weight"].first);
+}
+
+template <typename T>
+static mxArray* createRandomArray(size_t M, size_t N, std::mt19937 &Generator) {
+	mxArray* Array = mxCreateNumericMatrix(M, N, GetMexType<T>::typeVal, mxREAL);
+	T* Data = reinterpret_cast<T*>(mxGetData(Array));
+	for (size_t i = 0; i < M*N; ++i)
+		Data[i] = T(Generator() % 1000);
+	return Array;
+}
+
+static void BenchInput(size_t N, size_t NCells) {
+
+	std::mt19937 Generator(BenchSeed);
+
+	const char* FieldNames[] = { "Scalar", "Vector", "Matrix", "Cell", "Start", "End", "Weight" };
+	mwSize StructSize[] = { 1, 1 };
+	mxArray* InputStruct = mxCreateStructArray(2, StructSize, 7, FieldNames);
+
+	size_t NMatCols = 100;
+	mxSetField(InputStruct, 0, "Scalar", mxCreateDoubleScalar(42.0));
+	mxSetField(InputStruct, 0, "Vector", createRandomArray<float>(N, 1, Generator));
+	mxSetField(InputStruct, 0, "Matrix", createRandomArray<float>(NMatCols, N / NMatCols, Generator));
+	mxSetField(InputStruct, 0, "Start" , createRandomArray<int32_t>(N, 1, Generator));
+	mxSetField(InputStruct, 0, "End"   , createRandomArray<int32_t>(N, 1, Generator));
+	mxSetField(InputStruct, 0, "Weight", createRandomArray<float>(N, 1, Generator));
+
+	mxArray* CellArray = mxCreateCellMatrix(NCells, 1);
+	for (size_t i = 0; i < NCells; ++i)
+		mxSetCell(CellArray, i, createRandomArray<float>(Generator() % 32, 1, Generator));
+	mxSetField(InputStruct, 0, "Cell", CellArray);
+
+	// Scalar input (10^5 fields read)
+	RunBench("input scalar", "MexMem", 100000, [&]() {
+		double Sum = 0, Value = 0;
+		for (int i = 0; i < 100000; ++i) {
+			getInputfromStruct<double>(InputStruct, "Scalar", Value);
+			Sum += Value;
+		}
+		Sink += Sum;
+	});
+	RunBench("input scalar", "baseline", 100000, [&]() {
+		double Sum = 0;
+		for (int i = 0; i < 100000; ++i)
+			Sum += mxGetScalar(mxGetField(InputStruct, 0, "Scalar"));
+		Sink += Sum;
+	});
+
+	// Vector input
+	const mxArray* VectorArray = mxGetField(InputStruct, 0, "Vector");
+	RunBench("input vector", "MexMem", N, [&]() {
+		MexVector<float> VectorIn;
+		getInputfrommxArray<float>(VectorArray, VectorIn);
+		Sink += VectorIn[N / 2];
+	});
+	RunBench("input vector (struct)", "MexMem", N, [&]() {
+		MexVector<float> VectorIn;
+		getInputfromStruct<float>(InputStruct, "Vector", VectorIn);
+		Sink += VectorIn[N / 2];
+	});
+	RunBench("input vector", "std::vector", N, [&]() {
+		const float* Data = reinterpret_cast<const float*>(mxGetData(VectorArray));
+		std::vector<float> VectorIn(Data, Data + mxGetNumberOfElements(VectorArray));
+		Sink += VectorIn[N / 2];
+	});
+
+	// Matrix input
+	const mxArray* MatrixArray = mxGetField(InputStruct, 0, "Matrix");
+	RunBench("input matrix", "MexMem", N, [&]() {
+		MexMatrix<float> MatrixIn;
+		getInputfromStruct<float>(InputStruct, "Matrix", MatrixIn);
+		Sink += MatrixIn(0, 0);
+	});
+	RunBench("input matrix", "std::vector", N, [&]() {
+		const float* Data = reinterpret_cast<const float*>(mxGetData(MatrixArray));
+		std::vector<float> MatrixIn(Data, Data + mxGetNumberOfElements(MatrixArray));
+		Sink += MatrixIn[0];
+	});
+
+	// Cell array input
+	RunBench("input cell", "MexMem", NCells, [&]() {
+		MexVector<MexVector<float> > CellIn;
+		getInputfromStruct<float>(InputStruct, "Cell", CellIn);
+		Sink += CellIn.size();
+	});
+	RunBench("input cell", "std::vector", NCells, [&]() {
+		std::vector<std::vector<float> > CellIn(NCells);
+		for (size_t i = 0; i < NCells; ++i) {
+			const mxArray* Cell = mxGetCell(CellArray, i);
+			const float* Data = reinterpret_cast<const float*>(mxGetData(Cell));
+			CellIn[i].assign(Data, Data + mxGetNumberOfElements(Cell));
+		}
+		Sink += CellIn.size();
+	});
+
+	// Struct (of arrays) input
+	RunBench("input struct", "MexMem", N, [&]() {
+		MexVector<BenchSynapse> SynapsesIn;
+		getInputfromStruct<BenchSynapse>(InputStruct, "Start End Weight", SynapsesIn, getSynapse);
+		Sink += SynapsesIn.size();
+	});
+	RunBench("input struct", "std::vector", N, [&]() {
+		const int32_t* Start  = reinterpret_cast<const int32_t*>(mxGetData(mxGetField(InputStruct, 0, "Start")));
+		const int32_t* End    = reinterpret_cast<const int32_t*>(mxGetData(mxGetField(InputStruct, 0, "End")));
+		const float*   Weight = reinterpret_cast<const float*>(mxGetData(mxGetField(InputStruct, 0, "Weight")));
+		std::vector<BenchSynapse> SynapsesIn(N);
+		for (size_t i = 0; i < N; ++i)
+			SynapsesIn[i] = BenchSynapse{ Start[i], End[i], Weight[i] };
+		Sink += SynapsesIn.size();
+	});
+
+	mxDestroyArray(InputStruct);
+}
+
+static void BenchOutput(size_t N, size_t NCells) {
+
+	// The containers are regenerated for each repetition as assignmxArray
+	// releases their memory into the returned mxArray
+	RunBench("output vector", "MexMem", N, [&]() {
+		MexVector<float> VectorOut(N, 1.0f);
+		mxArray* Output = assignmxArray(VectorOut);
+		Sink += mxGetNumberOfElements(Output);
+		mxDestroyArray(Output);
+	});
+	RunBench("output vector", "std::vector", N, [&]() {
+		std::vector<float> VectorOut(N, 1.0f);
+		mxArray* Output = mxCreateNumericMatrix(N, 1, mxSINGLE_CLASS, mxREAL);
+		std::memcpy(mxGetData(Output), VectorOut.data(), N*sizeof(float));
+		Sink += mxGetNumberOfElements(Output);
+		mxDestroyArray(Output);
+	});
+
+	RunBench("output cell", "MexMem", NCells, [&]() {
+		MexVector<MexVector<float> > CellOut(NCells);
+		for (size_t i = 0; i < NCells; ++i)
+			CellOut[i].resize(i % 32, 1.0f);
+		mxArray* Output = assignmxArray(CellOut);
+		Sink += mxGetNumberOfElements(Output);
+		mxDestroyArray(Output);
+	});
+	RunBench("output cell", "std::vector", NCells, [&]() {
+		std::vector<std::vector<float> > CellOut(NCells);
+		for (size_t i = 0; i < NCells; ++i)
+			CellOut[i].resize(i % 32, 1.0f);
+		mxArray* Output = mxCreateCellMatrix(NCells, 1);
+		for (size_t i = 0; i < NCells; ++i) {
+			mxArray* Cell = mxCreateNumericMatrix(CellOut[i].size(), 1, mxSINGLE_CLASS, mxREAL);
+			if (!CellOut[i].empty())
+				std::memcpy(mxGetData(Cell), CellOut[i].data(), CellOut[i].size()*sizeof(float));
+			mxSetCell(Output, i, Cell);
+		}
+		Sink += mxGetNumberOfElements(Output);
+		mxDestroyArray(Output);
+	});
+}
+
+/////////////////////////////////////////////////
+// FLATVECTTREE BENCHMARKS  /////////////////////
+/////////////////////////////////////////////////
+
+static void BenchFlatVectTree(size_t NTop, size_t NLeaves) {
+
+	std::mt19937 Generator(BenchSeed);
+	MexVector<MexVector<MexVector<float> > > VectTree(NTop);
+	std::vector<std::vector<std::vector<float> > > StdVectTree(NTop);
+	for (size_t i = 0; i < NTop; ++i) {
+		VectTree[i].resize(NLeaves);
+		StdVectTree[i].resize(NLeaves);
+		for (size_t j = 0; j < NLeaves; ++j) {
+			size_t LeafSize = Generator() % 8;
+			VectTree[i][j].resize(LeafSize, float(j));
+			StdVectTree[i][j].resize(LeafSize, float(j));
+		}
+	}
+
+	FlatVectTree<float> FlatTree(2);
+	FlatTree.append(VectTree);
+
+	// Append (the std::vector baseline is a deep copy)
+	RunBench("FlatVectTree append", "FlatVectTree", NTop*NLeaves, [&]() {
+		FlatVectTree<float> Tree(2);
+		Tree.append(VectTree);
+		Sink += Tree.LevelSize(0);
+	});
+	RunBench("FlatVectTree append", "std::vector", NTop*NLeaves, [&]() {
+		std::vector<std::vector<std::vector<float> > > Tree;
+		Tree.insert(Tree.end(), StdVectTree.begin(), StdVectTree.end());
+		Sink += Tree.size();
+	});
+
+	// Fetching every leaf
+	RunBench("FlatVectTree fetch", "FlatVectTree", NTop*NLeaves, [&]() {
+		double Sum = 0;
+		auto TreeView = FlatTree.view();
+		for (size_t i = 0; i < NTop; ++i) {
+			auto SubTree = TreeView[i];
+			for (size_t j = 0; j < SubTree.size(); ++j) {
+				for (float Elem : SubTree[j].span())
+					Sum += Elem;
+			}
+		}
+		Sink += Sum;
+	});
+	RunBench("FlatVectTree fetch", "std::vector", NTop*NLeaves, [&]() {
+		double Sum = 0;
+		for (size_t i = 0; i < NTop; ++i) {
+			for (size_t j = 0; j < NLeaves; ++j) {
+				for (float Elem : StdVectTree[i][j])
+					Sum += Elem;
+			}
+		}
+		Sink += Sum;
+	});
+}
+
+int main(int argc, char* argv[]) {
+
+	BenchGrowth(10000000);
+	BenchInsertErase(100000, 2000);
+	BenchCopyMove(10000000);
+	BenchMatrixRows(10000, 1000);
+	BenchInput(1000000, 100000);
+	BenchOutput(1000000, 100000);
+	BenchFlatVectTree(1000, 1000);
+
+	if (argc > 1) {
+		FILE* OutFile = std::fopen(argv[1], "w");
+		if (OutFile == nullptr) {
+			WriteOutput("Could not open '%s' for writing\n", argv[1]);
+			return 1;
+		}
+		WriteJSON(OutFile);
+		std::fclose(OutFile);
+		WriteTable();
+	}
+	else {
+		WriteJSON(stdout);
+	}
+
+	return 0;
+}
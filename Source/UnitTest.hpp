@@ -0,0 +1,72 @@
+#ifndef UNIT_TEST_HPP
+#define UNIT_TEST_HPP
+
+// Minimal harness for the unit tests in Source (one executable per
+// UnitTest_*.cpp, registered with CTest). A test is a function that checks
+// its conditions using UNITTEST_CHECK; a failed check is reported with its
+// location and the test continues. RunUnitTests returns the exit code of
+// the executable (non-zero if any check failed or any test threw).
+//
+// These are to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+
+#include "../Headers/MexMem.hpp"
+
+struct UnitTestCase {
+	const char* Name;
+	void (*Function)();
+};
+
+inline size_t& UnitTestFailures() {
+	static size_t NFailures = 0;
+	return NFailures;
+}
+
+#define UNITTEST_CHECK(Cond)                                                      \
+	do {                                                                          \
+		if (!(Cond)) {                                                            \
+			std::printf("  %s:%d: check failed: %s\n", __FILE__, __LINE__, #Cond); \
+			UnitTestFailures()++;                                                 \
+		}                                                                         \
+	} while (0)
+
+// Checks that Expr raises the exception ExCode (a value of one of the
+// exception enums, e.g. ExOps::EXCEPTION_INVALID_INPUT or FV_INVALID_FETCH)
+#define UNITTEST_CHECK_THROWS(Expr, ExCode)                                       \
+	do {                                                                          \
+		bool isThrown = false;                                                    \
+		try { Expr; }                                                             \
+		catch (decltype(ExCode) Ex) { isThrown = (Ex == (ExCode)); }              \
+		catch (...) {}                                                            \
+		if (!isThrown) {                                                          \
+			std::printf("  %s:%d: %s did not throw %s\n", __FILE__, __LINE__, #Expr, #ExCode); \
+			UnitTestFailures()++;                                                 \
+		}                                                                         \
+	} while (0)
+
+template <size_t N>
+inline int RunUnitTests(const UnitTestCase (&Tests)[N]) {
+	size_t NFailedTests = 0;
+	for (const UnitTestCase &Test : Tests) {
+		size_t FailuresBefore = UnitTestFailures();
+		std::printf("%s\n", Test.Name);
+		try {
+			Test.Function();
+		}
+		catch (ExOps::ExCodes Ex) {
+			std::printf("  threw ExOps exception %d\n", int(Ex));
+			UnitTestFailures()++;
+		}
+		catch (...) {
+			std::printf("  threw an exception\n");
+			UnitTestFailures()++;
+		}
+		if (UnitTestFailures() != FailuresBefore)
+			NFailedTests++;
+	}
+	std::printf("%zu of %zu tests failed\n", NFailedTests, N);
+	return NFailedTests ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,120 @@
+// Unit tests of the call-site allocation profiler (MexAllocProfiler.hpp).
+//
+// This is to be compiled with MEX_EXE and MEXMEM_PROFILE_ALLOCATIONS
+// defined.
+
+#include <vector>
+
+#include "UnitTest.hpp"
+
+#ifndef MEXMEM_PROFILE_ALLOCATIONS
+#  error "UnitTest_AllocProfiler must be compiled with MEXMEM_PROFILE_ALLOCATIONS defined"
+#endif
+
+static const MexAllocSiteStats* FindSite(const std::vector<MexAllocSiteStats> &Report, int Line) {
+	for (const MexAllocSiteStats &Stats : Report)
+		if (Stats.Line == Line)
+			return &Stats;
+	return nullptr;
+}
+
+static size_t TotalFinalCapacity(const std::vector<MexAllocSiteStats> &Report) {
+	size_t Total = 0;
+	for (const MexAllocSiteStats &Stats : Report)
+		Total += Stats.FinalCapacity;
+	return Total;
+}
+
+static void TestVectorGrowth() {
+	MexAllocProfiler::reset();
+	int SiteLine;
+	{
+		SiteLine = __LINE__; MexVector<uint64_t> Vect(MexAllocSite(__FILE__, __LINE__));
+		for (uint64_t i = 0; i < 1000; ++i)
+			Vect.push_back(i);
+	}
+	std::vector<MexAllocSiteStats> Report;
+	MexAllocProfiler::getReport(Report);
+	const MexAllocSiteStats* Site = FindSite(Report, SiteLine);
+	UNITTEST_CHECK(Site != nullptr);
+	if (Site != nullptr) {
+		UNITTEST_CHECK(Site->Allocations == 1);
+		UNITTEST_CHECK(Site->Reallocations > 0);
+		UNITTEST_CHECK(Site->PeakCapacity >= 1000*sizeof(uint64_t));
+		UNITTEST_CHECK(Site->FinalCapacity == Site->PeakCapacity);
+	}
+}
+
+static void TestVectorSwap() {
+	MexAllocProfiler::reset();
+	int LineA, LineB;
+	{
+		LineA = __LINE__; MexVector<uint64_t> A(1000, MexAllocSite(__FILE__, __LINE__));
+		LineB = __LINE__; MexVector<uint64_t> B(MexAllocSite(__FILE__, __LINE__));
+		uint64_t* Data = A.begin();
+		for (int i = 0; i < 11; ++i)
+			A.swap(B);
+
+		// After an odd number of swaps, B holds the block allocated by A
+		UNITTEST_CHECK(A.isempty() && A.begin() == nullptr);
+		UNITTEST_CHECK(B.size() == 1000 && B.begin() == Data);
+	}
+	std::vector<MexAllocSiteStats> Report;
+	MexAllocProfiler::getReport(Report);
+	const MexAllocSiteStats* SiteA = FindSite(Report, LineA);
+	const MexAllocSiteStats* SiteB = FindSite(Report, LineB);
+
+	// The block is reported freed once, under the site that allocated it
+	UNITTEST_CHECK(TotalFinalCapacity(Report) == 1000*sizeof(uint64_t));
+	UNITTEST_CHECK(SiteA != nullptr && SiteA->FinalCapacity == 1000*sizeof(uint64_t));
+	UNITTEST_CHECK(SiteB == nullptr || SiteB->FinalCapacity == 0);
+}
+
+static void TestMatrixSwap() {
+	MexAllocProfiler::reset();
+	int LineA, LineB;
+	{
+		LineA = __LINE__; MexMatrix<float> A(10, 20, MexAllocSite(__FILE__, __LINE__));
+		LineB = __LINE__; MexMatrix<float> B(5, 4, MexAllocSite(__FILE__, __LINE__));
+		for (int i = 0; i < 10; ++i)
+			A.swap(B);
+		A.swap(B);
+		UNITTEST_CHECK(A.nrows() == 5 && A.ncols() == 4);
+		UNITTEST_CHECK(B.nrows() == 10 && B.ncols() == 20);
+	}
+	std::vector<MexAllocSiteStats> Report;
+	MexAllocProfiler::getReport(Report);
+	const MexAllocSiteStats* SiteA = FindSite(Report, LineA);
+	const MexAllocSiteStats* SiteB = FindSite(Report, LineB);
+	UNITTEST_CHECK(TotalFinalCapacity(Report) == (200 + 20)*sizeof(float));
+	UNITTEST_CHECK(SiteA != nullptr && SiteA->FinalCapacity == 200*sizeof(float));
+	UNITTEST_CHECK(SiteB != nullptr && SiteB->FinalCapacity == 20*sizeof(float));
+}
+
+static void TestSwapExternal() {
+	// Swapping with a vector wrapping external memory swaps the external
+	// flag along with the array
+	MexAllocProfiler::reset();
+	uint32_t External[4] = { 1, 2, 3, 4 };
+	{
+		MexVector<uint32_t> Owned(8);
+		MexVector<uint32_t> Wrapper;
+		Wrapper.assign(4, External, false);
+		Owned.swap(Wrapper);
+		UNITTEST_CHECK(Owned.ismemext() && Owned.begin() == External && Owned.size() == 4);
+		UNITTEST_CHECK(!Wrapper.ismemext() && Wrapper.size() == 8);
+	}
+	std::vector<MexAllocSiteStats> Report;
+	MexAllocProfiler::getReport(Report);
+	UNITTEST_CHECK(TotalFinalCapacity(Report) == 8*sizeof(uint32_t));
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "AllocProfiler.VectorGrowth", TestVectorGrowth },
+		{ "AllocProfiler.VectorSwap"  , TestVectorSwap },
+		{ "AllocProfiler.MatrixSwap"  , TestMatrixSwap },
+		{ "AllocProfiler.SwapExternal", TestSwapExternal },
+	};
+	return RunUnitTests(Tests);
+}
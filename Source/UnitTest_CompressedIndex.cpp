@@ -0,0 +1,133 @@
+// Unit tests of CompressedIndex: compression round trips over the block
+// widths (0 to 64 bits), random access, block decoding and the compressed
+// assignment of a FlatVectTree.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <random>
+
+#include "UnitTest.hpp"
+#include "../Headers/FlatVectTree/FlatVectTree.hpp"
+
+static std::mt19937_64 Generator(20151102);
+
+// Returns NIndices non-decreasing indices whose increments are below
+// MaxIncrement (with occasional jumps of JumpSize)
+template <typename IndexT>
+static MexVector<IndexT> RandomIndex(size_t NIndices, uint64_t MaxIncrement, uint64_t JumpSize = 0) {
+	MexVector<IndexT> Index(NIndices);
+	uint64_t Curr = 0;
+	for (size_t i = 0; i < NIndices; ++i) {
+		Curr += std::uniform_int_distribution<uint64_t>(0, MaxIncrement - 1)(Generator);
+		if (JumpSize && i % 97 == 13)
+			Curr += JumpSize;
+		Index[i] = IndexT(Curr);
+	}
+	return Index;
+}
+
+template <typename IndexT>
+static bool isRoundTripExact(const MexVector<IndexT> &Index) {
+	CompressedIndex<IndexT> Compressed(Index);
+	if (Compressed.size() != Index.size())
+		return false;
+
+	MexVector<IndexT> Decompressed;
+	Compressed.decompress(Decompressed);
+	if (Decompressed.size() != Index.size())
+		return false;
+	for (size_t i = 0; i < Index.size(); ++i)
+		if (Decompressed[i] != Index[i] || Compressed[i] != Index[i])
+			return false;
+
+	IndexT Block[CompressedIndex<IndexT>::BLOCK_SIZE];
+	for (size_t b = 0; b < Compressed.nBlocks(); ++b) {
+		Compressed.decodeBlock(b, Block);
+		for (size_t j = 0; j < CompressedIndex<IndexT>::BLOCK_SIZE; ++j) {
+			size_t i = b*CompressedIndex<IndexT>::BLOCK_SIZE + j;
+			if (i < Index.size() && Block[j] != Index[i])
+				return false;
+		}
+	}
+	return true;
+}
+
+static void TestRoundTrip32() {
+	// Sizes around the block boundaries, and increments giving widths from 0
+	// (constant blocks) to 32 bits
+	size_t Sizes[] = { 0, 1, 127, 128, 129, 1000, 100000 };
+	uint64_t MaxIncrements[] = { 1, 2, 16, 1000, uint64_t(1) << 24 };
+	for (size_t NIndices : Sizes)
+		for (uint64_t MaxIncrement : MaxIncrements)
+			UNITTEST_CHECK(isRoundTripExact(RandomIndex<uint32_t>(NIndices, MaxIncrement)));
+
+	// Maximal offsets (the whole 32-bit range within a block)
+	MexVector<uint32_t> Extremes = { 0, 0, uint32_t(-1), uint32_t(-1) };
+	UNITTEST_CHECK(isRoundTripExact(Extremes));
+}
+
+static void TestRoundTrip64() {
+	// Offsets within a block that exceed 32 bits are stored unpacked
+	UNITTEST_CHECK(isRoundTripExact(RandomIndex<uint64_t>(1000, 100)));
+	UNITTEST_CHECK(isRoundTripExact(RandomIndex<uint64_t>(1000, 100, uint64_t(1) << 40)));
+	UNITTEST_CHECK(isRoundTripExact(RandomIndex<uint64_t>(300, uint64_t(1) << 50)));
+}
+
+static void TestCompression() {
+	// An index of tiny leaves needs a few bits per index
+	MexVector<uint32_t> Index = RandomIndex<uint32_t>(100000, 4);
+	CompressedIndex<uint32_t> Compressed(Index);
+	UNITTEST_CHECK(Compressed.memoryBytes() < Index.size()*sizeof(uint32_t)/2);
+
+	UNITTEST_CHECK(Compressed.at(99999) == Index[99999]);
+	UNITTEST_CHECK_THROWS(Compressed.at(100000), ExOps::EXCEPTION_INVALID_INPUT);
+}
+
+static void TestFlatVectTree() {
+	MexVector<MexVector<MexVector<float> > > Nested(500);
+	for (size_t i = 0; i < Nested.size(); ++i) {
+		Nested[i].resize(i % 5);
+		for (size_t j = 0; j < Nested[i].size(); ++j)
+			Nested[i][j].resize((i + j) % 7, float(i));
+	}
+	FlatVectTree<float> FlatTree;
+	FlatTree.build(Nested);
+
+	MexVector<CompressedIndex<uint32_t> > Compressed;
+	FlatTree.compressIndex(Compressed);
+	UNITTEST_CHECK(Compressed.size() == 2);
+
+	FlatVectTree<float> Copy;
+	MexVector<MexVector<uint32_t> > PartitionIndex;
+	MexVector<float> Data;
+	Copy.assign(FlatTree);
+	Copy.releaseMem(PartitionIndex, Data);
+	FlatVectTree<float> Restored;
+	Restored.assign(Compressed, Data);
+
+	MexVector<MexVector<MexVector<float> > > RestoredNested;
+	Restored.getVectTree(RestoredNested);
+	bool isEqual = RestoredNested.size() == Nested.size();
+	for (size_t i = 0; isEqual && i < Nested.size(); ++i) {
+		isEqual = RestoredNested[i].size() == Nested[i].size();
+		for (size_t j = 0; isEqual && j < Nested[i].size(); ++j)
+			isEqual = RestoredNested[i][j].size() == Nested[i][j].size()
+			          && std::equal(Nested[i][j].begin(), Nested[i][j].end(), RestoredNested[i][j].begin());
+	}
+	UNITTEST_CHECK(isEqual);
+
+	// The data must match the compressed index
+	Data.push_back(0.0f);
+	UNITTEST_CHECK_THROWS(Restored.assign(Compressed, Data), FV_INVALID_APPEND);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "CompressedIndex.RoundTrip32" , TestRoundTrip32 },
+		{ "CompressedIndex.RoundTrip64" , TestRoundTrip64 },
+		{ "CompressedIndex.Compression" , TestCompression },
+		{ "CompressedIndex.FlatVectTree", TestFlatVectTree },
+	};
+	return RunUnitTests(Tests);
+}
@@ -0,0 +1,176 @@
+// Unit tests of the conversions between mxArrays and the containers
+// (MexVector, MexMatrix, nested MexVectors and FlatVectTree), as used by a
+// MEX_EXE program. Each container is returned as an mxArray and read back.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+
+#include "UnitTest.hpp"
+#include "../Headers/GenericMexIO.hpp"
+#include "../Headers/FlatVectTree/FlatVectTree.hpp"
+
+typedef MexVector<MexVector<MexVector<uint32_t> > > Tree3Type;
+
+static void getTree(Tree3Type &Tree) {
+	Tree.resize(50);
+	for (size_t i = 0; i < Tree.size(); ++i) {
+		Tree[i].resize(i % 3);
+		for (size_t j = 0; j < Tree[i].size(); ++j)
+			for (size_t k = 0; k < (i + j) % 5; ++k)
+				Tree[i][j].push_back(uint32_t(i*100 + j*10 + k));
+	}
+}
+
+static bool isEqual(const Tree3Type &A, const Tree3Type &B) {
+	if (A.size() != B.size())
+		return false;
+	for (size_t i = 0; i < A.size(); ++i) {
+		if (A[i].size() != B[i].size())
+			return false;
+		for (size_t j = 0; j < A[i].size(); ++j)
+			if (A[i][j].size() != B[i][j].size() || !std::equal(A[i][j].begin(), A[i][j].end(), B[i][j].begin()))
+				return false;
+	}
+	return true;
+}
+
+static void TestVectorRoundTrip() {
+	MexVector<int32_t> Vect(1000);
+	for (size_t i = 0; i < Vect.size(); ++i)
+		Vect[i] = int32_t(i) - 500;
+
+	mxArray* Array = assignmxArray(Vect);
+	UNITTEST_CHECK(Vect.isempty());
+	UNITTEST_CHECK(mxGetClassID(Array) == mxINT32_CLASS && mxGetNumberOfElements(Array) == 1000);
+
+	MexVector<int32_t> VectIn;
+	getInputfrommxArray<int32_t>(Array, VectIn);
+	bool isVectEqual = VectIn.size() == 1000;
+	for (size_t i = 0; isVectEqual && i < VectIn.size(); ++i)
+		isVectEqual = VectIn[i] == int32_t(i) - 500;
+	UNITTEST_CHECK(isVectEqual);
+	mxDestroyArray(Array);
+}
+
+static void TestMatrixRoundTrip() {
+	// Each row of the MexMatrix is a column of the mxArray
+	MexMatrix<double> Matrix(4, 9);
+	for (size_t i = 0; i < 4; ++i)
+		for (size_t j = 0; j < 9; ++j)
+			Matrix(i, j) = i*9.0 + j;
+
+	mxArray* Array = assignmxArray(Matrix);
+	UNITTEST_CHECK(mxGetM(Array) == 9 && mxGetN(Array) == 4);
+	UNITTEST_CHECK(mxGetPr(Array)[9*2 + 5] == 2*9.0 + 5);
+
+	MexMatrix<double> MatrixIn;
+	getInputfrommxArray<double>(Array, MatrixIn);
+	UNITTEST_CHECK(MatrixIn.nrows() == 4 && MatrixIn.ncols() == 9);
+	UNITTEST_CHECK(MatrixIn(3, 8) == 3*9.0 + 8 && MatrixIn(1, 0) == 9.0);
+	mxDestroyArray(Array);
+}
+
+static void TestMatrixPushRow() {
+	MexMatrix<double> Matrix(0, 3);
+	MexVector<double> Row(3);
+	for (size_t i = 0; i < 100; ++i) {
+		Row[0] = i; Row[1] = i + 0.5; Row[2] = -double(i);
+		Matrix.push_row(Row);
+	}
+	UNITTEST_CHECK(Matrix.nrows() == 100 && Matrix.ncols() == 3);
+	UNITTEST_CHECK(Matrix(57, 0) == 57 && Matrix(57, 1) == 57.5 && Matrix(99, 2) == -99);
+
+	// A matrix with no columns takes empty rows
+	MexMatrix<double> EmptyCols;
+	MexVector<double> EmptyRow;
+	EmptyCols.push_row(EmptyRow);
+	EmptyCols.push_row_size(4);
+	UNITTEST_CHECK(EmptyCols.nrows() == 5 && EmptyCols.ncols() == 0);
+}
+
+static void TestCellArrayRoundTrip() {
+	Tree3Type Tree, Expected;
+	getTree(Tree);
+	getTree(Expected);
+
+	mxArray* Array = assignmxArray(Tree);
+	UNITTEST_CHECK(mxIsCell(Array) && mxGetNumberOfElements(Array) == 50);
+
+	Tree3Type TreeIn;
+	getInputfrommxArray(Array, TreeIn);
+	UNITTEST_CHECK(isEqual(TreeIn, Expected));
+
+	// The same cell array read into a FlatVectTree
+	FlatVectTree<uint32_t> FlatTree;
+	getInputfromCellArray(Array, FlatTree, 2);
+	Tree3Type FlatNested;
+	FlatTree.getVectTree(FlatNested);
+	UNITTEST_CHECK(isEqual(FlatNested, Expected));
+
+	// Cell arrays of a different depth or class are rejected
+	FlatVectTree<uint32_t> FlatTree2;
+	FlatVectTree<float> FloatTree;
+	UNITTEST_CHECK(!getCheckedInputfromCellArray(Array, FlatTree2, 1));
+	UNITTEST_CHECK(!getCheckedInputfromCellArray(Array, FloatTree, 2));
+	mxDestroyArray(Array);
+
+	// A FlatVectTree returned as a cell array
+	mxArray* CellArray = assignmxCellArray(FlatTree);
+	Tree3Type CellNested;
+	getInputfrommxArray(CellArray, CellNested);
+	UNITTEST_CHECK(isEqual(CellNested, Expected));
+	mxDestroyArray(CellArray);
+}
+
+static void TestFlatCellArrayRoundTrip() {
+	Tree3Type Tree, Expected;
+	getTree(Tree);
+	getTree(Expected);
+
+	// Nested vectors returned directly as a FlatCellArray
+	mxArray* Array = assignmxFlatCellArray(Tree);
+	UNITTEST_CHECK(mxIsStruct(Array));
+
+	FlatVectTree<uint32_t> FlatTree;
+	getInputfrommxArray(Array, FlatTree);
+	Tree3Type FlatNested;
+	FlatTree.getVectTree(FlatNested);
+	UNITTEST_CHECK(isEqual(FlatNested, Expected));
+	mxDestroyArray(Array);
+
+	// A FlatVectTree of 64-bit indices
+	FlatVectTree<uint32_t, mxAllocator, uint64_t> FlatTree64;
+	FlatTree64.build(Expected);
+	Array = assignmxArray(FlatTree64);
+	UNITTEST_CHECK((FieldInfo<FlatVectTree<uint32_t, mxAllocator, uint64_t> >::getSize(Array) == 50));
+	UNITTEST_CHECK((FieldInfo<FlatVectTree<uint32_t, mxAllocator, uint64_t> >::getDepth(Array) == 2));
+	FlatVectTree<uint32_t, mxAllocator, uint64_t> FlatTree64In;
+	getInputfrommxArray(Array, FlatTree64In);
+	Tree3Type FlatNested64;
+	FlatTree64In.getVectTree(FlatNested64);
+	UNITTEST_CHECK(isEqual(FlatNested64, Expected));
+
+	// An empty mxArray gives an empty FlatVectTree
+	mxArray* EmptyArray = mxCreateDoubleMatrix(0, 0, mxREAL);
+	UNITTEST_CHECK(getCheckedInputfrommxArray(EmptyArray, FlatTree64In, false));
+	UNITTEST_CHECK(FlatTree64In.isempty() && FlatTree64In.depth() == 2 && FlatTree64In.LevelSize(1) == 0);
+	mxDestroyArray(EmptyArray);
+
+	// A FlatCellArray of a different index or data type is rejected
+	UNITTEST_CHECK_THROWS(getInputfrommxArray(Array, FlatTree), ExOps::EXCEPTION_INVALID_INPUT);
+	FlatVectTree<float, mxAllocator, uint64_t> FloatTree;
+	UNITTEST_CHECK_THROWS(getInputfrommxArray(Array, FloatTree), ExOps::EXCEPTION_INVALID_INPUT);
+	mxDestroyArray(Array);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "ExeInterface.VectorRoundTrip"       , TestVectorRoundTrip },
+		{ "ExeInterface.MatrixRoundTrip"       , TestMatrixRoundTrip },
+		{ "ExeInterface.MatrixPushRow"         , TestMatrixPushRow },
+		{ "ExeInterface.CellArrayRoundTrip"    , TestCellArrayRoundTrip },
+		{ "ExeInterface.FlatCellArrayRoundTrip", TestFlatCellArrayRoundTrip },
+	};
+	return RunUnitTests(Tests);
+}
@@ -0,0 +1,469 @@
+// Unit tests of the FlatVectTree construction and restructuring functions
+// (build, append_batch, filter, extract, group_by and FlatVectTreeBuilder)
+// and of the sharding and parallel leaf functions. Each result is compared
+// with the same operation performed on nested MexVectors.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "UnitTest.hpp"
+#include "../Headers/FlatVectTree/FlatVectTree.hpp"
+#include "../Headers/FlatVectTree/FlatVectTreeBuilder.hpp"
+
+typedef MexVector<float> LeafType;
+typedef MexVector<LeafType> Tree2Type;
+typedef MexVector<Tree2Type> Tree3Type;
+
+static std::mt19937 Generator(20151102);
+
+static size_t RandomSize(size_t MaxSize) {
+	// Empty elements are made frequent as they are the usual corner case
+	size_t Size = std::uniform_int_distribution<size_t>(0, MaxSize)(Generator);
+	return (Size % 4 == 0) ? 0 : Size;
+}
+
+static void RandomLeaf(LeafType &Leaf, size_t MaxSize) {
+	Leaf.resize(RandomSize(MaxSize));
+	for (float &Elem : Leaf)
+		Elem = float(std::uniform_int_distribution<int>(0, 1000)(Generator));
+}
+static void RandomTree(Tree2Type &Tree, size_t NElems, size_t MaxSize) {
+	Tree.resize(NElems);
+	for (LeafType &Leaf : Tree)
+		RandomLeaf(Leaf, MaxSize);
+}
+static void RandomTree(Tree3Type &Tree, size_t NElems, size_t MaxSize) {
+	Tree.resize(NElems);
+	for (Tree2Type &SubTree : Tree)
+		RandomTree(SubTree, RandomSize(MaxSize), MaxSize);
+}
+
+template <typename TreeType>
+static TreeType getNested(FlatVectTree<float> &FlatTree) {
+	TreeType Nested;
+	FlatTree.getVectTree(Nested);
+	return Nested;
+}
+
+static bool isEqual(const LeafType &A, const LeafType &B) {
+	return A.size() == B.size() && std::equal(A.begin(), A.end(), B.begin());
+}
+template <typename SubElemT>
+static bool isEqual(const MexVector<SubElemT> &A, const MexVector<SubElemT> &B) {
+	if (A.size() != B.size())
+		return false;
+	for (size_t i = 0; i < A.size(); ++i)
+		if (!isEqual(A[i], B[i]))
+			return false;
+	return true;
+}
+
+static void TestBuildRoundTrip() {
+	Tree3Type Nested;
+	RandomTree(Nested, 200, 8);
+
+	FlatVectTree<float> FlatTree;
+	FlatTree.build(Nested);
+	UNITTEST_CHECK(FlatTree.depth() == 2);
+	UNITTEST_CHECK(isEqual(getNested<Tree3Type>(FlatTree), Nested));
+
+	FlatVectTree<float, mxAllocator, uint64_t> FlatTree64;
+	FlatTree64.build(Nested);
+	Tree3Type Nested64;
+	FlatTree64.getVectTree(Nested64);
+	UNITTEST_CHECK(isEqual(Nested64, Nested));
+
+	// Levels too large for the index type are rejected (instead of wrapping
+	// around)
+	FlatVectTree<float, mxAllocator, uint8_t> FlatTree8;
+	Tree2Type WideTree(256), DeepTree(2, LeafType(128, 1.0f));
+	UNITTEST_CHECK_THROWS(FlatTree8.build(WideTree), FV_INVALID_APPEND);
+	UNITTEST_CHECK_THROWS(FlatTree8.build(DeepTree), FV_INVALID_APPEND);
+	DeepTree[1].pop_back();
+	FlatTree8.build(DeepTree);
+	UNITTEST_CHECK(FlatTree8.depth() == 1 && FlatTree8.LevelSize(0) == 2);
+
+	// Empty trees and trees of empty elements
+	Tree3Type EmptyNested(5);
+	FlatTree.build(EmptyNested);
+	UNITTEST_CHECK(isEqual(getNested<Tree3Type>(FlatTree), EmptyNested));
+}
+
+static void TestAppendBatch() {
+	Tree3Type Initial, Batch0, Batch1;
+	RandomTree(Initial, 20, 6);
+	RandomTree(Batch0, 50, 6);
+	RandomTree(Batch1, 50, 6);
+
+	// Batch appending is equivalent to appending each tree in turn
+	FlatVectTree<float> Batched, Sequential;
+	Batched.build(Initial);
+	Sequential.build(Initial);
+	MexVector<Tree3Type> Batches = { Batch0, Batch1 };
+	Batched.append_batch(Batches);
+	Sequential.append(Batch0);
+	Sequential.append(Batch1);
+	UNITTEST_CHECK(isEqual(getNested<Tree3Type>(Batched), getNested<Tree3Type>(Sequential)));
+
+	// Appending sub-trees at a given insert depth
+	MexVector<Tree2Type> SubTrees = { Batch0[0], Batch0[1], Batch1[2] };
+	Batched.append_batch(SubTrees, 1);
+	for (const Tree2Type &SubTree : SubTrees)
+		Sequential.append(SubTree, 1);
+	UNITTEST_CHECK(isEqual(getNested<Tree3Type>(Batched), getNested<Tree3Type>(Sequential)));
+
+	// Empty sub-trees (which change the actual insert depth of the next
+	// tree), moved into the batch
+	MexVector<Tree2Type> MixedTrees = { Tree2Type(), Batch1[3], Tree2Type(), Tree2Type(), Batch0[4] };
+	for (const Tree2Type &SubTree : MixedTrees)
+		Sequential.append(SubTree, 1);
+	Batched.append_batch(std::move(MixedTrees), 1);
+	UNITTEST_CHECK(MixedTrees.size() == 0);
+	UNITTEST_CHECK(isEqual(getNested<Tree3Type>(Batched), getNested<Tree3Type>(Sequential)));
+}
+
+static void TestExtract() {
+	Tree3Type Nested;
+	RandomTree(Nested, 100, 6);
+	FlatVectTree<float> FlatTree;
+	FlatTree.build(Nested);
+
+	// Level 0, with repetitions and in arbitrary order
+	MexVector<uint32_t> Indices = { 5, 3, 3, 99, 0, 42 };
+	FlatVectTree<float> Extracted;
+	FlatTree.extract(Extracted, 0, Indices);
+	Tree3Type Expected;
+	for (uint32_t Index : Indices)
+		Expected.push_back(Nested[Index]);
+	UNITTEST_CHECK(isEqual(getNested<Tree3Type>(Extracted), Expected));
+
+	// Level 1 (indexing the concatenation of the elements of level 1)
+	Tree2Type Level1;
+	for (const Tree2Type &SubTree : Nested)
+		for (const LeafType &Leaf : SubTree)
+			Level1.push_back(Leaf);
+	MexVector<uint32_t> Indices1;
+	for (uint32_t i = 0; i < Level1.size(); i += 3)
+		Indices1.push_back(uint32_t(Level1.size()) - 1 - i);
+	FlatTree.extract(Extracted, 1, Indices1);
+	Tree2Type Expected1;
+	for (uint32_t Index : Indices1)
+		Expected1.push_back(Level1[Index]);
+	UNITTEST_CHECK(Extracted.depth() == 1);
+	UNITTEST_CHECK(isEqual(getNested<Tree2Type>(Extracted), Expected1));
+
+	// Invalid indices
+	MexVector<uint32_t> InvalidIndices = { 0, 100 };
+	UNITTEST_CHECK_THROWS(FlatTree.extract(Extracted, 0, InvalidIndices), FV_INVALID_FILTER);
+	UNITTEST_CHECK_THROWS(FlatTree.extract(Extracted, 3, Indices), FV_INVALID_FILTER);
+}
+
+static void TestFilter() {
+	Tree3Type Nested;
+	RandomTree(Nested, 100, 6);
+
+	// Level 0 by indices (repetitions ignored, order preserved)
+	{
+		FlatVectTree<float> FlatTree;
+		FlatTree.build(Nested);
+		MexVector<uint32_t> Indices = { 42, 7, 7, 99, 0 };
+		FlatTree.filter(0, Indices);
+		Tree3Type Expected = { Nested[0], Nested[7], Nested[42], Nested[99] };
+		UNITTEST_CHECK(isEqual(getNested<Tree3Type>(FlatTree), Expected));
+	}
+
+	// Level 1 by mask (every top level element is retained, keeping only its
+	// selected children)
+	{
+		FlatVectTree<float> FlatTree;
+		FlatTree.build(Nested);
+		MexVector<bool> Mask;
+		Tree3Type Expected(Nested.size());
+		for (size_t i = 0; i < Nested.size(); ++i) {
+			for (const LeafType &Leaf : Nested[i]) {
+				bool isSelected = std::uniform_int_distribution<int>(0, 1)(Generator) != 0;
+				Mask.push_back(isSelected);
+				if (isSelected)
+					Expected[i].push_back(Leaf);
+			}
+		}
+		FlatTree.filter(1, Mask);
+		UNITTEST_CHECK(isEqual(getNested<Tree3Type>(FlatTree), Expected));
+	}
+
+	// The leaf data by mask
+	{
+		FlatVectTree<float> FlatTree;
+		FlatTree.build(Nested);
+		Tree3Type Expected(Nested.size());
+		MexVector<bool> Mask;
+		for (size_t i = 0; i < Nested.size(); ++i) {
+			Expected[i].resize(Nested[i].size());
+			for (size_t j = 0; j < Nested[i].size(); ++j) {
+				for (float Elem : Nested[i][j]) {
+					Mask.push_back(Elem >= 500);
+					if (Elem >= 500)
+						Expected[i][j].push_back(Elem);
+				}
+			}
+		}
+		FlatTree.filter(2, Mask);
+		UNITTEST_CHECK(isEqual(getNested<Tree3Type>(FlatTree), Expected));
+
+		MexVector<bool> ShortMask(3, true);
+		UNITTEST_CHECK_THROWS(FlatTree.filter(0, ShortMask), FV_INVALID_FILTER);
+	}
+}
+
+static void TestGroupBy() {
+	// Large enough to use the blocked (parallel) counting
+	size_t NValues = 100000;
+	MexVector<int32_t> Keys(NValues);
+	MexVector<float> Values(NValues);
+	for (size_t i = 0; i < NValues; ++i) {
+		Keys[i] = std::uniform_int_distribution<int32_t>(0, 999)(Generator);
+		Values[i] = float(std::uniform_int_distribution<int>(0, 1000000)(Generator));
+	}
+
+	Tree2Type Expected(1000);
+	for (size_t i = 0; i < NValues; ++i)
+		Expected[Keys[i]].push_back(Values[i]);
+
+	FlatVectTree<float> Grouped;
+	Grouped.group_by(Keys, Values);
+	UNITTEST_CHECK(Grouped.depth() == 1);
+	UNITTEST_CHECK(isEqual(getNested<Tree2Type>(Grouped), Expected));
+
+	// Explicit number of groups (the trailing groups being empty), sorted
+	Grouped.group_by(Keys, Values, 1010, true);
+	Expected.resize(1010);
+	for (LeafType &Group : Expected)
+		std::sort(Group.begin(), Group.end());
+	UNITTEST_CHECK(isEqual(getNested<Tree2Type>(Grouped), Expected));
+
+	// Small input (serial path)
+	MexVector<uint8_t> SmallKeys = { 2, 0, 2, 2, 0 };
+	MexVector<float> SmallValues = { 1, 2, 3, 4, 5 };
+	Grouped.group_by(SmallKeys, SmallValues);
+	Tree2Type SmallExpected = { LeafType{ 2, 5 }, LeafType(), LeafType{ 1, 3, 4 } };
+	UNITTEST_CHECK(isEqual(getNested<Tree2Type>(Grouped), SmallExpected));
+
+	// Invalid keys
+	MexVector<int32_t> NegativeKeys = { 0, -1 };
+	MexVector<float> TwoValues = { 1, 2 };
+	UNITTEST_CHECK_THROWS(Grouped.group_by(NegativeKeys, TwoValues), FV_INVALID_GROUP);
+	UNITTEST_CHECK_THROWS(Grouped.group_by(SmallKeys, SmallValues, 2), FV_INVALID_GROUP);
+	UNITTEST_CHECK_THROWS(Grouped.group_by(SmallKeys, TwoValues), FV_INVALID_GROUP);
+}
+
+static void TestBuilderMerge() {
+	size_t NTasks = 300, NBuilders = 4;
+	MexVector<Tree2Type> TaskTrees(NTasks);
+	for (Tree2Type &TaskTree : TaskTrees)
+		RandomTree(TaskTree, RandomSize(4), 6);
+
+	// The tasks are distributed over the builders in a shuffled order, each
+	// task pushing a variable number (possibly 0) of top level elements
+	std::vector<size_t> TaskOrder(NTasks);
+	for (size_t i = 0; i < NTasks; ++i)
+		TaskOrder[i] = i;
+	std::shuffle(TaskOrder.begin(), TaskOrder.end(), Generator);
+
+	std::vector<FlatVectTreeBuilder<float> > Builders(NBuilders, FlatVectTreeBuilder<float>(1));
+	Tree2Type BuilderOrderExpected[4];
+	for (size_t i = 0; i < NTasks; ++i) {
+		size_t Task = TaskOrder[i], b = i % NBuilders;
+		for (const LeafType &Leaf : TaskTrees[Task]) {
+			Builders[b].push_back(Leaf, Task);
+			BuilderOrderExpected[b].push_back(Leaf);
+		}
+	}
+
+	// In task order, the result is that of the sequential loop
+	FlatVectTree<float> Merged;
+	FlatVectTreeBuilder<float>::merge(Builders, Merged, true);
+	Tree2Type Expected;
+	for (const Tree2Type &TaskTree : TaskTrees)
+		for (const LeafType &Leaf : TaskTree)
+			Expected.push_back(Leaf);
+	UNITTEST_CHECK(isEqual(getNested<Tree2Type>(Merged), Expected));
+
+	// Otherwise, the builders are concatenated in order
+	FlatVectTreeBuilder<float>::merge(Builders, Merged, false);
+	Expected.clear();
+	for (const Tree2Type &BuilderExpected : BuilderOrderExpected)
+		for (const LeafType &Leaf : BuilderExpected)
+			Expected.push_back(Leaf);
+	UNITTEST_CHECK(isEqual(getNested<Tree2Type>(Merged), Expected));
+
+	// Builders of different depths cannot be merged
+	Builders.push_back(FlatVectTreeBuilder<float>(2));
+	UNITTEST_CHECK_THROWS(FlatVectTreeBuilder<float>::merge(Builders, Merged), FV_INVALID_APPEND);
+}
+
+typedef MexVector<FlatVectTreeView<float>, CAllocator> ShardsType;
+
+// Checks that the shards are non-empty, contiguous ranges covering the
+// LevelSize elements of their level exactly once
+static bool isShardCover(const ShardsType &Shards, size_t LevelSize) {
+	size_t NextBeg = 0;
+	for (const FlatVectTreeView<float> &Shard : Shards) {
+		if (Shard.levelBeg() != NextBeg || Shard.isempty())
+			return false;
+		NextBeg = Shard.levelEnd();
+	}
+	return NextBeg == LevelSize;
+}
+
+// The weight of a shard of leaves (the elements in the leaves plus one per
+// leaf, as used by shard)
+static size_t getLeafShardWeight(const FlatVectTreeView<float> &Shard) {
+	size_t Weight = Shard.size();
+	for (size_t i = 0; i < Shard.size(); ++i)
+		Weight += Shard[i].size();
+	return Weight;
+}
+
+static void TestShard() {
+	Tree3Type Nested;
+	RandomTree(Nested, 300, 8);
+	FlatVectTree<float> FlatTree;
+	FlatTree.build(Nested);
+
+	// By default the leaves (Level 1) are sharded
+	ShardsType Shards;
+	FlatTree.shard(Shards, 8);
+	UNITTEST_CHECK(Shards.size() <= 8 && isShardCover(Shards, FlatTree.LevelSize(1)));
+	UNITTEST_CHECK(Shards.size() == 0 || Shards[0].level() == 1);
+	FlatTree.shard(Shards, 8, 0);
+	UNITTEST_CHECK(Shards.size() <= 8 && isShardCover(Shards, FlatTree.LevelSize(0)));
+	size_t NData = 0;
+	for (const Tree2Type &SubTree : Nested)
+		for (const LeafType &Leaf : SubTree)
+			NData += Leaf.size();
+	FlatTree.shard(Shards, 8, 2);
+	UNITTEST_CHECK(Shards.size() <= 8 && isShardCover(Shards, NData));
+	UNITTEST_CHECK_THROWS(FlatTree.shard(Shards, 8, 3), FV_INVALID_FETCH);
+
+	// More shards than top level elements give one shard per element at most
+	Tree3Type SmallNested;
+	RandomTree(SmallNested, 5, 8);
+	FlatVectTree<float> SmallTree;
+	SmallTree.build(SmallNested);
+	SmallTree.shard(Shards, 64, 0);
+	UNITTEST_CHECK(Shards.size() <= 5 && isShardCover(Shards, 5));
+
+	// Skewed leaf sizes: every 50th leaf is 500 times larger than the
+	// others. As no leaf outweighs the average shard, there are exactly
+	// NShards shards, none heavier than the average by more than the
+	// heaviest leaf.
+	Tree2Type Skewed(1000);
+	for (size_t i = 0; i < Skewed.size(); ++i)
+		Skewed[i].resize((i % 50 == 0) ? 500 : 1, float(i));
+	FlatVectTree<float> SkewedTree;
+	SkewedTree.build(Skewed);
+	uint32_t NShards = 16;
+	SkewedTree.shard(Shards, NShards);
+	size_t TotalWeight = 20*500 + 980 + Skewed.size();
+	size_t MaxShardWeight = 0;
+	for (const FlatVectTreeView<float> &Shard : Shards)
+		MaxShardWeight = std::max(MaxShardWeight, getLeafShardWeight(Shard));
+	UNITTEST_CHECK(Shards.size() == NShards && isShardCover(Shards, Skewed.size()));
+	UNITTEST_CHECK(MaxShardWeight <= TotalWeight / NShards + 501);
+
+	// Empty trees give no shards
+	FlatVectTree<float> EmptyTree;
+	EmptyTree.shard(Shards, 8);
+	UNITTEST_CHECK(Shards.size() == 0);
+	FlatVectTree<float> EmptyTree2;
+	EmptyTree2.build(Tree3Type());
+	EmptyTree2.shard(Shards, 8);
+	UNITTEST_CHECK(Shards.size() == 0);
+}
+
+static void TestParallelLeaves() {
+	// Large enough to be processed in parallel
+	Tree3Type Nested;
+	RandomTree(Nested, 4000, 16);
+	FlatVectTree<float> FlatTree;
+	FlatTree.build(Nested);
+
+	// Each leaf is visited exactly once, with its own span
+	size_t NLeaves = FlatTree.LevelSize(1);
+	std::vector<int> NVisits(NLeaves, 0);
+	std::vector<size_t> LeafSizes(NLeaves, 0);
+	FlatTree.parallel_for_each_leaf([&](uint32_t LeafIndex, const FlatVectTreeSpan<float> &Leaf) {
+		NVisits[LeafIndex]++;
+		LeafSizes[LeafIndex] = Leaf.size();
+	});
+	bool isVisitedOnce = true;
+	size_t LeafIndex = 0;
+	for (const Tree2Type &SubTree : Nested)
+		for (const LeafType &Leaf : SubTree) {
+			isVisitedOnce &= NVisits[LeafIndex] == 1 && LeafSizes[LeafIndex] == Leaf.size();
+			LeafIndex++;
+		}
+	UNITTEST_CHECK(LeafIndex == NLeaves && isVisitedOnce);
+
+	// The map is that of the serial loop (each output element depending on
+	// its position in the leaf)
+	FlatVectTree<double> Mapped;
+	FlatTree.parallel_map_leaves(Mapped, [](const FlatVectTreeSpan<float> &Leaf, double* LeafOut) {
+		for (size_t i = 0; i < Leaf.size(); ++i)
+			LeafOut[i] = 2.0*Leaf[i] + double(i);
+	});
+	MexVector<MexVector<MexVector<double> > > MappedNested;
+	Mapped.getVectTree(MappedNested);
+	bool isMapEqual = MappedNested.size() == Nested.size();
+	for (size_t i = 0; isMapEqual && i < Nested.size(); ++i) {
+		isMapEqual = MappedNested[i].size() == Nested[i].size();
+		for (size_t j = 0; isMapEqual && j < Nested[i].size(); ++j) {
+			isMapEqual = MappedNested[i][j].size() == Nested[i][j].size();
+			for (size_t k = 0; isMapEqual && k < Nested[i][j].size(); ++k)
+				isMapEqual = MappedNested[i][j][k] == 2.0*Nested[i][j][k] + double(k);
+		}
+	}
+	UNITTEST_CHECK(isMapEqual);
+
+	// The map can be performed in place
+	FlatTree.parallel_map_leaves(FlatTree, [](const FlatVectTreeSpan<float> &Leaf, float* LeafOut) {
+		for (size_t i = 0; i < Leaf.size(); ++i)
+			LeafOut[i] = -Leaf[i];
+	});
+	Tree3Type NegatedNested;
+	FlatTree.getVectTree(NegatedNested);
+	for (Tree2Type &SubTree : Nested)
+		for (LeafType &Leaf : SubTree)
+			for (float &Elem : Leaf)
+				Elem = -Elem;
+	UNITTEST_CHECK(isEqual(NegatedNested, Nested));
+
+	// An empty tree of depth 0 has Data as its only (empty) leaf, and maps to
+	// an empty tree
+	FlatVectTree<float> EmptyTree;
+	size_t NEmptyCalls = 0;
+	EmptyTree.parallel_for_each_leaf([&](uint32_t, const FlatVectTreeSpan<float> &Leaf) {
+		NEmptyCalls += Leaf.isempty() ? 1 : 2;
+	});
+	UNITTEST_CHECK(NEmptyCalls == 1);
+	FlatVectTree<double> EmptyMapped;
+	EmptyTree.parallel_map_leaves(EmptyMapped, [](const FlatVectTreeSpan<float> &, double*) {});
+	UNITTEST_CHECK(EmptyMapped.istrulyempty());
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "FlatVectTree.BuildRoundTrip", TestBuildRoundTrip },
+		{ "FlatVectTree.AppendBatch"   , TestAppendBatch },
+		{ "FlatVectTree.Extract"       , TestExtract },
+		{ "FlatVectTree.Filter"        , TestFilter },
+		{ "FlatVectTree.GroupBy"       , TestGroupBy },
+		{ "FlatVectTree.BuilderMerge"  , TestBuilderMerge },
+		{ "FlatVectTree.Shard"         , TestShard },
+		{ "FlatVectTree.ParallelLeaves", TestParallelLeaves },
+	};
+	return RunUnitTests(Tests);
+}
@@ -0,0 +1,168 @@
+// Unit tests of FlatVectTreeView and FlatVectTreeSpan: navigation by index
+// and by iterator compared with the nested MexVectors, the checked access
+// functions, views of level ranges, and the output of a view as a cell
+// array.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+
+#include "UnitTest.hpp"
+#include "../Headers/GenericMexIO.hpp"
+#include "../Headers/FlatVectTree/FlatVectTree.hpp"
+
+typedef MexVector<uint32_t> LeafType;
+typedef MexVector<LeafType> Tree2Type;
+typedef MexVector<Tree2Type> Tree3Type;
+typedef FlatVectTreeView<uint32_t> ViewType;
+
+static void getTree(Tree3Type &Tree) {
+	Tree.resize(50);
+	for (size_t i = 0; i < Tree.size(); ++i) {
+		Tree[i].resize(i % 3);
+		for (size_t j = 0; j < Tree[i].size(); ++j)
+			for (size_t k = 0; k < (i + j) % 5; ++k)
+				Tree[i][j].push_back(uint32_t(i*100 + j*10 + k));
+	}
+}
+
+static bool isEqual(const FlatVectTreeSpan<uint32_t> &Span, const LeafType &Leaf) {
+	return Span.size() == Leaf.size() && std::equal(Span.begin(), Span.end(), Leaf.begin());
+}
+
+// Compares using operator[] and span
+static bool isEqualIndexed(const ViewType &View, const Tree3Type &Tree) {
+	if (View.size() != Tree.size() || View.depth() != 2)
+		return false;
+	for (size_t i = 0; i < Tree.size(); ++i) {
+		ViewType SubView = View[i];
+		if (SubView.size() != Tree[i].size() || SubView.depth() != 1 || SubView.level() != 1)
+			return false;
+		for (size_t j = 0; j < Tree[i].size(); ++j)
+			if (!SubView[j].isLeaf() || !isEqual(SubView[j].span(), Tree[i][j]))
+				return false;
+	}
+	return true;
+}
+
+// Compares using the iterators and the checked functions
+static bool isEqualIterated(const ViewType &View, const Tree3Type &Tree) {
+	size_t i = 0;
+	for (ViewType SubView : View) {
+		if (i >= Tree.size() || SubView.size() != Tree[i].size())
+			return false;
+		size_t j = 0;
+		for (ViewType Leaf : SubView) {
+			if (!isEqual(Leaf.checkedSpan(), Tree[i][j]) || !isEqual(View.at(i).at(j).span(), Tree[i][j]))
+				return false;
+			j++;
+		}
+		i++;
+	}
+	return i == Tree.size();
+}
+
+static void TestNavigation() {
+	Tree3Type Expected;
+	getTree(Expected);
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+
+	ViewType View = FlatTree.view();
+	UNITTEST_CHECK(View.level() == 0 && !View.isLeaf() && View.levelBeg() == 0 && View.levelEnd() == 50);
+	UNITTEST_CHECK(isEqualIndexed(View, Expected));
+	UNITTEST_CHECK(isEqualIterated(View, Expected));
+
+	// The children of consecutive elements are consecutive in their level
+	UNITTEST_CHECK(View[4].levelBeg() == View[3].levelEnd() && View[3].isempty());
+	UNITTEST_CHECK(View[5].levelEnd() == View[5].levelBeg() + 2);
+
+	// Iterators remain valid after the view they were obtained from
+	ViewType::iterator It = FlatTree.view()[5].begin();
+	++It;
+	UNITTEST_CHECK(isEqual((*It).span(), Expected[5][1]));
+	ViewType::iterator ItCopy = It++;
+	UNITTEST_CHECK(ItCopy != It && It == FlatTree.view()[5].end());
+}
+
+static void TestCheckedAccess() {
+	Tree3Type Expected;
+	getTree(Expected);
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+	ViewType View = FlatTree.view();
+
+	UNITTEST_CHECK_THROWS(View.at(50), FV_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(View.at(3).at(0), FV_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(View.at(5).at(1).at(0), FV_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(View.at(5).checkedSpan(), FV_INVALID_FETCH);
+
+	FlatVectTreeSpan<uint32_t> Leaf = View.at(5).at(1).checkedSpan();
+	UNITTEST_CHECK(Leaf.size() == 1 && Leaf.at(0) == 510 && Leaf[0] == 510);
+	UNITTEST_CHECK_THROWS(Leaf.at(1), FV_INVALID_FETCH);
+	FlatVectTreeSpan<uint32_t> EmptyLeaf = View.at(5).at(0).checkedSpan();
+	UNITTEST_CHECK(EmptyLeaf.isempty());
+	UNITTEST_CHECK_THROWS(EmptyLeaf.at(0), FV_INVALID_FETCH);
+}
+
+static void TestRangeViews() {
+	Tree3Type Expected;
+	getTree(Expected);
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+
+	// The leaves [2, 6) of Level 1 are the second leaf of the element 2, the
+	// leaf of the element 4 and the 2 leaves of the element 5
+	ViewType Leaves = FlatTree.view(1, 2, 6);
+	UNITTEST_CHECK(Leaves.size() == 4 && Leaves.depth() == 1 && Leaves.level() == 1);
+	UNITTEST_CHECK(isEqual(Leaves[0].span(), Expected[2][1]) && isEqual(Leaves[1].span(), Expected[4][0]));
+	UNITTEST_CHECK(isEqual(Leaves[2].span(), Expected[5][0]) && isEqual(Leaves[3].span(), Expected[5][1]));
+
+	// A range of Data is a leaf
+	ViewType DataRange = FlatTree.view(2, 1, 4);
+	UNITTEST_CHECK(DataRange.isLeaf() && DataRange.size() == 3);
+	UNITTEST_CHECK(DataRange.span()[0] == Expected[2][0][0] && DataRange.span()[2] == Expected[2][1][0]);
+
+	ViewType EmptyRange = FlatTree.view(0, 7, 7);
+	UNITTEST_CHECK(EmptyRange.isempty() && EmptyRange.begin() == EmptyRange.end());
+
+	UNITTEST_CHECK_THROWS(FlatTree.view(3, 0, 0), FV_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(FlatTree.view(0, 5, 4), FV_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(FlatTree.view(0, 0, 51), FV_INVALID_FETCH);
+
+	// A tree of depth 0 is a single leaf
+	LeafType Vect = { 3, 1, 4, 1, 5 };
+	FlatVectTree<uint32_t> FlatVect;
+	FlatVect.build(Vect);
+	UNITTEST_CHECK(FlatVect.view().isLeaf() && isEqual(FlatVect.view().checkedSpan(), Vect));
+}
+
+static void TestCellArrayOutput() {
+	Tree3Type Expected;
+	getTree(Expected);
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+
+	// The sub-tree of an element as a cell array of vectors
+	mxArray* CellArray = assignmxCellArray(FlatTree.view()[5]);
+	Tree2Type SubTree;
+	getInputfrommxArray(CellArray, SubTree);
+	UNITTEST_CHECK(SubTree.size() == 2 && isEqual(FlatTree.view()[5][0].span(), SubTree[0]) && isEqual(FlatTree.view()[5][1].span(), SubTree[1]));
+	mxDestroyArray(CellArray);
+
+	// A leaf as a vector
+	mxArray* LeafArray = assignmxCellArray(FlatTree.view()[8][1]);
+	UNITTEST_CHECK(!mxIsCell(LeafArray) && mxGetNumberOfElements(LeafArray) == Expected[8][1].size());
+	UNITTEST_CHECK(std::equal(Expected[8][1].begin(), Expected[8][1].end(), static_cast<uint32_t*>(mxGetData(LeafArray))));
+	mxDestroyArray(LeafArray);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "FlatVectTreeView.Navigation"     , TestNavigation },
+		{ "FlatVectTreeView.CheckedAccess"  , TestCheckedAccess },
+		{ "FlatVectTreeView.RangeViews"     , TestRangeViews },
+		{ "FlatVectTreeView.CellArrayOutput", TestCellArrayOutput },
+	};
+	return RunUnitTests(Tests);
+}
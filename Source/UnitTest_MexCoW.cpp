@@ -0,0 +1,147 @@
+// Unit tests of MexCoWVector and MexCoWMatrix: the chunk index and offset
+// arithmetic of mut, operator[] and copying (including the partial last
+// chunk), and that the wrapped data is never modified.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <vector>
+
+#include "UnitTest.hpp"
+#include "../Headers/MexCoW.hpp"
+
+static void getSource(std::vector<double> &Source, size_t Size) {
+	Source.resize(Size);
+	for (size_t i = 0; i < Size; ++i)
+		Source[i] = double(i)*0.5 + 1.0;
+}
+
+// Checks that View holds Expected element-wise (through operator[] and
+// getVector)
+static bool isEqual(const MexCoWVector<double> &View, const std::vector<double> &Expected) {
+	if (View.size() != Expected.size())
+		return false;
+	for (size_t i = 0; i < Expected.size(); ++i)
+		if (View[i] != Expected[i])
+			return false;
+	MexVector<double> Copy;
+	View.getVector(Copy);
+	return Copy.size() == Expected.size() && std::equal(Copy.begin(), Copy.end(), Expected.begin());
+}
+
+static void TestSingleChunk() {
+	// Below MEXMEM_COW_CHUNK_THRESHOLD the array is a single chunk whose
+	// length (a power of 2) exceeds the size
+	std::vector<double> Source, Expected;
+	getSource(Source, 1000);
+	getSource(Expected, 1000);
+
+	MexCoWVector<double> View(Source.size(), Source.data());
+	UNITTEST_CHECK(View.nchunks() == 1 && View.ncopiedchunks() == 0);
+	UNITTEST_CHECK(&View[999] == &Source[999]);
+
+	View.mut(0) = -1.0;
+	View.mut(999) = -2.0;
+	Expected[0] = -1.0;
+	Expected[999] = -2.0;
+	UNITTEST_CHECK(View.ncopiedchunks() == 1);
+	UNITTEST_CHECK(isEqual(View, Expected));
+	UNITTEST_CHECK(Source[0] == 1.0 && Source[999] == 999*0.5 + 1.0);
+}
+
+static void TestChunkBoundaries() {
+	// Above the threshold, chunks of ChunkLength elements with a partial
+	// last one
+	const size_t ChunkLength = MEXMEM_COW_CHUNK_SIZE / sizeof(double);
+	const size_t NFullChunks = MEXMEM_COW_CHUNK_THRESHOLD / MEXMEM_COW_CHUNK_SIZE + 4;
+	const size_t Size = NFullChunks*ChunkLength + 123;
+
+	std::vector<double> Source, Original, Expected;
+	getSource(Source, Size);
+	getSource(Original, Size);
+	getSource(Expected, Size);
+
+	MexCoWVector<double> View(Size, Source.data());
+	UNITTEST_CHECK(View.nchunks() == NFullChunks + 1);
+	UNITTEST_CHECK(&View[ChunkLength] == &Source[ChunkLength] && &View[Size - 1] == &Source[Size - 1]);
+
+	// The last element of chunk 0, the first of chunk 1 and the last of the
+	// partial last chunk
+	size_t Writes[] = { ChunkLength - 1, ChunkLength, Size - 1 };
+	for (size_t Index : Writes) {
+		View.mut(Index) = -double(Index);
+		Expected[Index] = -double(Index);
+	}
+	// Writing again into a copied chunk does not copy it again
+	View.mut(ChunkLength + 1) += 100.0;
+	Expected[ChunkLength + 1] += 100.0;
+
+	UNITTEST_CHECK(View.ncopiedchunks() == 3);
+	UNITTEST_CHECK(isEqual(View, Expected));
+	UNITTEST_CHECK(&View[2*ChunkLength] == &Source[2*ChunkLength]);
+	UNITTEST_CHECK(Source == Original);
+
+	// Copies share the source and copy the copied chunks only; writing into
+	// a copy does not affect the original
+	MexCoWVector<double> Copy(View);
+	UNITTEST_CHECK(Copy.nchunks() == View.nchunks() && Copy.ncopiedchunks() == 3);
+	UNITTEST_CHECK(isEqual(Copy, Expected));
+	Copy.mut(Size - 2) = 7.0;
+	Copy.mut(3*ChunkLength) = 8.0;
+	UNITTEST_CHECK(Copy.ncopiedchunks() == 4 && Copy[Size - 2] == 7.0 && Copy[3*ChunkLength] == 8.0);
+	UNITTEST_CHECK(isEqual(View, Expected));
+
+	MexCoWVector<double> Assigned;
+	Assigned = Copy;
+	UNITTEST_CHECK(Assigned.ncopiedchunks() == 4 && Assigned[Size - 2] == 7.0 && Assigned[ChunkLength - 1] == Expected[ChunkLength - 1]);
+
+	// materialize copies the remaining chunks and empties the view
+	MexVector<double> Materialized;
+	View.materialize(Materialized);
+	UNITTEST_CHECK(View.isempty() && View.nchunks() == 0);
+	UNITTEST_CHECK(Materialized.size() == Size && std::equal(Materialized.begin(), Materialized.end(), Expected.begin()));
+	UNITTEST_CHECK(Source == Original);
+}
+
+static void TestMatrix() {
+	// Row major, i.e. the element (r, c) is at r*NCols + c of the source
+	std::vector<double> Source;
+	getSource(Source, 12);
+	MexCoWMatrix<double> Matrix(3, 4, Source.data());
+	UNITTEST_CHECK(Matrix(2, 1) == Source[2*4 + 1]);
+	Matrix.mut(2, 1) = -5.0;
+	UNITTEST_CHECK(Matrix(2, 1) == -5.0 && Source[2*4 + 1] == 9*0.5 + 1.0);
+
+	MexMatrix<double> Materialized;
+	Matrix.materialize(Materialized);
+	UNITTEST_CHECK(Materialized.nrows() == 3 && Materialized.ncols() == 4);
+	UNITTEST_CHECK(Materialized(2, 1) == -5.0 && Materialized(1, 3) == Source[1*4 + 3]);
+	UNITTEST_CHECK(Matrix.isempty());
+}
+
+static void TestmxArrayInput() {
+	mxArray* Array = mxCreateNumericMatrix(5, 1, mxDOUBLE_CLASS, mxREAL);
+	double* ArrayData = mxGetPr(Array);
+	for (size_t i = 0; i < 5; ++i)
+		ArrayData[i] = double(i);
+
+	MexCoWVector<double> View;
+	getCoWInputfrommxArray(Array, View);
+	View.mut(4) = 40.0;
+	UNITTEST_CHECK(View.size() == 5 && View[3] == 3.0 && View[4] == 40.0 && ArrayData[4] == 4.0);
+
+	// The class must match exactly
+	MexCoWVector<float> FloatView;
+	UNITTEST_CHECK_THROWS(getCoWInputfrommxArray(Array, FloatView), ExOps::EXCEPTION_INVALID_INPUT);
+	mxDestroyArray(Array);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "MexCoW.SingleChunk"    , TestSingleChunk },
+		{ "MexCoW.ChunkBoundaries", TestChunkBoundaries },
+		{ "MexCoW.Matrix"         , TestMatrix },
+		{ "MexCoW.mxArrayInput"   , TestmxArrayInput },
+	};
+	return RunUnitTests(Tests);
+}
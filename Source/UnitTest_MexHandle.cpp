@@ -0,0 +1,113 @@
+// Unit tests of MexHandleRegistry: the lifetime of the registered objects,
+// the reuse of slots with a new generation, and the detection of stale,
+// foreign and mistyped handles by isvalid and get.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include "UnitTest.hpp"
+#include "../Headers/MexHandle.hpp"
+
+// Counts the live instances
+struct Counted {
+	static int NAlive;
+	int Value;
+	inline explicit Counted(int Value_) : Value(Value_) { NAlive++; }
+	inline ~Counted() { NAlive--; }
+};
+int Counted::NAlive = 0;
+
+// Destroys the handle it owns (unless already destroyed) when destroyed
+struct Owner {
+	uint64_t Child;
+	inline explicit Owner(uint64_t Child_) : Child(Child_) {}
+	inline ~Owner() {
+		if (MexHandleRegistry::isvalid(Child))
+			MexHandleRegistry::destroy(Child);
+	}
+};
+
+static const uint64_t SlotMask = 0xFFFFFFFF;
+
+static void TestLifetime() {
+	uint64_t Handle = MexHandleRegistry::emplace<Counted>(42);
+	UNITTEST_CHECK(Counted::NAlive == 1 && MexHandleRegistry::size() == 1);
+	UNITTEST_CHECK(MexHandleRegistry::isvalid(Handle));
+	UNITTEST_CHECK(MexHandleRegistry::get<Counted>(Handle).Value == 42);
+
+	// The object is the same on every lookup
+	MexHandleRegistry::get<Counted>(Handle).Value = 7;
+	UNITTEST_CHECK(MexHandleRegistry::get<Counted>(Handle).Value == 7);
+
+	MexHandleRegistry::destroy(Handle);
+	UNITTEST_CHECK(Counted::NAlive == 0 && MexHandleRegistry::size() == 0);
+	UNITTEST_CHECK(!MexHandleRegistry::isvalid(Handle));
+	UNITTEST_CHECK_THROWS(MexHandleRegistry::get<Counted>(Handle), ExOps::EXCEPTION_INVALID_INPUT);
+	UNITTEST_CHECK_THROWS(MexHandleRegistry::destroy(Handle), ExOps::EXCEPTION_INVALID_INPUT);
+}
+
+static void TestStaleHandles() {
+	// A destroyed slot is reused with the next generation, so that the old
+	// handle does not alias the new object
+	uint64_t OldHandle = MexHandleRegistry::emplace<Counted>(1);
+	MexHandleRegistry::destroy(OldHandle);
+	uint64_t NewHandle = MexHandleRegistry::emplace<Counted>(2);
+	UNITTEST_CHECK((NewHandle & SlotMask) == (OldHandle & SlotMask));
+	UNITTEST_CHECK(NewHandle == OldHandle + (uint64_t(1) << 32));
+	UNITTEST_CHECK(!MexHandleRegistry::isvalid(OldHandle) && MexHandleRegistry::isvalid(NewHandle));
+	UNITTEST_CHECK_THROWS(MexHandleRegistry::get<Counted>(OldHandle), ExOps::EXCEPTION_INVALID_INPUT);
+	UNITTEST_CHECK(MexHandleRegistry::get<Counted>(NewHandle).Value == 2);
+
+	// Handles of another registry instance (i.e. from before a 'clear mex')
+	// and handles of slots that were never allocated are invalid
+	uint64_t ForeignHandle = NewHandle ^ (uint64_t(1) << 48);
+	uint64_t UnallocatedHandle = (NewHandle & ~SlotMask) | (SlotMask - 1);
+	UNITTEST_CHECK(!MexHandleRegistry::isvalid(ForeignHandle));
+	UNITTEST_CHECK(!MexHandleRegistry::isvalid(UnallocatedHandle));
+	UNITTEST_CHECK_THROWS(MexHandleRegistry::get<Counted>(ForeignHandle), ExOps::EXCEPTION_INVALID_INPUT);
+
+	// The object must be requested with the type it was registered with
+	UNITTEST_CHECK_THROWS(MexHandleRegistry::get<Owner>(NewHandle), ExOps::EXCEPTION_INVALID_INPUT);
+
+	MexHandleRegistry::destroy(NewHandle);
+	UNITTEST_CHECK(Counted::NAlive == 0);
+}
+
+static void TestmxHandle() {
+	uint64_t Handle = MexHandleRegistry::emplace<Counted>(3);
+	mxArray* HandleArray = MexHandleRegistry::getmxHandle(Handle);
+	UNITTEST_CHECK(getHandlefrommxArray(HandleArray) == Handle);
+	mxDestroyArray(HandleArray);
+
+	mxArray* DoubleArray = mxCreateDoubleMatrix(1, 1, mxREAL);
+	UNITTEST_CHECK_THROWS(getHandlefrommxArray(DoubleArray), ExOps::EXCEPTION_INVALID_INPUT);
+	mxDestroyArray(DoubleArray);
+	MexHandleRegistry::destroy(Handle);
+}
+
+static void TestDestroyAll() {
+	// Including an object whose destructor destroys another one
+	uint64_t Child = MexHandleRegistry::emplace<Counted>(4);
+	uint64_t Parent = MexHandleRegistry::emplace<Owner>(Child);
+	MexHandleRegistry::emplace<Counted>(5);
+	UNITTEST_CHECK(MexHandleRegistry::size() == 3 && Counted::NAlive == 2);
+
+	MexHandleRegistry::destroyAll();
+	UNITTEST_CHECK(MexHandleRegistry::size() == 0 && Counted::NAlive == 0);
+	UNITTEST_CHECK(!MexHandleRegistry::isvalid(Child) && !MexHandleRegistry::isvalid(Parent));
+
+	// The same when the owner is destroyed first
+	Child = MexHandleRegistry::emplace<Counted>(6);
+	Parent = MexHandleRegistry::emplace<Owner>(Child);
+	MexHandleRegistry::destroy(Parent);
+	UNITTEST_CHECK(MexHandleRegistry::size() == 0 && Counted::NAlive == 0 && !MexHandleRegistry::isvalid(Child));
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "MexHandle.Lifetime"    , TestLifetime },
+		{ "MexHandle.StaleHandles", TestStaleHandles },
+		{ "MexHandle.mxHandle"    , TestmxHandle },
+		{ "MexHandle.DestroyAll"  , TestDestroyAll },
+	};
+	return RunUnitTests(Tests);
+}
@@ -0,0 +1,117 @@
+// Unit tests of MexInputCache: hits on unchanged inputs, misses on arrays
+// allocated at the address of a freed one, in-place modifications with the
+// sampled and the full fingerprint, and the budget.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include "UnitTest.hpp"
+#include "../Headers/MexInputCache.hpp"
+
+typedef MexVector<double, mxPersistentAllocator> VectorType;
+typedef MexVector<MexVector<double, mxPersistentAllocator>, mxPersistentAllocator> CellsType;
+
+static const VectorType& getCachedVector(const mxArray* Array) {
+	return MexInputCache::get<VectorType>(Array, [](const mxArray* InArray, VectorType &VectOut) {
+		getInputfrommxArray<double>(InArray, VectOut);
+	});
+}
+
+static mxArray* getVectorArray(size_t NElems) {
+	mxArray* Array = mxCreateDoubleMatrix(NElems, 1, mxREAL);
+	for (size_t i = 0; i < NElems; ++i)
+		mxGetPr(Array)[i] = double(i);
+	return Array;
+}
+
+static mxArray* getCellsArray(size_t NCells) {
+	mxArray* Array = mxCreateCellMatrix(NCells, 1);
+	for (size_t i = 0; i < NCells; ++i)
+		mxSetCell(Array, i, getVectorArray(i % 7));
+	return Array;
+}
+
+static void TestHitsAndMisses() {
+	MexInputCache::clear();
+	MexInputCache::resetStats();
+	mxArray* Array = getVectorArray(1000);
+
+	const VectorType &Vect = getCachedVector(Array);
+	UNITTEST_CHECK(Vect.size() == 1000 && Vect[999] == 999.0);
+	const VectorType &VectHit = getCachedVector(Array);
+	UNITTEST_CHECK(&VectHit == &Vect);
+
+	// The same array converted to another container type is another entry
+	MexInputCache::get<MexVector<float, mxPersistentAllocator> >(Array, [](const mxArray* InArray, MexVector<float, mxPersistentAllocator> &VectOut) {
+		getInputfrommxArray<double>(InArray, VectOut);
+	});
+
+	MexInputCacheStats Stats = MexInputCache::getStats();
+	UNITTEST_CHECK(Stats.Hits == 1 && Stats.Misses == 2 && Stats.NEntries == 2);
+
+	MexInputCache::clear();
+	UNITTEST_CHECK(MexInputCache::getStats().NEntries == 0 && MexInputCache::getStats().CachedBytes == 0);
+	mxDestroyArray(Array);
+}
+
+static void TestInPlaceModification() {
+	MexInputCache::clear();
+	mxArray* Array = getVectorArray(100000);
+	mxArray* Cells = getCellsArray(10000);
+
+	// An unsampled element modified in place is not detected by default
+	getCachedVector(Array);
+	MexInputCache::get<CellsType>(Cells);
+	mxGetPr(Array)[12385] = -1.0;
+	mxGetPr(mxGetCell(Cells, 4325))[3] = -1.0;
+	UNITTEST_CHECK(getCachedVector(Array)[12385] == 12385.0);
+	UNITTEST_CHECK(MexInputCache::get<CellsType>(Cells)[4325][3] == 3.0);
+
+	// but is with full hashing
+	MexInputCache::setFullHash(true);
+	UNITTEST_CHECK(MexInputCache::getStats().NEntries == 0);
+	UNITTEST_CHECK(getCachedVector(Array)[12385] == -1.0);
+	UNITTEST_CHECK(MexInputCache::get<CellsType>(Cells)[4325][3] == -1.0);
+	mxGetPr(Array)[54325] = -2.0;
+	mxGetPr(mxGetCell(Cells, 1238))[2] = -2.0;
+	UNITTEST_CHECK(getCachedVector(Array)[54325] == -2.0);
+	UNITTEST_CHECK(MexInputCache::get<CellsType>(Cells)[1238][2] == -2.0);
+	MexInputCache::setFullHash(false);
+
+	MexInputCache::clear();
+	mxDestroyArray(Array);
+	mxDestroyArray(Cells);
+}
+
+static void TestBudget() {
+	MexInputCache::clear();
+	MexInputCache::resetStats();
+	MexInputCache::setBudget(3*1000*sizeof(double));
+
+	mxArray* Arrays[4];
+	for (int i = 0; i < 4; ++i) {
+		Arrays[i] = getVectorArray(1000);
+		getCachedVector(Arrays[i]);
+	}
+	MexInputCacheStats Stats = MexInputCache::getStats();
+	UNITTEST_CHECK(Stats.NEntries <= 3 && Stats.Evictions >= 1 && Stats.CachedBytes <= Stats.Budget);
+
+	// The least recently used entry was evicted
+	MexInputCache::resetStats();
+	getCachedVector(Arrays[3]);
+	getCachedVector(Arrays[0]);
+	UNITTEST_CHECK(MexInputCache::getStats().Hits == 1 && MexInputCache::getStats().Misses == 1);
+
+	MexInputCache::clear();
+	MexInputCache::setBudget(MEXMEM_INPUT_CACHE_BUDGET);
+	for (int i = 0; i < 4; ++i)
+		mxDestroyArray(Arrays[i]);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "MexInputCache.HitsAndMisses"      , TestHitsAndMisses },
+		{ "MexInputCache.InPlaceModification", TestInPlaceModification },
+		{ "MexInputCache.Budget"             , TestBudget },
+	};
+	return RunUnitTests(Tests);
+}
@@ -0,0 +1,124 @@
+// Unit tests of MexRingBuffer and MexRingMatrix: time order across the
+// wraparound, decimated recording, the capacity checks on construction and
+// the release of the storage.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <type_traits>
+
+#include "UnitTest.hpp"
+#include "../Headers/MexRingBuffer.hpp"
+
+static void TestRingBufferWraparound() {
+	MexRingBuffer<int32_t> Ring(8);
+	for (int32_t i = 0; i < 5; ++i)
+		Ring.push_back(i);
+	UNITTEST_CHECK(Ring.size() == 5 && !Ring.iswrapped());
+	UNITTEST_CHECK(Ring.front() == 0 && Ring.back() == 4);
+
+	for (int32_t i = 5; i < 21; ++i)
+		Ring.push_back(i);
+	UNITTEST_CHECK(Ring.isfull() && Ring.iswrapped());
+
+	MexVector<int32_t> Values;
+	Ring.getVector(Values);
+	bool isInOrder = Values.size() == 8;
+	for (size_t i = 0; isInOrder && i < 8; ++i)
+		isInOrder = Values[i] == int32_t(13 + i) && Ring[i] == Values[i];
+	UNITTEST_CHECK(isInOrder);
+}
+
+static void TestRingBufferRecord() {
+	// Every 3rd of 20 steps, starting with the first
+	MexRingBuffer<double> Ring(7, 3);
+	for (int i = 0; i < 20; ++i)
+		Ring.record(i);
+	UNITTEST_CHECK(Ring.size() == 7);
+	UNITTEST_CHECK(Ring[0] == 0 && Ring[1] == 3 && Ring[6] == 18);
+}
+
+static void TestRingBufferCapacity() {
+	// The capacity is checked on construction only
+	UNITTEST_CHECK(!std::is_default_constructible<MexRingBuffer<float> >::value);
+	UNITTEST_CHECK_THROWS(MexRingBuffer<float>(0), ExOps::EXCEPTION_INVALID_INPUT);
+
+	// The size is capped by the capacity however many values are pushed
+	MexRingBuffer<float> Ring(4);
+	Ring.push_back(1.0f);
+	Ring.push_back(2.0f);
+	UNITTEST_CHECK(Ring.size() == 2 && !Ring.isfull());
+	for (int i = 0; i < 1000; ++i)
+		Ring.push_back(float(i));
+	UNITTEST_CHECK(Ring.size() == 4 && Ring.isfull() && Ring.iswrapped() && Ring.front() == 996.0f);
+	UNITTEST_CHECK(Ring.releaseArray() == nullptr && Ring.size() == 4);
+
+	Ring.clear();
+	UNITTEST_CHECK(Ring.isempty() && Ring.size() == 0 && Ring.capacity() == 4);
+	Ring.push_back(1.0f);
+	Ring.push_back(2.0f);
+	float* Data = Ring.releaseArray();
+	UNITTEST_CHECK(Data != nullptr && Data[1] == 2.0f);
+	mxFree(Data);
+	UNITTEST_CHECK(Ring.capacity() == 0 && Ring.isempty());
+
+	// A released recorder is reused by assigning it a new one
+	Ring = MexRingBuffer<float>(2);
+	Ring.push_back(3.0f);
+	UNITTEST_CHECK(Ring.capacity() == 2 && Ring.size() == 1 && Ring.back() == 3.0f);
+}
+
+static void TestRingMatrixWraparound() {
+	MexRingMatrix<double> Ring(3, 2);
+	MexVector<double> Row(2);
+	for (int i = 0; i < 5; ++i) {
+		Row[0] = i; Row[1] = -i;
+		Ring.push_row(Row);
+	}
+	UNITTEST_CHECK(Ring.nrows() == 3 && Ring.iswrapped());
+	UNITTEST_CHECK(Ring(0, 0) == 2 && Ring(2, 1) == -4 && Ring.lastrow()[0] == 4);
+
+	MexMatrix<double> Rows;
+	Ring.getMatrix(Rows);
+	UNITTEST_CHECK(Rows.nrows() == 3 && Rows(1, 0) == 3 && Rows(1, 1) == -3);
+
+	MexVector<double> WrongRow(3);
+	UNITTEST_CHECK_THROWS(Ring.push_row(WrongRow), ExOps::EXCEPTION_INVALID_INPUT);
+}
+
+static void TestRingMatrixCapacity() {
+	UNITTEST_CHECK(!std::is_default_constructible<MexRingMatrix<double> >::value);
+	UNITTEST_CHECK_THROWS(MexRingMatrix<double>(0, 2), ExOps::EXCEPTION_INVALID_INPUT);
+	UNITTEST_CHECK_THROWS(MexRingMatrix<double>(4, 0), ExOps::EXCEPTION_INVALID_INPUT);
+
+	// Decimated recording of 25 rows into a capacity of 4 keeps the last 4
+	// of the rows 0, 3, ..., 24
+	double Row[2] = { 1.0, 2.0 };
+	MexRingMatrix<double> Ring(4, 2, 3);
+	for (int i = 0; i < 25; ++i) {
+		Row[0] = i;
+		Ring.record_row(Row);
+	}
+	UNITTEST_CHECK(Ring.nrows() == 4 && Ring.isfull() && Ring(0, 0) == 15 && Ring(3, 0) == 24);
+
+	Ring.clear();
+	Ring.push_row(Row);
+	double* Data = Ring.releaseArray();
+	UNITTEST_CHECK(Data != nullptr && Data[0] == 24.0 && Data[1] == 2.0);
+	mxFree(Data);
+	UNITTEST_CHECK(Ring.capacity() == 0 && Ring.isempty());
+
+	Ring = MexRingMatrix<double>(2, 2);
+	Ring.push_row(Row);
+	UNITTEST_CHECK(Ring.capacity() == 2 && Ring.nrows() == 1 && Ring.lastrow()[1] == 2.0);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "MexRingBuffer.Wraparound"    , TestRingBufferWraparound },
+		{ "MexRingBuffer.Record"        , TestRingBufferRecord },
+		{ "MexRingBuffer.Capacity"      , TestRingBufferCapacity },
+		{ "MexRingMatrix.Wraparound"    , TestRingMatrixWraparound },
+		{ "MexRingMatrix.Capacity"      , TestRingMatrixCapacity },
+	};
+	return RunUnitTests(Tests);
+}
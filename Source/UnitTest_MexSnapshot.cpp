@@ -0,0 +1,187 @@
+// Unit tests of MexSnapshot: save / load round trips of vectors, matrices
+// and FlatVectTrees, and the rejection of invalid fetches and corrupted
+// files.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "UnitTest.hpp"
+#include "../Headers/MexSnapshot.hpp"
+
+static const char* SnapshotFile = "UnitTest_MexSnapshot.snap";
+
+template <typename T, class Al1, class Al2>
+static bool isEqual(const MexVector<T, Al1> &A, const MexVector<T, Al2> &B) {
+	return A.size() == B.size() && std::equal(A.begin(), A.end(), B.begin());
+}
+
+static void getNestedTree(MexVector<MexVector<MexVector<int16_t> > > &Nested) {
+	Nested.resize(300);
+	for (size_t i = 0; i < Nested.size(); ++i) {
+		Nested[i].resize(i % 4);
+		for (size_t j = 0; j < Nested[i].size(); ++j)
+			for (size_t k = 0; k < (i*j) % 9; ++k)
+				Nested[i][j].push_back(int16_t(i - j*k));
+	}
+}
+
+static void writeSnapshot() {
+	MexVector<double> Vect(1000);
+	for (size_t i = 0; i < Vect.size(); ++i)
+		Vect[i] = 0.5*i;
+	MexMatrix<uint8_t> Matrix(7, 13);
+	for (size_t i = 0; i < Matrix.nrows(); ++i)
+		for (size_t j = 0; j < Matrix.ncols(); ++j)
+			Matrix(i, j) = uint8_t(i*13 + j);
+	MexVector<MexVector<MexVector<int16_t> > > Nested;
+	getNestedTree(Nested);
+	FlatVectTree<int16_t, mxAllocator, uint64_t> Tree64;
+	Tree64.build(Nested);
+
+	MexSnapshotWriter Writer(SnapshotFile);
+	Writer.write("Vect", Vect);
+	Writer.write("Matrix", Matrix);
+	Writer.write("Nested", Nested);
+	Writer.write("Tree64", Tree64);
+	Writer.write("Empty", MexVector<float>());
+	Writer.close();
+}
+
+static void TestRoundTrip() {
+	writeSnapshot();
+	MexSnapshot Snapshot(SnapshotFile);
+	UNITTEST_CHECK(Snapshot.contains("Vect") && Snapshot.contains("Tree64") && !Snapshot.contains("Missing"));
+
+	MexVector<double> Vect;
+	Snapshot.get("Vect", Vect);
+	UNITTEST_CHECK(Vect.size() == 1000 && Vect.ismemext());
+	bool isVectEqual = true;
+	for (size_t i = 0; i < Vect.size(); ++i)
+		isVectEqual = isVectEqual && Vect[i] == 0.5*i;
+	UNITTEST_CHECK(isVectEqual);
+
+	MexMatrix<uint8_t> Matrix;
+	Snapshot.get("Matrix", Matrix);
+	UNITTEST_CHECK(Matrix.nrows() == 7 && Matrix.ncols() == 13);
+	UNITTEST_CHECK(Matrix(6, 12) == 6*13 + 12 && Matrix(2, 3) == 2*13 + 3);
+
+	MexVector<MexVector<MexVector<int16_t> > > Expected;
+	getNestedTree(Expected);
+
+	// Nested vectors are read back as FlatVectTrees (of the default index)
+	FlatVectTree<int16_t> Tree;
+	Snapshot.get("Nested", Tree);
+	MexVector<MexVector<MexVector<int16_t> > > Nested;
+	Tree.getVectTree(Nested);
+	bool isTreeEqual = Nested.size() == Expected.size();
+	for (size_t i = 0; isTreeEqual && i < Expected.size(); ++i) {
+		isTreeEqual = Nested[i].size() == Expected[i].size();
+		for (size_t j = 0; isTreeEqual && j < Expected[i].size(); ++j)
+			isTreeEqual = isEqual(Nested[i][j], Expected[i][j]);
+	}
+	UNITTEST_CHECK(isTreeEqual);
+
+	FlatVectTree<int16_t, mxAllocator, uint64_t> Tree64;
+	Snapshot.get("Tree64", Tree64, false);
+	UNITTEST_CHECK(!Tree64.isvalidated() && Tree64.validate());
+	MexVector<MexVector<MexVector<int16_t> > > Nested64;
+	Tree64.getVectTree(Nested64);
+	UNITTEST_CHECK(Nested64.size() == Expected.size() && isEqual(Nested64[299][2], Expected[299][2]));
+
+	MexVector<float> Empty;
+	Snapshot.get("Empty", Empty);
+	UNITTEST_CHECK(Empty.isempty());
+
+	Snapshot.close();
+	std::remove(SnapshotFile);
+}
+
+static void TestInvalidFetch() {
+	writeSnapshot();
+	MexSnapshot Snapshot(SnapshotFile);
+
+	MexVector<float> FloatVect;
+	MexMatrix<double> DoubleMatrix;
+	FlatVectTree<int16_t> Tree;
+	FlatVectTree<int16_t, mxAllocator, uint64_t> Tree64;
+	UNITTEST_CHECK_THROWS(Snapshot.get("Missing", FloatVect), MS_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(Snapshot.get("Vect", FloatVect), MS_INVALID_FETCH);      // different type
+	UNITTEST_CHECK_THROWS(Snapshot.get("Vect", DoubleMatrix), MS_INVALID_FETCH);   // different kind
+	UNITTEST_CHECK_THROWS(Snapshot.get("Tree64", Tree), MS_INVALID_FETCH);         // different index type
+	UNITTEST_CHECK_THROWS(Snapshot.get("Nested", Tree64), MS_INVALID_FETCH);
+
+	Snapshot.close();
+	UNITTEST_CHECK_THROWS(Snapshot.get("Vect", FloatVect), MS_INVALID_FETCH);
+
+	MexSnapshotWriter Writer(SnapshotFile);
+	Writer.write("Name", FloatVect);
+	UNITTEST_CHECK_THROWS(Writer.write("Name", FloatVect), ExOps::EXCEPTION_INVALID_INPUT);
+	UNITTEST_CHECK_THROWS(Writer.write("A name that is much too long to be stored", FloatVect), ExOps::EXCEPTION_INVALID_INPUT);
+	Writer.close();
+	std::remove(SnapshotFile);
+}
+
+static void TestCorruptedFile() {
+	writeSnapshot();
+
+	std::vector<char> Contents;
+	{
+		std::FILE* File = std::fopen(SnapshotFile, "rb");
+		std::fseek(File, 0, SEEK_END);
+		Contents.resize(std::ftell(File));
+		std::fseek(File, 0, SEEK_SET);
+		UNITTEST_CHECK(std::fread(Contents.data(), 1, Contents.size(), File) == Contents.size());
+		std::fclose(File);
+	}
+	auto WriteFile = [&](const std::vector<char> &Bytes) {
+		std::FILE* File = std::fopen(SnapshotFile, "wb");
+		std::fwrite(Bytes.data(), 1, Bytes.size(), File);
+		std::fclose(File);
+	};
+
+	// Truncated
+	WriteFile(std::vector<char>(Contents.begin(), Contents.end() - 100));
+	UNITTEST_CHECK_THROWS(MexSnapshot Snapshot(SnapshotFile), MS_INVALID_FILE);
+	WriteFile(std::vector<char>(Contents.begin(), Contents.begin() + 10));
+	UNITTEST_CHECK_THROWS(MexSnapshot Snapshot(SnapshotFile), MS_INVALID_FILE);
+
+	// Invalid magic number
+	std::vector<char> Corrupted(Contents);
+	Corrupted[0] = 'X';
+	WriteFile(Corrupted);
+	UNITTEST_CHECK_THROWS(MexSnapshot Snapshot(SnapshotFile), MS_INVALID_FILE);
+
+	// An inconsistent partition index is detected when the tree is validated
+	Corrupted = Contents;
+	MexSnapshotHeader Header;
+	std::memcpy(&Header, Corrupted.data(), sizeof(Header));
+	for (uint64_t i = 0; i < Header.NSections; ++i) {
+		MexSnapshotSection Section;
+		std::memcpy(&Section, Corrupted.data() + Header.SectionTableOffset + i*sizeof(Section), sizeof(Section));
+		if (!std::strcmp(Section.Name, "Nested") && Section.Kind == MEXSNAP_FVT_INDEX && Section.Part == 1) {
+			uint32_t Last = uint32_t(-1);
+			std::memcpy(Corrupted.data() + Section.Offset + (Section.NRows - 1)*sizeof(uint32_t), &Last, sizeof(Last));
+		}
+	}
+	WriteFile(Corrupted);
+	{
+		MexSnapshot Snapshot(SnapshotFile);
+		FlatVectTree<int16_t> Tree;
+		UNITTEST_CHECK_THROWS(Snapshot.get("Nested", Tree), FV_INVALID_APPEND);
+		Snapshot.get("Nested", Tree, false);
+		UNITTEST_CHECK(!Tree.validate());
+	}
+	std::remove(SnapshotFile);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "MexSnapshot.RoundTrip"    , TestRoundTrip },
+		{ "MexSnapshot.InvalidFetch" , TestInvalidFetch },
+		{ "MexSnapshot.CorruptedFile", TestCorruptedFile },
+	};
+	return RunUnitTests(Tests);
+}
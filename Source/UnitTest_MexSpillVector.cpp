@@ -0,0 +1,149 @@
+// Unit tests of MexSpillVector. The chunks are made tiny (see the
+// MEXMEM_SPILL_CHUNK_SIZE definition in CMakeLists.txt) so that the vectors
+// spill over many chunks, and the contents are read back through each of
+// ChunkReader, copyTo, assignmxArray and writeToFile.
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <cstdio>
+#include <vector>
+
+#include "UnitTest.hpp"
+#include "../Headers/MexSpillVector.hpp"
+
+typedef MexSpillVector<uint32_t> SpillType;
+
+static const char* SpillPath  = "UnitTest_MexSpillVector.spill";
+static const char* OutputPath = "UnitTest_MexSpillVector.bin";
+
+static uint32_t getValue(size_t Index) {
+	return uint32_t(Index*7 + 3);
+}
+
+static bool isExpected(const uint32_t* Values, size_t NValues, size_t FirstIndex) {
+	for (size_t i = 0; i < NValues; ++i)
+		if (Values[i] != getValue(FirstIndex + i))
+			return false;
+	return true;
+}
+
+// Checks the contents of Vector (which must hold getValue(0 ... N-1))
+// through every way of reading them back
+static void checkContents(SpillType &Vector, size_t N) {
+	UNITTEST_CHECK(Vector.size() == N);
+
+	// ChunkReader: full chunks followed by the (possibly partial) last one
+	{
+		SpillType::ChunkReader Reader = Vector.getReader();
+		size_t NRead = 0;
+		size_t NChunks = 0;
+		bool isChunkValid = true;
+		size_t NElems;
+		const uint32_t* Chunk;
+		while ((Chunk = Reader.next(NElems)) != nullptr) {
+			isChunkValid &= NElems > 0 && NElems <= Vector.chunklength() && isExpected(Chunk, NElems, NRead);
+			isChunkValid &= NChunks >= Vector.nspilledchunks() || NElems == Vector.chunklength();
+			NRead += NElems;
+			NChunks++;
+		}
+		UNITTEST_CHECK(isChunkValid);
+		UNITTEST_CHECK(NRead == N);
+		UNITTEST_CHECK(NChunks == (N + Vector.chunklength() - 1) / Vector.chunklength());
+		UNITTEST_CHECK(Reader.next(NElems) == nullptr && NElems == 0);
+	}
+
+	// copyTo
+	std::vector<uint32_t> Copied(N + 1, 0);
+	Vector.copyTo(Copied.data());
+	UNITTEST_CHECK(isExpected(Copied.data(), N, 0) && Copied[N] == 0);
+
+	// assignmxArray (which leaves the vector unchanged)
+	mxArray* Array = assignmxArray(Vector);
+	UNITTEST_CHECK(mxGetClassID(Array) == mxUINT32_CLASS && mxGetNumberOfElements(Array) == N);
+	UNITTEST_CHECK(N == 0 || isExpected(static_cast<uint32_t*>(mxGetData(Array)), N, 0));
+	mxDestroyArray(Array);
+
+	// writeToFile
+	Vector.writeToFile(OutputPath);
+	std::FILE* OutFile = std::fopen(OutputPath, "rb");
+	UNITTEST_CHECK(OutFile != nullptr);
+	if (OutFile != nullptr) {
+		std::vector<uint32_t> Written(N + 1);
+		size_t NWritten = std::fread(Written.data(), sizeof(uint32_t), N + 1, OutFile);
+		UNITTEST_CHECK(NWritten == N && isExpected(Written.data(), N, 0));
+		std::fclose(OutFile);
+	}
+	std::remove(OutputPath);
+
+	UNITTEST_CHECK(Vector.size() == N);
+}
+
+static void TestPushBack() {
+	SpillType Vector;
+	UNITTEST_CHECK(Vector.chunklength() == MEXMEM_SPILL_CHUNK_SIZE / sizeof(uint32_t));
+
+	// Many more chunks than MEXMEM_SPILL_BUFFERS, with a partial last one
+	size_t N = 100*Vector.chunklength() + 5;
+	for (size_t i = 0; i < N; ++i)
+		Vector.push_back(getValue(i));
+	UNITTEST_CHECK(Vector.nspilledchunks() == 100);
+	checkContents(Vector, N);
+
+	// The vector can be appended to after reading it back
+	for (size_t i = N; i < N + 2*Vector.chunklength(); ++i)
+		Vector.push_back(getValue(i));
+	checkContents(Vector, N + 2*Vector.chunklength());
+}
+
+static void TestAppend() {
+	// The spill file is removed once the vector has closed it
+	{
+		SpillType Vector(SpillPath);
+
+		// Appends of sizes smaller than, equal to and spanning several
+		// chunks, interleaved with push_back
+		size_t ChunkLength = Vector.chunklength();
+		size_t AppendSizes[] = { 1, ChunkLength - 1, ChunkLength, 3*ChunkLength + 2, 0, 7, 10*ChunkLength };
+		std::vector<uint32_t> Values;
+		size_t N = 0;
+		for (size_t AppendSize : AppendSizes) {
+			Values.resize(AppendSize);
+			for (size_t i = 0; i < AppendSize; ++i)
+				Values[i] = getValue(N + i);
+			Vector.append(Values.data(), AppendSize);
+			N += AppendSize;
+			Vector.push_back(getValue(N++));
+		}
+		UNITTEST_CHECK(Vector.nspilledchunks() == (N - 1) / ChunkLength);
+		checkContents(Vector, N);
+	}
+	std::remove(SpillPath);
+}
+
+static void TestFullLastChunk() {
+	// The last chunk is only spilled on the next append, so a size that is a
+	// multiple of the chunk length leaves a full chunk in memory
+	SpillType Vector;
+	size_t N = 20*Vector.chunklength();
+	for (size_t i = 0; i < N; ++i)
+		Vector.push_back(getValue(i));
+	UNITTEST_CHECK(Vector.nspilledchunks() == 19);
+	checkContents(Vector, N);
+}
+
+static void TestEmpty() {
+	SpillType Vector;
+	UNITTEST_CHECK(Vector.isempty() && Vector.nspilledchunks() == 0);
+	Vector.append(nullptr, 0);
+	checkContents(Vector, 0);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "MexSpillVector.PushBack"     , TestPushBack },
+		{ "MexSpillVector.Append"       , TestAppend },
+		{ "MexSpillVector.FullLastChunk", TestFullLastChunk },
+		{ "MexSpillVector.Empty"        , TestEmpty },
+	};
+	return RunUnitTests(Tests);
+}
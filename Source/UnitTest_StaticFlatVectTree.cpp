@@ -0,0 +1,160 @@
+// Unit tests of StaticFlatVectTree: the conversions from and to FlatVectTree,
+// the unrolled indexing functions, and the input from / output to mxArrays
+// (including the empty input).
+//
+// This is to be compiled with MEX_EXE defined.
+
+#include <algorithm>
+#include <utility>
+
+#include "UnitTest.hpp"
+#include "../Headers/FlatVectTree/FlatVectTree.hpp"
+#include "../Headers/FlatVectTree/StaticFlatVectTree.hpp"
+
+typedef MexVector<MexVector<uint32_t> > Tree2Type;
+typedef MexVector<Tree2Type> Tree3Type;
+typedef StaticFlatVectTree<uint32_t, 2> Static2Type;
+
+static void getTree(Tree3Type &Tree) {
+	Tree.resize(50);
+	for (size_t i = 0; i < Tree.size(); ++i) {
+		Tree[i].resize(i % 3);
+		for (size_t j = 0; j < Tree[i].size(); ++j)
+			for (size_t k = 0; k < (i + j) % 5; ++k)
+				Tree[i][j].push_back(uint32_t(i*100 + j*10 + k));
+	}
+}
+
+static bool isEqual(const Tree3Type &A, const Tree3Type &B) {
+	if (A.size() != B.size())
+		return false;
+	for (size_t i = 0; i < A.size(); ++i) {
+		if (A[i].size() != B[i].size())
+			return false;
+		for (size_t j = 0; j < A[i].size(); ++j)
+			if (A[i][j].size() != B[i][j].size() || !std::equal(A[i][j].begin(), A[i][j].end(), B[i][j].begin()))
+				return false;
+	}
+	return true;
+}
+
+// Compares the tree using leaf() and operator()
+static bool isEqual(const Static2Type &A, const Tree3Type &B) {
+	if (A.LevelSize(0) != B.size())
+		return false;
+	for (size_t i = 0; i < B.size(); ++i) {
+		for (size_t j = 0; j < B[i].size(); ++j) {
+			FlatVectTreeSpan<uint32_t> Leaf = A.leaf(i, j);
+			if (Leaf.size() != B[i][j].size() || !std::equal(Leaf.begin(), Leaf.end(), B[i][j].begin()))
+				return false;
+			for (size_t k = 0; k < B[i][j].size(); ++k)
+				if (A(i, j, k) != B[i][j][k])
+					return false;
+		}
+	}
+	return true;
+}
+
+static void TestConversion() {
+	Tree3Type Expected;
+	getTree(Expected);
+
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+
+	// Copying leaves FlatTree unchanged
+	Static2Type StaticCopy(FlatTree);
+	UNITTEST_CHECK(StaticCopy.isvalidated() && !StaticCopy.isempty());
+	UNITTEST_CHECK(isEqual(StaticCopy, Expected));
+	UNITTEST_CHECK(FlatTree.LevelSize(0) == 50);
+
+	// Moving leaves FlatTree empty with its depth unchanged
+	Static2Type StaticMoved(std::move(FlatTree));
+	UNITTEST_CHECK(isEqual(StaticMoved, Expected));
+	UNITTEST_CHECK(FlatTree.isempty() && FlatTree.depth() == 2);
+
+	// Releasing the memory back into a FlatVectTree
+	FlatVectTree<uint32_t> Released;
+	StaticMoved.releaseMem(Released);
+	UNITTEST_CHECK(StaticMoved.isempty() && StaticMoved.LevelSize(1) == 0);
+	Tree3Type ReleasedNested;
+	Released.getVectTree(ReleasedNested);
+	UNITTEST_CHECK(isEqual(ReleasedNested, Expected));
+
+	// A truly empty FlatVectTree empties the tree
+	FlatVectTree<uint32_t> EmptyTree;
+	StaticCopy.assign(EmptyTree);
+	UNITTEST_CHECK(StaticCopy.isempty() && StaticCopy.LevelSize(1) == 0);
+
+	// A FlatVectTree of a different depth is rejected
+	Tree2Type Tree2(3);
+	Tree2[1].push_back(7);
+	FlatVectTree<uint32_t> FlatTree2;
+	FlatTree2.build(Tree2);
+	UNITTEST_CHECK_THROWS(StaticCopy.assign(FlatTree2), FV_INVALID_FETCH);
+	UNITTEST_CHECK_THROWS(StaticCopy.assign(std::move(FlatTree2)), FV_INVALID_FETCH);
+}
+
+static void TestView() {
+	Tree3Type Expected;
+	getTree(Expected);
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+	Static2Type StaticTree(std::move(FlatTree));
+
+	FlatVectTreeView<uint32_t> View = StaticTree.view();
+	UNITTEST_CHECK(View.size() == 50 && View.depth() == 2);
+	bool isViewEqual = true;
+	for (size_t i = 0; i < Expected.size(); ++i) {
+		isViewEqual &= View[i].size() == Expected[i].size();
+		for (size_t j = 0; isViewEqual && j < Expected[i].size(); ++j) {
+			FlatVectTreeSpan<uint32_t> Leaf = View[i][j].span();
+			isViewEqual = Leaf.size() == Expected[i][j].size() && std::equal(Leaf.begin(), Leaf.end(), Expected[i][j].begin());
+		}
+	}
+	UNITTEST_CHECK(isViewEqual);
+}
+
+static void TestmxArrayInput() {
+	Tree3Type Expected;
+	getTree(Expected);
+	FlatVectTree<uint32_t> FlatTree;
+	FlatTree.build(Expected);
+	Static2Type StaticTree(std::move(FlatTree));
+
+	mxArray* Array = assignmxArray(StaticTree);
+	UNITTEST_CHECK(mxIsStruct(Array) && StaticTree.isempty());
+
+	Static2Type StaticIn;
+	UNITTEST_CHECK(getCheckedInputfrommxArray(Array, StaticIn));
+	UNITTEST_CHECK(isEqual(StaticIn, Expected));
+
+	// A FlatCellArray of a different depth is rejected
+	StaticFlatVectTree<uint32_t, 1> Static1;
+	UNITTEST_CHECK(!getCheckedInputfrommxArray(Array, Static1));
+	UNITTEST_CHECK_THROWS(getInputfrommxArray(Array, Static1), ExOps::EXCEPTION_INVALID_INPUT);
+
+	// An empty mxArray empties the tree
+	mxArray* EmptyArray = mxCreateDoubleMatrix(0, 0, mxREAL);
+	UNITTEST_CHECK(getCheckedInputfrommxArray(EmptyArray, StaticIn));
+	UNITTEST_CHECK(StaticIn.isempty() && StaticIn.LevelSize(1) == 0);
+	mxDestroyArray(EmptyArray);
+
+	// The same through a struct field
+	const char* FieldNames[] = { "Tree" };
+	mxArray* Struct = mxCreateStructMatrix(1, 1, 1, FieldNames);
+	mxSetField(Struct, 0, "Tree", Array);
+	Static2Type StaticField;
+	UNITTEST_CHECK(getInputfromStruct<uint32_t>(Struct, "Tree", StaticField) == 0);
+	UNITTEST_CHECK(isEqual(StaticField, Expected));
+	mxDestroyArray(Struct);
+}
+
+int main() {
+	UnitTestCase Tests[] = {
+		{ "StaticFlatVectTree.Conversion"  , TestConversion },
+		{ "StaticFlatVectTree.View"        , TestView },
+		{ "StaticFlatVectTree.mxArrayInput", TestmxArrayInput },
+	};
+	return RunUnitTests(Tests);
+}